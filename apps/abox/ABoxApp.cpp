@@ -10,9 +10,17 @@ void ABoxApp::run()
 {
   while (!wm.shouldClose()) {
     wm.pollEvents();
+#ifdef ABOX_SHADER_HOT_RELOAD
+    // Frame boundary: nothing is being recorded
+    if (std::vector<std::string> changed = shaderHandler.applyReloads();
+        !changed.empty()) {
+      rs.reloadPipelines(shaderHandler.getShaderHandlers(), changed);
+    }
+#endif
     rs.drawFrame();
     if (wm.consumeFramebufferResized()) {
-      rs.waitIdle();
+      // No device idle: replaced resources are retired through the device's
+      // deferred deletion queue
       LOG_INFO("App") << "recreating swapchain";
       LOG_INFO("App") << "value: "
                       << static_cast<int32_t>(
@@ -37,10 +45,15 @@ ABoxApp::ABoxApp()
   LOG_INFO("App") << "\n -- Swapchain Created --";
   rs.createRenderPass();
   LOG_INFO("App") << "\n -- Render Pass Created --";
+  // Shaders compiled in the background since shaderHandler was built
+  shaderHandler.waitForShaders();
   rs.addGraphicsPipeline(shaderHandler.getShaderHandlers());
   LOG_INFO("App") << "\n -- Graphics Pipeline added --";
   rs.createFramebuffers();
   LOG_INFO("App") << "\n -- Frame Buffers Created --";
+#ifdef ABOX_SHADER_HOT_RELOAD
+  shaderHandler.watch();
+#endif
 }
 
 ABoxApp::~ABoxApp() { rs.waitIdle(); };
@@ -21,7 +21,7 @@ class ABoxApp {
   };
 
   WindowManager    wm{baseWindowDimention, "ABoxApp"};
-  ShaderHandler    shaderHandler{SHADER_DIR};
+  ShaderHandler    shaderHandler{SHADER_DIR}; // compiles while rs is created
   ResourcesManager rs;
 
    public:
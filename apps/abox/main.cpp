@@ -1,18 +1,38 @@
 #include "ABoxApp.hpp"
+#include "BinaryLog.hpp"
+#include "HostAllocator.hpp"
 #include "Logger.hpp"
+#include "ObjectRegistry.hpp"
+#include <cstdlib>
 #include <exception>
 
 int main()
 {
-  ABoxApp app;
-  LOG_INFO("App") << "App created, memory pointer: " << (void *)&app;
-  try {
-    app.run();
+  // ABOX_BINARY_LOG=<file> records structured logs (ABOX_SLOG) to a ring
+  // file instead of formatting them, decode with abox-logdump
+  if (const char *binaryLog = std::getenv("ABOX_BINARY_LOG")) {
+    ABox::openBinaryLog(binaryLog);
   }
-  catch (const std::exception &e) {
-    LOG_ERROR("App") << e.what();
-    return EXIT_FAILURE;
+
+  int status = EXIT_SUCCESS;
+  {
+    ABoxApp app;
+    LOG_INFO("App") << "App created, memory pointer: " << (void *)&app;
+    try {
+      app.run();
+    }
+    catch (const std::exception &e) {
+      LOG_ERROR("App") << e.what();
+      status = EXIT_FAILURE;
+    }
   }
-  return EXIT_SUCCESS;
+#ifdef ABOX_OBJECT_TRACKING
+  // Every wrapper is gone with the app, anything still counted leaked
+  ObjectRegistry::reportLeaks();
+#endif
+#ifdef ABOX_HOST_ALLOCATOR
+  HostAllocator::logStats();
+#endif
+  ABox::closeBinaryLog();
+  return status;
 }
-
@@ -6,6 +6,8 @@
 #include <map>
 #include <algorithm>
 
+#include "HostSizeClasses.hpp"
+
 // Platform-specific headers
 #if defined(_WIN32) || defined(_WIN64)
     #include <malloc.h>
@@ -197,5 +199,14 @@ int main() {
         }
     }
 
+    // Phase 4: HostAllocator pool classes for this granularity
+    std::vector<size_t> host_classes = deriveSizeClasses(a, ABOX_HOST_ALLOC_MAX_POOLED);
+    std::cout << "\n[Recommendations for HostAllocator]\n";
+    std::cout << "  Build with -DABOX_HOST_ALLOC_GRANULARITY=" << std::max<size_t>(a, 16)
+              << " for these pool classes (" << host_classes.size() << "):\n    ";
+    for (size_t i = 0; i < host_classes.size(); ++i) {
+        std::cout << host_classes[i] << (i + 1 < host_classes.size() ? ", " : "\n");
+    }
+
     return 0;
 }
@@ -0,0 +1,128 @@
+// abox-logdump: render a binary log written by ABox::openBinaryLog to text
+//
+// Usage: abox-logdump <file.ablog> [--category NAME] [--min-level LEVEL]
+
+#include "BinaryLog.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+static const char *levelName(ABox::LogLevel level)
+{
+  switch (level) {
+    case ABox::LogLevel::DEBUG: return "DEBUG";
+    case ABox::LogLevel::INFO: return "INFO ";
+    case ABox::LogLevel::WARN: return "WARN ";
+    case ABox::LogLevel::ERROR: return "ERROR";
+  }
+  return "?????";
+}
+
+static bool parseLevel(const char *name, ABox::LogLevel &out)
+{
+  static const struct {
+    const char    *name;
+    ABox::LogLevel level;
+  } levels[] = {
+      {"debug", ABox::LogLevel::DEBUG},
+      {"info", ABox::LogLevel::INFO},
+      {"warn", ABox::LogLevel::WARN},
+      {"error", ABox::LogLevel::ERROR},
+  };
+  for (const auto &l : levels) {
+    if (std::strcmp(name, l.name) == 0) {
+      out = l.level;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void usage(const char *argv0)
+{
+  std::fprintf(
+      stderr,
+      "Usage: %s <file> [--category NAME] "
+      "[--min-level debug|info|warn|error]\n",
+      argv0
+  );
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const char    *path     = nullptr;
+  const char    *category = nullptr;
+  ABox::LogLevel minLevel = ABox::LogLevel::DEBUG;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--category") == 0 && i + 1 < argc) {
+      category = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--min-level") == 0 && i + 1 < argc) {
+      if (!parseLevel(argv[++i], minLevel)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    }
+    else if (!path && argv[i][0] != '-') {
+      path = argv[i];
+    }
+    else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (!path) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  ABox::BinaryLogReader reader;
+  if (!reader.open(path)) {
+    std::fprintf(stderr, "%s: not a readable ABox binary log\n", path);
+    return EXIT_FAILURE;
+  }
+
+  const std::time_t opened =
+      static_cast<std::time_t>(reader.wallClockAtOpenNs() / 1000000000ull);
+  char when[64] = "?";
+  if (const std::tm *tm = std::localtime(&opened)) {
+    std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", tm);
+  }
+  std::printf(
+      "# %s: opened %s, %zu formats, %llu dropped records\n",
+      path,
+      when,
+      reader.formatCount(),
+      static_cast<unsigned long long>(reader.droppedRecords())
+  );
+
+  size_t       shown = 0;
+  const size_t total = reader.forEach([&](const ABox::BinaryLogRecord &r) {
+    if (r.level < minLevel ||
+        (category && r.category != std::string_view(category))) {
+      return;
+    }
+    const std::string text = r.text();
+    std::printf(
+        "[%12.6f] [%s] [%.*s] %s\n",
+        static_cast<double>(r.timestampNs) / 1e9,
+        levelName(r.level),
+        static_cast<int>(r.category.size()),
+        r.category.data(),
+        text.c_str()
+    );
+    ++shown;
+  });
+
+  std::printf("# %zu of %zu records shown\n", shown, total);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+// abox-shaderpack: compile shaders and pack them into one ABox shader archive
+//
+// Usage: abox-shaderpack -o <out.absa> [--opt none|performance|size]
+//                        [--keep-debug] <folder|file>...
+
+#include "ShaderArchive.hpp"
+#include "ShaderHandler.hpp"
+#include "ShaderReflection.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+static bool parseLevel(const char *name, SpirvOptLevel &out)
+{
+  static const struct {
+    const char   *name;
+    SpirvOptLevel level;
+  } levels[] = {
+      {"none", SpirvOptLevel::None},
+      {"performance", SpirvOptLevel::Performance},
+      {"size", SpirvOptLevel::Size},
+  };
+  for (const auto &l : levels) {
+    if (std::strcmp(name, l.name) == 0) {
+      out = l.level;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void usage(const char *argv0)
+{
+  std::fprintf(
+      stderr,
+      "Usage: %s -o <out.absa> [--opt none|performance|size] [--keep-debug] "
+      "<folder|file>...\n",
+      argv0
+  );
+}
+
+int main(int argc, char **argv)
+{
+  const char                        *output = nullptr;
+  std::vector<std::filesystem::path> inputs;
+  // Archives are shipped: optimize and strip unless asked otherwise
+  SpirvOptimizerConfig config{
+      .level          = SpirvOptLevel::Performance,
+      .stripDebugInfo = true,
+      .validate       = true
+  };
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--opt") == 0 && i + 1 < argc) {
+      if (!parseLevel(argv[++i], config.level)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    }
+    else if (std::strcmp(argv[i], "--keep-debug") == 0) {
+      config.stripDebugInfo = false;
+    }
+    else if (argv[i][0] != '-') {
+      inputs.emplace_back(argv[i]);
+    }
+    else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (!output || inputs.empty()) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  ShaderHandler shaders;
+  shaders.setOptimizerConfig(config);
+  size_t failures = 0;
+  for (const std::filesystem::path &input : inputs) {
+    if (std::filesystem::is_directory(input)) {
+      shaders.loadShaderDataFromFolderAsync(input);
+    }
+    else if (shaders.loadShaderDataFile(input) != VK_FILE_SUCCESS) {
+      ++failures;
+    }
+  }
+  failures += shaders.waitForShaders().failures.size();
+  if (failures != 0) {
+    std::fprintf(stderr, "%zu shader(s) failed, no archive written\n", failures);
+    return EXIT_FAILURE;
+  }
+
+  ShaderArchiveWriter writer;
+  for (const ShaderDataFile &shader : shaders.getShaderHandlers()) {
+    const std::vector<std::byte> reflection =
+        shader.isReflectionValid()
+            ? serializeReflection(shader.getReflectionData())
+            : std::vector<std::byte>{};
+    if (!writer.add(
+            shader.getName(),
+            shader.getStage(),
+            shader.getCode(),
+            reflection
+        )) {
+      std::fprintf(
+          stderr,
+          "Duplicate shader name %s, no archive written\n",
+          shader.getName().c_str()
+      );
+      return EXIT_FAILURE;
+    }
+  }
+  if (!writer.write(output)) {
+    return EXIT_FAILURE;
+  }
+  std::printf("%s: %zu shader(s)\n", output, writer.size());
+  return EXIT_SUCCESS;
+}
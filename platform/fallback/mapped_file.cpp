@@ -0,0 +1,91 @@
+#include "platform/mapped_file.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace abox::platform {
+
+// Fallback for platforms without a native mapping API: the file content is
+// copied into a heap buffer and written back on flush/unmap.
+
+int map_file_read(const char *path, MappedFile &out)
+{
+  FILE *f = std::fopen(path, "rb");
+  if (!f) {
+    return -1;
+  }
+
+  std::fseek(f, 0, SEEK_END);
+  long size = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  if (size <= 0) {
+    std::fclose(f);
+    return -1;
+  }
+
+  void *data = std::malloc(static_cast<size_t>(size));
+  if (!data ||
+      std::fread(data, 1, static_cast<size_t>(size), f) !=
+          static_cast<size_t>(size)) {
+    std::free(data);
+    std::fclose(f);
+    return -1;
+  }
+  std::fclose(f);
+
+  out.data     = data;
+  out.size     = static_cast<size_t>(size);
+  out.handle   = -1;
+  out.mapping  = 0;
+  out.writable = false;
+  return 0;
+}
+
+int map_file_write(const char *path, size_t size, MappedFile &out)
+{
+  FILE *f = std::fopen(path, "wb+");
+  if (!f) {
+    return -1;
+  }
+
+  void *data = std::calloc(1, size);
+  if (!data) {
+    std::fclose(f);
+    return -1;
+  }
+
+  out.data     = data;
+  out.size     = size;
+  out.handle   = reinterpret_cast<intptr_t>(f);
+  out.mapping  = 0;
+  out.writable = true;
+  return 0;
+}
+
+int flush_file(MappedFile &file)
+{
+  if (!file.data || !file.writable) {
+    return 0;
+  }
+  FILE *f = reinterpret_cast<FILE *>(file.handle);
+  std::fseek(f, 0, SEEK_SET);
+  if (std::fwrite(file.data, 1, file.size, f) != file.size) {
+    return -1;
+  }
+  return std::fflush(f) == 0 ? 0 : -1;
+}
+
+void unmap_file(MappedFile &file)
+{
+  if (file.data) {
+    flush_file(file);
+    std::free(file.data);
+  }
+  if (file.writable && file.handle != -1) {
+    std::fclose(reinterpret_cast<FILE *>(file.handle));
+  }
+  file = MappedFile{};
+}
+
+} // namespace abox::platform
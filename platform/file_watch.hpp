@@ -0,0 +1,55 @@
+#ifndef ABOX_PLATFORM_FILE_WATCH_HPP
+#define ABOX_PLATFORM_FILE_WATCH_HPP
+
+#include <cstdint>
+
+namespace abox::platform {
+
+/**
+ * @brief Directory change notifications (inotify on Linux)
+ *
+ * Opened by file_watch_open and released by file_watch_close. Other
+ * platforms have no implementation yet: file_watch_open fails there.
+ */
+struct FileWatch {
+  intptr_t handle = -1;
+};
+
+/**
+ * @brief Called once per changed file
+ * @param user Pointer given to file_watch_poll
+ * @param watchId Value returned by file_watch_add for the directory
+ * @param name File name relative to that directory
+ */
+using FileWatchCallback = void (*)(void *user, int watchId, const char *name);
+
+/**
+ * @brief Create a watch set
+ * @return 0 on success, -1 on error or if unsupported
+ */
+int file_watch_open(FileWatch &out);
+
+/**
+ * @brief Report files of a directory (not recursive) that are written and
+ * closed, or moved in, the way editors save
+ * @return Watch id (>= 0), -1 on error. Adding a directory twice returns
+ * the same id.
+ */
+int file_watch_add(FileWatch &watch, const char *directory);
+
+/**
+ * @brief Wait up to timeoutMs for changes and report them
+ * @return Number of changes reported, 0 on timeout, -1 on error
+ */
+int file_watch_poll(
+    FileWatch        &watch,
+    int               timeoutMs,
+    FileWatchCallback callback,
+    void             *user
+);
+
+void file_watch_close(FileWatch &watch);
+
+} // namespace abox::platform
+
+#endif // ABOX_PLATFORM_FILE_WATCH_HPP
@@ -0,0 +1,80 @@
+#include "platform/file_watch.hpp"
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace abox::platform {
+
+int file_watch_open(FileWatch &out)
+{
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  out.handle = fd;
+  return 0;
+}
+
+int file_watch_add(FileWatch &watch, const char *directory)
+{
+  if (watch.handle < 0) {
+    return -1;
+  }
+  return inotify_add_watch(
+      static_cast<int>(watch.handle),
+      directory,
+      IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR
+  );
+}
+
+int file_watch_poll(
+    FileWatch        &watch,
+    int               timeoutMs,
+    FileWatchCallback callback,
+    void             *user
+)
+{
+  if (watch.handle < 0) {
+    return -1;
+  }
+  pollfd pfd{
+      .fd      = static_cast<int>(watch.handle),
+      .events  = POLLIN,
+      .revents = 0
+  };
+  int ready = poll(&pfd, 1, timeoutMs);
+  if (ready <= 0) {
+    return ready < 0 && errno != EINTR ? -1 : 0;
+  }
+
+  alignas(inotify_event) char buffer[4096];
+  int                         count = 0;
+  for (;;) {
+    ssize_t len = read(static_cast<int>(watch.handle), buffer, sizeof(buffer));
+    if (len <= 0) {
+      // EAGAIN: queue drained
+      return len < 0 && errno != EAGAIN && errno != EINTR ? -1 : count;
+    }
+    for (ssize_t offset = 0; offset < len;) {
+      const auto *event =
+          reinterpret_cast<const inotify_event *>(buffer + offset);
+      if (event->len > 0 && !(event->mask & IN_ISDIR)) {
+        callback(user, event->wd, event->name);
+        ++count;
+      }
+      offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+    }
+  }
+}
+
+void file_watch_close(FileWatch &watch)
+{
+  if (watch.handle >= 0) {
+    close(static_cast<int>(watch.handle));
+  }
+  watch = FileWatch{};
+}
+
+} // namespace abox::platform
@@ -0,0 +1,91 @@
+#include "platform/mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace abox::platform {
+
+int map_file_read(const char *path, MappedFile &out)
+{
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return -1;
+  }
+
+  void *data = mmap(
+      nullptr,
+      static_cast<size_t>(st.st_size),
+      PROT_READ,
+      MAP_PRIVATE,
+      fd,
+      0
+  );
+  if (data == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+
+  out.data     = data;
+  out.size     = static_cast<size_t>(st.st_size);
+  out.handle   = fd;
+  out.mapping  = 0;
+  out.writable = false;
+  return 0;
+}
+
+int map_file_write(const char *path, size_t size, MappedFile &out)
+{
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  void *data =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+
+  out.data     = data;
+  out.size     = size;
+  out.handle   = fd;
+  out.mapping  = 0;
+  out.writable = true;
+  return 0;
+}
+
+int flush_file(MappedFile &file)
+{
+  if (!file.data || !file.writable) {
+    return 0;
+  }
+  return msync(file.data, file.size, MS_SYNC);
+}
+
+void unmap_file(MappedFile &file)
+{
+  if (file.data) {
+    flush_file(file);
+    munmap(file.data, file.size);
+  }
+  if (file.handle >= 0) {
+    close(static_cast<int>(file.handle));
+  }
+  file = MappedFile{};
+}
+
+} // namespace abox::platform
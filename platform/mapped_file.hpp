@@ -0,0 +1,53 @@
+#ifndef ABOX_PLATFORM_MAPPED_FILE_HPP
+#define ABOX_PLATFORM_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace abox::platform {
+
+/**
+ * @brief A file mapped into the address space
+ *
+ * Filled by map_file_read / map_file_write and released by unmap_file.
+ * The native handles are opaque to callers.
+ */
+struct MappedFile {
+  void    *data     = nullptr;
+  size_t   size     = 0;
+  intptr_t handle   = -1; // fd on POSIX, HANDLE on Windows
+  intptr_t mapping  = 0;  // mapping object on Windows, unused elsewhere
+  bool     writable = false;
+};
+
+/**
+ * @brief Map an existing file read-only
+ * @param path File to map
+ * @param out Receives the mapping (untouched on failure)
+ * @return 0 on success, -1 on error
+ */
+int map_file_read(const char *path, MappedFile &out);
+
+/**
+ * @brief Create (or truncate) a file of the given size and map it read-write
+ * @param path File to create
+ * @param size Size in bytes of the file and of the mapping
+ * @param out Receives the mapping (untouched on failure)
+ * @return 0 on success, -1 on error
+ */
+int map_file_write(const char *path, size_t size, MappedFile &out);
+
+/**
+ * @brief Flush the dirty pages of a writable mapping to disk
+ * @return 0 on success, -1 on error
+ */
+int flush_file(MappedFile &file);
+
+/**
+ * @brief Unmap and close a mapping, flushing it first when writable
+ */
+void unmap_file(MappedFile &file);
+
+} // namespace abox::platform
+
+#endif // ABOX_PLATFORM_MAPPED_FILE_HPP
@@ -0,0 +1,30 @@
+#include "platform/file_watch.hpp"
+
+namespace abox::platform {
+
+// No change notification backend here yet, watch mode stays off.
+
+int file_watch_open(FileWatch &out)
+{
+  out = FileWatch{};
+  return -1;
+}
+
+int file_watch_add(FileWatch & /*watch*/, const char * /*directory*/)
+{
+  return -1;
+}
+
+int file_watch_poll(
+    FileWatch & /*watch*/,
+    int /*timeoutMs*/,
+    FileWatchCallback /*callback*/,
+    void * /*user*/
+)
+{
+  return -1;
+}
+
+void file_watch_close(FileWatch &watch) { watch = FileWatch{}; }
+
+} // namespace abox::platform
@@ -0,0 +1,119 @@
+#include "platform/mapped_file.hpp"
+
+#include <windows.h>
+
+namespace abox::platform {
+
+static int map_handle(
+    HANDLE      file,
+    size_t      size,
+    bool        writable,
+    MappedFile &out
+)
+{
+  const LARGE_INTEGER li{.QuadPart = static_cast<LONGLONG>(size)};
+
+  HANDLE mapping = CreateFileMappingA(
+      file,
+      nullptr,
+      writable ? PAGE_READWRITE : PAGE_READONLY,
+      static_cast<DWORD>(li.HighPart),
+      li.LowPart,
+      nullptr
+  );
+  if (!mapping) {
+    CloseHandle(file);
+    return -1;
+  }
+
+  void *data = MapViewOfFile(
+      mapping,
+      writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+      0,
+      0,
+      size
+  );
+  if (!data) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return -1;
+  }
+
+  out.data     = data;
+  out.size     = size;
+  out.handle   = reinterpret_cast<intptr_t>(file);
+  out.mapping  = reinterpret_cast<intptr_t>(mapping);
+  out.writable = writable;
+  return 0;
+}
+
+int map_file_read(const char *path, MappedFile &out)
+{
+  HANDLE file = CreateFileA(
+      path,
+      GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr
+  );
+  if (file == INVALID_HANDLE_VALUE) {
+    return -1;
+  }
+
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+    CloseHandle(file);
+    return -1;
+  }
+
+  return map_handle(file, static_cast<size_t>(size.QuadPart), false, out);
+}
+
+int map_file_write(const char *path, size_t size, MappedFile &out)
+{
+  HANDLE file = CreateFileA(
+      path,
+      GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ,
+      nullptr,
+      CREATE_ALWAYS,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr
+  );
+  if (file == INVALID_HANDLE_VALUE) {
+    return -1;
+  }
+
+  // The mapping extends the file to `size`
+  return map_handle(file, size, true, out);
+}
+
+int flush_file(MappedFile &file)
+{
+  if (!file.data || !file.writable) {
+    return 0;
+  }
+  if (!FlushViewOfFile(file.data, file.size)) {
+    return -1;
+  }
+  return FlushFileBuffers(reinterpret_cast<HANDLE>(file.handle)) ? 0 : -1;
+}
+
+void unmap_file(MappedFile &file)
+{
+  if (file.data) {
+    flush_file(file);
+    UnmapViewOfFile(file.data);
+  }
+  if (file.mapping) {
+    CloseHandle(reinterpret_cast<HANDLE>(file.mapping));
+  }
+  if (file.handle != -1) {
+    CloseHandle(reinterpret_cast<HANDLE>(file.handle));
+  }
+  file = MappedFile{};
+}
+
+} // namespace abox::platform
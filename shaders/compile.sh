@@ -1,2 +1,3 @@
-glslc shader.vert -o vert.spv
-glslc shader.frag -o frag.spv
+mkdir -p spv
+glslc shader.vert -o spv/shader.vert.spv
+glslc shader.frag -o spv/shader.frag.spv
@@ -1,4 +1,5 @@
 #include "ResourcesManager.hpp"
+#include "BinaryLog.hpp"
 #include "DeviceHandler.hpp"
 #include "Logger.hpp"
 #include "ShaderHandler.hpp"
@@ -101,7 +102,11 @@ ResourcesManager::ResourcesManager()
 
   LOG_DEBUG("Resource") << "VkInstanceCreateInfo created at "
                         << (void *)&instanceCreateInfo;
-  VkResult res = vkCreateInstance(&instanceCreateInfo, nullptr, instance.ptr());
+  VkResult res = vkCreateInstance(
+      &instanceCreateInfo,
+      instance.getAllocator(),
+      instance.ptr()
+  );
   if (res != VK_SUCCESS) {
     std::stringstream ss;
     ss << "Resources Manager Error : failed to create instance! VkResult = "
@@ -191,8 +196,8 @@ VkResult ResourcesManager::reCreateSwapchain(
 }
 
 VkResult ResourcesManager::addGraphicsPipeline(
-    const std::list<ShaderDataFile> &smcis,
-    uint32_t                         devIndex
+    ShaderDataView smcis,
+    uint32_t       devIndex
 )
 {
   LOG_DEBUG("Resource") << "devIndex: " << devIndex
@@ -205,6 +210,21 @@ VkResult ResourcesManager::addGraphicsPipeline(
              : VK_ERROR_DEVICE_LOST;
 }
 
+size_t ResourcesManager::reloadPipelines(
+    ShaderDataView                  smcis,
+    const std::vector<std::string> &changedShaders,
+    uint32_t                        devIndex
+)
+{
+  return deviceHandler.has_value() && deviceHandler.value().hasDevice(devIndex)
+             ? deviceHandler.value().reloadPipelines(
+                   devIndex,
+                   smcis,
+                   changedShaders
+               )
+             : 0;
+}
+
 VkResult ResourcesManager::createFramebuffers(uint32_t devIndex)
 {
   if (deviceHandler.has_value()) {
@@ -222,8 +242,9 @@ void ResourcesManager::drawFrame()
   uint32_t                         imageIndex;
   ABox_Utils::DeviceBoundElements *dbe = deviceHandler->getDBE("main");
   ABOX_LOG_PER_FRAME << "Got main deviceHandler";
-  dbe->getFrameSyncArray()->waitAndReset(dbe->getDevice());
-  ABOX_LOG_PER_FRAME << "Wait and reset done";
+  dbe->getFrameSyncArray()->wait(dbe->getDevice());
+  dbe->collectRetired();
+  ABOX_LOG_PER_FRAME << "Wait done";
 
   VkResult result = vkAcquireNextImageKHR(
       dbe->getDevice(),
@@ -235,15 +256,17 @@ void ResourcesManager::drawFrame()
   );
   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
     // dbe->swapchain.recreateSwapChain();
-    LOG_WARN("Vulkan") << "Need to recreate Swapchain!";
+    // The fence was not reset, so the next wait returns straight away
+    ABOX_LOG_RATE_LIMITED("Vulkan", ABox::LogLevel::WARN, 1)
+        << "Need to recreate Swapchain!";
     return;
   }
   else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
     throw std::runtime_error("failed to acquire swap chain image!");
   }
+  dbe->getFrameSyncArray()->reset(dbe->getDevice());
   const uint32_t frameIndex = dbe->getFrameSyncArray()->getFrameIndex();
-  ABOX_LOG_PER_FRAME << "ImageIndex " << imageIndex;
-  ABOX_LOG_PER_FRAME << "FrameIndex " << frameIndex;
+  ABOX_SLOG_PER_FRAME("ImageIndex {} FrameIndex {}", imageIndex, frameIndex);
 
   dbe->recordCommandBuffer(imageIndex, frameIndex);
 
@@ -281,6 +304,7 @@ void ResourcesManager::drawFrame()
   if (result != VK_SUCCESS) {
     throw std::runtime_error("failed to submit draw command buffer!");
   }
+  dbe->getFrameSyncArray()->markSubmitted();
 
   VkPresentInfoKHR presentInfo{
       .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
@@ -310,11 +334,8 @@ VkCommandBuffer ResourcesManager::beginFrame(uint32_t *pImageIndex, uint32_t dev
 
   // Wait for the fence from this frame's command buffer to be signaled
   // (i.e., wait for the previous use of this command buffer to complete)
-  VkFence inFlightFence = dbe->getFrameSyncArray()->getFrameSyncObject()->inFlight;
-  vkWaitForFences(dbe->getDevice(), 1, &inFlightFence, VK_TRUE, UINT64_MAX);
-
-  // Reset the fence for reuse
-  vkResetFences(dbe->getDevice(), 1, &inFlightFence);
+  dbe->getFrameSyncArray()->wait(dbe->getDevice());
+  dbe->collectRetired();
 
   // Acquire next swapchain image
   VkResult result = vkAcquireNextImageKHR(
@@ -334,6 +355,9 @@ VkCommandBuffer ResourcesManager::beginFrame(uint32_t *pImageIndex, uint32_t dev
     throw std::runtime_error("Failed to acquire swap chain image!");
   }
 
+  // Reset the fence for reuse, only now that a submit is guaranteed
+  dbe->getFrameSyncArray()->reset(dbe->getDevice());
+
   // Get command buffer for this frame
   VkCommandBuffer cmdBuffer = dbe->getCommandHandler()->top().getCommandBuffer(frameIndex);
 
@@ -387,6 +411,7 @@ void ResourcesManager::endFrame(uint32_t imageIndex, VkCommandBuffer commandBuff
   if (result != VK_SUCCESS) {
     throw std::runtime_error("Failed to submit draw command buffer!");
   }
+  dbe->getFrameSyncArray()->markSubmitted();
 
   // Present
   VkPresentInfoKHR presentInfo{
@@ -2,6 +2,7 @@
 #define RESSOURCES_MANAGER_HPP
 
 #include "DeviceHandler.hpp"
+#include "HostAllocator.hpp"
 #include "Logger.hpp"
 #include "PreProcUtils.hpp"
 #include "ShaderHandler.hpp"
@@ -22,7 +23,10 @@ DEFINE_VK_MEMORY_WRAPPER_FULL(
 )
 
 class ResourcesManager {
-  InstanceWrapper instance;
+  InstanceWrapper instance{
+      VK_NULL_HANDLE,
+      HostAllocator::callbacks(HostAllocTag::Instance)
+  };
 
 #ifdef DEBUG_VK_ABOX
   DebugHandler debugHandler;
@@ -108,8 +112,19 @@ class ResourcesManager {
   std::vector<const char *> getLayerNames();
 
   VkResult addGraphicsPipeline(
-      const std::list<ShaderDataFile> &smcis,
-      uint32_t                         deviceIndex = 0u
+      ShaderDataView smcis,
+      uint32_t       deviceIndex = 0u
+  );
+
+  /**
+   * @brief Rebuild the pipelines using the changed shaders, call between
+   * frames (see ShaderHandler::applyReloads)
+   * @return Number of pipelines rebuilt
+   */
+  size_t reloadPipelines(
+      ShaderDataView                  smcis,
+      const std::vector<std::string> &changedShaders,
+      uint32_t                        deviceIndex = 0u
   );
 
   VkResult createFramebuffers(uint32_t devIndex = 0u);
@@ -90,6 +90,20 @@ class FrameBufferBroker {
       framebuffer.erase(key);
     }
   }
+
+  /**
+   * @brief clear() deferring the destruction until in-flight frames are done
+   */
+  void clear(VkSwapchainKHR sc, VkRenderPass rp, DeferredDeletionQueue &retired)
+  {
+    auto it = framebuffer.find(frameBufferKey{sc, rp});
+    if (it != framebuffer.end()) {
+      for (auto &fb : it->second) {
+        fb.retire(retired);
+      }
+      framebuffer.erase(it);
+    }
+  }
   std::vector<FramebufferWrapper> *
       getFrameBuffers(VkSwapchainKHR sc, VkRenderPass rp)
   {
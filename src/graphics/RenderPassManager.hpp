@@ -5,6 +5,7 @@
 #include <graphics/SwapchainManager.hpp>
 #include <map>
 #include <memory/MemoryWrapper.hpp>
+#include <pipelines/RenderPassCompatibility.hpp>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
@@ -77,6 +78,8 @@ class RenderPassManager {
     }
 
     rPasses.emplace_back(device, renderpass);
+    // Pipelines key the render pass by what they need of it
+    RenderPassCompatibility::add(renderpass, renderPassInfo);
 
     return res;
   }
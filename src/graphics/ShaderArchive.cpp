@@ -0,0 +1,300 @@
+#include "ShaderArchive.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+constexpr uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+bool inBounds(uint64_t offset, uint64_t size, uint64_t fileSize)
+{
+  return offset <= fileSize && size <= fileSize - offset;
+}
+
+} // namespace
+
+ShaderArchive::ShaderArchive(const fs::path &path)
+{
+  if (abox::platform::map_file_read(path.string().c_str(), file) != 0) {
+    LOG_WARN("Shader") << "Couldn't map shader archive " << path.string();
+    return;
+  }
+  valid = validate(path);
+  if (valid) {
+    codeStates =
+        std::make_unique<std::atomic<CodeState>[]>(entries().size());
+  }
+}
+
+ShaderArchive::~ShaderArchive() { abox::platform::unmap_file(file); }
+
+bool ShaderArchive::validate(const fs::path &path) const
+{
+  ShaderArchiveHeader header;
+  if (file.size < sizeof(header)) {
+    LOG_WARN("Shader") << path.string() << " is not a shader archive";
+    return false;
+  }
+  std::memcpy(&header, bytes(), sizeof(header));
+  if (header.magic != SHADER_ARCHIVE_MAGIC) {
+    LOG_WARN("Shader") << path.string() << " is not a shader archive";
+    return false;
+  }
+  if (header.version != SHADER_ARCHIVE_VERSION) {
+    LOG_WARN("Shader") << path.string() << " has archive version "
+                       << header.version << ", expected "
+                       << SHADER_ARCHIVE_VERSION << ", repack it";
+    return false;
+  }
+  if (header.fileSize != file.size ||
+      header.indexOffset % alignof(ShaderArchiveEntry) != 0 ||
+      !inBounds(
+          header.indexOffset,
+          uint64_t(header.entryCount) * sizeof(ShaderArchiveEntry),
+          file.size
+      )) {
+    LOG_WARN("Shader") << "Truncated or corrupted shader archive "
+                       << path.string();
+    return false;
+  }
+
+  const auto *index = reinterpret_cast<const ShaderArchiveEntry *>(
+      bytes() + header.indexOffset
+  );
+  std::string_view previous;
+  for (uint32_t i = 0; i < header.entryCount; ++i) {
+    const ShaderArchiveEntry &e = index[i];
+    if (!inBounds(e.nameOffset, e.nameSize, file.size) ||
+        e.codeOffset % sizeof(uint32_t) != 0 ||
+        !inBounds(e.codeOffset, uint64_t(e.codeWords) * 4, file.size) ||
+        !inBounds(e.reflectionOffset, e.reflectionSize, file.size)) {
+      LOG_WARN("Shader") << "Corrupted entry " << i << " in shader archive "
+                         << path.string();
+      return false;
+    }
+    const std::string_view current = name(e);
+    if (i > 0 && !(previous < current)) {
+      LOG_WARN("Shader") << "Unsorted index in shader archive "
+                         << path.string();
+      return false;
+    }
+    previous = current;
+  }
+  return true;
+}
+
+std::span<const ShaderArchiveEntry> ShaderArchive::entries() const
+{
+  if (!valid) {
+    return {};
+  }
+  ShaderArchiveHeader header;
+  std::memcpy(&header, bytes(), sizeof(header));
+  return {
+      reinterpret_cast<const ShaderArchiveEntry *>(
+          bytes() + header.indexOffset
+      ),
+      header.entryCount
+  };
+}
+
+const ShaderArchiveEntry *ShaderArchive::find(std::string_view wanted) const
+{
+  const std::span<const ShaderArchiveEntry> index = entries();
+  auto it = std::lower_bound(
+      index.begin(),
+      index.end(),
+      wanted,
+      [this](const ShaderArchiveEntry &e, std::string_view n) {
+        return name(e) < n;
+      }
+  );
+  return it != index.end() && name(*it) == wanted ? &*it : nullptr;
+}
+
+std::string_view ShaderArchive::name(const ShaderArchiveEntry &entry) const
+{
+  return {
+      reinterpret_cast<const char *>(bytes() + entry.nameOffset),
+      entry.nameSize
+  };
+}
+
+std::span<const uint32_t>
+    ShaderArchive::code(const ShaderArchiveEntry &entry) const
+{
+  const std::span<const uint32_t> words{
+      reinterpret_cast<const uint32_t *>(bytes() + entry.codeOffset),
+      entry.codeWords
+  };
+  return isIntact(entry, words) ? words : std::span<const uint32_t>{};
+}
+
+bool ShaderArchive::isIntact(
+    const ShaderArchiveEntry &entry,
+    std::span<const uint32_t> words
+) const
+{
+  // Entries copied out of the index are hashed on every call
+  const std::span<const ShaderArchiveEntry> index = entries();
+  std::atomic<CodeState>                   *state = nullptr;
+  if (!std::less<>{}(&entry, index.data()) &&
+      std::less<>{}(&entry, index.data() + index.size())) {
+    state = &codeStates[static_cast<size_t>(&entry - index.data())];
+    const CodeState known = state->load(std::memory_order_acquire);
+    if (known != Unchecked) {
+      return known == Intact;
+    }
+  }
+
+  // In bounds is not intact: the code goes to the driver as is
+  const bool intact =
+      ABox::Hasher().update(words.data(), words.size_bytes()).digest() ==
+      entry.hash;
+  if (!intact) {
+    LOG_WARN("Shader") << "Corrupted code of " << name(entry)
+                       << " in shader archive";
+  }
+  if (state) {
+    state->store(intact ? Intact : Corrupted, std::memory_order_release);
+  }
+  return intact;
+}
+
+std::span<const std::byte>
+    ShaderArchive::reflection(const ShaderArchiveEntry &entry) const
+{
+  return {bytes() + entry.reflectionOffset, entry.reflectionSize};
+}
+
+bool ShaderArchiveWriter::add(
+    std::string_view           name,
+    uint32_t                   stage,
+    std::span<const uint32_t>  code,
+    std::span<const std::byte> reflection
+)
+{
+  if (name.empty() ||
+      std::any_of(shaders.begin(), shaders.end(), [name](const Pending &p) {
+        return p.name == name;
+      })) {
+    return false;
+  }
+  shaders.push_back(
+      {.name       = std::string(name),
+       .stage      = stage,
+       .code       = {code.begin(), code.end()},
+       .reflection = {reflection.begin(), reflection.end()}}
+  );
+  return true;
+}
+
+bool ShaderArchiveWriter::write(const fs::path &path) const
+{
+  std::vector<const Pending *> sorted;
+  sorted.reserve(shaders.size());
+  for (const Pending &p : shaders) {
+    sorted.push_back(&p);
+  }
+  std::sort(
+      sorted.begin(),
+      sorted.end(),
+      [](const Pending *a, const Pending *b) { return a->name < b->name; }
+  );
+
+  // Offsets first, then one sequential write
+  std::vector<ShaderArchiveEntry> index(sorted.size());
+  uint64_t offset = sizeof(ShaderArchiveHeader) +
+                    index.size() * sizeof(ShaderArchiveEntry);
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    index[i].nameOffset = offset;
+    index[i].nameSize   = static_cast<uint32_t>(sorted[i]->name.size());
+    offset += sorted[i]->name.size();
+  }
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    offset              = alignUp(offset, BLOB_ALIGNMENT);
+    index[i].codeOffset = offset;
+    index[i].codeWords  = static_cast<uint32_t>(sorted[i]->code.size());
+    index[i].stage      = sorted[i]->stage;
+    index[i].hash       = ABox::Hasher()
+                        .update(
+                            sorted[i]->code.data(),
+                            sorted[i]->code.size() * sizeof(uint32_t)
+                        )
+                        .digest();
+    offset += sorted[i]->code.size() * sizeof(uint32_t);
+  }
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    offset                    = alignUp(offset, BLOB_ALIGNMENT);
+    index[i].reflectionOffset = offset;
+    index[i].reflectionSize =
+        static_cast<uint32_t>(sorted[i]->reflection.size());
+    offset += sorted[i]->reflection.size();
+  }
+  const ShaderArchiveHeader header{
+      .magic       = SHADER_ARCHIVE_MAGIC,
+      .version     = SHADER_ARCHIVE_VERSION,
+      .entryCount  = static_cast<uint32_t>(index.size()),
+      .reserved    = 0,
+      .indexOffset = sizeof(ShaderArchiveHeader),
+      .fileSize    = offset
+  };
+
+  const fs::path tmp = fs::path(path.string() + ".tmp");
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    auto          put = [&out](const void *data, size_t size) {
+      out.write(
+          static_cast<const char *>(data),
+          static_cast<std::streamsize>(size)
+      );
+    };
+    auto pad = [&out](uint64_t to) {
+      static constexpr char zeros[BLOB_ALIGNMENT] = {};
+      const uint64_t at = static_cast<uint64_t>(out.tellp());
+      out.write(zeros, static_cast<std::streamsize>(to - at));
+    };
+    put(&header, sizeof(header));
+    put(index.data(), index.size() * sizeof(ShaderArchiveEntry));
+    for (const Pending *p : sorted) {
+      put(p->name.data(), p->name.size());
+    }
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      pad(index[i].codeOffset);
+      put(sorted[i]->code.data(), sorted[i]->code.size() * sizeof(uint32_t));
+    }
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      pad(index[i].reflectionOffset);
+      put(sorted[i]->reflection.data(), sorted[i]->reflection.size());
+    }
+    if (!out.good()) {
+      LOG_ERROR("Shader") << "Failed to write shader archive " << tmp.string();
+      out.close();
+      std::error_code ec;
+      fs::remove(tmp, ec);
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+  if (ec) {
+    LOG_ERROR("Shader") << "Failed to publish shader archive " << path.string()
+                        << ": " << ec.message();
+    fs::remove(tmp, ec);
+    return false;
+  }
+  LOG_INFO("Shader") << "Packed " << index.size() << " shader(s) into "
+                     << path.string() << " (" << offset << " bytes)";
+  return true;
+}
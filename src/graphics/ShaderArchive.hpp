@@ -0,0 +1,152 @@
+#ifndef SHADER_ARCHIVE_HPP
+#define SHADER_ARCHIVE_HPP
+
+#include "Hash.hpp"
+#include "PreProcUtils.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <platform/mapped_file.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/** @brief "ABSA" read as a little endian word */
+inline constexpr uint32_t SHADER_ARCHIVE_MAGIC = 0x41534241;
+
+/** @brief Bump when the header, the index or the blob layout changes */
+inline constexpr uint32_t SHADER_ARCHIVE_VERSION = 1;
+
+inline constexpr const char *SHADER_ARCHIVE_EXTENSION = ".absa";
+
+/**
+ * @brief Fixed size file header, at offset 0
+ */
+struct ShaderArchiveHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t reserved;
+  uint64_t indexOffset; // entryCount ShaderArchiveEntry, sorted by name
+  uint64_t fileSize;    // catches truncated copies
+};
+
+/**
+ * @brief Index record of one shader, all offsets are from the file start
+ */
+struct ShaderArchiveEntry {
+  ABox::Hash128 hash; // of the SPIR-V words
+  uint64_t      nameOffset;
+  uint64_t      codeOffset; // 4 byte aligned
+  uint64_t      reflectionOffset;
+  uint32_t      nameSize;
+  uint32_t      codeWords;
+  uint32_t      reflectionSize; // 0 when not serialized
+  uint32_t      stage;          // VkShaderStageFlagBits
+};
+
+static_assert(std::is_trivially_copyable_v<ShaderArchiveHeader>);
+static_assert(std::is_trivially_copyable_v<ShaderArchiveEntry>);
+static_assert(sizeof(ShaderArchiveHeader) == 32);
+static_assert(sizeof(ShaderArchiveEntry) == 56);
+
+/**
+ * @class ShaderArchive
+ * @brief Read-only view of a packed shader archive
+ *
+ * The file is mapped once and validated on open: header, index and every
+ * blob range are checked against the file size and the names must be
+ * sorted, so lookups are a binary search. Opening reads no code: an
+ * entry's code is checked against its hash on its first code() call, then
+ * the span can be handed to Vulkan as is. Keep the archive alive
+ * (shared_ptr) as long as any span taken from it is used.
+ */
+class ShaderArchive {
+  enum CodeState : uint8_t { Unchecked, Intact, Corrupted };
+
+  abox::platform::MappedFile file;
+  bool                       valid = false;
+  // One per entry, index order
+  std::unique_ptr<std::atomic<CodeState>[]> codeStates;
+
+  const std::byte *bytes() const
+  {
+    return static_cast<const std::byte *>(file.data);
+  }
+
+  bool validate(const std::filesystem::path &path) const;
+
+  /** @brief Whether words match entry's hash, hashed once per entry */
+  bool isIntact(
+      const ShaderArchiveEntry &entry,
+      std::span<const uint32_t> words
+  ) const;
+
+   public:
+  explicit ShaderArchive(const std::filesystem::path &path);
+  ~ShaderArchive();
+
+  DELETE_COPY(ShaderArchive);
+  DELETE_MOVE(ShaderArchive);
+
+  [[nodiscard]] bool isValid() const { return valid; }
+
+  /** @brief Index in name order, empty when invalid */
+  [[nodiscard]] std::span<const ShaderArchiveEntry> entries() const;
+
+  /** @brief Binary search by name, null when absent */
+  [[nodiscard]] const ShaderArchiveEntry *find(std::string_view name) const;
+
+  [[nodiscard]] std::string_view name(const ShaderArchiveEntry &entry) const;
+
+  /**
+   * @brief The entry's SPIR-V in place, empty if it does not match the
+   * entry's hash
+   */
+  [[nodiscard]] std::span<const uint32_t>
+      code(const ShaderArchiveEntry &entry) const;
+
+  [[nodiscard]] std::span<const std::byte>
+      reflection(const ShaderArchiveEntry &entry) const;
+};
+
+/**
+ * @class ShaderArchiveWriter
+ * @brief Collects compiled shaders and writes them as one archive
+ *
+ * Layout: header, index, names, then the SPIR-V and reflection blobs, each
+ * aligned to 16 bytes. The file is written next to its destination and
+ * renamed into place.
+ */
+class ShaderArchiveWriter {
+  struct Pending {
+    std::string            name;
+    uint32_t               stage;
+    std::vector<uint32_t>  code;
+    std::vector<std::byte> reflection;
+  };
+  std::vector<Pending> shaders;
+
+   public:
+  /**
+   * @brief Queue a shader
+   * @return false if the name is empty or already queued
+   */
+  bool add(
+      std::string_view           name,
+      uint32_t                   stage,
+      std::span<const uint32_t>  code,
+      std::span<const std::byte> reflection = {}
+  );
+
+  [[nodiscard]] size_t size() const { return shaders.size(); }
+
+  /** @return false on any I/O error, nothing is left at path then */
+  bool write(const std::filesystem::path &path) const;
+};
+
+#endif // SHADER_ARCHIVE_HPP
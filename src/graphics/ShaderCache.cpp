@@ -0,0 +1,297 @@
+#include "ShaderCache.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::string_view ENTRY_EXTENSION      = SPIRV_EXTENSION;
+constexpr std::string_view REFLECTION_EXTENSION = ".refl";
+constexpr std::string_view TMP_MARKER           = ".tmp-";
+
+// Temporary files older than this belong to a writer that died
+constexpr auto STALE_TMP_AGE = std::chrono::minutes(10);
+
+std::atomic<uint64_t> g_tmpCounter{0};
+
+/**
+ * @brief Name unique across threads and processes sharing the directory
+ */
+fs::path temporaryPath(const fs::path &entry)
+{
+  const uint64_t unique =
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) ^
+      static_cast<uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count()
+      ) ^
+      (g_tmpCounter.fetch_add(1, std::memory_order_relaxed) << 48);
+  return fs::path(entry.string() + std::string(TMP_MARKER) +
+                  std::to_string(unique));
+}
+
+bool isValidSpirv(const abox::platform::MappedFile &file)
+{
+  // SPIR-V header is 5 words
+  if (file.size < 5 * sizeof(uint32_t) || file.size % sizeof(uint32_t) != 0) {
+    return false;
+  }
+  uint32_t magic;
+  std::memcpy(&magic, file.data, sizeof(magic));
+  return magic == SPIRV_MAGIC_NUMBER;
+}
+
+} // namespace
+
+fs::path ShaderCache::defaultDirectory()
+{
+  if (const char *env = std::getenv("ABOX_SHADER_CACHE")) {
+    return env;
+  }
+  std::error_code ec;
+  fs::path        tmp = fs::temp_directory_path(ec);
+  return (ec ? fs::path(".") : tmp) / "abox-shader-cache";
+}
+
+ShaderCache::ShaderCache(fs::path directory, uint64_t maxBytes)
+    : dir(std::move(directory))
+    , maxBytes(maxBytes)
+{
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  valid = !ec && fs::is_directory(dir, ec);
+  if (!valid) {
+    LOG_WARN("Shader") << "Shader cache disabled, cannot use directory "
+                       << dir.string() << ": " << ec.message();
+    return;
+  }
+  LOG_DEBUG("Shader") << "Shader cache at " << dir.string();
+  evict();
+}
+
+fs::path ShaderCache::entryPath(
+    const ABox::Hash128 &key,
+    std::string_view     extension
+) const
+{
+  return dir / (key.toHex() + std::string(extension));
+}
+
+std::optional<MappedSpirv> ShaderCache::load(const ABox::Hash128 &key)
+{
+  if (!valid) {
+    return std::nullopt;
+  }
+  const fs::path             path = entryPath(key, ENTRY_EXTENSION);
+  abox::platform::MappedFile file;
+  if (abox::platform::map_file_read(path.string().c_str(), file) != 0) {
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+  if (!isValidSpirv(file)) {
+    LOG_WARN("Shader") << "Removing corrupted shader cache entry "
+                       << path.string();
+    abox::platform::unmap_file(file);
+    std::error_code ec;
+    fs::remove(path, ec);
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+
+  // Recently used entries survive eviction
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  hits.fetch_add(1, std::memory_order_relaxed);
+  return MappedSpirv(file);
+}
+
+bool ShaderCache::store(
+    const ABox::Hash128      &key,
+    std::span<const uint32_t> spirv
+)
+{
+  if (!valid || spirv.empty()) {
+    return false;
+  }
+  if (!publish(
+          entryPath(key, ENTRY_EXTENSION),
+          spirv.data(),
+          spirv.size_bytes()
+      )) {
+    return false;
+  }
+  stores.fetch_add(1, std::memory_order_relaxed);
+  evictIfOverBudget();
+  return true;
+}
+
+std::optional<std::vector<std::byte>>
+    ShaderCache::loadReflection(const ABox::Hash128 &key)
+{
+  if (!valid) {
+    return std::nullopt;
+  }
+  const fs::path path = entryPath(key, REFLECTION_EXTENSION);
+  std::ifstream  in(path, std::ios::binary | std::ios::ate);
+  if (!in.is_open()) {
+    return std::nullopt;
+  }
+  std::vector<std::byte> blob(static_cast<size_t>(in.tellg()));
+  in.seekg(0);
+  in.read(
+      reinterpret_cast<char *>(blob.data()),
+      static_cast<std::streamsize>(blob.size())
+  );
+  if (!in) {
+    return std::nullopt;
+  }
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  return blob;
+}
+
+bool ShaderCache::storeReflection(
+    const ABox::Hash128       &key,
+    std::span<const std::byte> blob
+)
+{
+  if (!valid || blob.empty()) {
+    return false;
+  }
+  if (!publish(
+          entryPath(key, REFLECTION_EXTENSION),
+          blob.data(),
+          blob.size()
+      )) {
+    return false;
+  }
+  evictIfOverBudget();
+  return true;
+}
+
+bool ShaderCache::publish(const fs::path &path, const void *data, size_t size)
+{
+  const fs::path tmp = temporaryPath(path);
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(
+        static_cast<const char *>(data),
+        static_cast<std::streamsize>(size)
+    );
+    if (!out.good()) {
+      LOG_WARN("Shader") << "Failed to write shader cache entry "
+                         << tmp.string();
+      out.close();
+      std::error_code ec;
+      fs::remove(tmp, ec);
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+  if (ec) {
+    // Another writer may have published the same content first
+    std::error_code ignored;
+    fs::remove(tmp, ignored);
+    if (!fs::exists(path, ignored)) {
+      LOG_WARN("Shader") << "Failed to publish shader cache entry "
+                         << path.string() << ": " << ec.message();
+      return false;
+    }
+  }
+  // An overwritten entry is counted twice until the next scan: that only
+  // brings the scan forward
+  cachedBytes.fetch_add(size, std::memory_order_relaxed);
+  return true;
+}
+
+uint64_t ShaderCache::evict()
+{
+  if (!valid) {
+    return 0;
+  }
+  std::lock_guard lock(evictMutex);
+  return evictLocked();
+}
+
+void ShaderCache::evictIfOverBudget()
+{
+  if (cachedBytes.load(std::memory_order_relaxed) <= maxBytes) {
+    return;
+  }
+  std::lock_guard lock(evictMutex);
+  // Another writer may have evicted while this one waited
+  if (cachedBytes.load(std::memory_order_relaxed) > maxBytes) {
+    evictLocked();
+  }
+}
+
+uint64_t ShaderCache::evictLocked()
+{
+  struct Entry {
+    fs::path            path;
+    uint64_t            size;
+    fs::file_time_type  time;
+  };
+  std::vector<Entry> entries;
+  uint64_t           total   = 0;
+  uint64_t           removed = 0;
+  const auto         now     = fs::file_time_type::clock::now();
+
+  std::error_code ec;
+  for (const fs::directory_entry &e : fs::directory_iterator(dir, ec)) {
+    std::error_code entryEc;
+    if (!e.is_regular_file(entryEc)) {
+      continue;
+    }
+    const std::string  name = e.path().filename().string();
+    const uint64_t     size = e.file_size(entryEc);
+    fs::file_time_type time = e.last_write_time(entryEc);
+    if (entryEc) {
+      continue;
+    }
+    if (name.find(TMP_MARKER) != std::string::npos) {
+      if (now - time > STALE_TMP_AGE && fs::remove(e.path(), entryEc)) {
+        removed += size;
+      }
+      continue;
+    }
+    if (e.path().extension() == ENTRY_EXTENSION ||
+        e.path().extension() == REFLECTION_EXTENSION) {
+      entries.push_back({e.path(), size, time});
+      total += size;
+    }
+  }
+
+  if (total <= maxBytes) {
+    cachedBytes.store(total, std::memory_order_relaxed);
+    return removed;
+  }
+  std::sort(
+      entries.begin(),
+      entries.end(),
+      [](const Entry &a, const Entry &b) { return a.time < b.time; }
+  );
+  const uint64_t target = maxBytes / 4 * 3;
+  for (const Entry &e : entries) {
+    if (total <= target) {
+      break;
+    }
+    std::error_code removeEc;
+    if (fs::remove(e.path, removeEc)) {
+      total -= e.size;
+      removed += e.size;
+    }
+  }
+  cachedBytes.store(total, std::memory_order_relaxed);
+  LOG_DEBUG("Shader") << "Shader cache evicted " << removed << " bytes";
+  return removed;
+}
@@ -0,0 +1,165 @@
+#ifndef SHADER_CACHE_HPP
+#define SHADER_CACHE_HPP
+
+#include "Hash.hpp"
+#include "PreProcUtils.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <platform/mapped_file.hpp>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/** @brief Bump when the cache key composition or the file layout changes */
+inline constexpr uint32_t SHADER_CACHE_FORMAT_VERSION = 1;
+
+inline constexpr uint32_t SPIRV_MAGIC_NUMBER = 0x07230203;
+
+/** @brief Extension of SPIR-V binaries, cache entries and precompiled ones */
+inline constexpr const char *SPIRV_EXTENSION = ".spv";
+
+/**
+ * @class MappedSpirv
+ * @brief SPIR-V words of a cache entry, mapped read-only from disk
+ */
+class MappedSpirv {
+  abox::platform::MappedFile file;
+
+   public:
+  explicit MappedSpirv(const abox::platform::MappedFile &mapped)
+      : file(mapped)
+  {
+  }
+
+  ~MappedSpirv() { abox::platform::unmap_file(file); }
+
+  DELETE_COPY(MappedSpirv);
+
+  MappedSpirv(MappedSpirv &&other) noexcept
+      : file(other.file)
+  {
+    other.file = {};
+  }
+
+  MappedSpirv &operator=(MappedSpirv &&other) noexcept
+  {
+    if (this != &other) {
+      abox::platform::unmap_file(file);
+      file       = other.file;
+      other.file = {};
+    }
+    return *this;
+  }
+
+  [[nodiscard]] std::span<const uint32_t> code() const
+  {
+    return {static_cast<const uint32_t *>(file.data), file.size / 4};
+  }
+};
+
+/**
+ * @class ShaderCache
+ * @brief Content addressed on-disk store of compiled SPIR-V
+ *
+ * Entries are `<key>.spv` files named after the hash of everything that
+ * affects compilation (see ShaderHandler), and `<key>.refl` reflection
+ * blobs named after the hash of the SPIR-V they describe. Writers go
+ * through a temporary file renamed into place, so readers never see a
+ * partial entry and concurrent writers of the same key are harmless. A hit
+ * refreshes the entry's modification time; once the directory exceeds its
+ * budget the least recently used entries are removed. The directory is
+ * only scanned on open and when the running size total says it is over
+ * budget. Errors only ever turn into misses, the cache never throws.
+ */
+class ShaderCache {
+  std::filesystem::path dir;
+  uint64_t              maxBytes;
+  bool                  valid = false;
+  std::mutex            evictMutex;
+  // Bytes of the entries, from the last scan plus what was published since
+  std::atomic<uint64_t> cachedBytes{0};
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+  std::atomic<uint64_t> stores{0};
+
+  std::filesystem::path entryPath(
+      const ABox::Hash128 &key,
+      std::string_view     extension
+  ) const;
+
+  /** @brief Write through a temporary file renamed into place */
+  bool publish(
+      const std::filesystem::path &path,
+      const void                  *data,
+      size_t                       size
+  );
+
+  /** @brief Scan and evict, evictMutex held */
+  uint64_t evictLocked();
+
+  /** @brief Evict only if the running total is over budget */
+  void evictIfOverBudget();
+
+   public:
+  static constexpr uint64_t DEFAULT_MAX_BYTES = 64ull * 1024 * 1024;
+
+  /**
+   * @brief $ABOX_SHADER_CACHE if set, else <temp>/abox-shader-cache
+   */
+  static std::filesystem::path defaultDirectory();
+
+  explicit ShaderCache(
+      std::filesystem::path directory = defaultDirectory(),
+      uint64_t              maxBytes  = DEFAULT_MAX_BYTES
+  );
+
+  DELETE_COPY(ShaderCache);
+  DELETE_MOVE(ShaderCache);
+
+  /** @brief false if the directory could not be created */
+  [[nodiscard]] bool isValid() const { return valid; }
+
+  [[nodiscard]] const std::filesystem::path &getDirectory() const
+  {
+    return dir;
+  }
+
+  /**
+   * @brief Map the entry for key, corrupted entries are removed
+   */
+  [[nodiscard]] std::optional<MappedSpirv> load(const ABox::Hash128 &key);
+
+  /**
+   * @brief Atomically publish an entry, then enforce the size budget
+   * @return false if the entry could not be written
+   */
+  bool store(const ABox::Hash128 &key, std::span<const uint32_t> spirv);
+
+  /**
+   * @brief Serialized reflection stored next to the SPIR-V entries, see
+   * reflectionCacheKey(). Not counted in the hit/miss statistics
+   */
+  [[nodiscard]] std::optional<std::vector<std::byte>>
+      loadReflection(const ABox::Hash128 &key);
+
+  bool storeReflection(
+      const ABox::Hash128       &key,
+      std::span<const std::byte> blob
+  );
+
+  /**
+   * @brief Remove least recently used entries until the cache fits in 3/4
+   * of its budget, and leftover temporary files of crashed writers
+   * @return Bytes removed
+   */
+  uint64_t evict();
+
+  [[nodiscard]] uint64_t getHits() const { return hits.load(); }
+  [[nodiscard]] uint64_t getMisses() const { return misses.load(); }
+  [[nodiscard]] uint64_t getStores() const { return stores.load(); }
+};
+
+#endif // SHADER_CACHE_HPP
@@ -1,6 +1,11 @@
 #include "ShaderHandler.hpp"
+#include "Hash.hpp"
 #include "Logger.hpp"
+#include "ShaderArchive.hpp"
+#include "ShaderIncludes.hpp"
+#include "ShaderWatcher.hpp"
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <glslang/Public/ResourceLimits.h>
 #include <glslang/SPIRV/GlslangToSpv.h>
@@ -10,6 +15,7 @@
 #include <numeric>
 #include <spirv_reflect.h>
 #include <stdexcept>
+#include <utility>
 #include <vulkan/vulkan_core.h>
 
 // @brief anonymous namespace to declare static elements
@@ -50,6 +56,103 @@ struct ExtensionFileResult {
   }
 }
 
+/** @brief The SPIR-V words of a result, owned or mapped */
+std::span<const uint32_t> resultCode(const ShaderCompileResult &result)
+{
+  return result.backing ? result.mappedCode
+                        : std::span<const uint32_t>(result.code);
+}
+
+/** @brief A successful result as a shared ShaderDataFile named name */
+ShaderDataRef
+    makeShaderData(const std::string &name, ShaderCompileResult &&result)
+{
+  if (result.backing) {
+    return std::make_shared<const ShaderDataFile>(
+        name,
+        result.mappedCode,
+        std::move(result.backing),
+        result.stage,
+        result.platform,
+        std::move(result.reflection)
+    );
+  }
+  return std::make_shared<const ShaderDataFile>(
+      name,
+      std::move(result.code),
+      result.stage,
+      result.platform,
+      std::move(result.reflection)
+  );
+}
+
+/**
+ * @brief Fill result.reflection from the cache, or reflect the module and
+ * cache it
+ */
+void reflectResult(ShaderCompileResult &result, ShaderCache *cache)
+{
+  const std::span<const uint32_t> code = resultCode(result);
+  ABox::Hash128 key{};
+  if (cache) {
+    key = reflectionCacheKey(code);
+    if (std::optional<std::vector<std::byte>> blob =
+            cache->loadReflection(key)) {
+      result.reflection = deserializeReflection(*blob);
+      if (result.reflection) {
+        return;
+      }
+    }
+  }
+  result.reflection = reflectShader(code);
+  if (result.reflection && cache) {
+    cache->storeReflection(key, serializeReflection(*result.reflection));
+  }
+}
+
+/**
+ * @brief Map a SPIR-V binary and read its stage from the first entry point,
+ * the words are not copied
+ */
+void loadSpirvBinary(
+    const std::filesystem::path &filePath,
+    ShaderCache                 *cache,
+    ShaderCompileResult         &result
+)
+{
+  abox::platform::MappedFile file;
+  if (abox::platform::map_file_read(filePath.string().c_str(), file) != 0) {
+    result.status = VK_FILE_UNKNOWN_ERROR;
+    result.error  = "Couldn't map SPIR-V file";
+    return;
+  }
+  auto mapped = std::make_shared<const MappedSpirv>(file);
+  if (file.size < 5 * sizeof(uint32_t) || file.size % sizeof(uint32_t) != 0 ||
+      mapped->code()[0] != SPIRV_MAGIC_NUMBER) {
+    result.status = VK_FILE_NOT_A_SHADER;
+    result.error  = "Not a SPIR-V module";
+    return;
+  }
+  result.mappedCode = mapped->code();
+  result.backing    = std::move(mapped);
+
+  reflectResult(result, cache);
+  if (!result.reflection) {
+    result.status = VK_FILE_UNKNOWN_ERROR;
+    result.error  = "SPIR-V module couldn't be parsed";
+    return;
+  }
+  const VkShaderStageFlagBits stageBit = result.reflection->stage;
+  if (!StageExtentionHandler::contains(stageBit)) {
+    result.status = VK_FILE_NOT_A_SHADER;
+    result.error  = "Unsupported SPIR-V execution model";
+    return;
+  }
+  result.stage    = &*StageExtentionHandler::at(stageBit);
+  result.platform = SourcePlatform::Unknown;
+  result.status   = VK_FILE_SUCCESS;
+}
+
 [[nodiscard]] ExtensionFileResult readExtentions(std::filesystem::path path)
 {
   std::vector<std::string> extensions;
@@ -83,87 +186,65 @@ struct ExtensionFileResult {
   }
   return result;
 }
-}; // namespace
-//--------------- ShaderHandler -----------------
-[[nodiscard]] VkFileResult
-    ShaderHandler::loadShaderDataFile(const std::filesystem::path &filePath)
-{
-  if (std::filesystem::exists(filePath)) {
-    LOG_DEBUG("Shader") << "Given path found: " << filePath.string();
-    ExtensionFileResult extFileResult = readExtentions(filePath);
-    if (extFileResult.status == VK_FILE_SUCCESS) {
-      LOG_DEBUG("Shader") << "Extension(s) Loaded";
-      std::string shaderF = loadShaderFromFile(filePath);
-      LOG_DEBUG("Shader") << "Shader Loaded";
-      std::vector<uint32_t> code =
-          compileGLSLToSPIRV(shaderF, get<EShLanguage>(*extFileResult.stage));
-      LOG_DEBUG("Shader") << "Compiled total number of uint32_t: "
-                          << code.size();
-      sDatas.emplace_back(
-          filePath.filename(),
-          code,
-          extFileResult.stage,
-          extFileResult.platform
-      );
-      LOG_DEBUG("Shader") << "ShaderData added";
-      return VK_FILE_SUCCESS;
-    }
-    else {
-      LOG_WARN("Shader") << "Extension couldn't be loaded: "
-                         << filePath.string();
-      return VK_FILE_NOT_A_SHADER;
-    }
-  }
-  else {
-    LOG_ERROR("Shader") << "At given path: " << filePath.string()
-                        << " - No shader elements found: ERROR";
-    return VK_FILE_UNKNOWN_ERROR;
-  }
-}
 
-uint32_t
-    ShaderHandler::loadShaderDataFromFolder(const std::filesystem::path &dirPath
-    )
+/**
+ * @brief Cache key of a GLSL source: everything that changes the SPIR-V
+ * glslang produces for it
+ */
+ABox::Hash128 shaderCacheKey(
+    const std::string                &source,
+    EShLanguage                       stage,
+    const std::vector<ShaderInclude> &includes,
+    const SpirvOptimizerConfig       &optimizer,
+    const ShaderVariantKey           &variant
+)
 {
-  uint32_t count = 0;
-
-  if (!std::filesystem::is_directory(dirPath)) {
-    LOG_WARN("Shader") << "The path is not a directory or does not exist";
+  ABox::Hasher hasher;
+  hasher.update(SHADER_CACHE_FORMAT_VERSION);
+  hasher.update(source);
+  hasher.update(static_cast<int32_t>(stage));
+  hasher.update(static_cast<int32_t>(OPENGL_CHOSEN_VERSION));
+  hasher.update(static_cast<int32_t>(VULKAN_CHOSEN_VERSION));
+  hasher.update(static_cast<int32_t>(SPIRV_CHOSEN_VERSION));
+  // Static storage, padding bytes are zero
+  hasher.update(*GetDefaultResources());
+  for (const ShaderInclude &inc : includes) {
+    hasher.update(inc.path.generic_string());
+    hasher.update(inc.content);
   }
-
-  for (auto f : std::filesystem::directory_iterator(dirPath)) {
-    LOG_DEBUG("Shader") << " count: " << count
-                        << " filename: " << f.path().filename().string();
-    count += std::filesystem::is_regular_file(f) &&
-             loadShaderDataFile(f) == VK_FILE_SUCCESS;
-  }
-  return const_cast<uint32_t &>(count);
-}
-
-const std::string
-    ShaderHandler::loadShaderFromFile(const std::filesystem::path &shaderFile)
-{
-  std::ifstream file(shaderFile);
-  if (!file.is_open()) {
-    throw std::runtime_error(
-        std::string("Couldn't load Shader File") + shaderFile.string()
-    );
+  optimizer.hash(hasher);
+  // Base shaders keep the keys they had before variants existed
+  if (!variant.empty()) {
+    hasher.update(variant.getHash());
   }
-  return std::string(
-      (std::istreambuf_iterator<char>(file)),
-      (std::istreambuf_iterator<char>())
-  );
+  return hasher.digest();
 }
 
-const std::vector<uint32_t> ShaderHandler::compileGLSLToSPIRV(
-    const std::string &shaderCode,
-    const EShLanguage &shaderStage
+/**
+ * @brief GLSL to SPIR-V with TShader/TProgram local to the call, so workers
+ * can run it concurrently once glslang is initialized, then through the
+ * SPIR-V optimizer
+ * @param name shader name for the optimizer report
+ * @param preamble variant defines, glslang inserts them after `#version`
+ * @param errors receives the parse, link or validation log on failure
+ */
+std::vector<uint32_t> compileGlsl(
+    const std::string           &shaderCode,
+    EShLanguage                  shaderStage,
+    const std::filesystem::path &sourceDir,
+    const SpirvOptimizerConfig  &optimizer,
+    const std::string           &name,
+    const std::string           &preamble,
+    std::string                 &errors
 )
 {
   glslang::TShader                  shader(shaderStage);
   const std::array<const char *, 1> shaderStrings = {shaderCode.c_str()};
 
   shader.setStrings(shaderStrings.data(), shaderStrings.size());
+  if (!preamble.empty()) {
+    shader.setPreamble(preamble.c_str());
+  }
   shader.setEnvInput(
       glslang::EShSourceGlsl,
       shaderStage,
@@ -173,11 +254,16 @@ const std::vector<uint32_t> ShaderHandler::compileGLSLToSPIRV(
   shader.setEnvClient(glslang::EShClientVulkan, VULKAN_CHOSEN_VERSION);
   shader.setEnvTarget(glslang::EShTargetSpv, SPIRV_CHOSEN_VERSION);
 
-  if (!shader.parse(GetDefaultResources(), 100, false, EShMsgDefault)) {
-    LOG_ERROR("Shader") << "GLSL Parsing Failed for shader stage: "
-                        << shaderStage;
-    LOG_ERROR("Shader") << shader.getInfoLog() << "\n"
-                        << shader.getInfoDebugLog();
+  ShaderIncluder includer(sourceDir);
+  if (!shader.parse(
+          GetDefaultResources(),
+          100,
+          false,
+          EShMsgDefault,
+          includer
+      )) {
+    errors = std::string("GLSL Parsing Failed: ") + shader.getInfoLog() +
+             shader.getInfoDebugLog();
     return {};
   }
 
@@ -185,15 +271,16 @@ const std::vector<uint32_t> ShaderHandler::compileGLSLToSPIRV(
   program.addShader(&shader);
 
   if (!program.link(EShMsgDefault)) {
-    LOG_ERROR("Shader") << "GLSL Linking Failed: " << program.getInfoLog();
-    LOG_ERROR("Shader") << program.getInfoDebugLog();
+    errors = std::string("GLSL Linking Failed: ") + program.getInfoLog() +
+             program.getInfoDebugLog();
     return {};
   }
 
   std::vector<uint32_t>   spirv;
   glslang::TIntermediate *intermediate = program.getIntermediate(shaderStage);
   if (!intermediate) {
-    LOG_ERROR("Shader") << "Failed to get intermediate representation";
+    errors = "Failed to get intermediate representation";
+    return {};
   }
 
   glslang::SpvOptions spvOptions;
@@ -204,154 +291,754 @@ const std::vector<uint32_t> ShaderHandler::compileGLSLToSPIRV(
     LOG_DEBUG("Shader") << "Spirv Logger: " << logger.getAllMessages();
   }
 
+  if (optimizer.enabled()) {
+    SpirvOptimizeStats stats;
+    std::string        optimizerErrors;
+    if (optimizeSpirv(spirv, optimizer, &stats, &optimizerErrors)) {
+      LOG_INFO("Shader") << name << " SPIR-V " << optimizer.level << ": "
+                         << stats.wordsBefore << " -> " << stats.wordsAfter
+                         << " words in " << stats.milliseconds << " ms";
+    }
+    else if (optimizer.validate) {
+      errors = "SPIR-V validation failed: " + optimizerErrors;
+      return {};
+    }
+    else {
+      LOG_WARN("Shader") << name << " SPIR-V optimization failed, keeping "
+                         << "the unoptimized module: " << optimizerErrors;
+    }
+  }
+
+  return spirv;
+}
+
+/**
+ * @brief Result of a worker, filesystem errors it threw become a failed
+ * result for path
+ */
+ShaderCompileResult takeResult(
+    std::future<ShaderCompileResult> &future,
+    const std::filesystem::path      &path
+)
+{
+  try {
+    return future.get();
+  }
+  catch (const std::exception &e) {
+    ShaderCompileResult failed;
+    failed.path  = path;
+    failed.error = e.what();
+    return failed;
+  }
+}
+}; // namespace
+//--------------- ShaderHandler -----------------
+ShaderHandler::ShaderHandler(
+    std::initializer_list<std::filesystem::path> folderNames
+)
+{
+  if (std::filesystem::path dir = ShaderCache::defaultDirectory();
+      !dir.empty()) {
+    cache = std::make_unique<ShaderCache>(dir);
+  }
+  for (const std::filesystem::path &folder : folderNames) {
+    loadShaderDataFromFolderAsync(folder);
+  }
+}
+
+ShaderHandler::~ShaderHandler()
+{
+  LOG_DEBUG("Shader") << "Destruction of the Shader Handler";
+  watcher.reset();
+  // Workers may still be inside glslang
+  std::lock_guard lock(pendingMutex);
+  for (PendingLoad &p : pending) {
+    p.result.wait();
+  }
+  for (PendingVariant &p : pendingVariants) {
+    p.result.wait();
+  }
+  finalizeGlsLang();
+}
+
+ShaderHandler::ShaderHandler(ShaderHandler &&other) noexcept
+{
+  *this = std::move(other);
+}
+
+ShaderHandler &ShaderHandler::operator=(ShaderHandler &&other) noexcept
+{
+  if (this == &other) {
+    return *this;
+  }
+  std::scoped_lock lock(pendingMutex, other.pendingMutex);
+  // glslang is finalized once, by the handler that initialized it
+  isGlsInit       = std::exchange(other.isGlsInit, false);
+  sDatas          = std::move(other.sDatas);
+  pending         = std::move(other.pending);
+  cache           = std::move(other.cache);
+  optimizerConfig = std::move(other.optimizerConfig);
+  folders         = std::move(other.folders);
+  watcher         = std::move(other.watcher);
+  sourcePaths     = std::move(other.sourcePaths);
+  variants        = std::move(other.variants);
+  variantsByCode  = std::move(other.variantsByCode);
+  pendingVariants = std::move(other.pendingVariants);
+  return *this;
+}
+
+void ShaderHandler::setCache(std::unique_ptr<ShaderCache> newCache)
+{
+  // In flight loads and the watcher hold the old one
+  const bool watching = isWatching();
+  unwatch();
+  waitForShaders();
+  cache = std::move(newCache);
+  if (watching) {
+    watch();
+  }
+}
+
+void ShaderHandler::setOptimizerConfig(const SpirvOptimizerConfig &config)
+{
+  optimizerConfig = config;
+  if (isWatching()) {
+    watch(); // the watcher compiles with a copy
+  }
+}
+
+bool ShaderHandler::watch(std::chrono::milliseconds debounce)
+{
+  unwatch();
+  if (!initGlsLang()) {
+    LOG_ERROR("Shader") << "glslang initialization failed";
+    return false;
+  }
+  watcher = std::make_unique<ShaderWatcher>(
+      folders,
+      cache.get(),
+      optimizerConfig,
+      debounce
+  );
+  if (!watcher->isValid()) {
+    watcher.reset();
+    return false;
+  }
+  LOG_INFO("Shader") << "Watching " << folders.size()
+                     << " shader folder(s) for changes";
+  return true;
+}
+
+void ShaderHandler::unwatch() { watcher.reset(); }
+
+std::vector<std::string> ShaderHandler::applyReloads()
+{
+  if (!watcher) {
+    return {};
+  }
+  mergePending();
+  std::vector<std::string> names;
+  for (ShaderCompileResult &result : watcher->takeResults()) {
+    if (result.status != VK_FILE_SUCCESS) {
+      LOG_ERROR("Shader") << "Reload of " << result.path.string()
+                          << " failed, keeping the previous version: "
+                          << result.error;
+      continue;
+    }
+    const std::string name = result.path.filename().string();
+    auto              old  = std::find_if(
+        sDatas.begin(),
+        sDatas.end(),
+        [&name](const ShaderDataRef &a) { return a->getName() == name; }
+    );
+    // Same position in the list: pipelines see a stable shader order. Builds
+    // holding the old version keep it alive until they are done.
+    emplaceShader(old, std::move(result));
+    if (old != sDatas.end()) {
+      sDatas.erase(old);
+    }
+    dropVariants(name);
+    names.push_back(name);
+    LOG_INFO("Shader") << "Reloaded shader " << name;
+  }
+  return names;
+}
+
+bool ShaderHandler::isShaderFile(const std::filesystem::path &path)
+{
+  // Same rule as readExtentions: the outermost of the last two extensions
+  if (path.extension() == SPIRV_EXTENSION) {
+    return true;
+  }
+  std::filesystem::path filename = path.filename();
+  std::string           stageExt;
+  for (int i = 0; i < 2 && filename.has_extension(); ++i) {
+    stageExt = filename.extension().string();
+    filename = filename.stem();
+  }
+  return !stageExt.empty() && StageExtentionHandler::contains(stageExt);
+}
+
+ShaderCompileResult ShaderHandler::compileShaderFile(
+    const std::filesystem::path &filePath,
+    ShaderCache                 *cache,
+    const SpirvOptimizerConfig  &optimizer,
+    const ShaderVariantKey      &variant
+)
+{
+  ShaderCompileResult result;
+  result.path = filePath;
+  if (!std::filesystem::exists(filePath)) {
+    result.status = VK_FILE_UNKNOWN_ERROR;
+    result.error  = "No shader elements found";
+    return result;
+  }
+  if (filePath.extension() == SPIRV_EXTENSION) {
+    if (!variant.empty()) {
+      result.status = VK_FILE_UNKNOWN_ERROR;
+      result.error  = "Precompiled SPIR-V has no variants";
+      return result;
+    }
+    loadSpirvBinary(filePath, cache, result);
+    return result;
+  }
+  ExtensionFileResult extFileResult = readExtentions(filePath);
+  if (extFileResult.status != VK_FILE_SUCCESS) {
+    result.status = VK_FILE_NOT_A_SHADER;
+    return result;
+  }
+  result.stage    = extFileResult.stage;
+  result.platform = extFileResult.platform;
+
+  std::string shaderF;
+  try {
+    shaderF = loadShaderFromFile(filePath);
+  }
+  catch (const std::exception &e) {
+    result.status = VK_FILE_UNKNOWN_ERROR;
+    result.error  = e.what();
+    return result;
+  }
+  const EShLanguage stage = get<EShLanguage>(*extFileResult.stage);
+
+  ABox::Hash128 key{};
+  if (cache) {
+    key = shaderCacheKey(
+        shaderF,
+        stage,
+        collectShaderIncludes(shaderF, filePath.parent_path()),
+        optimizer,
+        variant
+    );
+    if (std::optional<MappedSpirv> hit = cache->load(key)) {
+      auto mapped       = std::make_shared<const MappedSpirv>(std::move(*hit));
+      result.mappedCode = mapped->code();
+      result.backing    = std::move(mapped);
+      LOG_DEBUG("Shader") << "Shader cache hit " << key.toHex();
+    }
+  }
+  if (!result.backing) {
+    result.code = compileGlsl(
+        shaderF,
+        stage,
+        filePath.parent_path(),
+        optimizer,
+        filePath.filename().string(),
+        variant.preamble(),
+        result.error
+    );
+    if (result.code.empty()) {
+      result.status = VK_FILE_UNKNOWN_ERROR;
+      return result;
+    }
+    if (cache) {
+      cache->store(key, result.code);
+    }
+  }
+  LOG_DEBUG("Shader") << "Compiled total number of uint32_t: "
+                      << (result.backing ? result.mappedCode.size()
+                                         : result.code.size());
+  reflectResult(result, cache);
+  result.status = VK_FILE_SUCCESS;
+  return result;
+}
+
+void ShaderHandler::mergeResult(
+    ShaderCompileResult &&result,
+    ShaderLoadReport     &report
+)
+{
+  if (result.status == VK_FILE_SUCCESS) {
+    emplaceShader(sDatas.end(), std::move(result));
+    ++report.loaded;
+    return;
+  }
+  if (result.status == VK_FILE_NOT_A_SHADER) {
+    LOG_WARN("Shader") << "Extension couldn't be loaded: "
+                       << result.path.string();
+  }
+  else {
+    LOG_ERROR("Shader") << "Failed to load shader " << result.path.string()
+                        << ": " << result.error;
+  }
+  report.failures.push_back(
+      {.path   = std::move(result.path),
+       .status = result.status,
+       .error  = std::move(result.error)}
+  );
+}
+
+void ShaderHandler::emplaceShader(
+    std::list<ShaderDataRef>::const_iterator pos,
+    ShaderCompileResult                    &&result
+)
+{
+  const std::string name = result.path.filename().string();
+  sourcePaths[name]      = result.path;
+  sDatas.insert(pos, makeShaderData(name, std::move(result)));
+}
+
+ShaderLoadReport ShaderHandler::mergePending()
+{
+  // Held while merging: a concurrent caller waits for the loads to be in
+  // sDatas, and producers wait to queue behind them
+  std::lock_guard  lock(pendingMutex);
+  ShaderLoadReport report;
+  for (PendingLoad &p : pending) {
+    mergeResult(takeResult(p.result, p.path), report);
+  }
+  pending.clear();
+  return report;
+}
+
+[[nodiscard]] VkFileResult
+    ShaderHandler::loadShaderDataFile(const std::filesystem::path &filePath)
+{
+  mergePending(); // keep sDatas in submission order
+  if (filePath.extension() != SPIRV_EXTENSION && !initGlsLang()) {
+    LOG_ERROR("Shader") << "glslang initialization failed";
+    return VK_FILE_UNKNOWN_ERROR;
+  }
+  ShaderLoadReport    report;
+  ShaderCompileResult result =
+      compileShaderFile(filePath, cache.get(), optimizerConfig);
+  const VkFileResult status = result.status;
+  mergeResult(std::move(result), report);
+  return status;
+}
+
+uint32_t ShaderHandler::loadShaderDataFromFolderAsync(
+    const std::filesystem::path &dirPath
+)
+{
+  if (std::filesystem::is_regular_file(dirPath) &&
+      dirPath.extension() == SHADER_ARCHIVE_EXTENSION) {
+    return loadShaderArchive(dirPath);
+  }
+  if (!std::filesystem::is_directory(dirPath)) {
+    LOG_WARN("Shader") << "The path is not a directory or does not exist";
+    return 0;
+  }
+  std::vector<std::filesystem::path> files;
+  for (const auto &f : std::filesystem::directory_iterator(dirPath)) {
+    if (f.is_regular_file()) {
+      files.push_back(f.path());
+    }
+  }
+  // directory_iterator order is unspecified
+  std::sort(files.begin(), files.end());
+
+  // A folder of precompiled SPIR-V never touches glslang
+  const bool needsCompiler =
+      std::any_of(files.begin(), files.end(), [](const auto &file) {
+        return file.extension() != SPIRV_EXTENSION &&
+               file.extension() != SHADER_ARCHIVE_EXTENSION;
+      });
+  if (needsCompiler && !initGlsLang()) {
+    LOG_ERROR("Shader") << "glslang initialization failed";
+    return 0;
+  }
+
+  if (std::find(folders.begin(), folders.end(), dirPath) == folders.end()) {
+    folders.push_back(dirPath);
+  }
+
+  uint32_t                   queued      = 0;
+  ShaderCache               *sharedCache = cache.get();
+  const SpirvOptimizerConfig optimizer   = optimizerConfig;
+  for (std::filesystem::path &file : files) {
+    if (file.extension() == SHADER_ARCHIVE_EXTENSION) {
+      queued += loadShaderArchive(file);
+      continue;
+    }
+    LOG_DEBUG("Shader") << "Queued: " << file.filename().string();
+    std::future<ShaderCompileResult> result =
+        ABox::ThreadPool::shared().submit([file, sharedCache, optimizer] {
+          return compileShaderFile(file, sharedCache, optimizer);
+        });
+    std::lock_guard lock(pendingMutex);
+    pending.push_back({.path = std::move(file), .result = std::move(result)});
+    ++queued;
+  }
+  return queued;
+}
+
+uint32_t ShaderHandler::loadShaderArchive(const std::filesystem::path &path)
+{
+  auto archive = std::make_shared<const ShaderArchive>(path);
+  if (!archive->isValid()) {
+    return 0;
+  }
+  for (const ShaderArchiveEntry &entry : archive->entries()) {
+    ShaderCompileResult result;
+    result.path         = path / std::string(archive->name(entry));
+    const auto stageBit = static_cast<VkShaderStageFlagBits>(entry.stage);
+    if (!StageExtentionHandler::contains(stageBit)) {
+      result.status = VK_FILE_NOT_A_SHADER;
+      result.error  = "Unknown stage in archive";
+    }
+    // The first use of the entry's code checks it against its hash
+    else if (result.mappedCode = archive->code(entry);
+             result.mappedCode.empty()) {
+      result.status = VK_FILE_UNKNOWN_ERROR;
+      result.error  = "Corrupted code in archive";
+    }
+    else {
+      result.stage   = &*StageExtentionHandler::at(stageBit);
+      result.backing = archive;
+      result.status  = VK_FILE_SUCCESS;
+      if (entry.reflectionSize != 0) {
+        result.reflection = deserializeReflection(archive->reflection(entry));
+      }
+    }
+    // Nothing to compile, queued ready so the merge order is kept
+    std::promise<ShaderCompileResult> ready;
+    std::filesystem::path             entryPath = result.path;
+    ready.set_value(std::move(result));
+    std::lock_guard lock(pendingMutex);
+    pending.push_back(
+        {.path = std::move(entryPath), .result = ready.get_future()}
+    );
+  }
+  LOG_DEBUG("Shader") << "Mapped shader archive " << path.string() << ": "
+                      << archive->entries().size() << " shader(s)";
+  return static_cast<uint32_t>(archive->entries().size());
+}
+
+uint32_t
+    ShaderHandler::loadShaderDataFromFolder(const std::filesystem::path &dirPath
+    )
+{
+  loadShaderDataFromFolderAsync(dirPath);
+  return waitForShaders().loaded;
+}
+
+bool ShaderHandler::shadersReady() const
+{
+  std::lock_guard lock(pendingMutex);
+  return std::all_of(pending.begin(), pending.end(), [](const PendingLoad &p) {
+    return p.result.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+  });
+}
+
+ShaderLoadReport ShaderHandler::waitForShaders()
+{
+  ShaderLoadReport report = mergePending();
+  mergePendingVariants(report);
+  LOG_INFO("Shader") << "-- " << sDatas.size() << " Shaders Loaded! ("
+                     << report.failures.size() << " failure(s))";
+  if (cache) {
+    LOG_INFO("Shader") << "Shader cache: " << cache->getHits() << " hit(s), "
+                       << cache->getMisses() << " miss(es)";
+  }
+  return report;
+}
+
+const std::string
+    ShaderHandler::loadShaderFromFile(const std::filesystem::path &shaderFile)
+{
+  // One sized read instead of a per character istreambuf_iterator copy
+  std::ifstream file(shaderFile, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    throw std::runtime_error(
+        std::string("Couldn't load Shader File") + shaderFile.string()
+    );
+  }
+  std::string source(static_cast<size_t>(file.tellg()), '\0');
+  file.seekg(0);
+  file.read(source.data(), static_cast<std::streamsize>(source.size()));
+  if (!file) {
+    throw std::runtime_error(
+        std::string("Couldn't read Shader File") + shaderFile.string()
+    );
+  }
+  return source;
+}
+
+const std::vector<uint32_t> ShaderHandler::compileGLSLToSPIRV(
+    const std::string           &shaderCode,
+    const EShLanguage           &shaderStage,
+    const std::filesystem::path &sourceDir,
+    const ShaderVariantKey      &variant
+)
+{
+  if (!initGlsLang()) {
+    LOG_ERROR("Shader") << "glslang initialization failed";
+    return {};
+  }
+  std::string           errors;
+  std::vector<uint32_t> spirv = compileGlsl(
+      shaderCode,
+      shaderStage,
+      sourceDir,
+      optimizerConfig,
+      "Stage " + std::to_string(shaderStage),
+      variant.preamble(),
+      errors
+  );
+  if (spirv.empty()) {
+    LOG_ERROR("Shader") << "Shader stage " << shaderStage << ": " << errors;
+  }
   return spirv;
 }
 
-std::string ShaderHandler::listAllShaders() const
+std::string ShaderHandler::listAllShaders()
 {
+  mergePending();
   return std::accumulate(
       sDatas.begin(),
       sDatas.end(),
       std::string(),
-      [](const std::string &a, const ShaderDataFile &b) {
-        return a + b.getName() + '\n';
+      [](const std::string &a, const ShaderDataRef &b) {
+        return a + b->getName() + '\n';
       }
   );
 }
 
-const ShaderDataFile *ShaderHandler::getShader(std::string name) const
+const ShaderDataFile *ShaderHandler::getShader(std::string name)
 {
-  std::list<ShaderDataFile>::const_iterator result = std::find_if(
+  return shareShader(name).get();
+}
+
+ShaderDataRef ShaderHandler::shareShader(const std::string &name)
+{
+  mergePending();
+  auto result = std::find_if(
       sDatas.cbegin(),
       sDatas.cend(),
-      [&name](const ShaderDataFile &a) -> bool { return a.getName() == name; }
+      [&name](const ShaderDataRef &a) -> bool { return a->getName() == name; }
   );
-  return result != sDatas.end() ? &(*result) : nullptr;
+  return result != sDatas.end() ? *result : nullptr;
 }
 
-[[nodiscard]] ShaderHandler::operator std::vector<VkShaderModuleCreateInfo>(
-) const
+ABox::Hash128 ShaderHandler::variantId(
+    std::string_view        shader,
+    const ShaderVariantKey &key
+)
 {
-  std::vector<VkShaderModuleCreateInfo> result;
-  result.reserve(sDatas.size());
-  for (const auto &a : sDatas) {
-    result.push_back(static_cast<VkShaderModuleCreateInfo>(a));
-  }
-  return result;
+  return ABox::Hasher().update(shader).update(key.getHash()).digest();
 }
 
-void ShaderDataFile::performReflection()
+const ShaderDataFile *ShaderHandler::getShaderVariant(
+    const std::string      &shader,
+    const ShaderVariantKey &key
+)
 {
-  SpvReflectResult result = spvReflectCreateShaderModule(
-      code.size() * sizeof(uint32_t),
-      code.data(),
-      &reflectModule
-  );
+  return shareShaderVariant(shader, key).get();
+}
 
-  if (result != SPV_REFLECT_RESULT_SUCCESS) {
-    LOG_ERROR("Shader") << "Failed to create SPIRV-Reflect shader module for "
-                        << name;
-    reflectionValid = false;
-    return;
+ShaderDataRef ShaderHandler::shareShaderVariant(
+    const std::string      &shader,
+    const ShaderVariantKey &key
+)
+{
+  if (key.empty()) {
+    return shareShader(shader);
+  }
+  const ABox::Hash128 id = variantId(shader, key);
+  if (auto known = variants.find(id); known != variants.end()) {
+    return known->second.data;
   }
 
-  reflectionValid = true;
+  ShaderLoadReport report;
+  auto             queued = std::find_if(
+      pendingVariants.begin(),
+      pendingVariants.end(),
+      [&id](const PendingVariant &p) { return p.id == id; }
+  );
+  if (queued != pendingVariants.end()) {
+    ShaderCompileResult result = takeResult(queued->result, queued->path);
+    pendingVariants.erase(queued);
+    return addVariant(id, shader, key, std::move(result), report);
+  }
 
-  // Enumerate descriptor sets
-  result = spvReflectEnumerateDescriptorSets(
-      &reflectModule,
-      &reflectionData.descriptorSetCount,
-      nullptr
+  mergePending(); // the base shader may still be loading
+  auto source = sourcePaths.find(shader);
+  if (source == sourcePaths.end()) {
+    LOG_WARN("Shader") << "No shader " << shader << " to build variant ["
+                       << key.toString() << "] from";
+    return nullptr;
+  }
+  if (!initGlsLang()) {
+    LOG_ERROR("Shader") << "glslang initialization failed";
+    return nullptr;
+  }
+  return addVariant(
+      id,
+      shader,
+      key,
+      compileShaderFile(source->second, cache.get(), optimizerConfig, key),
+      report
   );
-  if (result == SPV_REFLECT_RESULT_SUCCESS &&
-      reflectionData.descriptorSetCount > 0) {
-    reflectionData.descriptorSets.resize(reflectionData.descriptorSetCount);
-    result = spvReflectEnumerateDescriptorSets(
-        &reflectModule,
-        &reflectionData.descriptorSetCount,
-        reflectionData.descriptorSets.data()
-    );
+}
 
-    if (result == SPV_REFLECT_RESULT_SUCCESS) {
-      LOG_DEBUG("Shader") << "Shader " << name << " has "
-                          << reflectionData.descriptorSetCount
-                          << " descriptor set(s)";
-      for (uint32_t i = 0; i < reflectionData.descriptorSetCount; ++i) {
-        const SpvReflectDescriptorSet *set = reflectionData.descriptorSets[i];
-        LOG_DEBUG("Shader") << "  Set " << set->set << ": "
-                            << set->binding_count << " binding(s)";
-      }
+uint32_t ShaderHandler::prepareShaderVariants(
+    const std::string                &shader,
+    std::span<const ShaderVariantKey> keys
+)
+{
+  mergePending();
+  auto source = sourcePaths.find(shader);
+  if (source == sourcePaths.end()) {
+    LOG_WARN("Shader") << "No shader " << shader << " to build variants from";
+    return 0;
+  }
+  if (!initGlsLang()) {
+    LOG_ERROR("Shader") << "glslang initialization failed";
+    return 0;
+  }
+
+  uint32_t                   queued      = 0;
+  ShaderCache               *sharedCache = cache.get();
+  const SpirvOptimizerConfig optimizer   = optimizerConfig;
+  for (const ShaderVariantKey &key : keys) {
+    const ABox::Hash128 id = variantId(shader, key);
+    if (key.empty() || variants.contains(id) ||
+        std::any_of(
+            pendingVariants.begin(),
+            pendingVariants.end(),
+            [&id](const PendingVariant &p) { return p.id == id; }
+        )) {
+      continue;
     }
+    const std::filesystem::path path = source->second;
+    std::future<ShaderCompileResult> result = ABox::ThreadPool::shared().submit(
+        [path, sharedCache, optimizer, key] {
+          return compileShaderFile(path, sharedCache, optimizer, key);
+        }
+    );
+    pendingVariants.push_back(
+        {.id     = id,
+         .shader = shader,
+         .key    = key,
+         .path   = path,
+         .result = std::move(result)}
+    );
+    ++queued;
   }
+  LOG_DEBUG("Shader") << "Queued " << queued << " variant(s) of " << shader;
+  return queued;
+}
 
-  // Enumerate push constants
-  result = spvReflectEnumeratePushConstantBlocks(
-      &reflectModule,
-      &reflectionData.pushConstantCount,
-      nullptr
-  );
-  if (result == SPV_REFLECT_RESULT_SUCCESS &&
-      reflectionData.pushConstantCount > 0) {
-    reflectionData.pushConstants.resize(reflectionData.pushConstantCount);
-    result = spvReflectEnumeratePushConstantBlocks(
-        &reflectModule,
-        &reflectionData.pushConstantCount,
-        reflectionData.pushConstants.data()
+ShaderDataRef ShaderHandler::addVariant(
+    const ABox::Hash128    &id,
+    const std::string      &shader,
+    const ShaderVariantKey &key,
+    ShaderCompileResult   &&result,
+    ShaderLoadReport       &report
+)
+{
+  if (result.status != VK_FILE_SUCCESS) {
+    LOG_ERROR("Shader") << "Failed to compile variant [" << key.toString()
+                        << "] of " << shader << ": " << result.error;
+    report.failures.push_back(
+        {.path   = std::move(result.path),
+         .status = result.status,
+         .error  = "[" + key.toString() + "] " + result.error}
     );
+    return nullptr;
+  }
 
-    if (result == SPV_REFLECT_RESULT_SUCCESS) {
-      LOG_DEBUG("Shader") << "Shader " << name << " has "
-                          << reflectionData.pushConstantCount
-                          << " push constant block(s)";
-      for (uint32_t i = 0; i < reflectionData.pushConstantCount; ++i) {
-        const SpvReflectBlockVariable *block = reflectionData.pushConstants[i];
-        LOG_DEBUG("Shader") << "  Push constant: " << block->name
-                            << ", size: " << block->size << " bytes";
-      }
-    }
+  VariantEntry                    entry{.shader = shader, .data = nullptr};
+  const std::span<const uint32_t> code = resultCode(result);
+  const ABox::Hash128             codeHash =
+      ABox::Hasher().update(code.data(), code.size_bytes()).digest();
+  if (auto same = variantsByCode.find(codeHash);
+      same != variantsByCode.end()) {
+    entry.data = same->second.lock();
+  }
+  if (entry.data) {
+    LOG_DEBUG("Shader") << "Variant [" << key.toString() << "] of " << shader
+                        << " is identical to " << entry.data->getName();
+  }
+  else {
+    entry.data =
+        makeShaderData(shader + "[" + key.toString() + "]", std::move(result));
+    variantsByCode[codeHash] = entry.data;
   }
+  return (variants[id] = std::move(entry)).data;
+}
 
-  // Enumerate input variables
-  result = spvReflectEnumerateInputVariables(
-      &reflectModule,
-      &reflectionData.inputVariableCount,
-      nullptr
-  );
-  if (result == SPV_REFLECT_RESULT_SUCCESS &&
-      reflectionData.inputVariableCount > 0) {
-    reflectionData.inputVariables.resize(reflectionData.inputVariableCount);
-    result = spvReflectEnumerateInputVariables(
-        &reflectModule,
-        &reflectionData.inputVariableCount,
-        reflectionData.inputVariables.data()
-    );
+void ShaderHandler::mergePendingVariants(ShaderLoadReport &report)
+{
+  for (PendingVariant &p : pendingVariants) {
+    addVariant(p.id, p.shader, p.key, takeResult(p.result, p.path), report);
+  }
+  pendingVariants.clear();
+}
 
-    if (result == SPV_REFLECT_RESULT_SUCCESS) {
-      LOG_DEBUG("Shader") << "Shader " << name << " has "
-                          << reflectionData.inputVariableCount
-                          << " input variable(s)";
+void ShaderHandler::dropVariants(const std::string &shader)
+{
+  std::erase_if(variants, [&shader](const auto &v) {
+    return v.second.shader == shader;
+  });
+  // Compiled from the previous source, and workers may still run glslang
+  std::erase_if(pendingVariants, [&shader](PendingVariant &p) {
+    if (p.shader != shader) {
+      return false;
     }
-  }
+    p.result.wait();
+    return true;
+  });
+  std::erase_if(variantsByCode, [](const auto &v) {
+    return v.second.expired();
+  });
+}
 
-  // Enumerate output variables
-  result = spvReflectEnumerateOutputVariables(
-      &reflectModule,
-      &reflectionData.outputVariableCount,
-      nullptr
+size_t ShaderHandler::getVariantModuleCount() const
+{
+  return std::count_if(
+      variantsByCode.begin(),
+      variantsByCode.end(),
+      [](const auto &v) { return !v.second.expired(); }
   );
-  if (result == SPV_REFLECT_RESULT_SUCCESS &&
-      reflectionData.outputVariableCount > 0) {
-    reflectionData.outputVariables.resize(reflectionData.outputVariableCount);
-    result = spvReflectEnumerateOutputVariables(
-        &reflectModule,
-        &reflectionData.outputVariableCount,
-        reflectionData.outputVariables.data()
-    );
+}
 
-    if (result == SPV_REFLECT_RESULT_SUCCESS) {
-      LOG_DEBUG("Shader") << "Shader " << name << " has "
-                          << reflectionData.outputVariableCount
-                          << " output variable(s)";
-    }
+[[nodiscard]] ShaderHandler::operator std::vector<VkShaderModuleCreateInfo>()
+{
+  mergePending();
+  std::vector<VkShaderModuleCreateInfo> result;
+  result.reserve(sDatas.size());
+  for (const ShaderDataRef &a : sDatas) {
+    result.push_back(static_cast<VkShaderModuleCreateInfo>(*a));
   }
+  return result;
+}
+
+void ShaderDataFile::performReflection(
+    std::optional<ShaderReflectionData> reflection
+)
+{
+  if (!reflection) {
+    reflection = reflectShader(code);
+  }
+  if (!reflection) {
+    LOG_ERROR("Shader") << "Failed to create SPIRV-Reflect shader module for "
+                        << name;
+    reflectionValid = false;
+    return;
+  }
+  reflectionData  = std::move(*reflection);
+  reflectionValid = true;
 }
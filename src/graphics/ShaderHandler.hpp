@@ -4,19 +4,32 @@
 #include "Logger.hpp"
 #include "MemoryWrapper.hpp"
 #include "PreProcUtils.hpp"
+#include "ShaderCache.hpp"
+#include "ShaderReflection.hpp"
+#include "ShaderVariant.hpp"
+#include "SpirvOptimizer.hpp"
+#include "ThreadPool.hpp"
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdio>
+#include <chrono>
 #include <filesystem>
+#include <future>
 #include <glslang/MachineIndependent/Versions.h>
 #include <glslang/Public/ShaderLang.h>
 #include <iostream>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <spirv_reflect.h>
 #include <string>
 #include <tuple>
+#include <utility>
+#include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
@@ -111,61 +124,67 @@ typedef enum VkFileResult {
 
 DEFINE_VK_MEMORY_WRAPPER(VkShaderModule, ShaderModule, vkDestroyShaderModule)
 
-/**
- * @brief Structure to hold SPIRV reflection data
- */
-struct ShaderReflectionData {
-  std::vector<SpvReflectDescriptorSet *>     descriptorSets;
-  std::vector<SpvReflectBlockVariable *>     pushConstants;
-  std::vector<SpvReflectInterfaceVariable *> inputVariables;
-  std::vector<SpvReflectInterfaceVariable *> outputVariables;
-
-  uint32_t descriptorSetCount  = 0;
-  uint32_t pushConstantCount   = 0;
-  uint32_t inputVariableCount  = 0;
-  uint32_t outputVariableCount = 0;
-
-  ~ShaderReflectionData() = default;
-};
-
 /**
  * @brief class used to represent a Shader data file
- * @member data contains the file data as a vector of chars
+ * @member code SPIR-V words, owned or pointing into a mapped file
  * @member mask
  */
 class ShaderDataFile {
-  const std::string           name;  // name without extensions
-  const std::vector<uint32_t> code;  // Spirv output
-  const stageExtention *const stage; // Pipeline stage for the shader
+  const std::string                 name;      // name without extensions
+  const std::vector<uint32_t>       ownedCode; // empty when mapped
+  const std::shared_ptr<const void> backing;   // keeps mapped code alive
+  const std::span<const uint32_t>   code;      // Spirv output
+  const stageExtention *const       stage;     // Pipeline stage for the shader
   [[maybe_unused]] const SourcePlatform
       platform; // in case of recompilation ?
                 // ShaderDataFile doesn't handle allocations
-  SpvReflectShaderModule reflectModule;
-  ShaderReflectionData   reflectionData;
-  bool                   reflectionValid = false;
+  ShaderReflectionData reflectionData;
+  bool                 reflectionValid = false;
 
    public:
+  /**
+   * @param reflection_ reflected ahead (worker, cache or archive), computed
+   * here when empty
+   */
   ShaderDataFile(
-      const std::string           &name_,
-      const std::vector<uint32_t> &code_,
-      const stageExtention *const  stage_,
-      const SourcePlatform        &platform_
+      const std::string                  &name_,
+      std::vector<uint32_t>               code_,
+      const stageExtention *const         stage_,
+      const SourcePlatform               &platform_,
+      std::optional<ShaderReflectionData> reflection_ = std::nullopt
   )
       : name(name_)
-      , code(code_)
+      , ownedCode(std::move(code_))
+      , code(ownedCode)
       , stage(stage_)
       , platform(platform_)
   {
-    performReflection();
+    performReflection(std::move(reflection_));
   }
 
-  ~ShaderDataFile()
+  /**
+   * @brief Reference code in place, backing is held as long as this
+   * ShaderDataFile lives (a MappedSpirv for instance)
+   */
+  ShaderDataFile(
+      const std::string                  &name_,
+      std::span<const uint32_t>           code_,
+      std::shared_ptr<const void>         backing_,
+      const stageExtention *const         stage_,
+      const SourcePlatform               &platform_,
+      std::optional<ShaderReflectionData> reflection_ = std::nullopt
+  )
+      : name(name_)
+      , backing(std::move(backing_))
+      , code(code_)
+      , stage(stage_)
+      , platform(platform_)
   {
-    if (reflectionValid) {
-      spvReflectDestroyShaderModule(&reflectModule);
-    }
+    performReflection(std::move(reflection_));
   }
 
+  ~ShaderDataFile() = default;
+
   inline operator VkShaderModuleCreateInfo() const
   {
     return {
@@ -183,8 +202,21 @@ class ShaderDataFile {
 
   std::string getName() const { return name; }
 
-  [[nodiscard]] inline VkPipelineShaderStageCreateInfo
-      getPSSCI(VkShaderModule shm) const
+  [[nodiscard]] std::span<const uint32_t> getCode() const { return code; }
+
+  [[nodiscard]] VkShaderStageFlagBits getStage() const
+  {
+    return std::get<VkShaderStageFlagBits>(*stage);
+  }
+
+  /**
+   * @param specialization constant values, must outlive the pipeline
+   * creation call; null keeps the defaults baked in the module
+   */
+  [[nodiscard]] inline VkPipelineShaderStageCreateInfo getPSSCI(
+      VkShaderModule              shm,
+      const VkSpecializationInfo *specialization = nullptr
+  ) const
   {
     return {
         .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -193,7 +225,7 @@ class ShaderDataFile {
         .stage  = std::get<VkShaderStageFlagBits>(*stage),
         .module = shm,
         .pName  = MAIN_ENTRY_POINT,
-        .pSpecializationInfo = nullptr
+        .pSpecializationInfo = specialization
     };
   }
 
@@ -202,26 +234,112 @@ class ShaderDataFile {
     return reflectionData;
   }
   bool isReflectionValid() const { return reflectionValid; }
-  const SpvReflectShaderModule &getReflectModule() const
+
+   private:
+  void performReflection(std::optional<ShaderReflectionData> reflection);
+};
+
+/**
+ * @brief Shared ownership of a ShaderDataFile: a reload replacing it in the
+ * ShaderHandler does not free it under a pipeline still being built
+ */
+using ShaderDataRef = std::shared_ptr<const ShaderDataFile>;
+
+struct ShaderDataDeref {
+  const ShaderDataFile &operator()(const ShaderDataRef &shader) const noexcept
   {
-    return reflectModule;
+    return *shader;
   }
+};
 
-   private:
-  void performReflection();
+/** @brief The ShaderDataFiles of a ShaderHandler, see getShaderHandlers */
+using ShaderDataView = std::ranges::transform_view<
+    std::ranges::ref_view<const std::list<ShaderDataRef>>,
+    ShaderDataDeref>;
+
+/**
+ * @brief Outcome of compiling one shader file, produced off the owner thread
+ * and turned into a ShaderDataFile when merged
+ */
+struct ShaderCompileResult {
+  std::filesystem::path               path;
+  VkFileResult                        status = VK_FILE_UNKNOWN_ERROR;
+  std::vector<uint32_t>               code;
+  std::span<const uint32_t>           mappedCode; // replaces code when backed
+  std::shared_ptr<const void>         backing;    // owner of mappedCode
+  std::optional<ShaderReflectionData> reflection; // reflected on the worker
+  const stageExtention               *stage    = nullptr;
+  SourcePlatform                      platform = SourcePlatform::Unknown;
+  std::string error; // compiler log when status is not success
+};
+
+/**
+ * @brief A shader file that failed to load, see ShaderLoadReport
+ */
+struct ShaderLoadFailure {
+  std::filesystem::path path;
+  VkFileResult          status;
+  std::string           error;
 };
 
+/**
+ * @brief Result of ShaderHandler::waitForShaders
+ */
+struct ShaderLoadReport {
+  uint32_t                       loaded = 0;
+  std::vector<ShaderLoadFailure> failures;
+};
+
+class ShaderWatcher;
+
 /**
  * @brief Shader Handler is a class that will load all shaders from a given
  * path
+ *
+ * Folder loads compile on ABox::ThreadPool::shared(). Results are merged
+ * into sDatas in sorted path order, so the list does not depend on
+ * scheduling. Accessors wait for pending loads first; the queue is guarded
+ * by pendingMutex.
  * @member sDatas vector of Shaders datas
  */
 class ShaderHandler {
-  bool                      isGlsInit = false;
-  std::list<ShaderDataFile> sDatas;
+  struct PendingLoad {
+    std::filesystem::path            path;
+    std::future<ShaderCompileResult> result;
+  };
+
+  struct VariantEntry {
+    std::string   shader; // base shader name
+    ShaderDataRef data;
+  };
+
+  struct PendingVariant {
+    ABox::Hash128                    id; // see variantId()
+    std::string                      shader;
+    ShaderVariantKey                 key;
+    std::filesystem::path            path; // of the base shader
+    std::future<ShaderCompileResult> result;
+  };
+
+  bool                               isGlsInit = false;
+  std::list<ShaderDataRef>           sDatas;
+  std::vector<PendingLoad>           pending; // in submission order
+  mutable std::mutex                 pendingMutex;
+  std::unique_ptr<ShaderCache>       cache; // null when disabled
+  SpirvOptimizerConfig               optimizerConfig =
+      SpirvOptimizerConfig::buildDefault();
+  std::vector<std::filesystem::path> folders; // loaded so far, for watch()
+  std::unique_ptr<ShaderWatcher>     watcher; // null unless watching
+  std::unordered_map<std::string, std::filesystem::path>
+      sourcePaths; // of the merged shaders, variants compile from them
+  std::unordered_map<ABox::Hash128, VariantEntry> variants; // by variantId()
+  std::unordered_map<ABox::Hash128, std::weak_ptr<const ShaderDataFile>>
+      variantsByCode; // identical SPIR-V is shared
+  std::vector<PendingVariant> pendingVariants;
 
   /**
-   * @brief function to initialize gls
+   * @brief function to initialize gls, done once on the owner thread before
+   * any compilation is dispatched
    * @return true if GlsInit is already init or init succeded else false
    */
   inline bool initGlsLang()
@@ -238,6 +356,45 @@ class ShaderHandler {
     }
   }
 
+  /**
+   * @brief Wait for the pending loads and move them into sDatas, in
+   * submission order, holding pendingMutex
+   */
+  ShaderLoadReport mergePending();
+
+  /** @brief Append a compiled shader to sDatas, log the failure otherwise */
+  void mergeResult(ShaderCompileResult &&result, ShaderLoadReport &report);
+
+  /** @brief Insert a successful result before pos */
+  void emplaceShader(
+      std::list<ShaderDataRef>::const_iterator pos,
+      ShaderCompileResult                    &&result
+  );
+
+  /** @brief Lookup key of a variant: base name and define set */
+  static ABox::Hash128
+      variantId(std::string_view shader, const ShaderVariantKey &key);
+
+  /**
+   * @brief Register a compiled variant under id, sharing the module of an
+   * identical one when there is. A failure is reported and not registered,
+   * so the variant compiles again when next requested
+   * @return null on failure
+   */
+  ShaderDataRef addVariant(
+      const ABox::Hash128    &id,
+      const std::string      &shader,
+      const ShaderVariantKey &key,
+      ShaderCompileResult   &&result,
+      ShaderLoadReport       &report
+  );
+
+  /** @brief Wait for the queued variants and register them */
+  void mergePendingVariants(ShaderLoadReport &report);
+
+  /** @brief Forget the variants of a shader, they recompile on demand */
+  void dropVariants(const std::string &shader);
+
    public:
   ShaderHandler()
       : ShaderHandler({})
@@ -249,39 +406,90 @@ class ShaderHandler {
   {
   }
 
-  ShaderHandler(std::initializer_list<std::filesystem::path> folderNames)
-  {
-    initGlsLang();
-    for (const std::filesystem::path &folder : folderNames) {
-      loadShaderDataFromFolder(folder);
-    }
-    LOG_INFO("Shader") << "-- " << sDatas.size() << " Shaders Loaded!";
-  }
+  /**
+   * @brief Start loading every shader of the folders in the background,
+   * through the SPIR-V cache at ShaderCache::defaultDirectory() (disabled by
+   * ABOX_SHADER_CACHE="")
+   */
+  ShaderHandler(std::initializer_list<std::filesystem::path> folderNames);
 
-  ~ShaderHandler()
-  {
-    LOG_DEBUG("Shader") << "Destruction of the Shader Handler";
-    finalizeGlsLang();
-  }
+  ~ShaderHandler();
 
   ShaderHandler(const ShaderHandler &other
   )          = delete; // no Copy -> ShaderDataFile are unique
   ShaderHandler &operator=(const ShaderHandler &other
   ) noexcept = delete; // no Copy
-  ShaderHandler(ShaderHandler &&other)                     = default;
-  ShaderHandler &operator=(ShaderHandler &&other) noexcept = default;
+  ShaderHandler(ShaderHandler &&other) noexcept;
+  ShaderHandler &operator=(ShaderHandler &&other) noexcept;
   /**
-   * @brief load data from given shader folder with expected extensions
+   * @brief load data from given shader folder with expected extensions,
+   * compiling in parallel and waiting for the result
    * @param filesystem::path the directory to load from
    * @return uint16_t the number of loaded files into the vector
    */
   uint32_t loadShaderDataFromFolder(const std::filesystem::path &dirPath);
 
+  /**
+   * @brief Queue the compilation of every regular file of the folder.
+   * Shader archives (`.absa`), given directly or found in the folder, are
+   * expanded in place
+   * @return number of shaders queued
+   */
+  uint32_t loadShaderDataFromFolderAsync(const std::filesystem::path &dirPath);
+
+  /**
+   * @brief Map a shader archive written by ShaderArchiveWriter (see
+   * abox-shaderpack), its shaders reference the mapping in place
+   * @return number of shaders queued, 0 if the archive is invalid
+   */
+  uint32_t loadShaderArchive(const std::filesystem::path &path);
+
+  /**
+   * @brief true once every queued file has finished compiling, never blocks
+   */
+  [[nodiscard]] bool shadersReady() const;
+
+  /**
+   * @brief Wait for the queued files and variants and merge them, failures
+   * are logged and listed per file
+   */
+  ShaderLoadReport waitForShaders();
+
+  /**
+   * @brief Recompile the shaders of the loaded folders in the background
+   * whenever they or their includes change on disk (inotify on Linux)
+   * @param debounce quiet time after the last event before rebuilding
+   * @return false if change notifications are unavailable
+   */
+  bool watch(
+      std::chrono::milliseconds debounce = std::chrono::milliseconds(150)
+  );
+
+  void unwatch();
+
+  [[nodiscard]] bool isWatching() const { return watcher != nullptr; }
+
+  /**
+   * @brief Swap in the shaders recompiled by watch() since the last call.
+   * Call between frames, then rebuild the pipelines using them. A shader
+   * that fails to compile keeps its previous version.
+   * @return Names of the replaced or added shaders
+   */
+  std::vector<std::string> applyReloads();
+
+  /**
+   * @brief true if the file name carries a stage extension, the way
+   * loadShaderDataFile reads it (`name.vert`, `name.vert.glsl`), or is a
+   * SPIR-V binary (`name.spv`)
+   */
+  [[nodiscard]] static bool isShaderFile(const std::filesystem::path &path);
+
   /**
    * @brief
    * @return std::string
    */
-  const std::string loadShaderFromFile(const std::filesystem::path &shaderFile);
+  static const std::string
+      loadShaderFromFile(const std::filesystem::path &shaderFile);
 
   /**
    * @brief load a shader from a file to a std::string
@@ -291,26 +499,108 @@ class ShaderHandler {
   [[nodiscard]] VkFileResult
       loadShaderDataFile(const std::filesystem::path &filePath);
 
+  /**
+   * @brief Read, look up in the cache and compile one file. Thread safe as
+   * long as glslang is initialized, touches no ShaderHandler state.
+   * `.spv` binaries are mapped as is, their stage is read from the entry
+   * point, glslang is not involved.
+   * @param cache may be null
+   * @param variant defines injected before the source, part of the cache
+   * key; binaries have no variants
+   */
+  [[nodiscard]] static ShaderCompileResult compileShaderFile(
+      const std::filesystem::path &filePath,
+      ShaderCache                 *cache,
+      const SpirvOptimizerConfig  &optimizer,
+      const ShaderVariantKey      &variant = {}
+  );
+
   /**
    * @brief Compile a GLSL Shader to Spriv
+   * @param sourceDir directory `#include "..."` is resolved from
+   * @param variant defines injected before the source
    * @return a vector of compiled binary data representing the Spriv
    * executable
    */
   const std::vector<uint32_t> compileGLSLToSPIRV(
-      const std::string &shaderCode,
-      const EShLanguage &shaderStage
+      const std::string           &shaderCode,
+      const EShLanguage           &shaderStage,
+      const std::filesystem::path &sourceDir = {},
+      const ShaderVariantKey      &variant   = {}
   );
 
-  std::string listAllShaders() const;
+  /**
+   * @brief Permutation of a loaded GLSL shader, compiled on the calling
+   * thread the first time it is requested unless prepareShaderVariants()
+   * queued it. Lookups are a hash map access; an empty key returns the
+   * base shader. Variants with identical SPIR-V share one ShaderDataFile.
+   * A hot reload of the base shader drops its variants.
+   * @return null if the shader is unknown or the variant failed to compile
+   * (failures are not cached, the next request compiles again), else valid
+   * until that reload; shareShaderVariant() keeps it alive past it
+   */
+  const ShaderDataFile *
+      getShaderVariant(const std::string &shader, const ShaderVariantKey &key);
+
+  /** @brief Same as getShaderVariant, shared, see shareShader */
+  ShaderDataRef shareShaderVariant(
+      const std::string      &shader,
+      const ShaderVariantKey &key
+  );
+
+  /**
+   * @brief Compile variants ahead of time on the shared thread pool, they
+   * are merged by the next getShaderVariant() or waitForShaders()
+   * @return number of variants queued, known and pending ones are skipped
+   */
+  uint32_t prepareShaderVariants(
+      const std::string                  &shader,
+      std::span<const ShaderVariantKey> keys
+  );
+
+  /** @brief Distinct compiled variant modules currently held */
+  [[nodiscard]] size_t getVariantModuleCount() const;
+
+  /**
+   * @brief Replace the SPIR-V cache used by the next loads, nullptr
+   * disables it
+   */
+  void setCache(std::unique_ptr<ShaderCache> newCache);
+
+  ShaderCache *getCache() const { return cache.get(); }
+
+  /**
+   * @brief SPIR-V post processing of the next compilations, defaults to
+   * SpirvOptimizerConfig::buildDefault()
+   */
+  void setOptimizerConfig(const SpirvOptimizerConfig &config);
 
-  const ShaderDataFile *getShader(std::string name) const;
+  [[nodiscard]] const SpirvOptimizerConfig &getOptimizerConfig() const
+  {
+    return optimizerConfig;
+  }
+
+  std::string listAllShaders();
+
+  /**
+   * @brief Loaded shader of that name, valid until a reload replaces it
+   * @return null if unknown
+   */
+  const ShaderDataFile *getShader(std::string name);
+
+  /**
+   * @brief Same as getShader, shared: what PipelineDescription holds so the
+   * shader outlives a reload while a pipeline builds from it
+   */
+  ShaderDataRef shareShader(const std::string &name);
 
-  [[nodiscard]] explicit operator std::vector<VkShaderModuleCreateInfo>() const;
+  [[nodiscard]] explicit operator std::vector<VkShaderModuleCreateInfo>();
 
-  inline const std::list<ShaderDataFile> &getShaderHandlers() const
+  inline ShaderDataView getShaderHandlers()
   {
+    mergePending();
     LOG_DEBUG("Shader") << " Loading sDatas - Size: " << sDatas.size();
-    return sDatas;
+    return ShaderDataView(std::as_const(sDatas), ShaderDataDeref{});
   }
 };
 
@@ -0,0 +1,244 @@
+#include "ShaderIncludes.hpp"
+#include "Logger.hpp"
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool readFile(const fs::path &path, std::string &out)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::ostringstream ss;
+  ss << file.rdbuf();
+  out = ss.str();
+  return true;
+}
+
+/** @brief Header name of an `#include` line and whether it is `"x"` */
+struct IncludeDirective {
+  std::string headerName; // empty if the line is no include
+  bool        local = true;
+};
+
+IncludeDirective includeDirective(std::string_view line)
+{
+  size_t i = line.find_first_not_of(" \t");
+  if (i == std::string_view::npos || line[i] != '#') {
+    return {};
+  }
+  i = line.find_first_not_of(" \t", i + 1);
+  if (i == std::string_view::npos || line.substr(i, 7) != "include") {
+    return {};
+  }
+  i = line.find_first_not_of(" \t", i + 7);
+  if (i == std::string_view::npos || (line[i] != '"' && line[i] != '<')) {
+    return {};
+  }
+  const bool   local = line[i] == '"';
+  const size_t end   = line.find(local ? '"' : '>', i + 1);
+  if (end == std::string_view::npos) {
+    return {};
+  }
+  return {.headerName = std::string(line.substr(i + 1, end - i - 1)),
+          .local      = local};
+}
+
+} // namespace
+
+fs::path resolveShaderInclude(
+    const std::string           &headerName,
+    bool                         local,
+    const fs::path              &includerDir,
+    const fs::path              &sourceDir,
+    const std::vector<fs::path> &includeDirs
+)
+{
+  std::error_code ec;
+  fs::path        first = (local ? includerDir : sourceDir) / headerName;
+  if (fs::is_regular_file(first, ec)) {
+    return first.lexically_normal();
+  }
+  for (const fs::path &dir : includeDirs) {
+    fs::path candidate = dir / headerName;
+    if (fs::is_regular_file(candidate, ec)) {
+      return candidate.lexically_normal();
+    }
+  }
+  return {};
+}
+
+std::vector<ShaderInclude> collectShaderIncludes(
+    const std::string            &source,
+    const fs::path               &sourceDir,
+    const std::vector<fs::path> &includeDirs
+)
+{
+  std::vector<ShaderInclude> result;
+  std::set<fs::path>         seen;
+
+  // Depth first over (text, directory of the file holding it)
+  std::vector<std::pair<std::string, fs::path>> pending{{source, sourceDir}};
+  while (!pending.empty()) {
+    auto [text, dir] = std::move(pending.back());
+    pending.pop_back();
+
+    std::istringstream lines(text);
+    std::string        line;
+    while (std::getline(lines, line)) {
+      const IncludeDirective directive = includeDirective(line);
+      if (directive.headerName.empty()) {
+        continue;
+      }
+      fs::path path = resolveShaderInclude(
+          directive.headerName,
+          directive.local,
+          dir,
+          sourceDir,
+          includeDirs
+      );
+      if (path.empty()) {
+        LOG_DEBUG("Shader") << "Unresolved include: "
+                            << directive.headerName;
+        continue;
+      }
+      if (!seen.insert(path).second) {
+        continue;
+      }
+      ShaderInclude inc{.path = path, .content = {}};
+      if (readFile(path, inc.content)) {
+        pending.emplace_back(inc.content, path.parent_path());
+        result.push_back(std::move(inc));
+      }
+    }
+  }
+  return result;
+}
+
+void ShaderDependencyGraph::setIncludes(
+    const fs::path                   &shader,
+    const std::vector<ShaderInclude> &includes
+)
+{
+  const fs::path key = shader.lexically_normal();
+  remove(key);
+  std::set<fs::path> &deps = includesOf[key];
+  for (const ShaderInclude &inc : includes) {
+    const fs::path dep = inc.path.lexically_normal();
+    deps.insert(dep);
+    dependentsOf[dep].insert(key);
+  }
+}
+
+void ShaderDependencyGraph::remove(const fs::path &shader)
+{
+  auto it = includesOf.find(shader.lexically_normal());
+  if (it == includesOf.end()) {
+    return;
+  }
+  for (const fs::path &dep : it->second) {
+    auto users = dependentsOf.find(dep);
+    users->second.erase(it->first);
+    if (users->second.empty()) {
+      dependentsOf.erase(users);
+    }
+  }
+  includesOf.erase(it);
+}
+
+bool ShaderDependencyGraph::isShader(const fs::path &path) const
+{
+  return includesOf.contains(path.lexically_normal());
+}
+
+std::set<fs::path>
+    ShaderDependencyGraph::affected(const std::set<fs::path> &changed) const
+{
+  // collectShaderIncludes already lists transitive includes per shader, so
+  // one lookup per changed file is enough
+  std::set<fs::path> result;
+  for (const fs::path &path : changed) {
+    const fs::path key = path.lexically_normal();
+    if (includesOf.contains(key)) {
+      result.insert(key);
+    }
+    if (auto users = dependentsOf.find(key); users != dependentsOf.end()) {
+      result.insert(users->second.begin(), users->second.end());
+    }
+  }
+  return result;
+}
+
+std::set<fs::path> ShaderDependencyGraph::directories() const
+{
+  std::set<fs::path> result;
+  for (const auto &[shader, deps] : includesOf) {
+    result.insert(shader.parent_path());
+    for (const fs::path &dep : deps) {
+      result.insert(dep.parent_path());
+    }
+  }
+  return result;
+}
+
+ShaderIncluder::IncludeResult *ShaderIncluder::include(
+    const char *headerName,
+    const char *includerName,
+    bool        localFirst
+)
+{
+  // Nested includers are named by the resolved path returned below
+  const fs::path includerDir = (includerName && *includerName)
+                                   ? fs::path(includerName).parent_path()
+                                   : sourceDir;
+  const fs::path path = resolveShaderInclude(
+      headerName,
+      localFirst,
+      includerDir,
+      sourceDir,
+      includeDirs
+  );
+
+  auto *content = new std::string();
+  if (path.empty() || !readFile(path, *content)) {
+    delete content;
+    return nullptr; // glslang reports the failed include
+  }
+  return new IncludeResult(
+      path.string(),
+      content->data(),
+      content->size(),
+      content
+  );
+}
+
+ShaderIncluder::IncludeResult *ShaderIncluder::includeLocal(
+    const char *headerName,
+    const char *includerName,
+    size_t /*inclusionDepth*/
+)
+{
+  return include(headerName, includerName, true);
+}
+
+ShaderIncluder::IncludeResult *ShaderIncluder::includeSystem(
+    const char *headerName,
+    const char *includerName,
+    size_t /*inclusionDepth*/
+)
+{
+  return include(headerName, includerName, false);
+}
+
+void ShaderIncluder::releaseInclude(IncludeResult *result)
+{
+  if (result) {
+    delete static_cast<std::string *>(result->userData);
+    delete result;
+  }
+}
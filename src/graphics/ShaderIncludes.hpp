@@ -0,0 +1,122 @@
+#ifndef SHADER_INCLUDES_HPP
+#define SHADER_INCLUDES_HPP
+
+#include <filesystem>
+#include <glslang/Public/ShaderLang.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A file pulled in by `#include`, resolved on disk
+ */
+struct ShaderInclude {
+  std::filesystem::path path;
+  std::string           content;
+};
+
+/**
+ * @brief Resolve an include name, for both ShaderIncluder and
+ * collectShaderIncludes: `"x"` relative to the including file first, `<x>`
+ * relative to the shader first, then relative to the include directories
+ * @param local `"x"` rather than `<x>`
+ * @param includerDir directory of the file holding the directive
+ * @param sourceDir directory of the shader being compiled
+ * @return empty path if not found
+ */
+std::filesystem::path resolveShaderInclude(
+    const std::string                        &headerName,
+    bool                                      local,
+    const std::filesystem::path              &includerDir,
+    const std::filesystem::path              &sourceDir,
+    const std::vector<std::filesystem::path> &includeDirs
+);
+
+/**
+ * @brief Every file reachable through `#include` directives from source,
+ * each listed once in discovery order
+ *
+ * Textual scan, directives in inactive `#if` branches are followed too:
+ * this is meant for cache keys and dependency tracking, where a superset is
+ * safe.
+ */
+std::vector<ShaderInclude> collectShaderIncludes(
+    const std::string                        &source,
+    const std::filesystem::path              &sourceDir,
+    const std::vector<std::filesystem::path> &includeDirs = {}
+);
+
+/**
+ * @class ShaderDependencyGraph
+ * @brief Which shaders pull in which files, to find what a file change
+ * invalidates. Paths are compared after lexically_normal().
+ */
+class ShaderDependencyGraph {
+  std::map<std::filesystem::path, std::set<std::filesystem::path>> includesOf;
+  std::map<std::filesystem::path, std::set<std::filesystem::path>>
+      dependentsOf;
+
+   public:
+  /** @brief Record (or replace) the includes of a shader */
+  void setIncludes(
+      const std::filesystem::path      &shader,
+      const std::vector<ShaderInclude> &includes
+  );
+
+  void remove(const std::filesystem::path &shader);
+
+  [[nodiscard]] bool isShader(const std::filesystem::path &path) const;
+
+  /**
+   * @brief Shaders to rebuild: the changed ones that are known shaders plus
+   * every shader including a changed file, directly or not
+   */
+  [[nodiscard]] std::set<std::filesystem::path>
+      affected(const std::set<std::filesystem::path> &changed) const;
+
+  /** @brief Directories holding a shader or one of its includes */
+  [[nodiscard]] std::set<std::filesystem::path> directories() const;
+};
+
+/**
+ * @class ShaderIncluder
+ * @brief glslang includer for GL_GOOGLE_include_directive, finding files
+ * with resolveShaderInclude like collectShaderIncludes
+ */
+class ShaderIncluder : public glslang::TShader::Includer {
+  std::filesystem::path              sourceDir;
+  std::vector<std::filesystem::path> includeDirs;
+
+  IncludeResult *include(
+      const char *headerName,
+      const char *includerName,
+      bool        localFirst
+  );
+
+   public:
+  explicit ShaderIncluder(
+      std::filesystem::path              sourceDir,
+      std::vector<std::filesystem::path> includeDirs = {}
+  )
+      : sourceDir(std::move(sourceDir))
+      , includeDirs(std::move(includeDirs))
+  {
+  }
+
+  IncludeResult *includeLocal(
+      const char *headerName,
+      const char *includerName,
+      size_t      inclusionDepth
+  ) override;
+
+  IncludeResult *includeSystem(
+      const char *headerName,
+      const char *includerName,
+      size_t      inclusionDepth
+  ) override;
+
+  void releaseInclude(IncludeResult *result) override;
+};
+
+#endif // SHADER_INCLUDES_HPP
@@ -0,0 +1,415 @@
+#include "ShaderReflection.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace {
+
+/** @brief "ABRF" read as a little endian word */
+constexpr uint32_t REFLECTION_MAGIC = 0x46524241;
+
+struct ReflectionBlobHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t stage;
+  uint32_t bindingCount;
+  uint32_t pushConstantCount;
+  uint32_t inputCount;
+  uint32_t outputCount;
+  uint32_t specializationCount;
+  uint32_t namesSize;
+};
+
+// SPIR-V opcodes and decorations read by reflectSpecializationConstants
+constexpr uint32_t SPIRV_HEADER_WORDS     = 5;
+constexpr uint32_t OP_NAME                = 5;
+constexpr uint32_t OP_TYPE_BOOL           = 20;
+constexpr uint32_t OP_TYPE_INT            = 21;
+constexpr uint32_t OP_TYPE_FLOAT          = 22;
+constexpr uint32_t OP_SPEC_CONSTANT_TRUE  = 48;
+constexpr uint32_t OP_SPEC_CONSTANT_FALSE = 49;
+constexpr uint32_t OP_SPEC_CONSTANT       = 50;
+constexpr uint32_t OP_DECORATE            = 71;
+constexpr uint32_t DECORATION_SPEC_ID     = 1;
+
+/**
+ * @brief Two call enumeration of SPIRV-Reflect, empty on failure
+ */
+template <typename T, typename F>
+std::vector<T *> enumerate(const SpvReflectShaderModule &module, F function)
+{
+  uint32_t count = 0;
+  if (function(&module, &count, nullptr) != SPV_REFLECT_RESULT_SUCCESS ||
+      count == 0) {
+    return {};
+  }
+  std::vector<T *> items(count);
+  if (function(&module, &count, items.data()) != SPV_REFLECT_RESULT_SUCCESS) {
+    return {};
+  }
+  return items;
+}
+
+void appendInterface(
+    const std::vector<SpvReflectInterfaceVariable *> &variables,
+    std::vector<ReflectedInterfaceVariable>          &out,
+    std::string                                      &names
+)
+{
+  out.reserve(variables.size());
+  for (const SpvReflectInterfaceVariable *var : variables) {
+    const std::string_view name = var->name ? var->name : "";
+    out.push_back(
+        {.location   = var->location,
+         .format     = var->format,
+         .builtIn    = var->built_in,
+         .nameOffset = static_cast<uint32_t>(names.size()),
+         .nameSize   = static_cast<uint32_t>(name.size())}
+    );
+    names += name;
+  }
+}
+
+template <typename T>
+void put(std::vector<std::byte> &blob, const std::vector<T> &items)
+{
+  const auto *bytes = reinterpret_cast<const std::byte *>(items.data());
+  blob.insert(blob.end(), bytes, bytes + items.size() * sizeof(T));
+}
+
+template <typename T>
+bool take(std::span<const std::byte> &blob, uint32_t count, std::vector<T> &out)
+{
+  const size_t size = size_t(count) * sizeof(T);
+  if (blob.size() < size) {
+    return false;
+  }
+  out.resize(count);
+  if (size != 0) {
+    std::memcpy(out.data(), blob.data(), size);
+  }
+  blob = blob.subspan(size);
+  return true;
+}
+
+/** @brief Literal string operand, nul terminated within the words */
+std::string_view literalString(std::span<const uint32_t> words)
+{
+  const auto *chars = reinterpret_cast<const char *>(words.data());
+  return std::string_view(chars, strnlen(chars, words.size_bytes()));
+}
+
+} // namespace
+
+const ReflectedSpecializationConstant *
+    ShaderReflectionData::findSpecializationConstant(uint32_t constantId) const
+{
+  auto it = std::lower_bound(
+      specializationConstants.begin(),
+      specializationConstants.end(),
+      constantId,
+      [](const ReflectedSpecializationConstant &c, uint32_t id) {
+        return c.constantId < id;
+      }
+  );
+  return it != specializationConstants.end() && it->constantId == constantId
+             ? &*it
+             : nullptr;
+}
+
+std::vector<ReflectedSpecializationConstant> reflectSpecializationConstants(
+    std::span<const uint32_t> code,
+    std::string              &names
+)
+{
+  struct ScalarType {
+    SpecializationKind kind;
+    uint32_t           size;
+  };
+  struct SpecConstant {
+    uint32_t id;
+    uint32_t type;
+    uint64_t value;
+  };
+  std::map<uint32_t, ScalarType>       types;
+  std::map<uint32_t, uint32_t>         specIds; // result id -> constant_id
+  std::map<uint32_t, std::string_view> idNames;
+  std::vector<SpecConstant>            constants;
+
+  if (code.size() < SPIRV_HEADER_WORDS) {
+    return {};
+  }
+  for (size_t at = SPIRV_HEADER_WORDS; at < code.size();) {
+    const uint32_t wordCount = code[at] >> 16;
+    const uint32_t opcode    = code[at] & 0xFFFF;
+    if (wordCount == 0 || at + wordCount > code.size()) {
+      return {};
+    }
+    const std::span<const uint32_t> op = code.subspan(at + 1, wordCount - 1);
+    at += wordCount;
+
+    switch (opcode) {
+      case OP_NAME:
+        if (op.size() >= 2) {
+          idNames[op[0]] = literalString(op.subspan(1));
+        }
+        break;
+      case OP_DECORATE:
+        if (op.size() >= 3 && op[1] == DECORATION_SPEC_ID) {
+          specIds[op[0]] = op[2];
+        }
+        break;
+      case OP_TYPE_BOOL:
+        if (op.size() >= 1) {
+          types[op[0]] = {.kind = SpecializationKind::Bool, .size = 4};
+        }
+        break;
+      case OP_TYPE_INT:
+        if (op.size() >= 3) {
+          types[op[0]] = {
+              .kind = op[2] ? SpecializationKind::Int : SpecializationKind::UInt,
+              .size = op[1] / 8
+          };
+        }
+        break;
+      case OP_TYPE_FLOAT:
+        if (op.size() >= 2) {
+          types[op[0]] = {.kind = SpecializationKind::Float, .size = op[1] / 8};
+        }
+        break;
+      case OP_SPEC_CONSTANT_TRUE:
+      case OP_SPEC_CONSTANT_FALSE:
+        if (op.size() >= 2) {
+          constants.push_back(
+              {.id    = op[1],
+               .type  = op[0],
+               .value = opcode == OP_SPEC_CONSTANT_TRUE ? 1u : 0u}
+          );
+        }
+        break;
+      case OP_SPEC_CONSTANT:
+        if (op.size() >= 3) {
+          uint64_t value = op[2];
+          if (op.size() >= 4) {
+            value |= uint64_t(op[3]) << 32;
+          }
+          constants.push_back({.id = op[1], .type = op[0], .value = value});
+        }
+        break;
+      default: break;
+    }
+  }
+
+  std::vector<ReflectedSpecializationConstant> out;
+  for (const SpecConstant &c : constants) {
+    auto specId = specIds.find(c.id);
+    auto type   = types.find(c.type);
+    if (specId == specIds.end() || type == types.end()) {
+      continue; // not specializable, or not a scalar
+    }
+    const std::string_view name =
+        idNames.contains(c.id) ? idNames.at(c.id) : std::string_view();
+    out.push_back(
+        {.defaultValue = c.value,
+         .constantId   = specId->second,
+         .kind         = type->second.kind,
+         .size         = type->second.size,
+         .nameOffset   = static_cast<uint32_t>(names.size()),
+         .nameSize     = static_cast<uint32_t>(name.size()),
+         .reserved     = 0}
+    );
+    names += name;
+  }
+  std::sort(
+      out.begin(),
+      out.end(),
+      [](const ReflectedSpecializationConstant &a,
+         const ReflectedSpecializationConstant &b) {
+        return a.constantId < b.constantId;
+      }
+  );
+  return out;
+}
+
+std::string specializationTypeName(SpecializationKind kind, uint32_t size)
+{
+  switch (kind) {
+    case SpecializationKind::Bool: return "bool";
+    case SpecializationKind::Int: return "int" + std::to_string(size * 8);
+    case SpecializationKind::UInt: return "uint" + std::to_string(size * 8);
+    case SpecializationKind::Float: return "float" + std::to_string(size * 8);
+  }
+  return "unknown";
+}
+
+std::optional<ShaderReflectionData>
+    reflectShader(std::span<const uint32_t> code)
+{
+  SpvReflectShaderModule module;
+  if (spvReflectCreateShaderModule2(
+          SPV_REFLECT_MODULE_FLAG_NO_COPY,
+          code.size_bytes(),
+          code.data(),
+          &module
+      ) != SPV_REFLECT_RESULT_SUCCESS) {
+    return std::nullopt;
+  }
+
+  ShaderReflectionData data;
+  data.stage = static_cast<VkShaderStageFlagBits>(module.shader_stage);
+
+  for (const SpvReflectDescriptorSet *set :
+       enumerate<SpvReflectDescriptorSet>(
+           module,
+           spvReflectEnumerateDescriptorSets
+       )) {
+    for (uint32_t i = 0; i < set->binding_count; ++i) {
+      const SpvReflectDescriptorBinding *binding = set->bindings[i];
+      data.descriptorBindings.push_back(
+          {.set            = set->set,
+           .binding        = binding->binding,
+           .descriptorType = static_cast<VkDescriptorType>(
+               binding->descriptor_type
+           ),
+           .count = binding->count}
+      );
+    }
+  }
+  std::sort(
+      data.descriptorBindings.begin(),
+      data.descriptorBindings.end(),
+      [](const ReflectedDescriptorBinding &a,
+         const ReflectedDescriptorBinding &b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+      }
+  );
+
+  for (const SpvReflectBlockVariable *block :
+       enumerate<SpvReflectBlockVariable>(
+           module,
+           spvReflectEnumeratePushConstantBlocks
+       )) {
+    data.pushConstants.push_back({.offset = block->offset, .size = block->size}
+    );
+  }
+
+  appendInterface(
+      enumerate<SpvReflectInterfaceVariable>(
+          module,
+          spvReflectEnumerateInputVariables
+      ),
+      data.inputVariables,
+      data.names
+  );
+  appendInterface(
+      enumerate<SpvReflectInterfaceVariable>(
+          module,
+          spvReflectEnumerateOutputVariables
+      ),
+      data.outputVariables,
+      data.names
+  );
+  spvReflectDestroyShaderModule(&module);
+  data.specializationConstants =
+      reflectSpecializationConstants(code, data.names);
+
+  LOG_DEBUG("Shader") << "Reflected " << data.descriptorBindings.size()
+                      << " binding(s) in " << data.descriptorSetCount()
+                      << " set(s), " << data.pushConstants.size()
+                      << " push constant block(s), "
+                      << data.inputVariables.size() << " input(s), "
+                      << data.outputVariables.size() << " output(s), "
+                      << data.specializationConstants.size()
+                      << " specialization constant(s)";
+  return data;
+}
+
+std::vector<std::byte> serializeReflection(const ShaderReflectionData &data)
+{
+  const ReflectionBlobHeader header{
+      .magic             = REFLECTION_MAGIC,
+      .version           = SHADER_REFLECTION_VERSION,
+      .stage             = static_cast<uint32_t>(data.stage),
+      .bindingCount      = static_cast<uint32_t>(data.descriptorBindings.size()),
+      .pushConstantCount = static_cast<uint32_t>(data.pushConstants.size()),
+      .inputCount        = static_cast<uint32_t>(data.inputVariables.size()),
+      .outputCount       = static_cast<uint32_t>(data.outputVariables.size()),
+      .specializationCount =
+          static_cast<uint32_t>(data.specializationConstants.size()),
+      .namesSize = static_cast<uint32_t>(data.names.size())
+  };
+  std::vector<std::byte> blob(sizeof(header));
+  std::memcpy(blob.data(), &header, sizeof(header));
+  put(blob, data.descriptorBindings);
+  put(blob, data.pushConstants);
+  put(blob, data.inputVariables);
+  put(blob, data.outputVariables);
+  put(blob, data.specializationConstants);
+  const auto *names = reinterpret_cast<const std::byte *>(data.names.data());
+  blob.insert(blob.end(), names, names + data.names.size());
+  return blob;
+}
+
+std::optional<ShaderReflectionData>
+    deserializeReflection(std::span<const std::byte> blob)
+{
+  ReflectionBlobHeader header;
+  if (blob.size() < sizeof(header)) {
+    return std::nullopt;
+  }
+  std::memcpy(&header, blob.data(), sizeof(header));
+  if (header.magic != REFLECTION_MAGIC ||
+      header.version != SHADER_REFLECTION_VERSION) {
+    return std::nullopt;
+  }
+  blob = blob.subspan(sizeof(header));
+
+  ShaderReflectionData data;
+  data.stage = static_cast<VkShaderStageFlagBits>(header.stage);
+  if (!take(blob, header.bindingCount, data.descriptorBindings) ||
+      !take(blob, header.pushConstantCount, data.pushConstants) ||
+      !take(blob, header.inputCount, data.inputVariables) ||
+      !take(blob, header.outputCount, data.outputVariables) ||
+      !take(
+          blob,
+          header.specializationCount,
+          data.specializationConstants
+      ) ||
+      blob.size() != header.namesSize) {
+    return std::nullopt;
+  }
+  data.names.assign(reinterpret_cast<const char *>(blob.data()), blob.size());
+
+  // Names must stay inside the pool, the rest is only compared
+  auto inPool = [&data](const auto &v) {
+    return v.nameOffset <= data.names.size() &&
+           v.nameSize <= data.names.size() - v.nameOffset;
+  };
+  if (!std::all_of(
+          data.inputVariables.begin(),
+          data.inputVariables.end(),
+          inPool
+      ) ||
+      !std::all_of(
+          data.outputVariables.begin(),
+          data.outputVariables.end(),
+          inPool
+      ) ||
+      !std::all_of(
+          data.specializationConstants.begin(),
+          data.specializationConstants.end(),
+          inPool
+      )) {
+    return std::nullopt;
+  }
+  return data;
+}
+
+ABox::Hash128 reflectionCacheKey(std::span<const uint32_t> code)
+{
+  ABox::Hasher hasher;
+  hasher.update(SHADER_REFLECTION_VERSION);
+  hasher.update(code.data(), code.size_bytes());
+  return hasher.digest();
+}
@@ -0,0 +1,140 @@
+#ifndef SHADER_REFLECTION_HPP
+#define SHADER_REFLECTION_HPP
+
+#include "Hash.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <spirv_reflect.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+/** @brief Bump when a reflected record or the serialized layout changes */
+inline constexpr uint32_t SHADER_REFLECTION_VERSION = 2;
+
+/** @brief location of built-ins and of variables without one */
+inline constexpr uint32_t REFLECTION_NO_LOCATION = UINT32_MAX;
+
+struct ReflectedDescriptorBinding {
+  uint32_t         set;
+  uint32_t         binding;
+  VkDescriptorType descriptorType;
+  uint32_t         count;
+};
+
+struct ReflectedPushConstant {
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct ReflectedInterfaceVariable {
+  uint32_t         location;
+  SpvReflectFormat format;
+  SpvBuiltIn       builtIn;    // -1 when not a built-in
+  uint32_t         nameOffset; // into ShaderReflectionData::names
+  uint32_t         nameSize;
+};
+
+/** @brief Scalar kind of a specialization constant, its width is in size */
+enum class SpecializationKind : uint32_t { Bool, Int, UInt, Float };
+
+struct ReflectedSpecializationConstant {
+  uint64_t           defaultValue; // raw bits, 0 / 1 for booleans
+  uint32_t           constantId;   // layout(constant_id = N)
+  SpecializationKind kind;
+  uint32_t           size;       // bytes VkSpecializationMapEntry must give
+  uint32_t           nameOffset; // into ShaderReflectionData::names
+  uint32_t           nameSize;
+  uint32_t           reserved; // keeps the record free of padding
+};
+
+static_assert(std::is_trivially_copyable_v<ReflectedDescriptorBinding>);
+static_assert(std::is_trivially_copyable_v<ReflectedPushConstant>);
+static_assert(std::is_trivially_copyable_v<ReflectedInterfaceVariable>);
+static_assert(std::is_trivially_copyable_v<ReflectedSpecializationConstant>);
+static_assert(sizeof(ReflectedSpecializationConstant) == 32);
+
+/**
+ * @brief Flat reflection of a shader module: what pipelines need to build
+ * layouts and check stage interfaces, without keeping the SPIRV-Reflect
+ * module alive
+ */
+struct ShaderReflectionData {
+  VkShaderStageFlagBits                   stage = VK_SHADER_STAGE_ALL;
+  std::vector<ReflectedDescriptorBinding> descriptorBindings; // set, binding
+  std::vector<ReflectedPushConstant>      pushConstants;
+  std::vector<ReflectedInterfaceVariable> inputVariables;
+  std::vector<ReflectedInterfaceVariable> outputVariables;
+  std::vector<ReflectedSpecializationConstant>
+              specializationConstants; // by constantId
+  std::string names; // interface variable and constant names
+
+  [[nodiscard]] std::string_view
+      nameOf(const ReflectedInterfaceVariable &variable) const
+  {
+    return std::string_view(names).substr(variable.nameOffset, variable.nameSize);
+  }
+
+  [[nodiscard]] std::string_view
+      nameOf(const ReflectedSpecializationConstant &constant) const
+  {
+    return std::string_view(names).substr(constant.nameOffset, constant.nameSize);
+  }
+
+  /** @return null if the module declares no such constant_id */
+  [[nodiscard]] const ReflectedSpecializationConstant *
+      findSpecializationConstant(uint32_t constantId) const;
+
+  /** @brief Number of descriptor sets, the highest set index + 1 */
+  [[nodiscard]] uint32_t descriptorSetCount() const
+  {
+    return descriptorBindings.empty() ? 0
+                                      : descriptorBindings.back().set + 1;
+  }
+};
+
+/**
+ * @brief Run SPIRV-Reflect over a module once and flatten the result, the
+ * reflect module is released before returning
+ */
+[[nodiscard]] std::optional<ShaderReflectionData>
+    reflectShader(std::span<const uint32_t> code);
+
+/**
+ * @brief Scalar specialization constants of a module (OpSpecConstant*
+ * decorated with SpecId), read straight from the words since SPIRV-Reflect
+ * reports neither their type nor their default. Names are appended to names
+ * @return sorted by constantId, empty for a malformed module
+ */
+[[nodiscard]] std::vector<ReflectedSpecializationConstant>
+    reflectSpecializationConstants(
+        std::span<const uint32_t> code,
+        std::string              &names
+    );
+
+/** @brief "bool", "int32", "float64"... for logs and errors */
+[[nodiscard]] std::string
+    specializationTypeName(SpecializationKind kind, uint32_t size);
+
+/**
+ * @brief Self contained little endian blob (header, records, names), stored
+ * in the shader cache and in shader archives
+ */
+[[nodiscard]] std::vector<std::byte>
+    serializeReflection(const ShaderReflectionData &data);
+
+/** @return nullopt if the blob is truncated or of another version */
+[[nodiscard]] std::optional<ShaderReflectionData>
+    deserializeReflection(std::span<const std::byte> blob);
+
+/**
+ * @brief Shader cache key of the reflection of a module, the module words
+ * are the only input
+ */
+[[nodiscard]] ABox::Hash128 reflectionCacheKey(std::span<const uint32_t> code);
+
+#endif // SHADER_REFLECTION_HPP
@@ -0,0 +1,113 @@
+#include "ShaderVariant.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+bool isIdentifier(std::string_view name)
+{
+  auto isStart = [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+  };
+  auto isBody = [&isStart](char c) { return isStart(c) || (c >= '0' && c <= '9'); };
+  return !name.empty() && isStart(name.front()) &&
+         std::all_of(name.begin() + 1, name.end(), isBody);
+}
+
+} // namespace
+
+ShaderVariantKey::ShaderVariantKey(
+    std::initializer_list<ShaderDefine> defines_
+)
+{
+  for (const ShaderDefine &d : defines_) {
+    define(d.name, d.value);
+  }
+}
+
+ShaderVariantKey &
+    ShaderVariantKey::define(std::string_view name, std::string_view value)
+{
+  if (!isIdentifier(name)) {
+    throw std::invalid_argument(
+        "Invalid shader define name '" + std::string(name) + "'"
+    );
+  }
+  if (value.find_first_of("\r\n") != std::string_view::npos) {
+    throw std::invalid_argument(
+        "Shader define " + std::string(name) + " spans several lines"
+    );
+  }
+  auto it = std::lower_bound(
+      defines.begin(),
+      defines.end(),
+      name,
+      [](const ShaderDefine &d, std::string_view n) { return d.name < n; }
+  );
+  if (it != defines.end() && it->name == name) {
+    it->value = value;
+  }
+  else {
+    defines.insert(it, {.name = std::string(name), .value = std::string(value)});
+  }
+  rehash();
+  return *this;
+}
+
+void ShaderVariantKey::rehash()
+{
+  if (defines.empty()) {
+    hash = {};
+    return;
+  }
+  ABox::Hasher hasher;
+  for (const ShaderDefine &d : defines) {
+    hasher.update(d.name);
+    hasher.update(d.value);
+  }
+  hash = hasher.digest();
+}
+
+std::string ShaderVariantKey::preamble() const
+{
+  std::string out;
+  for (const ShaderDefine &d : defines) {
+    out += "#define " + d.name + ' ' + d.value + '\n';
+  }
+  return out;
+}
+
+std::string ShaderVariantKey::toString() const
+{
+  std::string out;
+  for (const ShaderDefine &d : defines) {
+    if (!out.empty()) {
+      out += ',';
+    }
+    out += d.name + '=' + d.value;
+  }
+  return out;
+}
+
+std::vector<ShaderVariantKey>
+    shaderVariantPermutations(std::span<const ShaderVariantAxis> axes)
+{
+  std::vector<ShaderVariantKey> keys(1);
+  for (const ShaderVariantAxis &axis : axes) {
+    if (axis.values.empty()) {
+      continue;
+    }
+    std::vector<ShaderVariantKey> next;
+    next.reserve(keys.size() * axis.values.size());
+    for (const ShaderVariantKey &key : keys) {
+      for (const std::string &value : axis.values) {
+        ShaderVariantKey &k = next.emplace_back(key);
+        if (!value.empty()) {
+          k.define(axis.name, value);
+        }
+      }
+    }
+    keys = std::move(next);
+  }
+  return keys;
+}
@@ -0,0 +1,87 @@
+#ifndef SHADER_VARIANT_HPP
+#define SHADER_VARIANT_HPP
+
+#include "Hash.hpp"
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief One `#define NAME VALUE` injected before the shader source
+ */
+struct ShaderDefine {
+  std::string name;
+  std::string value = "1";
+
+  bool operator==(const ShaderDefine &) const = default;
+};
+
+/**
+ * @class ShaderVariantKey
+ * @brief Canonical set of defines selecting one permutation of a shader
+ *
+ * Defines are kept sorted by name, a name appears once, so the same set
+ * gives the same key whatever the order it was built in. The hash is
+ * computed on every change and reused by the lookups. An empty key is the
+ * base shader.
+ */
+class ShaderVariantKey {
+  std::vector<ShaderDefine> defines; // sorted by name
+  ABox::Hash128             hash;    // zero when empty
+
+  void rehash();
+
+   public:
+  ShaderVariantKey() = default;
+
+  /** @throws std::invalid_argument see define() */
+  ShaderVariantKey(std::initializer_list<ShaderDefine> defines_);
+
+  /**
+   * @brief Add a define or replace its value
+   * @throws std::invalid_argument if name is not an identifier or value
+   * spans several lines
+   */
+  ShaderVariantKey &define(std::string_view name, std::string_view value = "1");
+
+  [[nodiscard]] bool empty() const { return defines.empty(); }
+
+  [[nodiscard]] std::span<const ShaderDefine> getDefines() const
+  {
+    return defines;
+  }
+
+  [[nodiscard]] const ABox::Hash128 &getHash() const { return hash; }
+
+  /** @brief `#define` lines handed to glslang as the preamble */
+  [[nodiscard]] std::string preamble() const;
+
+  /** @brief "NAME=VALUE,..." for names and logs, empty for the base */
+  [[nodiscard]] std::string toString() const;
+
+  bool operator==(const ShaderVariantKey &other) const
+  {
+    return defines == other.defines;
+  }
+};
+
+/**
+ * @brief One feature of a material and the values it can take, an empty
+ * value leaves the define out (feature off)
+ */
+struct ShaderVariantAxis {
+  std::string              name;
+  std::vector<std::string> values;
+};
+
+/**
+ * @brief Every combination of the axes, the first axis varying slowest
+ * @throws std::invalid_argument on an invalid define, see
+ * ShaderVariantKey::define()
+ */
+[[nodiscard]] std::vector<ShaderVariantKey>
+    shaderVariantPermutations(std::span<const ShaderVariantAxis> axes);
+
+#endif // SHADER_VARIANT_HPP
@@ -0,0 +1,193 @@
+#include "ShaderWatcher.hpp"
+#include "Logger.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <future>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr int IDLE_POLL_MS = 100; // bounds the latency of a stop request
+
+/** @brief Normalized without trailing separator, to compare parent_path() */
+std::vector<fs::path> normalizeRoots(std::vector<fs::path> folders)
+{
+  for (fs::path &folder : folders) {
+    folder = (folder / "").lexically_normal().parent_path();
+  }
+  return folders;
+}
+} // namespace
+
+ShaderWatcher::ShaderWatcher(
+    std::vector<fs::path>       folders,
+    ShaderCache                *cache,
+    const SpirvOptimizerConfig &optimizer,
+    std::chrono::milliseconds   debounce
+)
+    : roots(normalizeRoots(std::move(folders)))
+    , cache(cache)
+    , optimizer(optimizer)
+    , debounce(debounce)
+{
+  if (abox::platform::file_watch_open(fileWatch) != 0) {
+    LOG_WARN("Shader") << "Shader hot reload unavailable on this platform";
+    return;
+  }
+  thread = std::thread(&ShaderWatcher::run, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+  stopping.store(true);
+  if (thread.joinable()) {
+    thread.join();
+  }
+  abox::platform::file_watch_close(fileWatch);
+}
+
+std::vector<ShaderCompileResult> ShaderWatcher::takeResults()
+{
+  std::lock_guard lock(resultsMutex);
+  return std::exchange(results, {});
+}
+
+void ShaderWatcher::onFileEvent(void *user, int watchId, const char *name)
+{
+  auto *self = static_cast<ShaderWatcher *>(user);
+  auto  dir  = self->watchedDirs.find(watchId);
+  if (dir != self->watchedDirs.end()) {
+    self->changed.insert((dir->second / name).lexically_normal());
+  }
+}
+
+void ShaderWatcher::watchDirectory(const fs::path &dir)
+{
+  const fs::path target = dir.empty() ? fs::path(".") : dir;
+  int id =
+      abox::platform::file_watch_add(fileWatch, target.string().c_str());
+  if (id < 0) {
+    LOG_WARN("Shader") << "Cannot watch " << target.string();
+    return;
+  }
+  if (watchedDirs.emplace(id, dir).second) {
+    LOG_DEBUG("Shader") << "Watching " << target.string();
+  }
+}
+
+void ShaderWatcher::trackIncludes(const fs::path &shader)
+{
+  if (shader.extension() == SPIRV_EXTENSION) { // binaries have no includes
+    graph.setIncludes(shader, {});
+    return;
+  }
+  try {
+    const std::string source = ShaderHandler::loadShaderFromFile(shader);
+    graph.setIncludes(
+        shader,
+        collectShaderIncludes(source, shader.parent_path())
+    );
+  }
+  catch (const std::exception &) { // deleted meanwhile
+    graph.remove(shader);
+  }
+}
+
+void ShaderWatcher::scanRoots()
+{
+  std::error_code ec;
+  for (const fs::path &root : roots) {
+    for (const auto &entry : fs::directory_iterator(root, ec)) {
+      if (entry.is_regular_file(ec) &&
+          ShaderHandler::isShaderFile(entry.path())) {
+        trackIncludes(entry.path().lexically_normal());
+      }
+    }
+    watchDirectory(root);
+  }
+  for (const fs::path &dir : graph.directories()) {
+    watchDirectory(dir);
+  }
+}
+
+void ShaderWatcher::rebuild()
+{
+  std::set<fs::path> shaders = graph.affected(changed);
+  // Shaders created after the watch started
+  for (const fs::path &path : changed) {
+    if (!graph.isShader(path) && ShaderHandler::isShaderFile(path) &&
+        std::find(roots.begin(), roots.end(), path.parent_path()) !=
+            roots.end()) {
+      shaders.insert(path);
+    }
+  }
+  changed.clear();
+  if (shaders.empty()) {
+    return;
+  }
+
+  std::vector<std::future<ShaderCompileResult>> compiled;
+  compiled.reserve(shaders.size());
+  for (const fs::path &shader : shaders) {
+    compiled.push_back(ABox::ThreadPool::shared().submit([shader, this] {
+      return ShaderHandler::compileShaderFile(shader, cache, optimizer);
+    }));
+  }
+
+  std::vector<ShaderCompileResult> batch;
+  batch.reserve(shaders.size());
+  for (std::future<ShaderCompileResult> &future : compiled) {
+    batch.push_back(future.get());
+  }
+  // Includes may have been added or removed by the edit
+  for (const fs::path &shader : shaders) {
+    trackIncludes(shader);
+  }
+  for (const fs::path &dir : graph.directories()) {
+    watchDirectory(dir);
+  }
+
+  LOG_INFO("Shader") << "Hot reload: " << batch.size()
+                     << " shader(s) recompiled";
+  std::lock_guard lock(resultsMutex);
+  for (ShaderCompileResult &result : batch) {
+    results.push_back(std::move(result));
+  }
+}
+
+void ShaderWatcher::run()
+{
+  scanRoots();
+  auto lastEvent = std::chrono::steady_clock::now();
+  while (!stopping.load()) {
+    int timeout = IDLE_POLL_MS;
+    if (!changed.empty()) {
+      auto quiet = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - lastEvent
+      );
+      timeout = static_cast<int>(std::max<int64_t>(
+          (debounce - quiet).count(),
+          0
+      ));
+    }
+
+    int events = abox::platform::file_watch_poll(
+        fileWatch,
+        timeout,
+        &ShaderWatcher::onFileEvent,
+        this
+    );
+    if (events < 0) {
+      LOG_ERROR("Shader") << "Shader watch failed, hot reload stopped";
+      return;
+    }
+    if (events > 0) {
+      lastEvent = std::chrono::steady_clock::now();
+    }
+    else if (!changed.empty() &&
+             std::chrono::steady_clock::now() - lastEvent >= debounce) {
+      rebuild();
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#ifndef SHADER_WATCHER_HPP
+#define SHADER_WATCHER_HPP
+
+#include "PreProcUtils.hpp"
+#include "ShaderHandler.hpp"
+#include "ShaderIncludes.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <platform/file_watch.hpp>
+#include <set>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ShaderWatcher
+ * @brief Background thread recompiling the shaders of some folders when
+ * they, or a file they `#include`, change on disk
+ *
+ * Changes are debounced: a rebuild starts once no event arrived for the
+ * debounce delay, so an editor writing several times per save causes a
+ * single recompilation. Only the changed shaders and their dependents are
+ * compiled. Results queue up until the owner collects them with
+ * takeResults(), typically at a frame boundary (see
+ * ShaderHandler::applyReloads). glslang must stay initialized while the
+ * watcher lives.
+ */
+class ShaderWatcher {
+  const std::vector<std::filesystem::path> roots;
+  ShaderCache *const                       cache; // may be null
+  const SpirvOptimizerConfig               optimizer;
+  const std::chrono::milliseconds          debounce;
+
+  // Watcher thread only
+  abox::platform::FileWatch            fileWatch;
+  std::map<int, std::filesystem::path> watchedDirs;
+  ShaderDependencyGraph                graph;
+  std::set<std::filesystem::path>      changed;
+
+  std::mutex                       resultsMutex;
+  std::vector<ShaderCompileResult> results;
+  std::atomic<bool>                stopping{false};
+  std::thread                      thread;
+
+  static void onFileEvent(void *user, int watchId, const char *name);
+
+  void run();
+  void scanRoots();
+  void watchDirectory(const std::filesystem::path &dir);
+  void trackIncludes(const std::filesystem::path &shader);
+  void rebuild();
+
+   public:
+  static constexpr std::chrono::milliseconds DEFAULT_DEBOUNCE{150};
+
+  ShaderWatcher(
+      std::vector<std::filesystem::path> folders,
+      ShaderCache                       *cache,
+      const SpirvOptimizerConfig        &optimizer,
+      std::chrono::milliseconds          debounce = DEFAULT_DEBOUNCE
+  );
+  ~ShaderWatcher();
+
+  DELETE_COPY(ShaderWatcher);
+  DELETE_MOVE(ShaderWatcher);
+
+  /** @brief false when the platform has no change notifications */
+  [[nodiscard]] bool isValid() const { return fileWatch.handle >= 0; }
+
+  /**
+   * @brief Recompilations finished since the last call, failures included
+   */
+  [[nodiscard]] std::vector<ShaderCompileResult> takeResults();
+};
+
+#endif // SHADER_WATCHER_HPP
@@ -0,0 +1,85 @@
+#include "SpirvOptimizer.hpp"
+#include <chrono>
+#include <spirv-tools/libspirv.hpp>
+#include <spirv-tools/optimizer.hpp>
+
+namespace {
+constexpr spv_target_env TARGET_ENV = SPV_ENV_VULKAN_1_3;
+} // namespace
+
+OSTREAM_OP(SpirvOptLevel level)
+{
+  switch (level) {
+    case SpirvOptLevel::None: return os << "none";
+    case SpirvOptLevel::Performance: return os << "-O";
+    case SpirvOptLevel::Size: return os << "-Os";
+  }
+  return os << "unknown";
+}
+
+bool optimizeSpirv(
+    std::vector<uint32_t>      &spirv,
+    const SpirvOptimizerConfig &config,
+    SpirvOptimizeStats         *stats,
+    std::string                *errors
+)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  std::string                messages;
+  spvtools::MessageConsumer consumer = [&messages](
+                                           spv_message_level_t level,
+                                           const char * /*source*/,
+                                           const spv_position_t &position,
+                                           const char           *message
+                                       ) {
+    if (level <= SPV_MSG_ERROR) {
+      messages += "word " + std::to_string(position.index) + ": " +
+                  message + '\n';
+    }
+  };
+
+  bool                  ok = true;
+  std::vector<uint32_t> result;
+  if (config.level == SpirvOptLevel::None && !config.stripDebugInfo) {
+    // Validation only
+    if (config.validate) {
+      spvtools::SpirvTools tools(TARGET_ENV);
+      tools.SetMessageConsumer(consumer);
+      ok = tools.Validate(spirv.data(), spirv.size());
+    }
+    result = spirv;
+  }
+  else {
+    spvtools::Optimizer optimizer(TARGET_ENV);
+    optimizer.SetMessageConsumer(consumer);
+    if (config.level == SpirvOptLevel::Performance) {
+      optimizer.RegisterPerformancePasses();
+    }
+    else if (config.level == SpirvOptLevel::Size) {
+      optimizer.RegisterSizePasses();
+    }
+    if (config.stripDebugInfo) {
+      optimizer.RegisterPass(spvtools::CreateStripDebugInfoPass());
+    }
+    spvtools::OptimizerOptions options;
+    options.set_run_validator(config.validate);
+    ok = optimizer.Run(spirv.data(), spirv.size(), &result, options);
+  }
+
+  if (!ok) {
+    if (errors) {
+      *errors = messages.empty() ? "SPIR-V optimization failed" : messages;
+    }
+    return false;
+  }
+  if (stats) {
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    stats->wordsBefore  = spirv.size();
+    stats->wordsAfter   = result.size();
+    stats->milliseconds = elapsed.count();
+  }
+  spirv = std::move(result);
+  return true;
+}
@@ -0,0 +1,85 @@
+#ifndef SPIRV_OPTIMIZER_HPP
+#define SPIRV_OPTIMIZER_HPP
+
+#include "Hash.hpp"
+#include "PreProcUtils.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class SpirvOptLevel {
+  None,        // keep glslang's output
+  Performance, // spirv-opt -O
+  Size         // spirv-opt -Os
+};
+
+OSTREAM_OP(SpirvOptLevel level);
+
+/**
+ * @brief Post compilation SPIR-V processing, applied before the module is
+ * cached
+ */
+struct SpirvOptimizerConfig {
+  SpirvOptLevel level          = SpirvOptLevel::Performance;
+  bool          stripDebugInfo = false; // names and line info, breaks
+                                        // shader debuggers
+  bool          validate       = false; // spirv-val before optimizing
+
+  [[nodiscard]] bool enabled() const
+  {
+    return level != SpirvOptLevel::None || stripDebugInfo || validate;
+  }
+
+  /** @brief Feed every field to a cache key */
+  void hash(ABox::Hasher &hasher) const
+  {
+    hasher.update(static_cast<uint8_t>(level));
+    hasher.update(static_cast<uint8_t>(stripDebugInfo));
+    hasher.update(static_cast<uint8_t>(validate));
+  }
+
+  /**
+   * @brief Debug builds validate and keep debug info unoptimized for
+   * shader debuggers, release builds optimize and strip
+   */
+  static SpirvOptimizerConfig buildDefault()
+  {
+#ifdef DEBUG_VK_ABOX
+    return {
+        .level          = SpirvOptLevel::None,
+        .stripDebugInfo = false,
+        .validate       = true
+    };
+#else
+    return {
+        .level          = SpirvOptLevel::Performance,
+        .stripDebugInfo = true,
+        .validate       = false
+    };
+#endif
+  }
+};
+
+struct SpirvOptimizeStats {
+  size_t wordsBefore  = 0;
+  size_t wordsAfter   = 0;
+  double milliseconds = 0.0;
+};
+
+/**
+ * @brief Run SPIRV-Tools over a module (Vulkan 1.3 target environment)
+ * @param spirv Replaced by the processed module on success, untouched
+ * otherwise
+ * @param stats Optional, filled on success
+ * @param errors Optional, receives the validator or optimizer messages
+ * @return false if validation or optimization failed
+ */
+bool optimizeSpirv(
+    std::vector<uint32_t>      &spirv,
+    const SpirvOptimizerConfig &config,
+    SpirvOptimizeStats         *stats  = nullptr,
+    std::string                *errors = nullptr
+);
+
+#endif // SPIRV_OPTIMIZER_HPP
@@ -74,8 +74,11 @@ Swapchain::Swapchain(
   createImageViews(logicalDevice);
 }
 
-VkResult
-    Swapchain::createSwapchain(VkPhysicalDevice phyDev, VkDevice logicalDevice)
+VkResult Swapchain::createSwapchain(
+    VkPhysicalDevice       phyDev,
+    VkDevice               logicalDevice,
+    DeferredDeletionQueue *retired
+)
 {
   VkSwapchainKHR newSwapchain = VK_NULL_HANDLE;
   ;
@@ -121,7 +124,12 @@ VkResult
     LOG_DEBUG("Swapchain") << "Has an old swapchain? "
                            << (bool)(!swapChain.empty())
                            << " ptrValue: " << (void *)swapChain.ptr();
-    swapChain.swap(newSwapchain);
+    if (retired) {
+      swapChain.swap(newSwapchain, *retired);
+    }
+    else {
+      swapChain.swap(newSwapchain);
+    }
     LOG_INFO("Swapchain") << "Swapchain created: " << (void *)swapChain.ptr();
   }
   return VK_SUCCESS;
@@ -222,29 +230,34 @@ VkResult Swapchain::chooseSwapExtent(uint32_t width, uint32_t height)
 }
 
 VkResult Swapchain::resizeSwapChain(
-    VkPhysicalDevice   phyDev,
-    VkDevice           device,
-    VkRenderPass       rp,
-    FrameBufferBroker &fbb
+    VkPhysicalDevice       phyDev,
+    VkDevice               device,
+    VkRenderPass           rp,
+    FrameBufferBroker     &fbb,
+    DeferredDeletionQueue &retired
 )
 {
-  fbb.clear(swapChain, rp);
+  fbb.clear(swapChain, rp, retired);
+  for (auto &img : swapChainImages) {
+    img.imageViewWrapper.retire(retired);
+  }
   swapChainImages.clear();
 
-  createSwapchain(phyDev, device);
+  createSwapchain(phyDev, device, &retired);
   createImageViews(device);
   fbb.createFramebuffers(device, rp, this);
   return VK_SUCCESS;
 }
 
 VkResult Swapchain::resizeSwapChain(
-    VkPhysicalDevice   phyDev,
-    VkDevice           device,
-    VkExtent2D         window,
-    VkRenderPass       rp,
-    FrameBufferBroker &fbb
+    VkPhysicalDevice       phyDev,
+    VkDevice               device,
+    VkExtent2D             window,
+    VkRenderPass           rp,
+    FrameBufferBroker     &fbb,
+    DeferredDeletionQueue &retired
 )
 {
   extent = window;
-  return resizeSwapChain(phyDev, device, rp, fbb);
+  return resizeSwapChain(phyDev, device, rp, fbb, retired);
 }
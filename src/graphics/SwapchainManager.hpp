@@ -107,7 +107,15 @@ class Swapchain {
     return queueFamilyIndices.getGraphicsQueueDeviceIndice();
   };
 
-  VkResult createSwapchain(VkPhysicalDevice phyDev, VkDevice logicalDevice);
+  /**
+   * @param retired When set, the previous swapchain is retired through it
+   * instead of being destroyed immediately
+   */
+  VkResult createSwapchain(
+      VkPhysicalDevice       phyDev,
+      VkDevice               logicalDevice,
+      DeferredDeletionQueue *retired = nullptr
+  );
 
   VkResult createImageViews(VkDevice device);
 
@@ -129,19 +137,25 @@ class Swapchain {
 
   VkSwapchainKHR *swapchainPtr() { return swapChain.ptr(); }
 
+  /**
+   * @brief Recreate swapchain, image views and framebuffers; the old ones
+   * are handed to `retired` so frames in flight can still use them
+   */
   VkResult resizeSwapChain(
-      VkPhysicalDevice   phyDev,
-      VkDevice           device,
-      VkRenderPass       rp,
-      FrameBufferBroker &fbb
+      VkPhysicalDevice       phyDev,
+      VkDevice               device,
+      VkRenderPass           rp,
+      FrameBufferBroker     &fbb,
+      DeferredDeletionQueue &retired
   );
 
   VkResult resizeSwapChain(
-      VkPhysicalDevice   phyDev,
-      VkDevice           device,
-      VkExtent2D         window,
-      VkRenderPass       rp,
-      FrameBufferBroker &fbb
+      VkPhysicalDevice       phyDev,
+      VkDevice               device,
+      VkExtent2D             window,
+      VkRenderPass           rp,
+      FrameBufferBroker     &fbb,
+      DeferredDeletionQueue &retired
   );
 
   inline uint32_t getMinImageCount() const
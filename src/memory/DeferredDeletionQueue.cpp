@@ -0,0 +1,69 @@
+#include "DeferredDeletionQueue.hpp"
+#include "Logger.hpp"
+
+DeferredDeletionQueue::~DeferredDeletionQueue()
+{
+  const size_t count = flush();
+  if (count > 0) {
+    LOG_DEBUG("Memory") << "Deferred deletion queue flushed " << count
+                        << " handle(s) on destruction";
+  }
+}
+
+size_t DeferredDeletionQueue::run(std::deque<Entry> &ready)
+{
+  for (const Entry &e : ready) {
+    LOG_DEBUG("Memory") << " ---- Deferred destruction [" << e.typeName
+                        << "] -- container: " << (void *)(uintptr_t)e.handle
+                        << " -- retired at frame " << e.serial;
+    e.destroy(e);
+#ifdef ABOX_OBJECT_TRACKING
+    ObjectRegistry::onDestroy(e.trackedType, e.parent, true);
+#endif
+  }
+  return ready.size();
+}
+
+size_t DeferredDeletionQueue::advance(uint64_t recording, uint64_t completed)
+{
+  recordingSerial.store(recording, std::memory_order_release);
+  return collect(completed);
+}
+
+size_t DeferredDeletionQueue::collect(uint64_t completed)
+{
+  // Monotonic: a stale caller must not move the completed serial backwards
+  uint64_t previous = completedSerial.load(std::memory_order_relaxed);
+  while (previous < completed &&
+         !completedSerial.compare_exchange_weak(
+             previous, completed, std::memory_order_acq_rel
+         )) {
+  }
+
+  std::deque<Entry> ready;
+  {
+    std::lock_guard lock(mutex);
+    while (!entries.empty() && entries.front().serial <= completed) {
+      ready.push_back(entries.front());
+      entries.pop_front();
+    }
+  }
+  // Destroy outside the lock, vkDestroy* can be slow
+  return run(ready);
+}
+
+size_t DeferredDeletionQueue::flush()
+{
+  std::deque<Entry> ready;
+  {
+    std::lock_guard lock(mutex);
+    ready.swap(entries);
+  }
+  return run(ready);
+}
+
+size_t DeferredDeletionQueue::size() const
+{
+  std::lock_guard lock(mutex);
+  return entries.size();
+}
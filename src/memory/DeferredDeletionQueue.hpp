@@ -0,0 +1,147 @@
+#ifndef DEFERRED_DELETION_QUEUE_HPP
+#define DEFERRED_DELETION_QUEUE_HPP
+
+#include "ObjectRegistry.hpp"
+#include "PreProcUtils.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <type_traits>
+#include <typeinfo>
+#include <vulkan/vulkan_core.h>
+
+/**
+ * @class DeferredDeletionQueue
+ * @brief Per-device queue of Vulkan handles waiting for the GPU to be done
+ * with them
+ *
+ * Handles are tagged with the serial of the frame being recorded when they
+ * were retired and destroyed once that frame's fence has signalled, so a
+ * resource can be replaced without idling the device. Serials come from the
+ * device's FrameSyncArray through advance().
+ */
+class DeferredDeletionQueue {
+  struct Entry {
+    uint64_t serial;
+    void (*destroy)(const Entry &);
+    void (*destroyFunction)(); // type-erased vkDestroy* pointer
+    uint64_t                     handle;
+    uint64_t                     parent;
+    const VkAllocationCallbacks *pAllocator;
+    const char                  *typeName;
+    uint16_t                     trackedType; // ObjectRegistry slot
+  };
+
+  mutable std::mutex    mutex;
+  std::deque<Entry>     entries; // serials never decrease front to back
+  std::atomic<uint64_t> recordingSerial{1};
+  std::atomic<uint64_t> completedSerial{0};
+
+  template <typename H> static uint64_t toBits(H handle)
+  {
+    if constexpr (std::is_pointer_v<H>) {
+      return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(handle));
+    }
+    else {
+      return static_cast<uint64_t>(handle);
+    }
+  }
+
+  template <typename H> static H fromBits(uint64_t bits)
+  {
+    if constexpr (std::is_pointer_v<H>) {
+      return reinterpret_cast<H>(static_cast<uintptr_t>(bits));
+    }
+    else {
+      return static_cast<H>(bits);
+    }
+  }
+
+  template <typename T, typename VkD, typename VkP>
+  static void destroyEntry(const Entry &e)
+  {
+    VkD fn = reinterpret_cast<VkD>(e.destroyFunction);
+    if constexpr (std::is_same_v<VkP, std::nullptr_t>) {
+      fn(fromBits<T>(e.handle), e.pAllocator);
+    }
+    else {
+      fn(fromBits<VkP>(e.parent), fromBits<T>(e.handle), e.pAllocator);
+    }
+  }
+
+  static size_t run(std::deque<Entry> &ready);
+
+   public:
+  DeferredDeletionQueue() = default;
+  ~DeferredDeletionQueue();
+
+  DELETE_COPY(DeferredDeletionQueue);
+  DELETE_MOVE(DeferredDeletionQueue);
+
+  /**
+   * @brief Queue a handle for destruction after the current frame completes
+   *
+   * Called by MemoryWrapper::retire, the handle must not be referenced by
+   * commands recorded after this call.
+   * @param trackedType ObjectRegistry slot released on destruction
+   */
+  template <typename T, typename VkD, typename VkP>
+  void enqueue(
+      T                            handle,
+      VkP                          parent,
+      VkD                          destroyFunction,
+      const VkAllocationCallbacks *pAllocator,
+      uint16_t                     trackedType = ObjectRegistry::NO_TYPE
+  )
+  {
+    Entry e{
+        .serial          = recordingSerial.load(std::memory_order_acquire),
+        .destroy         = &destroyEntry<T, VkD, VkP>,
+        .destroyFunction = reinterpret_cast<void (*)()>(destroyFunction),
+        .handle          = toBits(handle),
+        .parent          = 0,
+        .pAllocator      = pAllocator,
+        .typeName        = typeid(T).name(),
+        .trackedType     = trackedType,
+    };
+    if constexpr (!std::is_same_v<VkP, std::nullptr_t>) {
+      e.parent = toBits(parent);
+    }
+    std::lock_guard lock(mutex);
+    entries.push_back(e);
+  }
+
+  /**
+   * @brief Update the frame serials and destroy everything now safe
+   * @param recording Serial of the frame about to be recorded
+   * @param completed Highest serial whose GPU work is known complete
+   * @return Number of handles destroyed
+   */
+  size_t advance(uint64_t recording, uint64_t completed);
+
+  /**
+   * @brief Destroy the entries whose serial is <= completed
+   */
+  size_t collect(uint64_t completed);
+
+  /**
+   * @brief Destroy everything regardless of serial, the device must be idle
+   */
+  size_t flush();
+
+  [[nodiscard]] size_t size() const;
+
+  [[nodiscard]] uint64_t getRecordingSerial() const
+  {
+    return recordingSerial.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] uint64_t getCompletedSerial() const
+  {
+    return completedSerial.load(std::memory_order_acquire);
+  }
+};
+
+#endif // DEFERRED_DELETION_QUEUE_HPP
@@ -0,0 +1,444 @@
+#include "HostAllocator.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+constexpr size_t  TAG_COUNT    = static_cast<size_t>(HostAllocTag::Count);
+constexpr size_t  SLAB_BYTES   = 64 * 1024;
+constexpr size_t  MIN_ALIGN    = 16;
+constexpr uint8_t SYSTEM_CLASS = 0xFF;
+
+/**
+ * @brief Written right before every pointer returned to the driver
+ */
+struct alignas(MIN_ALIGN) Header {
+  uint64_t size;      // requested bytes
+  uint32_t offset;    // user pointer - start of the underlying block
+  uint8_t  sizeClass; // SYSTEM_CLASS for malloc'd blocks
+  uint8_t  scope;
+  uint8_t  tag;
+  uint8_t  reserved;
+};
+static_assert(sizeof(Header) == MIN_ALIGN);
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+struct Pool {
+  std::mutex            mutex;
+  FreeBlock            *freeList = nullptr;
+  void                 *slabs    = nullptr; // chained through the first word
+  size_t                classSize = 0;
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> slabBytes{0};
+};
+
+struct ScopeCounters {
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> frees{0};
+  std::atomic<uint64_t> liveCount{0};
+  std::atomic<uint64_t> liveBytes{0};
+  std::atomic<uint64_t> peakBytes{0};
+  std::atomic<uint64_t> internalBytes{0};
+};
+
+struct State {
+  std::vector<size_t> classes =
+      deriveSizeClasses(ABOX_HOST_ALLOC_GRANULARITY, ABOX_HOST_ALLOC_MAX_POOLED);
+  std::vector<Pool> pools{classes.size()};
+  // (size + MIN_ALIGN - 1) / MIN_ALIGN -> pool index
+  std::vector<uint8_t>  lookup;
+  size_t                maxPooled = 0;
+  ScopeCounters         counters[TAG_COUNT][HOST_ALLOC_SCOPE_COUNT];
+  std::atomic<uint64_t> systemAllocations{0};
+
+  State()
+  {
+    maxPooled = classes.empty() ? 0 : classes.back();
+    lookup.resize(maxPooled / MIN_ALIGN + 1);
+    size_t c = 0;
+    for (size_t i = 0; i < lookup.size(); ++i) {
+      while (c < classes.size() && classes[c] < i * MIN_ALIGN) {
+        ++c;
+      }
+      lookup[i] = static_cast<uint8_t>(c);
+    }
+    for (size_t i = 0; i < classes.size(); ++i) {
+      pools[i].classSize = classes[i];
+    }
+  }
+};
+
+/**
+ * @brief Never destroyed, the driver may release memory after static
+ * destructors have run
+ */
+State &state()
+{
+  static State *s = new State();
+  return *s;
+}
+
+struct UserData {
+  HostAllocTag tag;
+};
+
+std::array<UserData, TAG_COUNT> g_userData = [] {
+  std::array<UserData, TAG_COUNT> data{};
+  for (size_t i = 0; i < TAG_COUNT; ++i) {
+    data[i].tag = static_cast<HostAllocTag>(i);
+  }
+  return data;
+}();
+
+size_t scopeIndex(VkSystemAllocationScope scope)
+{
+  const size_t index = static_cast<size_t>(scope);
+  return index < HOST_ALLOC_SCOPE_COUNT ? index : 0;
+}
+
+ScopeCounters &countersOf(uint8_t tag, uint8_t scope)
+{
+  return state().counters[tag][scope];
+}
+
+Header *headerOf(void *user)
+{
+  return reinterpret_cast<Header *>(static_cast<char *>(user) - sizeof(Header));
+}
+
+void accountAlloc(const Header &h)
+{
+  ScopeCounters &c = countersOf(h.tag, h.scope);
+  c.allocations.fetch_add(1, std::memory_order_relaxed);
+  c.liveCount.fetch_add(1, std::memory_order_relaxed);
+  const uint64_t live =
+      c.liveBytes.fetch_add(h.size, std::memory_order_relaxed) + h.size;
+  uint64_t peak = c.peakBytes.load(std::memory_order_relaxed);
+  while (peak < live &&
+         !c.peakBytes.compare_exchange_weak(
+             peak, live, std::memory_order_relaxed
+         )) {
+  }
+}
+
+void accountFree(const Header &h)
+{
+  ScopeCounters &c = countersOf(h.tag, h.scope);
+  c.frees.fetch_add(1, std::memory_order_relaxed);
+  c.liveCount.fetch_sub(1, std::memory_order_relaxed);
+  c.liveBytes.fetch_sub(h.size, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Carve a new slab into blocks of header + class size, pool locked
+ */
+bool refill(Pool &pool)
+{
+  void *slab = std::aligned_alloc(MIN_ALIGN, SLAB_BYTES);
+  if (!slab) {
+    return false;
+  }
+  *static_cast<void **>(slab) = pool.slabs;
+  pool.slabs                  = slab;
+  pool.slabBytes.fetch_add(SLAB_BYTES, std::memory_order_relaxed);
+
+  const size_t block = sizeof(Header) + pool.classSize;
+  char        *begin = static_cast<char *>(slab) + MIN_ALIGN;
+  char        *end   = static_cast<char *>(slab) + SLAB_BYTES;
+  for (char *p = begin; p + block <= end; p += block) {
+    auto *node     = reinterpret_cast<FreeBlock *>(p);
+    node->next     = pool.freeList;
+    pool.freeList  = node;
+  }
+  return true;
+}
+
+void *allocate(size_t size, size_t alignment, uint8_t scope, uint8_t tag)
+{
+  State &s = state();
+  if (size == 0) {
+    return nullptr;
+  }
+
+  Header header{
+      .size      = size,
+      .offset    = sizeof(Header),
+      .sizeClass = SYSTEM_CLASS,
+      .scope     = scope,
+      .tag       = tag,
+      .reserved  = 0,
+  };
+  char *user = nullptr;
+
+  if (alignment <= MIN_ALIGN && size <= s.maxPooled) {
+    const uint8_t index = s.lookup[(size + MIN_ALIGN - 1) / MIN_ALIGN];
+    Pool         &pool  = s.pools[index];
+    FreeBlock    *block = nullptr;
+    {
+      std::lock_guard lock(pool.mutex);
+      if (pool.freeList || refill(pool)) {
+        block         = pool.freeList;
+        pool.freeList = block->next;
+      }
+    }
+    if (block) {
+      pool.hits.fetch_add(1, std::memory_order_relaxed);
+      header.sizeClass = index;
+      user             = reinterpret_cast<char *>(block) + sizeof(Header);
+    }
+  }
+
+  if (!user) {
+    const size_t align = alignment > MIN_ALIGN ? alignment : MIN_ALIGN;
+    char *raw = static_cast<char *>(std::malloc(size + align + sizeof(Header)));
+    if (!raw) {
+      return nullptr;
+    }
+    const uintptr_t first = reinterpret_cast<uintptr_t>(raw) + sizeof(Header);
+    user = reinterpret_cast<char *>((first + align - 1) & ~(uintptr_t{align} - 1));
+    header.offset = static_cast<uint32_t>(user - raw);
+    s.systemAllocations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  *headerOf(user) = header;
+  accountAlloc(header);
+  return user;
+}
+
+void release(void *user)
+{
+  if (!user) {
+    return;
+  }
+  const Header header = *headerOf(user);
+  accountFree(header);
+
+  char *block = static_cast<char *>(user) - header.offset;
+  if (header.sizeClass == SYSTEM_CLASS) {
+    std::free(block);
+    return;
+  }
+  Pool           &pool = state().pools[header.sizeClass];
+  auto           *node = reinterpret_cast<FreeBlock *>(block);
+  std::lock_guard lock(pool.mutex);
+  node->next    = pool.freeList;
+  pool.freeList = node;
+}
+
+uint8_t tagOf(void *pUserData)
+{
+  return pUserData ? static_cast<uint8_t>(
+                         static_cast<const UserData *>(pUserData)->tag
+                     )
+                   : static_cast<uint8_t>(HostAllocTag::Other);
+}
+
+void *VKAPI_PTR hostAllocation(
+    void                   *pUserData,
+    size_t                  size,
+    size_t                  alignment,
+    VkSystemAllocationScope scope
+)
+{
+  return allocate(
+      size,
+      alignment,
+      static_cast<uint8_t>(scopeIndex(scope)),
+      tagOf(pUserData)
+  );
+}
+
+void *VKAPI_PTR hostReallocation(
+    void                   *pUserData,
+    void                   *pOriginal,
+    size_t                  size,
+    size_t                  alignment,
+    VkSystemAllocationScope scope
+)
+{
+  if (!pOriginal) {
+    return hostAllocation(pUserData, size, alignment, scope);
+  }
+  if (size == 0) {
+    release(pOriginal);
+    return nullptr;
+  }
+
+  Header *header = headerOf(pOriginal);
+  // Shrinking or growing within the same pooled class keeps the block
+  if (header->sizeClass != SYSTEM_CLASS && alignment <= MIN_ALIGN &&
+      size <= state().pools[header->sizeClass].classSize) {
+    accountFree(*header);
+    header->size = size;
+    accountAlloc(*header);
+    return pOriginal;
+  }
+
+  void *moved = allocate(size, alignment, header->scope, header->tag);
+  if (moved) {
+    std::memcpy(moved, pOriginal, std::min<uint64_t>(header->size, size));
+    release(pOriginal);
+  }
+  return moved;
+}
+
+void VKAPI_PTR hostFree(void * /*pUserData*/, void *pMemory)
+{
+  release(pMemory);
+}
+
+void VKAPI_PTR hostInternalAllocation(
+    void                    *pUserData,
+    size_t                   size,
+    VkInternalAllocationType /*type*/,
+    VkSystemAllocationScope  scope
+)
+{
+  countersOf(tagOf(pUserData), static_cast<uint8_t>(scopeIndex(scope)))
+      .internalBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void VKAPI_PTR hostInternalFree(
+    void                    *pUserData,
+    size_t                   size,
+    VkInternalAllocationType /*type*/,
+    VkSystemAllocationScope  scope
+)
+{
+  countersOf(tagOf(pUserData), static_cast<uint8_t>(scopeIndex(scope)))
+      .internalBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+std::array<VkAllocationCallbacks, TAG_COUNT> g_callbacks = [] {
+  std::array<VkAllocationCallbacks, TAG_COUNT> callbacks{};
+  for (size_t i = 0; i < TAG_COUNT; ++i) {
+    callbacks[i] = VkAllocationCallbacks{
+        .pUserData             = &g_userData[i],
+        .pfnAllocation         = &hostAllocation,
+        .pfnReallocation       = &hostReallocation,
+        .pfnFree               = &hostFree,
+        .pfnInternalAllocation = &hostInternalAllocation,
+        .pfnInternalFree       = &hostInternalFree,
+    };
+  }
+  return callbacks;
+}();
+
+const char *scopeName(size_t scope)
+{
+  switch (scope) {
+    case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:
+      return "command";
+    case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:
+      return "object";
+    case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:
+      return "cache";
+    case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:
+      return "device";
+    case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE:
+      return "instance";
+    default:
+      return "unknown";
+  }
+}
+
+} // namespace
+
+OSTREAM_OP(HostAllocTag tag)
+{
+  switch (tag) {
+    case HostAllocTag::Instance:
+      return os << "Instance";
+    case HostAllocTag::Device:
+      return os << "Device";
+    case HostAllocTag::Pipeline:
+      return os << "Pipeline";
+    case HostAllocTag::ShaderModule:
+      return os << "ShaderModule";
+    default:
+      return os << "Other";
+  }
+}
+
+const VkAllocationCallbacks *HostAllocator::callbacks(HostAllocTag tag)
+{
+#ifdef ABOX_HOST_ALLOCATOR
+  return &g_callbacks[static_cast<size_t>(tag)];
+#else
+  (void)tag;
+  return nullptr;
+#endif
+}
+
+HostScopeStats
+HostAllocator::scopeStats(HostAllocTag tag, VkSystemAllocationScope scope)
+{
+  const ScopeCounters &c = countersOf(
+      static_cast<uint8_t>(tag),
+      static_cast<uint8_t>(scopeIndex(scope))
+  );
+  return {
+      .allocations   = c.allocations.load(std::memory_order_relaxed),
+      .frees         = c.frees.load(std::memory_order_relaxed),
+      .liveCount     = c.liveCount.load(std::memory_order_relaxed),
+      .liveBytes     = c.liveBytes.load(std::memory_order_relaxed),
+      .peakBytes     = c.peakBytes.load(std::memory_order_relaxed),
+      .internalBytes = c.internalBytes.load(std::memory_order_relaxed),
+  };
+}
+
+std::vector<HostPoolStats> HostAllocator::poolStats()
+{
+  std::vector<HostPoolStats> stats;
+  for (const Pool &pool : state().pools) {
+    stats.push_back({
+        .classSize = pool.classSize,
+        .hits      = pool.hits.load(std::memory_order_relaxed),
+        .slabBytes = pool.slabBytes.load(std::memory_order_relaxed),
+    });
+  }
+  return stats;
+}
+
+uint64_t HostAllocator::systemAllocations()
+{
+  return state().systemAllocations.load(std::memory_order_relaxed);
+}
+
+void HostAllocator::logStats()
+{
+  for (size_t tag = 0; tag < TAG_COUNT; ++tag) {
+    for (size_t scope = 0; scope < HOST_ALLOC_SCOPE_COUNT; ++scope) {
+      const HostScopeStats s = scopeStats(
+          static_cast<HostAllocTag>(tag),
+          static_cast<VkSystemAllocationScope>(scope)
+      );
+      if (s.allocations == 0 && s.internalBytes == 0) {
+        continue;
+      }
+      LOG_INFO("Memory") << "Host allocations [" << static_cast<HostAllocTag>(tag)
+                         << " | " << scopeName(scope)
+                         << "] count: " << s.allocations
+                         << " -- live: " << s.liveCount << " (" << s.liveBytes
+                         << " B) -- peak: " << s.peakBytes
+                         << " B -- internal: " << s.internalBytes << " B";
+    }
+  }
+  uint64_t pooled = 0;
+  uint64_t slabs  = 0;
+  for (const HostPoolStats &p : poolStats()) {
+    pooled += p.hits;
+    slabs += p.slabBytes;
+  }
+  LOG_INFO("Memory") << "Host allocator pools: " << pooled << " pooled, "
+                     << systemAllocations() << " system -- slabs: " << slabs
+                     << " B";
+}
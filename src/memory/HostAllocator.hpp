@@ -0,0 +1,81 @@
+#ifndef HOST_ALLOCATOR_HPP
+#define HOST_ALLOCATOR_HPP
+
+#include "HostSizeClasses.hpp"
+#include "PreProcUtils.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+/**
+ * @brief What the driver allocates for, carried to the callbacks through
+ * pUserData so statistics are split per object family
+ */
+enum class HostAllocTag : uint8_t {
+  Instance,
+  Device,
+  Pipeline,
+  ShaderModule,
+  Other,
+  Count
+};
+
+OSTREAM_OP(HostAllocTag tag);
+
+inline constexpr size_t HOST_ALLOC_SCOPE_COUNT =
+    VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+/**
+ * @brief Host memory handed to the driver for one tag and one
+ * VkSystemAllocationScope
+ */
+struct HostScopeStats {
+  uint64_t allocations   = 0;
+  uint64_t frees         = 0;
+  uint64_t liveCount     = 0;
+  uint64_t liveBytes     = 0;
+  uint64_t peakBytes     = 0;
+  uint64_t internalBytes = 0; // reported by pfnInternalAllocation
+};
+
+struct HostPoolStats {
+  size_t   classSize;
+  uint64_t hits;      // allocations served by this class
+  uint64_t slabBytes; // memory reserved by this class
+};
+
+/**
+ * @class HostAllocator
+ * @brief ABox VkAllocationCallbacks for driver host allocations
+ *
+ * Requests up to ABOX_HOST_ALLOC_MAX_POOLED bytes with an alignment of at
+ * most 16 are served from per size class free lists carved out of 64 KiB
+ * slabs; larger or over-aligned requests go to malloc. Every allocation is
+ * preceded by a 16 byte header recording its size, class, scope and tag so
+ * frees and reallocations are accounted without a lookup.
+ *
+ * Slabs are never returned to the system: the driver may free host memory
+ * late during shutdown, and the pools stay small.
+ */
+class HostAllocator {
+   public:
+  /**
+   * @brief Callbacks for a tag, to pass both to vkCreate* and to the
+   * wrapper destroying the object (the allocators must be compatible)
+   * @return nullptr when ABOX_HOST_ALLOCATOR is not defined
+   */
+  static const VkAllocationCallbacks *callbacks(HostAllocTag tag);
+
+  static HostScopeStats scopeStats(HostAllocTag tag, VkSystemAllocationScope scope);
+
+  static std::vector<HostPoolStats> poolStats();
+
+  /** @brief Allocations that bypassed the pools (size or alignment) */
+  static uint64_t systemAllocations();
+
+  /** @brief Log per tag/scope usage and pool hit counts */
+  static void logStats();
+};
+
+#endif // HOST_ALLOCATOR_HPP
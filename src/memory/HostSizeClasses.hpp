@@ -0,0 +1,50 @@
+#ifndef HOST_SIZE_CLASSES_HPP
+#define HOST_SIZE_CLASSES_HPP
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Granularity of the system allocator, the `a` of the
+ * `actual_size = n + a * x` pattern printed by apps/allocator_test
+ */
+#ifndef ABOX_HOST_ALLOC_GRANULARITY
+  #define ABOX_HOST_ALLOC_GRANULARITY 16
+#endif
+
+/** @brief Largest request served from the HostAllocator pools */
+#ifndef ABOX_HOST_ALLOC_MAX_POOLED
+  #define ABOX_HOST_ALLOC_MAX_POOLED 1024
+#endif
+
+/**
+ * @brief Pool size classes for the HostAllocator
+ *
+ * Linear steps of `granularity` up to 8 * granularity, then four classes per
+ * power of two so internal fragmentation stays under 25%. Header only so
+ * apps/allocator_test can print the classes matching the detected pattern.
+ *
+ * @param granularity Power of two, at least 16 (HostAllocator alignment)
+ * @param maxSize Largest class, rounded down to a class boundary
+ */
+inline std::vector<size_t> deriveSizeClasses(size_t granularity, size_t maxSize)
+{
+  std::vector<size_t> classes;
+  if (granularity < 16) {
+    granularity = 16;
+  }
+  size_t size = granularity;
+  for (; size <= 8 * granularity && size <= maxSize; size += granularity) {
+    classes.push_back(size);
+  }
+  for (size_t power = 8 * granularity; power < maxSize; power *= 2) {
+    const size_t step = power / 4;
+    for (size = power + step; size <= 2 * power && size <= maxSize;
+         size += step) {
+      classes.push_back(size);
+    }
+  }
+  return classes;
+}
+
+#endif // HOST_SIZE_CLASSES_HPP
@@ -1,10 +1,13 @@
 #ifndef MEMORY_WRAPPER
 #define MEMORY_WRAPPER
 
+#include "DeferredDeletionQueue.hpp"
 #include "Logger.hpp"
+#include "ObjectRegistry.hpp"
 #include "PreProcUtils.hpp"
 #include <vulkan/vulkan_core.h>
 
+#include <atomic>
 #include <iostream> // Used in MACRO so no direct call but mandatory
 #include <typeinfo> // For typeid
 
@@ -14,9 +17,63 @@ class MemoryWrapper {
   VkP                          vulkanParent;
   VkD                          vulkanDestructionFunction;
   const VkAllocationCallbacks *pAllocator;
+#ifdef ABOX_OBJECT_TRACKING
+  // container is counted in the ObjectRegistry. Atomic: const get() may
+  // notice the creation from several threads, only one of them counts it
+  mutable std::atomic<bool> tracked = false;
+
+  static uint16_t trackingType()
+  {
+    static const uint16_t type = ObjectRegistry::registerType(typeid(T).name());
+    return type;
+  }
+
+  uint64_t trackingParent() const
+  {
+    if constexpr (std::is_same_v<VkP, std::nullptr_t>) {
+      return 0;
+    }
+    else if constexpr (std::is_pointer_v<VkP>) {
+      return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(vulkanParent));
+    }
+    else {
+      return static_cast<uint64_t>(vulkanParent);
+    }
+  }
+#endif
+
+  /**
+   * @brief Count the handle the first time it is seen non-null. vkCreate*
+   * writes through ptr(), so creation is noticed on the next access.
+   */
+  void trackCreation() const
+  {
+#ifdef ABOX_OBJECT_TRACKING
+    if (container != VK_NULL_HANDLE &&
+        !tracked.load(std::memory_order_relaxed) &&
+        !tracked.exchange(true, std::memory_order_relaxed)) {
+      ObjectRegistry::onCreate(trackingType(), trackingParent());
+    }
+#endif
+  }
+
+  /**
+   * @param released false if the handle is dropped without being destroyed
+   */
+  void trackDestruction([[maybe_unused]] bool released)
+  {
+#ifdef ABOX_OBJECT_TRACKING
+    if (tracked.exchange(false, std::memory_order_relaxed)) {
+      ObjectRegistry::onDestroy(trackingType(), trackingParent(), released);
+    }
+#endif
+  }
 
   void Destroy()
   {
+    trackCreation();
+    bool released = false;
+
     if constexpr (std::is_same_v<VkP, std::nullptr_t>) {
       LOG_DEBUG("Memory") << " ---- Destruction of Memory wrapper ["
                           << typeid(T).name() << " | no parent] -- container: "
@@ -34,10 +91,12 @@ class MemoryWrapper {
     if (vulkanDestructionFunction != nullptr && this->get() != VK_NULL_HANDLE) {
       if constexpr (std::is_same_v<VkP, std::nullptr_t>) {
         vulkanDestructionFunction(container, pAllocator);
+        released = true;
       }
       else {
         if (vulkanParent != VK_NULL_HANDLE) {
           vulkanDestructionFunction(vulkanParent, container, pAllocator);
+          released = true;
         }
         else {
           LOG_WARN("Memory") << "Skipping destruction of " << typeid(T).name()
@@ -49,6 +108,7 @@ class MemoryWrapper {
       LOG_WARN("Memory") << "Skipping destruction of " << typeid(T).name()
                          << " - destruction function is nullptr (moved-from object)";
     }
+    trackDestruction(released);
   }
 
    public:
@@ -75,6 +135,7 @@ class MemoryWrapper {
                           << "] -- container: " << (void *)this->get()
                           << " -- parent: " << (void *)vulkanParent;
     }
+    trackCreation();
   }
 
   ~MemoryWrapper() { Destroy(); }
@@ -91,6 +152,12 @@ class MemoryWrapper {
     other.vulkanParent              = VK_NULL_HANDLE;
     other.vulkanDestructionFunction = nullptr;
     other.pAllocator                = nullptr;
+#ifdef ABOX_OBJECT_TRACKING
+    tracked.store(
+        other.tracked.exchange(false, std::memory_order_relaxed),
+        std::memory_order_relaxed
+    );
+#endif
 
     if constexpr (std::is_same_v<VkP, std::nullptr_t>) {
       LOG_DEBUG("Memory") << "Dangerous -> Memory Moved [" << typeid(T).name()
@@ -114,6 +181,10 @@ class MemoryWrapper {
   MemoryWrapper &operator=(MemoryWrapper &&other) noexcept
   {
     if (this != &other) {
+      // The previous handle is overwritten without being destroyed
+      trackCreation();
+      trackDestruction(false);
+
       container                 = other.container;
       vulkanParent              = other.vulkanParent;
       vulkanDestructionFunction = other.vulkanDestructionFunction;
@@ -123,6 +194,12 @@ class MemoryWrapper {
       other.vulkanParent              = VK_NULL_HANDLE;
       other.vulkanDestructionFunction = nullptr;
       other.pAllocator                = nullptr;
+#ifdef ABOX_OBJECT_TRACKING
+      tracked.store(
+          other.tracked.exchange(false, std::memory_order_relaxed),
+          std::memory_order_relaxed
+      );
+#endif
     }
 
     if constexpr (std::is_same_v<VkP, std::nullptr_t>) {
@@ -144,16 +221,92 @@ class MemoryWrapper {
     }
     return *this;
   }
-  T      get() const { return container; }
-  T     *ptr() { return &container; }
-  inline operator T() const { return container; }
+  T get() const
+  {
+    trackCreation();
+    return container;
+  }
+
+  T *ptr()
+  {
+    trackCreation();
+    return &container;
+  }
+
+  inline operator T() const
+  {
+    trackCreation();
+    return container;
+  }
 
   void swap(const T &item)
   {
     Destroy();
     container = item;
   }
+
+  /**
+   * @brief Hand the handle over to a deferred deletion queue, it is destroyed
+   * once the frame being recorded has completed. The wrapper becomes empty.
+   */
+  void retire(DeferredDeletionQueue &queue)
+  {
+    trackCreation();
+    uint16_t trackedType = ObjectRegistry::NO_TYPE;
+#ifdef ABOX_OBJECT_TRACKING
+    if (tracked.load(std::memory_order_relaxed)) {
+      trackedType = trackingType();
+    }
+#endif
+    [[maybe_unused]] bool queued = false;
+    if (vulkanDestructionFunction != nullptr && container != VK_NULL_HANDLE) {
+      if constexpr (std::is_same_v<VkP, std::nullptr_t>) {
+        queue.enqueue(
+            container,
+            nullptr,
+            vulkanDestructionFunction,
+            pAllocator,
+            trackedType
+        );
+        queued = true;
+      }
+      else if (vulkanParent != VK_NULL_HANDLE) {
+        queue.enqueue(
+            container,
+            vulkanParent,
+            vulkanDestructionFunction,
+            pAllocator,
+            trackedType
+        );
+        queued = true;
+      }
+    }
+#ifdef ABOX_OBJECT_TRACKING
+    // The queue now accounts for the handle
+    if (queued) {
+      tracked.store(false, std::memory_order_relaxed);
+    }
+#endif
+    trackDestruction(false);
+    container = VK_NULL_HANDLE;
+  }
+
+  /**
+   * @brief swap() without stalling: the previous handle goes through the
+   * deferred deletion queue instead of being destroyed immediately
+   */
+  void swap(const T &item, DeferredDeletionQueue &queue)
+  {
+    retire(queue);
+    container = item;
+  }
   bool empty() const { return container != VK_NULL_HANDLE; }
+
+  /**
+   * @brief Callbacks the handle is destroyed with, creation must use the
+   * same ones
+   */
+  const VkAllocationCallbacks *getAllocator() const { return pAllocator; }
 };
 
 #define DEFINE_VK_MEMORY_WRAPPER_FULL(Type, Name, DestroyFunc, VkParent)       \
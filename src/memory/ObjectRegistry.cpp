@@ -0,0 +1,336 @@
+#include "ObjectRegistry.hpp"
+#include "Logger.hpp"
+#include "PreProcUtils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if defined(__GNUG__)
+  #include <cstdlib>
+  #include <cxxabi.h>
+  #include <memory>
+#endif
+
+namespace {
+
+struct alignas(ABOX_CACHE_LINE_SIZE) Shard {
+  std::atomic<uint64_t> created[ObjectRegistry::MAX_TYPES]{};
+  std::atomic<uint64_t> destroyed[ObjectRegistry::MAX_TYPES]{};
+  std::atomic<uint64_t> leaked[ObjectRegistry::MAX_TYPES]{};
+};
+
+struct alignas(ABOX_CACHE_LINE_SIZE) ParentEntry {
+  std::atomic<uint64_t> key{0}; // parent + 1, 0 = free
+  std::atomic<int64_t>  live[ObjectRegistry::MAX_TYPES]{};
+  std::atomic<int64_t>  highWater[ObjectRegistry::MAX_TYPES]{};
+};
+
+struct TypeSample {
+  std::atomic<int64_t>  highWater{0};
+  std::atomic<uint64_t> lastCreated{0};
+  std::atomic<uint64_t> lastDestroyed{0};
+  std::atomic<double>   createdPerSecond{0.0};
+  std::atomic<double>   destroyedPerSecond{0.0};
+};
+
+Shard                 g_shards[ObjectRegistry::SHARDS];
+ParentEntry           g_parents[ObjectRegistry::MAX_PARENTS];
+TypeSample            g_samples[ObjectRegistry::MAX_TYPES];
+const char           *g_typeNames[ObjectRegistry::MAX_TYPES]{};
+std::atomic<uint32_t> g_typeCount{0};
+std::atomic<int64_t>  g_lastSampleNs{0};
+std::atomic<bool>     g_parentTableFull{false};
+std::mutex            g_typeMutex; // first registration of a type only
+std::mutex            g_sampleMutex;
+
+Shard &localShard()
+{
+  thread_local const uint32_t index = static_cast<uint32_t>(
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) %
+      ObjectRegistry::SHARDS
+  );
+  return g_shards[index];
+}
+
+/**
+ * @brief Find or claim the table entry of a parent, lock-free
+ */
+ParentEntry *parentEntry(uint64_t parent)
+{
+  const uint64_t key   = parent + 1;
+  const uint64_t start = (key * 0x9E3779B97F4A7C15ull) >> 58; // 6 bits
+  for (uint32_t probe = 0; probe < ObjectRegistry::MAX_PARENTS; ++probe) {
+    ParentEntry &e    = g_parents[(start + probe) % ObjectRegistry::MAX_PARENTS];
+    uint64_t     seen = e.key.load(std::memory_order_acquire);
+    if (seen == key) {
+      return &e;
+    }
+    if (seen == 0) {
+      if (e.key.compare_exchange_strong(
+              seen, key, std::memory_order_acq_rel
+          ) ||
+          seen == key) {
+        return &e;
+      }
+    }
+  }
+  if (!g_parentTableFull.exchange(true, std::memory_order_relaxed)) {
+    LOG_WARN("Memory") << "ObjectRegistry parent table full, per parent "
+                       << "counts are incomplete";
+  }
+  return nullptr;
+}
+
+int64_t nowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()
+  )
+      .count();
+}
+
+std::string demangle(const char *name)
+{
+#if defined(__GNUG__)
+  int                                    status = 0;
+  std::unique_ptr<char, void (*)(void *)> res{
+      abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free
+  };
+  if (status == 0 && res) {
+    return res.get();
+  }
+#endif
+  return name;
+}
+
+struct Totals {
+  uint64_t created   = 0;
+  uint64_t destroyed = 0;
+  uint64_t leaked    = 0;
+};
+
+Totals totalsOf(uint32_t type)
+{
+  Totals t;
+  for (const Shard &s : g_shards) {
+    t.created += s.created[type].load(std::memory_order_relaxed);
+    t.destroyed += s.destroyed[type].load(std::memory_order_relaxed);
+    t.leaked += s.leaked[type].load(std::memory_order_relaxed);
+  }
+  return t;
+}
+
+int64_t liveOf(const Totals &t)
+{
+  return static_cast<int64_t>(t.created) -
+         static_cast<int64_t>(t.destroyed + t.leaked);
+}
+
+void atomicMax(std::atomic<int64_t> &target, int64_t value)
+{
+  int64_t current = target.load(std::memory_order_relaxed);
+  while (current < value &&
+         !target.compare_exchange_weak(
+             current, value, std::memory_order_relaxed
+         )) {
+  }
+}
+
+} // namespace
+
+uint16_t ObjectRegistry::registerType(const char *name)
+{
+  std::lock_guard lock(g_typeMutex);
+  const uint32_t  count = g_typeCount.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (std::string_view(g_typeNames[i]) == name) {
+      return static_cast<uint16_t>(i);
+    }
+  }
+  if (count >= MAX_TYPES) {
+    LOG_WARN("Memory") << "ObjectRegistry full, " << demangle(name)
+                       << " is not tracked";
+    return NO_TYPE;
+  }
+  g_typeNames[count] = name;
+  g_typeCount.store(count + 1, std::memory_order_release);
+  return static_cast<uint16_t>(count);
+}
+
+void ObjectRegistry::onCreate(uint16_t type, uint64_t parent)
+{
+  if (type >= MAX_TYPES) {
+    return;
+  }
+  localShard().created[type].fetch_add(1, std::memory_order_relaxed);
+  if (ParentEntry *e = parentEntry(parent)) {
+    const int64_t live =
+        e->live[type].fetch_add(1, std::memory_order_relaxed) + 1;
+    atomicMax(e->highWater[type], live);
+  }
+}
+
+void ObjectRegistry::onDestroy(uint16_t type, uint64_t parent, bool released)
+{
+  if (type >= MAX_TYPES) {
+    return;
+  }
+  Shard &shard = localShard();
+  (released ? shard.destroyed : shard.leaked)[type].fetch_add(
+      1, std::memory_order_relaxed
+  );
+  if (ParentEntry *e = parentEntry(parent)) {
+    e->live[type].fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void ObjectRegistry::sample(uint32_t minIntervalMs)
+{
+  const int64_t now  = nowNs();
+  int64_t       last = g_lastSampleNs.load(std::memory_order_relaxed);
+  if (last != 0 && now - last < int64_t{minIntervalMs} * 1000000) {
+    return;
+  }
+  // One sampler at a time, others just skip
+  std::unique_lock lock(g_sampleMutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return;
+  }
+  last = g_lastSampleNs.exchange(now, std::memory_order_relaxed);
+  const double seconds =
+      last != 0 ? static_cast<double>(now - last) / 1e9 : 0.0;
+
+  const uint32_t count = g_typeCount.load(std::memory_order_acquire);
+  for (uint32_t type = 0; type < count; ++type) {
+    const Totals t = totalsOf(type);
+    TypeSample  &s = g_samples[type];
+    atomicMax(s.highWater, liveOf(t));
+
+    const uint64_t prevCreated =
+        s.lastCreated.exchange(t.created, std::memory_order_relaxed);
+    const uint64_t prevDestroyed = s.lastDestroyed.exchange(
+        t.destroyed + t.leaked, std::memory_order_relaxed
+    );
+    if (seconds > 0.0) {
+      s.createdPerSecond.store(
+          static_cast<double>(t.created - prevCreated) / seconds,
+          std::memory_order_relaxed
+      );
+      s.destroyedPerSecond.store(
+          static_cast<double>(t.destroyed + t.leaked - prevDestroyed) /
+              seconds,
+          std::memory_order_relaxed
+      );
+    }
+  }
+}
+
+ObjectRegistrySnapshot ObjectRegistry::snapshot()
+{
+  ObjectRegistrySnapshot snap;
+  const uint32_t         count = g_typeCount.load(std::memory_order_acquire);
+
+  std::vector<std::string> names;
+  names.reserve(count);
+  for (uint32_t type = 0; type < count; ++type) {
+    names.push_back(demangle(g_typeNames[type]));
+  }
+
+  for (uint32_t type = 0; type < count; ++type) {
+    const Totals      t = totalsOf(type);
+    const TypeSample &s = g_samples[type];
+    const int64_t     live = liveOf(t);
+    snap.types.push_back({
+        .name      = names[type],
+        .created   = t.created,
+        .destroyed = t.destroyed,
+        .leaked    = t.leaked,
+        .live      = live,
+        .highWater =
+            std::max(live, s.highWater.load(std::memory_order_relaxed)),
+        .createdPerSecond =
+            s.createdPerSecond.load(std::memory_order_relaxed),
+        .destroyedPerSecond =
+            s.destroyedPerSecond.load(std::memory_order_relaxed),
+    });
+  }
+
+  for (const ParentEntry &e : g_parents) {
+    const uint64_t key = e.key.load(std::memory_order_acquire);
+    if (key == 0) {
+      continue;
+    }
+    for (uint32_t type = 0; type < count; ++type) {
+      const int64_t peak = e.highWater[type].load(std::memory_order_relaxed);
+      if (peak == 0) {
+        continue;
+      }
+      snap.parents.push_back({
+          .parent    = key - 1,
+          .type      = names[type],
+          .live      = e.live[type].load(std::memory_order_relaxed),
+          .highWater = peak,
+      });
+    }
+  }
+  return snap;
+}
+
+uint64_t ObjectRegistry::reportLeaks()
+{
+  const ObjectRegistrySnapshot snap  = snapshot();
+  uint64_t                     total = 0;
+  for (const ObjectTypeStats &t : snap.types) {
+    if (t.live <= 0 && t.leaked == 0) {
+      continue;
+    }
+    total += static_cast<uint64_t>(std::max<int64_t>(t.live, 0)) + t.leaked;
+    LOG_WARN("Memory") << "Leak: " << t.name << " -- live: " << t.live
+                       << " -- dropped without destruction: " << t.leaked
+                       << " -- created: " << t.created
+                       << " -- peak: " << t.highWater;
+  }
+  for (const ObjectParentStats &p : snap.parents) {
+    if (p.live > 0) {
+      LOG_WARN("Memory") << "  " << p.live << " x " << p.type
+                         << " still owned by parent "
+                         << (void *)(uintptr_t)p.parent;
+    }
+  }
+  if (total == 0) {
+    LOG_INFO("Memory") << "ObjectRegistry: no leaked Vulkan handles ("
+                       << snap.types.size() << " types tracked)";
+  }
+  return total;
+}
+
+void ObjectRegistry::reset()
+{
+  std::lock_guard lock(g_sampleMutex);
+  for (Shard &s : g_shards) {
+    for (uint32_t type = 0; type < MAX_TYPES; ++type) {
+      s.created[type].store(0, std::memory_order_relaxed);
+      s.destroyed[type].store(0, std::memory_order_relaxed);
+      s.leaked[type].store(0, std::memory_order_relaxed);
+    }
+  }
+  for (ParentEntry &e : g_parents) {
+    e.key.store(0, std::memory_order_relaxed);
+    for (uint32_t type = 0; type < MAX_TYPES; ++type) {
+      e.live[type].store(0, std::memory_order_relaxed);
+      e.highWater[type].store(0, std::memory_order_relaxed);
+    }
+  }
+  for (TypeSample &s : g_samples) {
+    s.highWater.store(0, std::memory_order_relaxed);
+    s.lastCreated.store(0, std::memory_order_relaxed);
+    s.lastDestroyed.store(0, std::memory_order_relaxed);
+    s.createdPerSecond.store(0.0, std::memory_order_relaxed);
+    s.destroyedPerSecond.store(0.0, std::memory_order_relaxed);
+  }
+  g_lastSampleNs.store(0, std::memory_order_relaxed);
+  g_parentTableFull.store(false, std::memory_order_relaxed);
+}
@@ -0,0 +1,93 @@
+#ifndef OBJECT_REGISTRY_HPP
+#define OBJECT_REGISTRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Runtime statistics of one wrapped handle type
+ */
+struct ObjectTypeStats {
+  std::string name;
+  uint64_t    created   = 0;
+  uint64_t    destroyed = 0;
+  uint64_t    leaked    = 0; // wrappers that could not destroy their handle
+  int64_t     live      = 0;
+  int64_t     highWater = 0; // sampled, see ObjectRegistry::sample()
+  double      createdPerSecond   = 0.0;
+  double      destroyedPerSecond = 0.0;
+};
+
+/**
+ * @brief Live objects of one type owned by one parent handle
+ */
+struct ObjectParentStats {
+  uint64_t    parent; // 0 for parentless handles (instance level)
+  std::string type;
+  int64_t     live;
+  int64_t     highWater;
+};
+
+struct ObjectRegistrySnapshot {
+  std::vector<ObjectTypeStats>   types;
+  std::vector<ObjectParentStats> parents;
+};
+
+/**
+ * @class ObjectRegistry
+ * @brief Process wide count of the Vulkan handles held by MemoryWrapper
+ *
+ * Fed by MemoryWrapper when ABOX_OBJECT_TRACKING is defined. Per type
+ * created/destroyed counters are sharded per thread and cache-line aligned,
+ * per parent counts live in a fixed open-addressed table; nothing takes a
+ * lock after a type's first registration. Global live counts are the
+ * difference of the sharded counters, so the per type high-water mark and
+ * rates are refreshed by sample(), while per parent high-water marks are
+ * exact.
+ */
+class ObjectRegistry {
+   public:
+  static constexpr uint32_t MAX_TYPES   = 64;
+  static constexpr uint32_t MAX_PARENTS = 64;
+  static constexpr uint32_t SHARDS      = 8;
+  static constexpr uint16_t NO_TYPE     = UINT16_MAX;
+
+  /**
+   * @brief Slot of a handle type, registered on first use
+   * @param name typeid(T).name() of the handle type
+   * @return NO_TYPE once MAX_TYPES types are registered
+   */
+  static uint16_t registerType(const char *name);
+
+  static void onCreate(uint16_t type, uint64_t parent);
+
+  /**
+   * @param released false if the handle was dropped without being destroyed
+   */
+  static void onDestroy(uint16_t type, uint64_t parent, bool released);
+
+  /**
+   * @brief Refresh high-water marks and creation/destruction rates
+   *
+   * Cheap enough to call every frame, does nothing if the previous sample
+   * is less than `minIntervalMs` old.
+   */
+  static void sample(uint32_t minIntervalMs = 250);
+
+  static ObjectRegistrySnapshot snapshot();
+
+  /**
+   * @brief Log every type with live or leaked handles
+   * @return Number of leaked handles (live + leaked)
+   */
+  static uint64_t reportLeaks();
+
+  /**
+   * @brief Zero every counter, registered types are kept (tests)
+   */
+  static void reset();
+};
+
+#endif // OBJECT_REGISTRY_HPP
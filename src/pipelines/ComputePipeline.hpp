@@ -5,6 +5,7 @@
 #include "MemoryWrapper.hpp"
 #include "PipelineBase.hpp"
 #include "ShaderHandler.hpp"
+#include <algorithm>
 #include <vulkan/vulkan_core.h>
 
 /**
@@ -17,12 +18,25 @@ class ComputePipeline : public PipelineBase {
    * @brief Construct a compute pipeline
    * @param device Logical device handle
    * @param shaders Range of shader data files (should contain one .comp shader)
+   * @param modules Device's shader modules, the pipeline keeps the one it
+   * uses
+   * @param layouts Device's layouts, the pipeline keeps the ones it uses
+   * @param cache Device's pipeline cache, records the creation time
+   * @param specialization values of the shader's specialization constants
+   * (workgroup size, loop counts...)
    */
   template <std::ranges::range R>
     requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
              std::same_as<std::ranges::range_value_t<R>, const ShaderDataFile>
-  ComputePipeline(VkDevice device, const R &shaders)
-      : PipelineBase(device, shaders)
+  ComputePipeline(
+      VkDevice                       device,
+      const R                       &shaders,
+      ShaderModuleCache             &modules,
+      PipelineLayoutCache           &layouts,
+      PipelineCache                 &cache,
+      const SpecializationConstants &specialization = {}
+  )
+      : PipelineBase(device, shaders, layouts)
   {
     if (std::ranges::empty(shaders)) {
       throw std::runtime_error("ComputePipeline requires at least one shader");
@@ -31,9 +45,7 @@ class ComputePipeline : public PipelineBase {
     // Validate that we have a compute shader
     bool hasComputeShader = false;
     for (const auto &shader : shaders) {
-      const auto           &reflectModule = shader.getReflectModule();
-      VkShaderStageFlagBits stage =
-          static_cast<VkShaderStageFlagBits>(reflectModule.shader_stage);
+      const VkShaderStageFlagBits stage = shader.getStage();
       if (stage == VK_SHADER_STAGE_COMPUTE_BIT) {
         hasComputeShader = true;
         break;
@@ -46,52 +58,46 @@ class ComputePipeline : public PipelineBase {
       );
     }
 
-    // Create shader modules and stage info
-    std::vector<ShaderModuleWrapper> shaderModules;
-    shaderModules.reserve(std::ranges::size(shaders));
-    VkPipelineShaderStageCreateInfo computeStage{};
+    validateSpecialization(shaders, specialization);
+    const VkSpecializationInfo specializationInfo = specialization.getInfo();
 
-    for (const auto &shader : shaders) {
-      VkShaderModuleCreateInfo moduleInfo = shader;
-      shaderModules.emplace_back(device);
-
-      VkResult result = vkCreateShaderModule(
-          device,
-          &moduleInfo,
-          nullptr,
-          shaderModules.back().ptr()
-      );
-
-      if (result != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create compute shader module");
-      }
-
-      computeStage = shader.getPSSCI(shaderModules.back());
-    }
+    ShaderStageSet stages = modules.stagesFor(
+        device,
+        shaders,
+        specialization.empty() ? nullptr : &specializationInfo
+    );
+    const auto computeStage = std::ranges::find(
+        stages.stages,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        &VkPipelineShaderStageCreateInfo::stage
+    );
 
     // Create compute pipeline
+    PipelineCreation            creation;
     VkComputePipelineCreateInfo pipelineInfo{
         .sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-        .pNext              = nullptr,
-        .flags              = 0u,
-        .stage              = computeStage,
-        .layout             = pipelineLayout,
+        .pNext              = cache.beginCreation(creation),
+        .flags              = cache.creationFlags(),
+        .stage              = *computeStage,
+        .layout             = getPipelineLayout(),
         .basePipelineHandle = VK_NULL_HANDLE,
         .basePipelineIndex  = -1
     };
 
     VkResult result = vkCreateComputePipelines(
         device,
-        VK_NULL_HANDLE,
+        cache.get(),
         1,
         &pipelineInfo,
-        nullptr,
+        pipeline.getAllocator(),
         pipeline.ptr()
     );
+    cache.endCreation(creation, pipeline.get());
 
     if (result != VK_SUCCESS) {
       throw std::runtime_error("Failed to create compute pipeline!");
     }
+    shaderModules = std::move(stages.modules);
 
     LOG_INFO("Pipeline") << "ComputePipeline created successfully";
     printReflectionInfo();
@@ -0,0 +1,233 @@
+#include "DynamicState.hpp"
+#include "Logger.hpp"
+
+namespace {
+
+/** @brief First topology of the class of topology, what a pipeline fixes */
+VkPrimitiveTopology topologyClass(VkPrimitiveTopology topology)
+{
+  switch (topology) {
+    case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+      return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+      return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+    case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+      return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+    default: return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  }
+}
+
+template <typename PFN>
+void load(VkDevice device, PFN &function, const char *name)
+{
+  function = reinterpret_cast<PFN>(vkGetDeviceProcAddr(device, name));
+}
+
+} // namespace
+
+void RasterState::hash(ABox::Hasher &hasher) const
+{
+  hasher.update(topology);
+  hasher.update(cullMode);
+  hasher.update(frontFace);
+  hasher.update(depthCompareOp);
+  hasher.update(polygonMode);
+  hasher.update(depthTest);
+  hasher.update(depthWrite);
+  hasher.update(depthBias);
+  hasher.update(primitiveRestart);
+  hasher.update(rasterizerDiscard);
+  hasher.update(blend);
+}
+
+std::vector<VkDynamicState>
+    ExtendedDynamicState::stateList(const DynamicStateFeatures &features)
+{
+  std::vector<VkDynamicState> list = {
+      VK_DYNAMIC_STATE_VIEWPORT,
+      VK_DYNAMIC_STATE_SCISSOR
+  };
+  if (features.extendedDynamicState) {
+    list.insert(
+        list.end(),
+        {VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+         VK_DYNAMIC_STATE_CULL_MODE,
+         VK_DYNAMIC_STATE_FRONT_FACE,
+         VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+         VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+         VK_DYNAMIC_STATE_DEPTH_COMPARE_OP}
+    );
+  }
+  if (features.extendedDynamicState2) {
+    list.insert(
+        list.end(),
+        {VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE,
+         VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE,
+         VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE}
+    );
+  }
+  if (features.polygonMode) {
+    list.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+  }
+  if (features.colorBlendEnable) {
+    list.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+  }
+  return list;
+}
+
+RasterState ExtendedDynamicState::baked(
+    const RasterState          &state,
+    const DynamicStateFeatures &features
+)
+{
+  const RasterState defaults;
+  RasterState       result = state;
+  if (features.extendedDynamicState) {
+    result.topology       = topologyClass(state.topology);
+    result.cullMode       = defaults.cullMode;
+    result.frontFace      = defaults.frontFace;
+    result.depthTest      = defaults.depthTest;
+    result.depthWrite     = defaults.depthWrite;
+    result.depthCompareOp = defaults.depthCompareOp;
+  }
+  if (features.extendedDynamicState2) {
+    result.depthBias         = defaults.depthBias;
+    result.primitiveRestart  = defaults.primitiveRestart;
+    result.rasterizerDiscard = defaults.rasterizerDiscard;
+  }
+  if (features.polygonMode) {
+    result.polygonMode = defaults.polygonMode;
+  }
+  if (features.colorBlendEnable) {
+    result.blend = defaults.blend;
+  }
+  return result;
+}
+
+void ExtendedDynamicState::enable(
+    VkDevice                    device,
+    const DynamicStateFeatures &supported
+)
+{
+  features = supported;
+  if (features.extendedDynamicState) {
+    load(device, setPrimitiveTopology, "vkCmdSetPrimitiveTopology");
+    load(device, setCullMode, "vkCmdSetCullMode");
+    load(device, setFrontFace, "vkCmdSetFrontFace");
+    load(device, setDepthTestEnable, "vkCmdSetDepthTestEnable");
+    load(device, setDepthWriteEnable, "vkCmdSetDepthWriteEnable");
+    load(device, setDepthCompareOp, "vkCmdSetDepthCompareOp");
+    features.extendedDynamicState =
+        setPrimitiveTopology && setCullMode && setFrontFace &&
+        setDepthTestEnable && setDepthWriteEnable && setDepthCompareOp;
+  }
+  if (features.extendedDynamicState2) {
+    load(device, setDepthBiasEnable, "vkCmdSetDepthBiasEnable");
+    load(
+        device,
+        setPrimitiveRestartEnable,
+        "vkCmdSetPrimitiveRestartEnable"
+    );
+    load(
+        device,
+        setRasterizerDiscardEnable,
+        "vkCmdSetRasterizerDiscardEnable"
+    );
+    features.extendedDynamicState2 = setDepthBiasEnable &&
+                                     setPrimitiveRestartEnable &&
+                                     setRasterizerDiscardEnable;
+  }
+  if (features.polygonMode) {
+    load(device, setPolygonMode, "vkCmdSetPolygonModeEXT");
+    features.polygonMode = setPolygonMode != nullptr;
+  }
+  if (features.colorBlendEnable) {
+    load(device, setColorBlendEnable, "vkCmdSetColorBlendEnableEXT");
+    features.colorBlendEnable = setColorBlendEnable != nullptr;
+  }
+  if (!(features == supported)) {
+    LOG_WARN("Vulkan") << "Missing extended dynamic state entry points, "
+                          "baking those states";
+  }
+  states = stateList(features);
+  LOG_INFO("Pipeline") << "Graphics pipelines created with " << states.size()
+                       << " dynamic states";
+}
+
+uint32_t DynamicStateRecorder::apply(
+    VkCommandBuffer    commandBuffer,
+    const RasterState &state
+)
+{
+  const DynamicStateFeatures &features = dynamicState.getFeatures();
+  uint32_t                    commands = 0;
+  // Records set(value) when the field is dynamic and not set to it already
+  const auto set = [&](bool dynamic, auto field, auto command) {
+    if (!dynamic) {
+      return;
+    }
+    if (known && current.*field == state.*field) {
+      ++skipped;
+      return;
+    }
+    command(state.*field);
+    ++commands;
+  };
+
+  set(features.extendedDynamicState,
+      &RasterState::topology,
+      [&](VkPrimitiveTopology topology) {
+        dynamicState.setPrimitiveTopology(commandBuffer, topology);
+      });
+  set(features.extendedDynamicState,
+      &RasterState::cullMode,
+      [&](VkCullModeFlags cullMode) {
+        dynamicState.setCullMode(commandBuffer, cullMode);
+      });
+  set(features.extendedDynamicState,
+      &RasterState::frontFace,
+      [&](VkFrontFace frontFace) {
+        dynamicState.setFrontFace(commandBuffer, frontFace);
+      });
+  set(features.extendedDynamicState, &RasterState::depthTest, [&](bool on) {
+    dynamicState.setDepthTestEnable(commandBuffer, on);
+  });
+  set(features.extendedDynamicState, &RasterState::depthWrite, [&](bool on) {
+    dynamicState.setDepthWriteEnable(commandBuffer, on);
+  });
+  set(features.extendedDynamicState,
+      &RasterState::depthCompareOp,
+      [&](VkCompareOp compareOp) {
+        dynamicState.setDepthCompareOp(commandBuffer, compareOp);
+      });
+  set(features.extendedDynamicState2, &RasterState::depthBias, [&](bool on) {
+    dynamicState.setDepthBiasEnable(commandBuffer, on);
+  });
+  set(features.extendedDynamicState2,
+      &RasterState::primitiveRestart,
+      [&](bool on) {
+        dynamicState.setPrimitiveRestartEnable(commandBuffer, on);
+      });
+  set(features.extendedDynamicState2,
+      &RasterState::rasterizerDiscard,
+      [&](bool on) {
+        dynamicState.setRasterizerDiscardEnable(commandBuffer, on);
+      });
+  set(features.polygonMode,
+      &RasterState::polygonMode,
+      [&](VkPolygonMode polygonMode) {
+        dynamicState.setPolygonMode(commandBuffer, polygonMode);
+      });
+  set(features.colorBlendEnable, &RasterState::blend, [&](bool on) {
+    const VkBool32 enable = on ? VK_TRUE : VK_FALSE;
+    dynamicState.setColorBlendEnable(commandBuffer, 0u, 1u, &enable);
+  });
+
+  current = state;
+  known   = true;
+  recorded += commands;
+  return commands;
+}
@@ -0,0 +1,161 @@
+#ifndef DYNAMIC_STATE_HPP
+#define DYNAMIC_STATE_HPP
+
+#include "Hash.hpp"
+#include "PreProcUtils.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+/**
+ * @brief Fixed-function state of a draw. Baked in the graphics pipeline,
+ * or set at record time for the fields the device makes dynamic.
+ */
+struct RasterState {
+  VkPrimitiveTopology topology       = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  VkCullModeFlags     cullMode       = VK_CULL_MODE_NONE;
+  VkFrontFace         frontFace      = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  VkCompareOp         depthCompareOp = VK_COMPARE_OP_LESS;
+  VkPolygonMode       polygonMode    = VK_POLYGON_MODE_FILL;
+  bool                depthTest      = false;
+  bool                depthWrite     = false;
+  bool                depthBias      = false;
+  bool                primitiveRestart  = false;
+  bool                rasterizerDiscard = false;
+  bool                blend = false; // alpha blending of color attachment 0
+
+  bool operator==(const RasterState &) const = default;
+
+  /** @brief Field by field, the padding between the flags is not hashed */
+  void hash(ABox::Hasher &hasher) const;
+};
+
+/** @brief Which RasterState fields a device can set at record time */
+struct DynamicStateFeatures {
+  // Topology, cull mode, front face, depth test, write and compare op
+  bool extendedDynamicState = false; // core from Vulkan 1.3
+  // Depth bias, primitive restart and rasterizer discard enables
+  bool extendedDynamicState2 = false; // core from Vulkan 1.3
+  // VK_EXT_extended_dynamic_state3, per state
+  bool polygonMode      = false;
+  bool colorBlendEnable = false;
+
+  bool operator==(const DynamicStateFeatures &) const = default;
+};
+
+/**
+ * @class ExtendedDynamicState
+ * @brief Extended dynamic state of one device: the states its graphics
+ * pipelines are created with dynamic, and the entry points recording sets
+ * them through
+ *
+ * Each RasterState field the device sets dynamically is left out of the
+ * pipeline key, so draws that only differ there share one pipeline instead
+ * of compiling a permutation each. Enabled by DeviceHandler from what the
+ * device supports, before any pipeline is created; until then every field
+ * is baked.
+ */
+class ExtendedDynamicState {
+  DynamicStateFeatures        features;
+  std::vector<VkDynamicState> states = stateList({});
+
+  PFN_vkCmdSetPrimitiveTopologyEXT      setPrimitiveTopology      = nullptr;
+  PFN_vkCmdSetCullModeEXT               setCullMode               = nullptr;
+  PFN_vkCmdSetFrontFaceEXT              setFrontFace              = nullptr;
+  PFN_vkCmdSetDepthTestEnableEXT        setDepthTestEnable        = nullptr;
+  PFN_vkCmdSetDepthWriteEnableEXT       setDepthWriteEnable       = nullptr;
+  PFN_vkCmdSetDepthCompareOpEXT         setDepthCompareOp         = nullptr;
+  PFN_vkCmdSetDepthBiasEnableEXT        setDepthBiasEnable        = nullptr;
+  PFN_vkCmdSetPrimitiveRestartEnableEXT setPrimitiveRestartEnable = nullptr;
+  PFN_vkCmdSetRasterizerDiscardEnableEXT setRasterizerDiscardEnable =
+      nullptr;
+  PFN_vkCmdSetPolygonModeEXT      setPolygonMode      = nullptr;
+  PFN_vkCmdSetColorBlendEnableEXT setColorBlendEnable = nullptr;
+
+  friend class DynamicStateRecorder;
+
+   public:
+  ExtendedDynamicState() = default;
+
+  DELETE_COPY(ExtendedDynamicState);
+  DELETE_MOVE(ExtendedDynamicState);
+
+  /**
+   * @brief Dynamic states of a graphics pipeline: viewport and scissor,
+   * plus those of the features
+   */
+  [[nodiscard]] static std::vector<VkDynamicState>
+      stateList(const DynamicStateFeatures &features);
+
+  /**
+   * @brief What a pipeline bakes of state: the dynamic fields at their
+   * default, so they neither split the pipeline key nor the libraries. A
+   * dynamic topology keeps its class (point, line, triangle, patch), the
+   * only part of it a pipeline fixes.
+   */
+  [[nodiscard]] static RasterState
+      baked(const RasterState &state, const DynamicStateFeatures &features);
+
+  /**
+   * @brief Use the supported features and load their entry points, the
+   * first two from Vulkan 1.3 core, the others from
+   * VK_EXT_extended_dynamic_state3
+   */
+  void enable(VkDevice device, const DynamicStateFeatures &supported);
+
+  [[nodiscard]] const DynamicStateFeatures &getFeatures() const noexcept
+  {
+    return features;
+  }
+
+  [[nodiscard]] std::span<const VkDynamicState> getStates() const noexcept
+  {
+    return states;
+  }
+
+  [[nodiscard]] RasterState baked(const RasterState &state) const
+  {
+    return baked(state, features);
+  }
+};
+
+/**
+ * @brief Sets the dynamic fields of RasterStates on one command buffer,
+ * skipping each command that would set what is already set. One per
+ * recording: the state is unknown when a command buffer begins.
+ */
+class DynamicStateRecorder {
+  const ExtendedDynamicState &dynamicState;
+  RasterState                 current;
+  bool                        known    = false;
+  uint64_t                    recorded = 0;
+  uint64_t                    skipped  = 0;
+
+   public:
+  explicit DynamicStateRecorder(const ExtendedDynamicState &dynamicState)
+      : dynamicState(dynamicState)
+  {
+  }
+
+  /**
+   * @brief Forget what was set: after vkBeginCommandBuffer, or binding a
+   * pipeline without these dynamic states
+   */
+  void reset() noexcept { known = false; }
+
+  /**
+   * @brief Set the dynamic fields of state that differ from the last ones,
+   * after binding a pipeline of the device. The other fields are the
+   * pipeline's.
+   * @return Number of commands recorded
+   */
+  uint32_t apply(VkCommandBuffer commandBuffer, const RasterState &state);
+
+  [[nodiscard]] uint64_t getRecorded() const noexcept { return recorded; }
+
+  /** @brief Set commands not recorded since the value was already set */
+  [[nodiscard]] uint64_t getSkipped() const noexcept { return skipped; }
+};
+
+#endif // DYNAMIC_STATE_HPP
@@ -1,25 +1,95 @@
 #ifndef GRAPHICS_PIPELINE_HPP
 #define GRAPHICS_PIPELINE_HPP
 
+#include "DynamicState.hpp"
 #include "Logger.hpp"
 #include "PipelineBase.hpp"
+#include "PipelineLibraryCache.hpp"
 #include "SwapchainManager.hpp"
 #include <array>
 #include <graphics/RenderPassManager.hpp>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
-static const std::array<VkDynamicState, 2> dynamicStates = {
-    VK_DYNAMIC_STATE_VIEWPORT,
-    VK_DYNAMIC_STATE_SCISSOR
-};
-
 // RenderPass is Graphics-specific, not in PipelineBase
 
 class GraphicsPipeline : public PipelineBase {
 
   VkViewport viewport;
   VkRect2D   scissor;
+  // What the pipeline bakes, the dynamic fields at their default
+  RasterState rasterState;
+  // One per part when linked from libraries, empty for a monolithic build
+  std::vector<PipelineLibraryRef> libraryParts;
+  bool                            linkTimeOptimized = false;
+
+  /**
+   * @brief Build or reuse the four library parts of pipelineInfo and
+   * fast-link them
+   * @param stages one per shader, in the same order
+   */
+  template <std::ranges::range R>
+  void linkLibraries(
+      const R                                            &shaders,
+      const std::vector<VkPipelineShaderStageCreateInfo> &stages,
+      const SpecializationConstants                      &specialization,
+      const VkGraphicsPipelineCreateInfo                 &pipelineInfo,
+      PipelineLibraryCache                               &libraries,
+      PipelineCache                                      &cache
+  )
+  {
+    // What the shader parts are built from besides their state structs
+    std::vector<VkPipelineShaderStageCreateInfo> preRasterizationStages;
+    std::vector<VkPipelineShaderStageCreateInfo> fragmentStages;
+    ABox::Hasher                                 preRasterizationShaders;
+    ABox::Hasher                                 fragmentShaders;
+    auto                                         stage = stages.begin();
+    for (const ShaderDataFile &shader : shaders) {
+      const bool fragment = stage->stage == VK_SHADER_STAGE_FRAGMENT_BIT;
+      const std::span<const uint32_t> code = shader.getCode();
+      (fragment ? fragmentStages : preRasterizationStages).push_back(*stage);
+      (fragment ? fragmentShaders : preRasterizationShaders)
+          .update(stage->stage)
+          .update(code.data(), code.size_bytes());
+      ++stage;
+    }
+    for (ABox::Hasher *hasher : {&preRasterizationShaders, &fragmentShaders}) {
+      hasher->update(specialization.getHash());
+      hasher->update(layoutKey);
+    }
+
+    libraryParts = {
+        libraries.acquire(
+            PipelineLibraryPart::VertexInput,
+            pipelineInfo,
+            {},
+            {},
+            cache
+        ),
+        libraries.acquire(
+            PipelineLibraryPart::PreRasterization,
+            pipelineInfo,
+            preRasterizationStages,
+            preRasterizationShaders.digest(),
+            cache
+        ),
+        libraries.acquire(
+            PipelineLibraryPart::FragmentShader,
+            pipelineInfo,
+            fragmentStages,
+            fragmentShaders.digest(),
+            cache
+        ),
+        libraries.acquire(
+            PipelineLibraryPart::FragmentOutput,
+            pipelineInfo,
+            {},
+            {},
+            cache
+        ),
+    };
+    pipeline = libraries.link(libraryParts, getPipelineLayout(), false, cache);
+  }
 
   /**
    * @brief Validate that required shader stages are present for graphics
@@ -36,9 +106,7 @@ class GraphicsPipeline : public PipelineBase {
     bool hasFragment = false;
 
     for (const auto &shader : shaders) {
-      const auto           &reflectModule = shader.getReflectModule();
-      VkShaderStageFlagBits stage =
-          static_cast<VkShaderStageFlagBits>(reflectModule.shader_stage);
+      const VkShaderStageFlagBits stage = shader.getStage();
       if (stage == VK_SHADER_STAGE_VERTEX_BIT) {
         hasVertex = true;
       }
@@ -69,8 +137,8 @@ class GraphicsPipeline : public PipelineBase {
   /**
    * @brief Order graphics shaders by pipeline stage
    * @param shaders Input range of shaders
-   * @return Ordered vector of shaders (vertex → tess control → tess eval →
-   * geometry → fragment)
+   * @return Ordered vector of shaders (vertex → tess control →
+   * tess eval → geometry → fragment)
    */
   template <std::ranges::range R>
     requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
@@ -87,9 +155,7 @@ class GraphicsPipeline : public PipelineBase {
         if (!shader.isReflectionValid()) {
           continue;
         }
-        const auto           &reflectModule = shader.getReflectModule();
-        VkShaderStageFlagBits stage =
-            static_cast<VkShaderStageFlagBits>(reflectModule.shader_stage);
+        const VkShaderStageFlagBits stage = shader.getStage();
         if (stage == targetStage) {
           return &shader;
         }
@@ -134,36 +200,35 @@ class GraphicsPipeline : public PipelineBase {
 
     // Validate vertex shader outputs gl_Position
     if (ordered[0]) {
-      const auto           &reflectModule = ordered[0]->getReflectModule();
-      VkShaderStageFlagBits stage =
-          static_cast<VkShaderStageFlagBits>(reflectModule.shader_stage);
+      const VkShaderStageFlagBits stage = ordered[0]->getStage();
 
       if (stage == VK_SHADER_STAGE_VERTEX_BIT) {
         bool        hasGlPosition  = false;
         const auto &reflectionData = ordered[0]->getReflectionData();
 
         LOG_DEBUG("Shader")
-            << "Vertex shader has " << reflectionData.outputVariableCount
+            << "Vertex shader has " << reflectionData.outputVariables.size()
             << " output variables";
 
-        for (uint32_t i = 0; i < reflectionData.outputVariableCount; ++i) {
-          const SpvReflectInterfaceVariable *var =
+        for (size_t i = 0; i < reflectionData.outputVariables.size(); ++i) {
+          const ReflectedInterfaceVariable &var =
               reflectionData.outputVariables[i];
+          const std::string_view name = reflectionData.nameOf(var);
           LOG_DEBUG("Shader")
               << "  Output " << i
-              << ": name=" << (var->name ? var->name : "<null>")
-              << ", location=" << var->location
-              << ", built_in=" << static_cast<int>(var->built_in) << " (hex: 0x"
-              << std::hex << static_cast<uint32_t>(var->built_in) << std::dec
+              << ": name=" << (name.empty() ? "<null>" : name)
+              << ", location=" << var.location
+              << ", built_in=" << static_cast<int>(var.builtIn) << " (hex: 0x"
+              << std::hex << static_cast<uint32_t>(var.builtIn) << std::dec
               << ")"
               << ", SpvBuiltInPosition="
               << static_cast<int>(SpvBuiltInPosition);
 
           // Check if this is gl_Position (could be identified by built_in OR by
           // having no/empty name with invalid location)
-          bool isGlPosition = (var->built_in == SpvBuiltInPosition) ||
-                              ((var->name == nullptr || var->name[0] == '\0') &&
-                               var->location == static_cast<uint32_t>(-1));
+          bool isGlPosition = (var.builtIn == SpvBuiltInPosition) ||
+                              (name.empty() &&
+                               var.location == REFLECTION_NO_LOCATION);
 
           if (isGlPosition) {
             LOG_DEBUG("Shader") << "  -> Identified as gl_Position";
@@ -188,41 +253,41 @@ class GraphicsPipeline : public PipelineBase {
       const auto &currentReflection = currentStage->getReflectionData();
       const auto &nextReflection    = nextStage->getReflectionData();
 
-      // Check each output from current stage
-      for (uint32_t outIdx = 0; outIdx < currentReflection.outputVariableCount;
-           ++outIdx) {
-        const SpvReflectInterfaceVariable *outputVar =
-            currentReflection.outputVariables[outIdx];
+      auto nameOf = [](const ShaderReflectionData       &reflection,
+                       const ReflectedInterfaceVariable &var) {
+        const std::string_view name = reflection.nameOf(var);
+        return name.empty() ? std::string_view("<unnamed>") : name;
+      };
 
+      // Check each output from current stage
+      for (const ReflectedInterfaceVariable &outputVar :
+           currentReflection.outputVariables) {
         // Skip built-ins and variables without valid locations
-        if (outputVar->built_in != static_cast<SpvBuiltIn>(-1) ||
-            outputVar->location == static_cast<uint32_t>(-1)) {
+        if (outputVar.builtIn != static_cast<SpvBuiltIn>(-1) ||
+            outputVar.location == REFLECTION_NO_LOCATION) {
           continue;
         }
 
         // Find matching input in next stage
         bool found = false;
-        for (uint32_t inIdx = 0; inIdx < nextReflection.inputVariableCount;
-             ++inIdx) {
-          const SpvReflectInterfaceVariable *inputVar =
-              nextReflection.inputVariables[inIdx];
-
-          if (inputVar->location == outputVar->location) {
+        for (const ReflectedInterfaceVariable &inputVar :
+             nextReflection.inputVariables) {
+          if (inputVar.location == outputVar.location) {
             found = true;
 
             // Validate format compatibility
-            if (inputVar->format != outputVar->format) {
+            if (inputVar.format != outputVar.format) {
               LOG_ERROR("Shader")
                   << "Shader interface mismatch at location "
-                  << outputVar->location << ": '" << currentStage->getName()
+                  << outputVar.location << ": '" << currentStage->getName()
                   << "' outputs "
-                  << PipelineBase::formatToString(outputVar->format)
-                  << " (variable: "
-                  << (outputVar->name ? outputVar->name : "<unnamed>") << ")"
+                  << PipelineBase::formatToString(outputVar.format)
+                  << " (variable: " << nameOf(currentReflection, outputVar)
+                  << ")"
                   << " but '" << nextStage->getName() << "' expects "
-                  << PipelineBase::formatToString(inputVar->format)
-                  << " (variable: "
-                  << (inputVar->name ? inputVar->name : "<unnamed>") << ")";
+                  << PipelineBase::formatToString(inputVar.format)
+                  << " (variable: " << nameOf(nextReflection, inputVar)
+                  << ")";
             }
             break;
           }
@@ -231,31 +296,25 @@ class GraphicsPipeline : public PipelineBase {
         if (!found) {
           LOG_ERROR("Shader")
               << "Shader interface mismatch: '" << currentStage->getName()
-              << "' outputs location " << outputVar->location << " (variable: "
-              << (outputVar->name ? outputVar->name : "<unnamed>") << ")"
+              << "' outputs location " << outputVar.location << " (variable: "
+              << nameOf(currentReflection, outputVar) << ")"
               << " but '" << nextStage->getName() << "' doesn't consume it";
         }
       }
 
       // Check for unmatched inputs in next stage
-      for (uint32_t inIdx = 0; inIdx < nextReflection.inputVariableCount;
-           ++inIdx) {
-        const SpvReflectInterfaceVariable *inputVar =
-            nextReflection.inputVariables[inIdx];
-
+      for (const ReflectedInterfaceVariable &inputVar :
+           nextReflection.inputVariables) {
         // Skip built-ins and variables without valid locations
-        if (inputVar->built_in != static_cast<SpvBuiltIn>(-1) ||
-            inputVar->location == static_cast<uint32_t>(-1)) {
+        if (inputVar.builtIn != static_cast<SpvBuiltIn>(-1) ||
+            inputVar.location == REFLECTION_NO_LOCATION) {
           continue;
         }
 
         bool hasMatchingOutput = false;
-        for (uint32_t outIdx = 0;
-             outIdx < currentReflection.outputVariableCount;
-             ++outIdx) {
-          const SpvReflectInterfaceVariable *outputVar =
-              currentReflection.outputVariables[outIdx];
-          if (outputVar->location == inputVar->location) {
+        for (const ReflectedInterfaceVariable &outputVar :
+             currentReflection.outputVariables) {
+          if (outputVar.location == inputVar.location) {
             hasMatchingOutput = true;
             break;
           }
@@ -264,9 +323,8 @@ class GraphicsPipeline : public PipelineBase {
         if (!hasMatchingOutput) {
           LOG_ERROR("Shader")
               << "Shader interface mismatch: '" << nextStage->getName()
-              << "' expects input at location " << inputVar->location
-              << " (variable: "
-              << (inputVar->name ? inputVar->name : "<unnamed>") << ")"
+              << "' expects input at location " << inputVar.location
+              << " (variable: " << nameOf(nextReflection, inputVar) << ")"
               << " but '" << currentStage->getName() << "' doesn't provide it";
         }
       }
@@ -282,52 +340,56 @@ class GraphicsPipeline : public PipelineBase {
    * @param device Logical device handle
    * @param swapchain Swapchain manager for render pass configuration
    * @param shaders Range of shader data files (accepts any container)
+   * @param renderPass Render pass the pipeline is used in
+   * @param modules Device's shader modules, the pipeline keeps the ones it
+   * uses
+   * @param layouts Device's layouts, the pipeline keeps the ones it uses
+   * @param cache Device's pipeline cache, records the creation time
+   * @param libraries Device's pipeline libraries, the pipeline is linked
+   * from them when they are enabled
+   * @param dynamicState Device's extended dynamic state, the fields of
+   * raster it covers are left dynamic
+   * @param specialization values of the specialization constants, shared
+   * by every stage
+   * @param raster fixed-function state of the draws
    */
   template <std::ranges::input_range R>
     requires std::
         same_as<std::remove_cv_t<std::ranges::range_value_t<R>>, ShaderDataFile>
       GraphicsPipeline(
-          VkDevice         device,
-          const Swapchain &swapchain,
-          const R         &shaders,
-          VkRenderPass     renderPass
+          VkDevice                       device,
+          const Swapchain               &swapchain,
+          const R                       &shaders,
+          VkRenderPass                   renderPass,
+          ShaderModuleCache             &modules,
+          PipelineLayoutCache           &layouts,
+          PipelineCache                 &cache,
+          PipelineLibraryCache          &libraries,
+          const ExtendedDynamicState    &dynamicState,
+          const SpecializationConstants &specialization = {},
+          const RasterState             &raster         = {}
       )
-      : PipelineBase(device, shaders)
+      : PipelineBase(device, shaders, layouts)
+      , rasterState(dynamicState.baked(raster))
   {
     validateGraphicsShaderStages(shaders);
     validateGraphicsShaderInterfaces(shaders);
+    validateSpecialization(shaders, specialization);
+    const VkSpecializationInfo specializationInfo = specialization.getInfo();
 
     LOG_DEBUG("Pipeline") << "Device value: " << (void *)device;
 
-    // Create shader modules and stages
-    std::vector<ShaderModuleWrapper>             shaderModules;
-    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
-    shaderModules.reserve(std::ranges::size(shaders));
-    shaderStages.reserve(std::ranges::size(shaders));
-
-    for (const auto &shader : shaders) {
-      VkShaderModuleCreateInfo moduleInfo = shader;
-      shaderModules.emplace_back(device);
-
-      VkResult result = vkCreateShaderModule(
-          device,
-          &moduleInfo,
-          nullptr,
-          shaderModules.back().ptr()
-      );
-
-      if (result != VK_SUCCESS) {
-        throw std::runtime_error(
-            "Failed to create shader module for graphics pipeline"
-        );
-      }
-
-      shaderStages.push_back(shader.getPSSCI(shaderModules.back()));
-    }
+    ShaderStageSet stages = modules.stagesFor(
+        device,
+        shaders,
+        specialization.empty() ? nullptr : &specializationInfo
+    );
 
     updateExtent(swapchain.getExtent());
 
-    VkPipelineDynamicStateCreateInfo dynamicState{
+    const std::span<const VkDynamicState> dynamicStates =
+        dynamicState.getStates();
+    VkPipelineDynamicStateCreateInfo dynamicStateInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0u,
@@ -349,8 +411,8 @@ class GraphicsPipeline : public PipelineBase {
         .sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
         .pNext    = nullptr,
         .flags    = 0u,
-        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-        .primitiveRestartEnable = VK_FALSE
+        .topology = rasterState.topology,
+        .primitiveRestartEnable = rasterState.primitiveRestart
     };
 
     VkPipelineViewportStateCreateInfo viewportState{
@@ -368,11 +430,11 @@ class GraphicsPipeline : public PipelineBase {
         .pNext = nullptr,
         .flags = 0u,
         .depthClampEnable        = VK_FALSE,
-        .rasterizerDiscardEnable = VK_FALSE,
-        .polygonMode             = VK_POLYGON_MODE_FILL,
-        .cullMode                = 0u,
-        .frontFace               = VK_FRONT_FACE_COUNTER_CLOCKWISE,
-        .depthBiasEnable         = VK_FALSE,
+        .rasterizerDiscardEnable = rasterState.rasterizerDiscard,
+        .polygonMode             = rasterState.polygonMode,
+        .cullMode                = rasterState.cullMode,
+        .frontFace               = rasterState.frontFace,
+        .depthBiasEnable         = rasterState.depthBias,
         .depthBiasConstantFactor = 0.0f,
         .depthBiasClamp          = 0.0f,
         .depthBiasSlopeFactor    = 0.0f,
@@ -391,10 +453,26 @@ class GraphicsPipeline : public PipelineBase {
         .alphaToOneEnable      = VK_FALSE
     };
 
+    VkPipelineDepthStencilStateCreateInfo depthStencil{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0u,
+        .depthTestEnable       = rasterState.depthTest,
+        .depthWriteEnable      = rasterState.depthWrite,
+        .depthCompareOp        = rasterState.depthCompareOp,
+        .depthBoundsTestEnable = VK_FALSE,
+        .stencilTestEnable     = VK_FALSE,
+        .front                 = {},
+        .back                  = {},
+        .minDepthBounds        = 0.0f,
+        .maxDepthBounds        = 1.0f
+    };
+
+    // Blend factors are only read with blending enabled
     VkPipelineColorBlendAttachmentState colorBlendAttachment{
-        .blendEnable         = VK_FALSE,
-        .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
-        .dstColorBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .blendEnable         = rasterState.blend,
+        .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+        .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
         .colorBlendOp        = VK_BLEND_OP_ADD,
         .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
         .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
@@ -415,7 +493,7 @@ class GraphicsPipeline : public PipelineBase {
     };
 
     LOG_DEBUG("Pipeline") << "Shader Stages loading into Pipeline Info";
-    for (const VkPipelineShaderStageCreateInfo &a : shaderStages) {
+    for (const VkPipelineShaderStageCreateInfo &a : stages.stages) {
       LOG_DEBUG("Pipeline") << "  Stage: " << a.stage << " - entry point: \""
                             << std::string(a.pName) << "\"";
     }
@@ -423,42 +501,60 @@ class GraphicsPipeline : public PipelineBase {
     VkGraphicsPipelineCreateInfo pipelineInfo{
         .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
         .pNext               = nullptr,
-        .flags               = 0u,
-        .stageCount          = static_cast<uint32_t>(shaderStages.size()),
-        .pStages             = shaderStages.data(),
+        .flags               = cache.creationFlags(),
+        .stageCount          = static_cast<uint32_t>(stages.stages.size()),
+        .pStages             = stages.stages.data(),
         .pVertexInputState   = &vertexInputInfo,
         .pInputAssemblyState = &inputAssembly,
         .pTessellationState  = nullptr,
         .pViewportState      = &viewportState,
         .pRasterizationState = &rasterizer,
         .pMultisampleState   = &multisampling,
-        .pDepthStencilState  = nullptr,
+        .pDepthStencilState  = &depthStencil,
         .pColorBlendState    = &colorBlending,
-        .pDynamicState       = &dynamicState,
-        .layout              = pipelineLayout,
+        .pDynamicState       = &dynamicStateInfo,
+        .layout              = getPipelineLayout(),
         .renderPass          = renderPass,
         .subpass             = 0,
         .basePipelineHandle  = VK_NULL_HANDLE,
         .basePipelineIndex   = -1,
     };
 
-    VkResult res = vkCreateGraphicsPipelines(
-        device,
-        VK_NULL_HANDLE,
-        1,
-        &pipelineInfo,
-        nullptr,
-        pipeline.ptr()
-    );
+    if (libraries.isEnabled()) {
+      linkLibraries(
+          shaders,
+          stages.stages,
+          specialization,
+          pipelineInfo,
+          libraries,
+          cache
+      );
+    }
+    else {
+      PipelineCreation creation;
+      pipelineInfo.pNext = cache.beginCreation(creation);
+      VkResult res       = vkCreateGraphicsPipelines(
+          device,
+          cache.get(),
+          1,
+          &pipelineInfo,
+          pipeline.getAllocator(),
+          pipeline.ptr()
+      );
+      cache.endCreation(creation, pipeline.get());
 
-    if (res != VK_SUCCESS) {
-      std::stringstream ss;
-      ss << "Failed to create the graphics pipeline !\n\tError value : " << res
-         << std::endl;
-      throw std::runtime_error(ss.str().c_str());
+      if (res != VK_SUCCESS) {
+        std::stringstream ss;
+        ss << "Failed to create the graphics pipeline !\n\tError value : "
+           << res << std::endl;
+        throw std::runtime_error(ss.str().c_str());
+      }
     }
+    shaderModules = std::move(stages.modules);
 
-    LOG_INFO("Pipeline") << "GraphicsPipeline created successfully";
+    LOG_INFO("Pipeline") << "GraphicsPipeline "
+                         << (libraryParts.empty() ? "created" : "fast-linked")
+                         << " successfully";
     printReflectionInfo();
   }
 
@@ -469,6 +565,53 @@ class GraphicsPipeline : public PipelineBase {
     return VK_PIPELINE_BIND_POINT_GRAPHICS;
   }
 
+  /**
+   * @brief Linked from libraries without link-time optimization yet, see
+   * linkOptimized
+   */
+  [[nodiscard]] bool isFastLinked() const noexcept
+  {
+    return !libraryParts.empty() && !linkTimeOptimized;
+  }
+
+  /**
+   * @brief Link the same libraries again with link-time optimization. Only
+   * reads the pipeline: run it on a worker while the fast-linked one renders
+   * @throws std::runtime_error on failure
+   */
+  [[nodiscard]] PipelineWrapper
+      linkOptimized(PipelineLibraryCache &libraries, PipelineCache &cache) const
+  {
+    return libraries.link(libraryParts, getPipelineLayout(), true, cache);
+  }
+
+  /**
+   * @brief Replace the fast-linked handle by the result of linkOptimized, the
+   * old one goes through the deletion queue
+   * @return false if the pipeline was retired meanwhile, optimized is then
+   * left to be destroyed
+   */
+  bool adoptOptimized(PipelineWrapper &&optimized, DeferredDeletionQueue &queue)
+  {
+    if (pipeline.get() == VK_NULL_HANDLE) {
+      return false;
+    }
+    pipeline.retire(queue);
+    pipeline          = std::move(optimized);
+    linkTimeOptimized = true;
+    return true;
+  }
+
+  /**
+   * @brief The fixed-function state baked in the pipeline, its dynamic
+   * fields at their default: what recording sets them to unless a draw
+   * asks otherwise
+   */
+  [[nodiscard]] const RasterState &getRasterState() const noexcept
+  {
+    return rasterState;
+  }
+
   [[nodiscard]] VkViewport getViewport() const noexcept { return viewport; }
 
   [[nodiscard]] const VkViewport *getViewportPtr() const noexcept
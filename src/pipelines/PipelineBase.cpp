@@ -39,38 +39,20 @@ const char *PipelineBase::formatToString(SpvReflectFormat format)
   }
 }
 
-void PipelineBase::createPipelineLayout(VkDevice device)
+void PipelineBase::createPipelineLayout(
+    VkDevice                         device,
+    PipelineLayoutCache             &layouts,
+    PipelineLayoutCache::SetBindings sets
+)
 {
-  std::vector<VkDescriptorSetLayout> layouts;
-  layouts.reserve(descriptorSetLayouts.size());
+  PipelineLayoutSet set =
+      layouts.acquire(device, std::move(sets), pushConstantRanges);
+  descriptorSetLayouts = std::move(set.setLayouts);
+  pipelineLayout       = std::move(set.layout);
+  layoutKey            = set.key;
 
-  for (const auto &layout : descriptorSetLayouts) {
-    layouts.push_back(layout.get());
-  }
-
-  VkPipelineLayoutCreateInfo pipelineLayoutInfo{
-      .sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-      .pNext          = nullptr,
-      .flags          = 0,
-      .setLayoutCount = static_cast<uint32_t>(layouts.size()),
-      .pSetLayouts    = layouts.data(),
-      .pushConstantRangeCount =
-          static_cast<uint32_t>(pushConstantRanges.size()),
-      .pPushConstantRanges = pushConstantRanges.data()
-  };
-
-  VkResult result = vkCreatePipelineLayout(
-      device,
-      &pipelineLayoutInfo,
-      nullptr,
-      pipelineLayout.ptr()
-  );
-
-  if (result != VK_SUCCESS) {
-    throw std::runtime_error("Failed to create pipeline layout!");
-  }
-
-  LOG_DEBUG("Pipeline") << "Created pipeline layout with " << layouts.size()
+  LOG_DEBUG("Pipeline") << "Using pipeline layout with "
+                        << descriptorSetLayouts.size()
                         << " descriptor sets and " << pushConstantRanges.size()
                         << " push constant ranges";
 }
@@ -90,7 +72,7 @@ void PipelineBase::bindDescriptorSets(
     vkCmdBindDescriptorSets(
         commandBuffer,
         getBindPoint(),
-        pipelineLayout,
+        getPipelineLayout(),
         firstSet,
         static_cast<uint32_t>(descriptorSets.size()),
         descriptorSets.data(),
@@ -100,6 +82,13 @@ void PipelineBase::bindDescriptorSets(
   }
 }
 
+void PipelineBase::retire(DeferredDeletionQueue &queue)
+{
+  pipeline.retire(queue);
+  pipelineLayout.reset();
+  descriptorSetLayouts.clear();
+}
+
 void PipelineBase::printReflectionInfo() const
 {
   LOG_INFO("Pipeline") << "=== Pipeline Reflection Info ===";
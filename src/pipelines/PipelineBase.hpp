@@ -1,26 +1,20 @@
 #ifndef PIPELINE_BASE_HPP
 #define PIPELINE_BASE_HPP
 
+#include "Hash.hpp"
+#include "HostAllocator.hpp"
 #include "Logger.hpp"
 #include "MemoryWrapper.hpp"
+#include "PipelineCache.hpp"
+#include "PipelineLayoutCache.hpp"
 #include "ShaderHandler.hpp"
+#include "ShaderModuleCache.hpp"
+#include "SpecializationConstants.hpp"
 #include <map>
 #include <ranges>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
-DEFINE_VK_MEMORY_WRAPPER(
-    VkDescriptorSetLayout,
-    DescriptorSetLayout,
-    vkDestroyDescriptorSetLayout
-)
-
-DEFINE_VK_MEMORY_WRAPPER(
-    VkPipelineLayout,
-    PipelineLayout,
-    vkDestroyPipelineLayout
-)
-
 DEFINE_VK_MEMORY_WRAPPER(VkPipeline, Pipeline, vkDestroyPipeline)
 
 /**
@@ -30,24 +24,28 @@ DEFINE_VK_MEMORY_WRAPPER(VkPipeline, Pipeline, vkDestroyPipeline)
  */
 class PipelineBase {
    protected:
-  std::vector<VkPushConstantRange>        pushConstantRanges;
-  std::vector<DescriptorSetLayoutWrapper> descriptorSetLayouts;
-  PipelineWrapper                         pipeline;
-  PipelineLayoutWrapper                   pipelineLayout;
+  std::vector<VkPushConstantRange> pushConstantRanges;
+  // Shared with the other pipelines declaring the same resources
+  std::vector<DescriptorSetLayoutRef> descriptorSetLayouts;
+  PipelineWrapper                     pipeline;
+  PipelineLayoutRef                   pipelineLayout;
+  // Shared with the other pipelines built from the same SPIR-V
+  std::vector<ShaderModuleRef> shaderModules;
+  // Set layouts and push constant ranges, see getLayoutKey
+  ABox::Hash128 layoutKey;
 
   /**
-   * @brief Build descriptor set layouts and push constant ranges from shader
-   * reflection data (internal helper)
-   * @param device Logical device handle
+   * @brief Gather descriptor set bindings and push constant ranges from
+   * shader reflection data (internal helper)
    * @param shaders Range of shader data files with reflection information
+   * @return Bindings by set index, for PipelineLayoutCache::acquire
    */
   template <std::ranges::range R>
     requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
              std::same_as<std::ranges::range_value_t<R>, const ShaderDataFile>
-  void buildReflectionDataImpl(VkDevice device, const R &shaders)
+  PipelineLayoutCache::SetBindings buildReflectionDataImpl(const R &shaders)
   {
-    std::map<uint32_t, std::vector<VkDescriptorSetLayoutBinding>>
-        setBindingsMap;
+    PipelineLayoutCache::SetBindings setBindingsMap;
 
     for (const ShaderDataFile &shader : shaders) {
       if (!shader.isReflectionValid()) {
@@ -55,61 +53,49 @@ class PipelineBase {
         continue;
       }
 
-      const auto &reflectModule  = shader.getReflectModule();
-      const auto &reflectionData = shader.getReflectionData();
-
-      VkShaderStageFlagBits stage =
-          static_cast<VkShaderStageFlagBits>(reflectModule.shader_stage);
-
-      for (uint32_t i = 0; i < reflectionData.descriptorSetCount; ++i) {
-        const SpvReflectDescriptorSet *set = reflectionData.descriptorSets[i];
-
-        LOG_DEBUG("Shader") << "Processing descriptor set " << set->set
-                            << " with " << set->binding_count << " bindings";
-
-        for (uint32_t j = 0; j < set->binding_count; ++j) {
-          const SpvReflectDescriptorBinding *binding = set->bindings[j];
-
-          VkDescriptorSetLayoutBinding layoutBinding{};
-          layoutBinding.binding = binding->binding;
-          layoutBinding.descriptorType =
-              static_cast<VkDescriptorType>(binding->descriptor_type);
-          layoutBinding.descriptorCount    = binding->count;
-          layoutBinding.stageFlags         = stage;
-          layoutBinding.pImmutableSamplers = nullptr;
-
-          auto &bindings        = setBindingsMap[set->set];
-          auto  existingBinding = std::find_if(
-              bindings.begin(),
-              bindings.end(),
-              [&](const VkDescriptorSetLayoutBinding &b) {
-                return b.binding == layoutBinding.binding;
-              }
-          );
+      const ShaderReflectionData &reflectionData = shader.getReflectionData();
+      const VkShaderStageFlagBits stage          = shader.getStage();
+
+      for (const ReflectedDescriptorBinding &binding :
+           reflectionData.descriptorBindings) {
+        VkDescriptorSetLayoutBinding layoutBinding{};
+        layoutBinding.binding            = binding.binding;
+        layoutBinding.descriptorType     = binding.descriptorType;
+        layoutBinding.descriptorCount    = binding.count;
+        layoutBinding.stageFlags         = stage;
+        layoutBinding.pImmutableSamplers = nullptr;
+
+        auto &bindings        = setBindingsMap[binding.set];
+        auto  existingBinding = std::find_if(
+            bindings.begin(),
+            bindings.end(),
+            [&](const VkDescriptorSetLayoutBinding &b) {
+              return b.binding == layoutBinding.binding;
+            }
+        );
 
-          if (existingBinding != bindings.end()) {
-            existingBinding->stageFlags |= stage;
-            LOG_DEBUG("Shader")
-                << "  Merged binding " << layoutBinding.binding
-                << " with existing (stages: 0x" << std::hex
-                << existingBinding->stageFlags << std::dec << ")";
-          }
-          else {
-            bindings.push_back(layoutBinding);
-            LOG_DEBUG("Shader") << "  Added binding " << layoutBinding.binding
-                                << ", type: " << layoutBinding.descriptorType
-                                << ", count: " << layoutBinding.descriptorCount;
-          }
+        if (existingBinding != bindings.end()) {
+          existingBinding->stageFlags |= stage;
+          LOG_DEBUG("Shader")
+              << "  Merged binding " << layoutBinding.binding
+              << " of set " << binding.set << " with existing (stages: 0x"
+              << std::hex << existingBinding->stageFlags << std::dec << ")";
+        }
+        else {
+          bindings.push_back(layoutBinding);
+          LOG_DEBUG("Shader") << "  Added binding " << layoutBinding.binding
+                              << " of set " << binding.set
+                              << ", type: " << layoutBinding.descriptorType
+                              << ", count: " << layoutBinding.descriptorCount;
         }
       }
 
-      for (uint32_t i = 0; i < reflectionData.pushConstantCount; ++i) {
-        const SpvReflectBlockVariable *pushConstant =
-            reflectionData.pushConstants[i];
+      for (const ReflectedPushConstant &pushConstant :
+           reflectionData.pushConstants) {
         VkPushConstantRange range{};
         range.stageFlags   = stage;
-        range.offset       = pushConstant->offset;
-        range.size         = pushConstant->size;
+        range.offset       = pushConstant.offset;
+        range.size         = pushConstant.size;
         auto existingRange = std::find_if(
             pushConstantRanges.begin(),
             pushConstantRanges.end(),
@@ -134,45 +120,65 @@ class PipelineBase {
       }
     }
 
-    descriptorSetLayouts.reserve(setBindingsMap.size());
-    for (const auto &[setIndex, bindings] : setBindingsMap) {
-      VkDescriptorSetLayoutCreateInfo layoutInfo{
-          .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-          .pNext        = nullptr,
-          .flags        = 0,
-          .bindingCount = static_cast<uint32_t>(bindings.size()),
-          .pBindings    = bindings.data()
-      };
-      while (descriptorSetLayouts.size() <= setIndex) {
-        descriptorSetLayouts.emplace_back(device);
-      }
-
-      VkResult result = vkCreateDescriptorSetLayout(
-          device,
-          &layoutInfo,
-          nullptr,
-          descriptorSetLayouts[setIndex].ptr()
-      );
+    PipelineLayoutCache::normalize(pushConstantRanges);
+    return setBindingsMap;
+  }
 
-      if (result != VK_SUCCESS) {
-        throw std::runtime_error(
-            "Failed to create descriptor set layout for set " +
-            std::to_string(setIndex)
-        );
+  /**
+   * @brief Check the specialization values against the constants the
+   * shaders declare: a value whose size differs from the reflected type is
+   * invalid usage, an id no stage declares is only logged
+   * @throws std::runtime_error on a size mismatch
+   */
+  template <std::ranges::range R>
+    requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
+             std::same_as<std::ranges::range_value_t<R>, const ShaderDataFile>
+  static void validateSpecialization(
+      const R                       &shaders,
+      const SpecializationConstants &specialization
+  )
+  {
+    for (const VkSpecializationMapEntry &entry : specialization.getEntries()) {
+      bool declared = false;
+      for (const ShaderDataFile &shader : shaders) {
+        if (!shader.isReflectionValid()) {
+          continue;
+        }
+        const ShaderReflectionData &reflection = shader.getReflectionData();
+        const ReflectedSpecializationConstant *constant =
+            reflection.findSpecializationConstant(entry.constantID);
+        if (!constant) {
+          continue;
+        }
+        declared = true;
+        if (constant->size != entry.size) {
+          const std::string message =
+              "Specialization constant " + std::to_string(entry.constantID) +
+              " ('" + std::string(reflection.nameOf(*constant)) + "') of " +
+              shader.getName() + " is a " +
+              specializationTypeName(constant->kind, constant->size) +
+              ", got " + std::to_string(entry.size) + " bytes";
+          LOG_ERROR("Pipeline") << message;
+          throw std::runtime_error(message);
+        }
+      }
+      if (!declared) {
+        LOG_WARN("Pipeline") << "Specialization constant " << entry.constantID
+                             << " is not declared by any stage, ignored";
       }
-
-      LOG_DEBUG("Shader") << "Created descriptor set layout for set "
-                          << setIndex << " with " << bindings.size()
-                          << " bindings";
     }
   }
 
   /**
-   * @brief Create the pipeline layout from descriptor set layouts and push
-   * constants
+   * @brief Take the descriptor set layouts and pipeline layout from the
+   * device's cache, shared with every pipeline of the same bindings
    * @param device Logical device handle
    */
-  void createPipelineLayout(VkDevice device);
+  void createPipelineLayout(
+      VkDevice                         device,
+      PipelineLayoutCache             &layouts,
+      PipelineLayoutCache::SetBindings sets
+  );
 
   /**
    * @brief Helper to convert SpvReflectFormat to string for error messages
@@ -187,18 +193,21 @@ class PipelineBase {
    * @param device Logical device handle
    * @param shaders Range of shader data files (accepts any container: list,
    * vector, deque, etc.)
+   * @param layouts Device's layouts, the pipeline keeps the ones it uses
    */
   template <std::ranges::range R>
     requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
                  std::same_as<
                      std::ranges::range_value_t<R>,
                      const ShaderDataFile>
-  PipelineBase(VkDevice device, const R &shaders)
-      : pipeline(device)
-      , pipelineLayout(device)
+  PipelineBase(VkDevice device, const R &shaders, PipelineLayoutCache &layouts)
+      : pipeline(
+            device,
+            VK_NULL_HANDLE,
+            HostAllocator::callbacks(HostAllocTag::Pipeline)
+        )
   {
-    buildReflectionDataImpl(device, shaders);
-    createPipelineLayout(device);
+    createPipelineLayout(device, layouts, buildReflectionDataImpl(shaders));
   }
 
   virtual ~PipelineBase() = default;
@@ -208,12 +217,14 @@ class PipelineBase {
 
   [[nodiscard]] VkPipeline getPipeline() const noexcept { return pipeline; }
 
+  /** @brief Null once retired */
   [[nodiscard]] VkPipelineLayout getPipelineLayout() const noexcept
   {
-    return pipelineLayout;
+    return pipelineLayout ? pipelineLayout->get() : VK_NULL_HANDLE;
   }
 
-  [[nodiscard]] const std::vector<DescriptorSetLayoutWrapper> &
+  /** @brief By set index, a set no stage uses has an empty layout */
+  [[nodiscard]] const std::vector<DescriptorSetLayoutRef> &
       getDescriptorSetLayouts() const noexcept
   {
     return descriptorSetLayouts;
@@ -225,6 +236,15 @@ class PipelineBase {
     return pushConstantRanges;
   }
 
+  /**
+   * @brief Hash of the reflected bindings and push constant ranges: pipelines
+   * with equal keys share their layouts, so they are bind compatible
+   */
+  [[nodiscard]] const ABox::Hash128 &getLayoutKey() const noexcept
+  {
+    return layoutKey;
+  }
+
   /**
    * @brief Get the pipeline bind point (graphics or compute)
    * @return VkPipelineBindPoint for this pipeline type
@@ -267,7 +287,7 @@ class PipelineBase {
     for (const auto &range : pushConstantRanges) {
       vkCmdPushConstants(
           commandBuffer,
-          pipelineLayout,
+          getPipelineLayout(),
           range.stageFlags,
           range.offset,
           range.size,
@@ -280,6 +300,14 @@ class PipelineBase {
    * @brief Print reflection information for debugging
    */
   void printReflectionInfo() const;
+
+  /**
+   * @brief Hand the pipeline over to the deletion queue, frames in flight
+   * may still use it, and release the shared layouts: the cache retires
+   * them once unused, see PipelineLayoutCache::retireUnused. The pipeline
+   * is empty afterwards.
+   */
+  void retire(DeferredDeletionQueue &queue);
 };
 
 #endif // PIPELINE_BASE_HPP
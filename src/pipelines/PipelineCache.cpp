@@ -0,0 +1,438 @@
+#include "PipelineCache.hpp"
+#include "HostAllocator.hpp"
+#include "Logger.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::atomic<uint64_t> g_tmpCounter{0};
+
+/** @brief Name unique across threads and processes saving the same file */
+fs::path temporaryPath(const fs::path &file)
+{
+  const uint64_t unique =
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) ^
+      static_cast<uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count()
+      ) ^
+      (g_tmpCounter.fetch_add(1, std::memory_order_relaxed) << 48);
+  return fs::path(file.string() + ".tmp-" + std::to_string(unique));
+}
+
+std::optional<std::vector<std::byte>> readFile(const fs::path &file)
+{
+  std::ifstream in(file, std::ios::binary | std::ios::ate);
+  if (!in.is_open()) {
+    return std::nullopt;
+  }
+  std::vector<std::byte> data(static_cast<size_t>(in.tellg()));
+  in.seekg(0);
+  in.read(
+      reinterpret_cast<char *>(data.data()),
+      static_cast<std::streamsize>(data.size())
+  );
+  if (!in) {
+    return std::nullopt;
+  }
+  return data;
+}
+
+VkResult createCache(
+    VkDevice                             device,
+    std::span<const std::byte>           initialData,
+    std::optional<PipelineCacheWrapper> &cache
+)
+{
+  const VkPipelineCacheCreateInfo cacheInfo{
+      .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .pNext           = nullptr,
+      .flags           = 0u,
+      .initialDataSize = initialData.size(),
+      .pInitialData    = initialData.data()
+  };
+  cache.emplace(
+      device,
+      VK_NULL_HANDLE,
+      HostAllocator::callbacks(HostAllocTag::Pipeline)
+  );
+  const VkResult result = vkCreatePipelineCache(
+      device,
+      &cacheInfo,
+      cache->getAllocator(),
+      cache->ptr()
+  );
+  if (result != VK_SUCCESS) {
+    cache.reset();
+  }
+  return result;
+}
+
+} // namespace
+
+OSTREAM_OP(PipelineCacheDataCheck check)
+{
+  switch (check) {
+    case PipelineCacheDataCheck::Valid: return os << "valid";
+    case PipelineCacheDataCheck::TooSmall: return os << "truncated header";
+    case PipelineCacheDataCheck::BadHeader: return os << "unknown header";
+    case PipelineCacheDataCheck::OtherVendor: return os << "other vendor";
+    case PipelineCacheDataCheck::OtherDevice: return os << "other device";
+    case PipelineCacheDataCheck::OtherDriver: return os << "other driver";
+  }
+  return os << "unknown";
+}
+
+OSTREAM_OP(PipelineCacheOutcome outcome)
+{
+  switch (outcome) {
+    case PipelineCacheOutcome::Hit: return os << "hit";
+    case PipelineCacheOutcome::Miss: return os << "miss";
+    case PipelineCacheOutcome::Unreported: return os << "unreported";
+  }
+  return os << "unknown";
+}
+
+fs::path PipelineCache::defaultDirectory()
+{
+  if (const char *env = std::getenv("ABOX_PIPELINE_CACHE")) {
+    return env;
+  }
+  std::error_code ec;
+  fs::path        tmp = fs::temp_directory_path(ec);
+  return (ec ? fs::path(".") : tmp) / "abox-pipeline-cache";
+}
+
+std::string
+    PipelineCache::fileName(const VkPhysicalDeviceProperties &properties)
+{
+  std::ostringstream name;
+  name << std::hex << properties.vendorID << '-' << properties.deviceID
+       << ".bin";
+  return name.str();
+}
+
+PipelineCacheDataCheck PipelineCache::checkData(
+    std::span<const std::byte>        data,
+    const VkPhysicalDeviceProperties &properties
+)
+{
+  VkPipelineCacheHeaderVersionOne header;
+  if (data.size() < sizeof(header)) {
+    return PipelineCacheDataCheck::TooSmall;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+      header.headerSize < sizeof(header) || header.headerSize > data.size()) {
+    return PipelineCacheDataCheck::BadHeader;
+  }
+  if (header.vendorID != properties.vendorID) {
+    return PipelineCacheDataCheck::OtherVendor;
+  }
+  if (header.deviceID != properties.deviceID) {
+    return PipelineCacheDataCheck::OtherDevice;
+  }
+  if (std::memcmp(
+          header.pipelineCacheUUID,
+          properties.pipelineCacheUUID,
+          VK_UUID_SIZE
+      ) != 0) {
+    return PipelineCacheDataCheck::OtherDriver;
+  }
+  return PipelineCacheDataCheck::Valid;
+}
+
+PipelineCache::~PipelineCache()
+{
+  if (cache && createdSinceSave.load() > 0) {
+    save();
+  }
+}
+
+std::optional<std::vector<std::byte>> PipelineCache::readCompatible() const
+{
+  std::optional<std::vector<std::byte>> data = readFile(path);
+  if (!data) {
+    return std::nullopt;
+  }
+  VkPhysicalDeviceProperties properties{};
+  properties.vendorID = expected.vendorID;
+  properties.deviceID = expected.deviceID;
+  std::memcpy(
+      properties.pipelineCacheUUID,
+      expected.pipelineCacheUUID,
+      VK_UUID_SIZE
+  );
+  const PipelineCacheDataCheck check = checkData(*data, properties);
+  if (check != PipelineCacheDataCheck::Valid) {
+    LOG_INFO("Pipeline") << "Ignoring pipeline cache " << path.string()
+                         << ": " << check;
+    return std::nullopt;
+  }
+  return data;
+}
+
+bool PipelineCache::open(
+    VkDevice         logicalDevice,
+    VkPhysicalDevice physicalDevice,
+    fs::path         directory
+)
+{
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  device   = logicalDevice;
+  expected = {
+      .headerSize        = sizeof(VkPipelineCacheHeaderVersionOne),
+      .headerVersion     = VK_PIPELINE_CACHE_HEADER_VERSION_ONE,
+      .vendorID          = properties.vendorID,
+      .deviceID          = properties.deviceID,
+      .pipelineCacheUUID = {}
+  };
+  std::memcpy(
+      expected.pipelineCacheUUID,
+      properties.pipelineCacheUUID,
+      VK_UUID_SIZE
+  );
+  creationFeedback = properties.apiVersion >= VK_API_VERSION_1_3;
+
+  path.clear();
+  if (!directory.empty()) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (!ec && fs::is_directory(directory, ec)) {
+      path = directory / fileName(properties);
+    }
+    else {
+      LOG_WARN("Pipeline") << "Pipeline cache not persisted, cannot use "
+                           << directory.string() << ": " << ec.message();
+    }
+  }
+
+  std::optional<std::vector<std::byte>> initial;
+  if (!path.empty()) {
+    std::error_code ec;
+    const FileTime time = fs::last_write_time(path, ec);
+    initial = readCompatible();
+    if (initial && !ec) {
+      diskTime = time;
+    }
+  }
+
+  VkResult result = createCache(
+      device,
+      initial ? std::span<const std::byte>(*initial)
+              : std::span<const std::byte>(),
+      cache
+  );
+  if (result != VK_SUCCESS && initial) {
+    LOG_WARN("Pipeline") << "Driver rejected pipeline cache " << path.string()
+                         << " (" << result << "), starting empty";
+    initial.reset();
+    diskTime.reset();
+    result = createCache(device, {}, cache);
+  }
+  if (result != VK_SUCCESS) {
+    LOG_ERROR("Pipeline") << "Failed to create pipeline cache: " << result;
+    return false;
+  }
+
+  {
+    std::lock_guard lock(statsMutex);
+    stats.loadedBytes = initial ? initial->size() : 0;
+  }
+  lastSave = std::chrono::steady_clock::now();
+  LOG_INFO("Pipeline") << "Pipeline cache "
+                       << (path.empty() ? std::string("in memory only")
+                                        : path.string())
+                       << ", " << (initial ? initial->size() : 0)
+                       << " bytes loaded";
+  return true;
+}
+
+const void *
+    PipelineCache::beginCreation(PipelineCreation &creation, const void *next)
+        const
+{
+  creation.feedback = {};
+  creation.start    = std::chrono::steady_clock::now();
+  if (!creationFeedback) {
+    return next;
+  }
+  creation.info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+      .pNext = next,
+      .pPipelineCreationFeedback          = &creation.feedback,
+      .pipelineStageCreationFeedbackCount = 0u,
+      .pPipelineStageCreationFeedbacks    = nullptr
+  };
+  return &creation.info;
+}
+
+void PipelineCache::endCreation(
+    const PipelineCreation &creation,
+    VkPipeline              created
+)
+{
+  uint64_t nanoseconds = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - creation.start
+      )
+          .count()
+  );
+  createdSinceSave.fetch_add(1, std::memory_order_relaxed);
+
+  PipelineCacheOutcome outcome = PipelineCacheOutcome::Unreported;
+  if (creation.feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) {
+    // The driver's own duration leaves out the call overhead
+    nanoseconds = creation.feedback.duration;
+    outcome     = (creation.feedback.flags &
+               VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT)
+                      ? PipelineCacheOutcome::Hit
+                      : PipelineCacheOutcome::Miss;
+  }
+
+  std::lock_guard lock(statsMutex);
+  switch (outcome) {
+    case PipelineCacheOutcome::Hit:
+      ++stats.hits;
+      stats.hitNanoseconds += nanoseconds;
+      break;
+    case PipelineCacheOutcome::Miss:
+      ++stats.misses;
+      stats.missNanoseconds += nanoseconds;
+      break;
+    case PipelineCacheOutcome::Unreported:
+      ++stats.unreported;
+      stats.unreportedNanoseconds += nanoseconds;
+      break;
+  }
+  if (created != VK_NULL_HANDLE) {
+    creations[created] = {
+        .duration = std::chrono::nanoseconds(nanoseconds),
+        .outcome  = outcome
+    };
+  }
+}
+
+std::optional<PipelineCreationRecord>
+    PipelineCache::getCreationRecord(VkPipeline created) const
+{
+  std::lock_guard lock(statsMutex);
+  auto            known = creations.find(created);
+  if (known == creations.end()) {
+    return std::nullopt;
+  }
+  return known->second;
+}
+
+void PipelineCache::forgetCreation(VkPipeline created)
+{
+  std::lock_guard lock(statsMutex);
+  creations.erase(created);
+}
+
+bool PipelineCache::save()
+{
+  std::lock_guard lock(saveMutex);
+  if (!cache || path.empty()) {
+    return false;
+  }
+
+  // Keep what another instance saved since the file was read
+  std::error_code ec;
+  const FileTime  time = fs::last_write_time(path, ec);
+  if (!ec && (!diskTime || *diskTime != time)) {
+    std::optional<std::vector<std::byte>> other = readCompatible();
+    std::optional<PipelineCacheWrapper>   otherCache;
+    if (other && createCache(device, *other, otherCache) == VK_SUCCESS) {
+      const VkPipelineCache source = otherCache->get();
+      if (vkMergePipelineCaches(device, cache->get(), 1, &source) ==
+          VK_SUCCESS) {
+        LOG_DEBUG("Pipeline") << "Merged pipeline cache saved by another "
+                                 "process";
+      }
+    }
+  }
+
+  // The cache may grow between the size query and the copy
+  std::vector<std::byte> data;
+  VkResult               result;
+  do {
+    size_t size = 0;
+    result      = vkGetPipelineCacheData(device, cache->get(), &size, nullptr);
+    if (result != VK_SUCCESS) {
+      break;
+    }
+    data.resize(size);
+    result =
+        vkGetPipelineCacheData(device, cache->get(), &size, data.data());
+    data.resize(size);
+  } while (result == VK_INCOMPLETE);
+  if (result != VK_SUCCESS) {
+    LOG_WARN("Pipeline") << "Failed to read pipeline cache data: " << result;
+    return false;
+  }
+
+  const fs::path tmp = temporaryPath(path);
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(
+        reinterpret_cast<const char *>(data.data()),
+        static_cast<std::streamsize>(data.size())
+    );
+    if (!out.good()) {
+      LOG_WARN("Pipeline") << "Failed to write pipeline cache "
+                           << tmp.string();
+      out.close();
+      fs::remove(tmp, ec);
+      return false;
+    }
+  }
+  fs::rename(tmp, path, ec);
+  if (ec) {
+    LOG_WARN("Pipeline") << "Failed to publish pipeline cache "
+                         << path.string() << ": " << ec.message();
+    std::error_code ignored;
+    fs::remove(tmp, ignored);
+    return false;
+  }
+
+  const FileTime written = fs::last_write_time(path, ec);
+  diskTime = ec ? std::nullopt : std::optional(written);
+  lastSave = std::chrono::steady_clock::now();
+  createdSinceSave.store(0);
+  {
+    std::lock_guard statsLock(statsMutex);
+    stats.savedBytes = data.size();
+    ++stats.saves;
+  }
+  LOG_DEBUG("Pipeline") << "Saved " << data.size() << " bytes of pipeline "
+                        << "cache to " << path.string();
+  return true;
+}
+
+bool PipelineCache::saveIfDue(std::chrono::steady_clock::duration interval)
+{
+  if (createdSinceSave.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  {
+    std::lock_guard lock(saveMutex);
+    if (std::chrono::steady_clock::now() - lastSave < interval) {
+      return false;
+    }
+  }
+  return save();
+}
+
+PipelineCacheStats PipelineCache::getStats() const
+{
+  std::lock_guard lock(statsMutex);
+  return stats;
+}
@@ -0,0 +1,229 @@
+#ifndef PIPELINE_CACHE_HPP
+#define PIPELINE_CACHE_HPP
+
+#include "MemoryWrapper.hpp"
+#include "PreProcUtils.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+DEFINE_VK_MEMORY_WRAPPER(
+    VkPipelineCache,
+    PipelineCache,
+    vkDestroyPipelineCache
+)
+
+/** @brief Why serialized cache data is (not) usable on a device */
+enum class PipelineCacheDataCheck : uint8_t {
+  Valid,
+  TooSmall,  // shorter than VkPipelineCacheHeaderVersionOne
+  BadHeader, // headerSize or headerVersion not understood
+  OtherVendor,
+  OtherDevice,
+  OtherDriver, // pipelineCacheUUID differs: driver update
+};
+
+OSTREAM_OP(PipelineCacheDataCheck check);
+
+/**
+ * @brief Creation counts and times, split by the driver's creation
+ * feedback (core in Vulkan 1.3)
+ */
+struct PipelineCacheStats {
+  uint64_t hits                  = 0; // found in the pipeline cache
+  uint64_t misses                = 0; // compiled
+  uint64_t unreported            = 0; // no feedback, hit or miss unknown
+  uint64_t hitNanoseconds        = 0;
+  uint64_t missNanoseconds       = 0;
+  uint64_t unreportedNanoseconds = 0;
+  uint64_t loadedBytes           = 0; // accepted from disk when opened
+  uint64_t savedBytes            = 0; // written by the last save
+  uint64_t saves                 = 0;
+
+  [[nodiscard]] double averageHitMilliseconds() const
+  {
+    return hits ? static_cast<double>(hitNanoseconds) / hits / 1e6 : 0.0;
+  }
+
+  [[nodiscard]] double averageMissMilliseconds() const
+  {
+    return misses ? static_cast<double>(missNanoseconds) / misses / 1e6 : 0.0;
+  }
+};
+
+/** @brief Whether one creation was served by the pipeline cache */
+enum class PipelineCacheOutcome : uint8_t {
+  Hit,
+  Miss,
+  Unreported, // no creation feedback
+};
+
+OSTREAM_OP(PipelineCacheOutcome outcome);
+
+/** @brief How long creating a pipeline took, and if the cache served it */
+struct PipelineCreationRecord {
+  std::chrono::nanoseconds duration{0}; // the driver's when it reports one
+  PipelineCacheOutcome     outcome = PipelineCacheOutcome::Unreported;
+};
+
+/**
+ * @brief State of one vkCreate*Pipelines call, see
+ * PipelineCache::beginCreation
+ */
+struct PipelineCreation {
+  VkPipelineCreationFeedback            feedback{};
+  VkPipelineCreationFeedbackCreateInfo  info{};
+  std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @class PipelineCache
+ * @brief The VkPipelineCache of one device, persisted across launches
+ *
+ * Opened at device creation from `<directory>/<vendor>-<device>.bin`; data
+ * whose VkPipelineCacheHeaderVersionOne does not match the device (other
+ * GPU, driver update) is discarded. Saving merges what another process may
+ * have written since, then goes through a temporary file renamed into
+ * place. Saves happen on destruction and, through saveIfDue, periodically
+ * while new pipelines are created. Disk errors only disable persistence,
+ * the in-memory cache keeps working.
+ */
+class PipelineCache {
+  using FileTime = std::filesystem::file_time_type;
+
+  VkDevice                            device = VK_NULL_HANDLE;
+  std::optional<PipelineCacheWrapper> cache;
+  VkPipelineCacheHeaderVersionOne     expected{};
+  bool                                creationFeedback = false;
+  std::filesystem::path               path;     // empty: not persisted
+  std::optional<FileTime>             diskTime; // of the file merged in
+
+  std::mutex                            saveMutex;
+  std::chrono::steady_clock::time_point lastSave;
+  std::atomic<uint64_t>                 createdSinceSave{0};
+
+  mutable std::mutex statsMutex;
+  PipelineCacheStats stats;
+  // Last creation of each handle, a handle the driver reuses is overwritten
+  std::unordered_map<VkPipeline, PipelineCreationRecord> creations;
+  bool captureStatistics = false;
+
+  /** @brief Contents of path if its header matches the device */
+  [[nodiscard]] std::optional<std::vector<std::byte>> readCompatible() const;
+
+   public:
+  static constexpr std::chrono::seconds DEFAULT_SAVE_INTERVAL{30};
+
+  /**
+   * @brief $ABOX_PIPELINE_CACHE if set (empty disables persistence), else
+   * <temp>/abox-pipeline-cache
+   */
+  static std::filesystem::path defaultDirectory();
+
+  /** @brief `<vendorID>-<deviceID>.bin`, in hexadecimal */
+  static std::string fileName(const VkPhysicalDeviceProperties &properties);
+
+  /**
+   * @brief Validate the VkPipelineCacheHeaderVersionOne at the start of data
+   * against the device that would load it
+   */
+  [[nodiscard]] static PipelineCacheDataCheck checkData(
+      std::span<const std::byte>        data,
+      const VkPhysicalDeviceProperties &properties
+  );
+
+  PipelineCache() = default;
+  ~PipelineCache();
+
+  DELETE_COPY(PipelineCache);
+  DELETE_MOVE(PipelineCache);
+
+  /**
+   * @brief Create the cache, seeded from disk when the file matches the
+   * device
+   * @return false if vkCreatePipelineCache failed, pipelines are then
+   * created without a cache
+   */
+  bool open(
+      VkDevice              logicalDevice,
+      VkPhysicalDevice      physicalDevice,
+      std::filesystem::path directory = defaultDirectory()
+  );
+
+  /** @brief VK_NULL_HANDLE until opened */
+  [[nodiscard]] VkPipelineCache get() const
+  {
+    return cache ? cache->get() : VK_NULL_HANDLE;
+  }
+
+  [[nodiscard]] const std::filesystem::path &getPath() const { return path; }
+
+  /**
+   * @brief Start timing a creation
+   * @return pNext for the pipeline create info: the feedback struct chained
+   * before next when the device reports creation feedback, else next
+   */
+  [[nodiscard]] const void *
+      beginCreation(PipelineCreation &creation, const void *next = nullptr)
+          const;
+
+  /**
+   * @brief Count the creation as a hit or a miss, call once it returned
+   * @param created the pipeline it returned, its record is kept for
+   * getCreationRecord
+   */
+  void endCreation(
+      const PipelineCreation &creation,
+      VkPipeline              created = VK_NULL_HANDLE
+  );
+
+  /** @brief Time and cache outcome of created, if it went through here */
+  [[nodiscard]] std::optional<PipelineCreationRecord>
+      getCreationRecord(VkPipeline created) const;
+
+  /** @brief Drop the record of created, call when it is retired */
+  void forgetCreation(VkPipeline created);
+
+  /**
+   * @brief Have the driver capture executable statistics of the pipelines
+   * created from now on, see PipelineStatistics. Set before creating any.
+   */
+  void setCaptureStatistics(bool capture) { captureStatistics = capture; }
+
+  /** @brief Flags every pipeline create info of this device adds */
+  [[nodiscard]] VkPipelineCreateFlags creationFlags() const
+  {
+    return captureStatistics
+               ? static_cast<VkPipelineCreateFlags>(
+                     VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR
+                 )
+               : 0u;
+  }
+
+  /**
+   * @brief Merge the file written by other processes since it was read,
+   * then atomically replace it with the cache contents
+   * @return false if not opened, not persisted or the write failed
+   */
+  bool save();
+
+  /**
+   * @brief save() when pipelines were created since the last save and
+   * interval elapsed, cheap otherwise: call once per frame
+   */
+  bool saveIfDue(std::chrono::steady_clock::duration interval =
+                     DEFAULT_SAVE_INTERVAL);
+
+  [[nodiscard]] PipelineCacheStats getStats() const;
+};
+
+#endif // PIPELINE_CACHE_HPP
@@ -0,0 +1,216 @@
+#include "PipelineLayoutCache.hpp"
+#include "HostAllocator.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+void PipelineLayoutCache::normalize(
+    std::vector<VkDescriptorSetLayoutBinding> &bindings
+)
+{
+  std::ranges::sort(bindings, {}, &VkDescriptorSetLayoutBinding::binding);
+}
+
+void PipelineLayoutCache::normalize(std::vector<VkPushConstantRange> &ranges)
+{
+  std::ranges::sort(
+      ranges,
+      [](const VkPushConstantRange &a, const VkPushConstantRange &b) {
+        return a.offset != b.offset ? a.offset < b.offset : a.size < b.size;
+      }
+  );
+}
+
+ABox::Hash128 PipelineLayoutCache::setLayoutKey(
+    std::span<const VkDescriptorSetLayoutBinding> bindings
+)
+{
+  // Field by field: the struct ends with a pointer, never set here
+  ABox::Hasher hasher;
+  hasher.update(static_cast<uint64_t>(bindings.size()));
+  for (const VkDescriptorSetLayoutBinding &binding : bindings) {
+    hasher.update(binding.binding);
+    hasher.update(binding.descriptorType);
+    hasher.update(binding.descriptorCount);
+    hasher.update(binding.stageFlags);
+  }
+  return hasher.digest();
+}
+
+ABox::Hash128 PipelineLayoutCache::pipelineLayoutKey(
+    std::span<const ABox::Hash128>       setKeys,
+    std::span<const VkPushConstantRange> pushConstantRanges
+)
+{
+  ABox::Hasher hasher;
+  hasher.update(static_cast<uint64_t>(setKeys.size()));
+  for (const ABox::Hash128 &key : setKeys) {
+    hasher.update(key);
+  }
+  hasher.update(static_cast<uint64_t>(pushConstantRanges.size()));
+  for (const VkPushConstantRange &range : pushConstantRanges) {
+    hasher.update(range);
+  }
+  return hasher.digest();
+}
+
+DescriptorSetLayoutRef PipelineLayoutCache::acquireSetLayout(
+    VkDevice                                      device,
+    std::span<const VkDescriptorSetLayoutBinding> bindings,
+    const ABox::Hash128                          &key
+)
+{
+  auto known = setLayouts.find(key);
+  if (known != setLayouts.end()) {
+    ++reuses;
+    return known->second;
+  }
+
+  auto layout = std::make_shared<DescriptorSetLayoutWrapper>(
+      device,
+      VK_NULL_HANDLE,
+      HostAllocator::callbacks(HostAllocTag::Pipeline)
+  );
+  const VkDescriptorSetLayoutCreateInfo layoutInfo{
+      .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .pNext        = nullptr,
+      .flags        = 0,
+      .bindingCount = static_cast<uint32_t>(bindings.size()),
+      .pBindings    = bindings.data()
+  };
+  if (vkCreateDescriptorSetLayout(
+          device,
+          &layoutInfo,
+          layout->getAllocator(),
+          layout->ptr()
+      ) != VK_SUCCESS) {
+    throw std::runtime_error(
+        "Failed to create descriptor set layout with " +
+        std::to_string(bindings.size()) + " bindings"
+    );
+  }
+  ++creations;
+  LOG_DEBUG("Pipeline") << "Created descriptor set layout with "
+                        << bindings.size() << " bindings";
+
+  setLayouts.emplace(key, layout);
+  return layout;
+}
+
+PipelineLayoutSet PipelineLayoutCache::acquire(
+    VkDevice                             device,
+    SetBindings                          sets,
+    std::span<const VkPushConstantRange> pushConstantRanges
+)
+{
+  // Every index up to the highest set is laid out, the gaps empty
+  const uint32_t setCount = sets.empty() ? 0u : sets.rbegin()->first + 1u;
+
+  std::lock_guard            lock(mutex);
+  PipelineLayoutSet          result;
+  std::vector<ABox::Hash128> setKeys;
+  result.setLayouts.reserve(setCount);
+  setKeys.reserve(setCount);
+  for (uint32_t setIndex = 0; setIndex < setCount; ++setIndex) {
+    std::vector<VkDescriptorSetLayoutBinding> &bindings = sets[setIndex];
+    normalize(bindings);
+    setKeys.push_back(setLayoutKey(bindings));
+    result.setLayouts.push_back(
+        acquireSetLayout(device, bindings, setKeys.back())
+    );
+  }
+
+  result.key = pipelineLayoutKey(setKeys, pushConstantRanges);
+  auto known = pipelineLayouts.find(result.key);
+  if (known != pipelineLayouts.end()) {
+    ++reuses;
+    result.layout = known->second;
+    LOG_DEBUG("Pipeline") << "Reusing pipeline layout with " << setCount
+                          << " descriptor sets and "
+                          << pushConstantRanges.size()
+                          << " push constant ranges";
+    return result;
+  }
+
+  std::vector<VkDescriptorSetLayout> handles;
+  handles.reserve(setCount);
+  for (const DescriptorSetLayoutRef &setLayout : result.setLayouts) {
+    handles.push_back(setLayout->get());
+  }
+
+  auto layout = std::make_shared<PipelineLayoutWrapper>(
+      device,
+      VK_NULL_HANDLE,
+      HostAllocator::callbacks(HostAllocTag::Pipeline)
+  );
+  const VkPipelineLayoutCreateInfo layoutInfo{
+      .sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .pNext          = nullptr,
+      .flags          = 0,
+      .setLayoutCount = static_cast<uint32_t>(handles.size()),
+      .pSetLayouts    = handles.data(),
+      .pushConstantRangeCount =
+          static_cast<uint32_t>(pushConstantRanges.size()),
+      .pPushConstantRanges = pushConstantRanges.data()
+  };
+  if (vkCreatePipelineLayout(
+          device,
+          &layoutInfo,
+          layout->getAllocator(),
+          layout->ptr()
+      ) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create pipeline layout!");
+  }
+  ++creations;
+  LOG_DEBUG("Pipeline") << "Created pipeline layout with " << setCount
+                        << " descriptor sets and " << pushConstantRanges.size()
+                        << " push constant ranges";
+
+  pipelineLayouts.emplace(result.key, layout);
+  result.layout = std::move(layout);
+  return result;
+}
+
+size_t PipelineLayoutCache::retireUnused(DeferredDeletionQueue &queue)
+{
+  std::lock_guard lock(mutex);
+  const auto      retireIfUnused = [&queue](auto &entry) {
+    if (entry.second.use_count() != 1) {
+      return false;
+    }
+    entry.second->retire(queue);
+    return true;
+  };
+  // Pipeline layouts first, they were created from the set layouts
+  size_t retired = std::erase_if(pipelineLayouts, retireIfUnused);
+  retired += std::erase_if(setLayouts, retireIfUnused);
+  if (retired > 0) {
+    LOG_DEBUG("Pipeline") << "Retired " << retired << " unused layouts";
+  }
+  return retired;
+}
+
+size_t PipelineLayoutCache::setLayoutCount() const
+{
+  std::lock_guard lock(mutex);
+  return setLayouts.size();
+}
+
+size_t PipelineLayoutCache::pipelineLayoutCount() const
+{
+  std::lock_guard lock(mutex);
+  return pipelineLayouts.size();
+}
+
+uint64_t PipelineLayoutCache::getCreations() const
+{
+  std::lock_guard lock(mutex);
+  return creations;
+}
+
+uint64_t PipelineLayoutCache::getReuses() const
+{
+  std::lock_guard lock(mutex);
+  return reuses;
+}
@@ -0,0 +1,126 @@
+#ifndef PIPELINE_LAYOUT_CACHE_HPP
+#define PIPELINE_LAYOUT_CACHE_HPP
+
+#include "DeferredDeletionQueue.hpp"
+#include "Hash.hpp"
+#include "MemoryWrapper.hpp"
+#include "PreProcUtils.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+DEFINE_VK_MEMORY_WRAPPER(
+    VkDescriptorSetLayout,
+    DescriptorSetLayout,
+    vkDestroyDescriptorSetLayout
+)
+
+DEFINE_VK_MEMORY_WRAPPER(
+    VkPipelineLayout,
+    PipelineLayout,
+    vkDestroyPipelineLayout
+)
+
+/** @brief Shared layouts, owned by the cache and the pipelines using them */
+using DescriptorSetLayoutRef =
+    std::shared_ptr<const DescriptorSetLayoutWrapper>;
+using PipelineLayoutRef      = std::shared_ptr<const PipelineLayoutWrapper>;
+
+/** @brief Layouts of one pipeline, see PipelineLayoutCache::acquire */
+struct PipelineLayoutSet {
+  // By set index, sets no shader uses get an empty layout
+  std::vector<DescriptorSetLayoutRef> setLayouts;
+  PipelineLayoutRef                   layout;
+  ABox::Hash128                       key; // of the pipeline layout
+};
+
+/**
+ * @class PipelineLayoutCache
+ * @brief Descriptor set layouts and pipeline layouts of one device, keyed
+ * by their normalized bindings and push constant ranges
+ *
+ * Pipelines whose shaders declare the same resources get the same
+ * VkPipelineLayout: they are bind compatible, descriptor sets stay bound
+ * across a switch between them. The cache owns the layouts, so they also
+ * survive a reload of every pipeline using them; retireUnused hands the
+ * unreferenced ones to the deletion queue. Thread safe.
+ */
+class PipelineLayoutCache {
+  mutable std::mutex mutex;
+  std::unordered_map<ABox::Hash128, std::shared_ptr<DescriptorSetLayoutWrapper>>
+      setLayouts;
+  std::unordered_map<ABox::Hash128, std::shared_ptr<PipelineLayoutWrapper>>
+           pipelineLayouts;
+  uint64_t creations = 0;
+  uint64_t reuses    = 0;
+
+  /** @brief Caller holds the mutex */
+  DescriptorSetLayoutRef acquireSetLayout(
+      VkDevice                                      device,
+      std::span<const VkDescriptorSetLayoutBinding> bindings,
+      const ABox::Hash128                          &key
+  );
+
+   public:
+  // Reflected bindings by set index
+  using SetBindings =
+      std::map<uint32_t, std::vector<VkDescriptorSetLayoutBinding>>;
+
+  PipelineLayoutCache() = default;
+
+  DELETE_COPY(PipelineLayoutCache);
+  DELETE_MOVE(PipelineLayoutCache);
+
+  /** @brief Sort by binding number, the order shaders were reflected in */
+  static void normalize(std::vector<VkDescriptorSetLayoutBinding> &bindings);
+
+  /** @brief Sort by offset, then size */
+  static void normalize(std::vector<VkPushConstantRange> &ranges);
+
+  /** @brief Key of a normalized binding list */
+  [[nodiscard]] static ABox::Hash128
+      setLayoutKey(std::span<const VkDescriptorSetLayoutBinding> bindings);
+
+  /** @brief Key of set layouts, by set index, and normalized ranges */
+  [[nodiscard]] static ABox::Hash128 pipelineLayoutKey(
+      std::span<const ABox::Hash128>       setKeys,
+      std::span<const VkPushConstantRange> pushConstantRanges
+  );
+
+  /**
+   * @brief The layouts for these reflected sets and push constant ranges,
+   * created if missing
+   * @param sets bindings by set index, normalized here
+   * @param pushConstantRanges normalized
+   * @throws std::runtime_error if a layout cannot be created
+   */
+  [[nodiscard]] PipelineLayoutSet acquire(
+      VkDevice                             device,
+      SetBindings                          sets,
+      std::span<const VkPushConstantRange> pushConstantRanges
+  );
+
+  /**
+   * @brief Hand the layouts no pipeline uses anymore to the deletion queue,
+   * call once retired pipelines released theirs
+   * @return Number of layouts retired
+   */
+  size_t retireUnused(DeferredDeletionQueue &queue);
+
+  [[nodiscard]] size_t setLayoutCount() const;
+
+  [[nodiscard]] size_t pipelineLayoutCount() const;
+
+  /** @brief vkCreateDescriptorSetLayout and vkCreatePipelineLayout calls */
+  [[nodiscard]] uint64_t getCreations() const;
+
+  /** @brief Layouts served from the cache */
+  [[nodiscard]] uint64_t getReuses() const;
+};
+
+#endif // PIPELINE_LAYOUT_CACHE_HPP
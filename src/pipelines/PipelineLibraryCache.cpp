@@ -0,0 +1,450 @@
+#include "PipelineLibraryCache.hpp"
+#include "HostAllocator.hpp"
+#include "Logger.hpp"
+#include "RenderPassCompatibility.hpp"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+OSTREAM_OP(PipelineLibraryPart part)
+{
+  switch (part) {
+    case PipelineLibraryPart::VertexInput: return os << "vertex input";
+    case PipelineLibraryPart::PreRasterization:
+      return os << "pre-rasterization";
+    case PipelineLibraryPart::FragmentShader: return os << "fragment shader";
+    case PipelineLibraryPart::FragmentOutput: return os << "fragment output";
+  }
+  return os << "unknown";
+}
+
+namespace {
+
+bool isDynamic(const VkGraphicsPipelineCreateInfo &info, VkDynamicState state)
+{
+  if (!info.pDynamicState) {
+    return false;
+  }
+  const std::span<const VkDynamicState> states(
+      info.pDynamicState->pDynamicStates,
+      info.pDynamicState->dynamicStateCount
+  );
+  return std::ranges::find(states, state) != states.end();
+}
+
+/** @brief count, then the items: a null array may only come with 0 */
+template <typename T>
+void hashArray(ABox::Hasher &hasher, const T *items, uint32_t count)
+{
+  hasher.update(count);
+  if (count > 0) {
+    hasher.update(items, count * sizeof(T));
+  }
+}
+
+/**
+ * @brief Hash the state structs info points to, field by field: they hold
+ * pNext pointers, and a missing struct must not hash like a default one
+ */
+void hashState(ABox::Hasher &hasher, const VkGraphicsPipelineCreateInfo &info)
+{
+  hasher.update(info.pVertexInputState != nullptr);
+  if (const auto *vertexInput = info.pVertexInputState) {
+    hashArray(
+        hasher,
+        vertexInput->pVertexBindingDescriptions,
+        vertexInput->vertexBindingDescriptionCount
+    );
+    hashArray(
+        hasher,
+        vertexInput->pVertexAttributeDescriptions,
+        vertexInput->vertexAttributeDescriptionCount
+    );
+  }
+
+  hasher.update(info.pInputAssemblyState != nullptr);
+  if (const auto *inputAssembly = info.pInputAssemblyState) {
+    hasher.update(inputAssembly->topology);
+    hasher.update(inputAssembly->primitiveRestartEnable);
+  }
+
+  hasher.update(info.pTessellationState != nullptr);
+  if (const auto *tessellation = info.pTessellationState) {
+    hasher.update(tessellation->patchControlPoints);
+  }
+
+  hasher.update(info.pViewportState != nullptr);
+  if (const auto *viewport = info.pViewportState) {
+    // Dynamic rectangles are ignored: a resize must not split the library
+    const bool staticViewports =
+        viewport->pViewports && !isDynamic(info, VK_DYNAMIC_STATE_VIEWPORT);
+    const bool staticScissors =
+        viewport->pScissors && !isDynamic(info, VK_DYNAMIC_STATE_SCISSOR);
+    hasher.update(viewport->viewportCount);
+    hasher.update(viewport->scissorCount);
+    if (staticViewports) {
+      hashArray(hasher, viewport->pViewports, viewport->viewportCount);
+    }
+    if (staticScissors) {
+      hashArray(hasher, viewport->pScissors, viewport->scissorCount);
+    }
+  }
+
+  hasher.update(info.pRasterizationState != nullptr);
+  if (const auto *rasterization = info.pRasterizationState) {
+    hasher.update(rasterization->depthClampEnable);
+    hasher.update(rasterization->rasterizerDiscardEnable);
+    hasher.update(rasterization->polygonMode);
+    hasher.update(rasterization->cullMode);
+    hasher.update(rasterization->frontFace);
+    hasher.update(rasterization->depthBiasEnable);
+    hasher.update(rasterization->depthBiasConstantFactor);
+    hasher.update(rasterization->depthBiasClamp);
+    hasher.update(rasterization->depthBiasSlopeFactor);
+    hasher.update(rasterization->lineWidth);
+  }
+
+  hasher.update(info.pMultisampleState != nullptr);
+  if (const auto *multisample = info.pMultisampleState) {
+    hasher.update(multisample->rasterizationSamples);
+    hasher.update(multisample->sampleShadingEnable);
+    hasher.update(multisample->minSampleShading);
+    hasher.update(multisample->pSampleMask != nullptr);
+    if (multisample->pSampleMask) {
+      hashArray(
+          hasher,
+          multisample->pSampleMask,
+          (multisample->rasterizationSamples + 31) / 32
+      );
+    }
+    hasher.update(multisample->alphaToCoverageEnable);
+    hasher.update(multisample->alphaToOneEnable);
+  }
+
+  hasher.update(info.pDepthStencilState != nullptr);
+  if (const auto *depthStencil = info.pDepthStencilState) {
+    hasher.update(depthStencil->depthTestEnable);
+    hasher.update(depthStencil->depthWriteEnable);
+    hasher.update(depthStencil->depthCompareOp);
+    hasher.update(depthStencil->depthBoundsTestEnable);
+    hasher.update(depthStencil->stencilTestEnable);
+    hasher.update(depthStencil->front);
+    hasher.update(depthStencil->back);
+    hasher.update(depthStencil->minDepthBounds);
+    hasher.update(depthStencil->maxDepthBounds);
+  }
+
+  hasher.update(info.pColorBlendState != nullptr);
+  if (const auto *colorBlend = info.pColorBlendState) {
+    hasher.update(colorBlend->logicOpEnable);
+    hasher.update(colorBlend->logicOp);
+    hashArray(hasher, colorBlend->pAttachments, colorBlend->attachmentCount);
+    hasher.update(colorBlend->blendConstants);
+  }
+
+  hasher.update(info.pDynamicState != nullptr);
+  if (const auto *dynamic = info.pDynamicState) {
+    hashArray(hasher, dynamic->pDynamicStates, dynamic->dynamicStateCount);
+  }
+
+  hasher.update(RenderPassCompatibility::key(info.renderPass, info.subpass));
+}
+
+} // namespace
+
+VkGraphicsPipelineLibraryFlagsEXT
+    PipelineLibraryCache::partFlag(PipelineLibraryPart part)
+{
+  switch (part) {
+    case PipelineLibraryPart::VertexInput:
+      return VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+    case PipelineLibraryPart::PreRasterization:
+      return VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+    case PipelineLibraryPart::FragmentShader:
+      return VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+    case PipelineLibraryPart::FragmentOutput:
+      return VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+  }
+  return 0u;
+}
+
+VkGraphicsPipelineCreateInfo PipelineLibraryCache::partInfo(
+    PipelineLibraryPart                              part,
+    const VkGraphicsPipelineCreateInfo              &complete,
+    std::span<const VkPipelineShaderStageCreateInfo> stages
+)
+{
+  // Every part takes the whole dynamic state, each uses what concerns it
+  VkGraphicsPipelineCreateInfo info{
+      .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .pNext               = nullptr,
+      .flags               = 0u,
+      .stageCount          = 0u,
+      .pStages             = nullptr,
+      .pVertexInputState   = nullptr,
+      .pInputAssemblyState = nullptr,
+      .pTessellationState  = nullptr,
+      .pViewportState      = nullptr,
+      .pRasterizationState = nullptr,
+      .pMultisampleState   = nullptr,
+      .pDepthStencilState  = nullptr,
+      .pColorBlendState    = nullptr,
+      .pDynamicState       = complete.pDynamicState,
+      .layout              = VK_NULL_HANDLE,
+      .renderPass          = VK_NULL_HANDLE,
+      .subpass             = 0u,
+      .basePipelineHandle  = VK_NULL_HANDLE,
+      .basePipelineIndex   = -1,
+  };
+
+  switch (part) {
+    case PipelineLibraryPart::VertexInput:
+      info.pVertexInputState   = complete.pVertexInputState;
+      info.pInputAssemblyState = complete.pInputAssemblyState;
+      return info;
+    case PipelineLibraryPart::PreRasterization:
+      info.pTessellationState  = complete.pTessellationState;
+      info.pViewportState      = complete.pViewportState;
+      info.pRasterizationState = complete.pRasterizationState;
+      break;
+    case PipelineLibraryPart::FragmentShader:
+      info.pMultisampleState  = complete.pMultisampleState;
+      info.pDepthStencilState = complete.pDepthStencilState;
+      break;
+    case PipelineLibraryPart::FragmentOutput:
+      info.pMultisampleState = complete.pMultisampleState;
+      info.pColorBlendState  = complete.pColorBlendState;
+      info.renderPass        = complete.renderPass;
+      info.subpass           = complete.subpass;
+      return info;
+  }
+
+  // Shader parts
+  info.stageCount = static_cast<uint32_t>(stages.size());
+  info.pStages    = stages.data();
+  info.layout     = complete.layout;
+  info.renderPass = complete.renderPass;
+  info.subpass    = complete.subpass;
+  return info;
+}
+
+ABox::Hash128 PipelineLibraryCache::partKey(
+    PipelineLibraryPart                 part,
+    const VkGraphicsPipelineCreateInfo &info,
+    const ABox::Hash128                &shaderKey
+)
+{
+  ABox::Hasher hasher;
+  hasher.update(part);
+  hasher.update(shaderKey);
+  hashState(hasher, info);
+  return hasher.digest();
+}
+
+void PipelineLibraryCache::enable(VkDevice logicalDevice)
+{
+  std::lock_guard lock(mutex);
+  device = logicalDevice;
+  LOG_INFO("Pipeline") << "Graphics pipelines fast-linked from libraries "
+                          "(VK_EXT_graphics_pipeline_library)";
+}
+
+bool PipelineLibraryCache::isEnabled() const
+{
+  std::lock_guard lock(mutex);
+  return device != VK_NULL_HANDLE;
+}
+
+void PipelineLibraryCache::setBackgroundOptimization(bool enabled)
+{
+  std::lock_guard lock(mutex);
+  optimizeInBackground = enabled;
+}
+
+bool PipelineLibraryCache::optimizesInBackground() const
+{
+  std::lock_guard lock(mutex);
+  return optimizeInBackground;
+}
+
+PipelineLibraryRef PipelineLibraryCache::acquire(
+    PipelineLibraryPart                              part,
+    const VkGraphicsPipelineCreateInfo              &complete,
+    std::span<const VkPipelineShaderStageCreateInfo> stages,
+    const ABox::Hash128                             &shaderKey,
+    PipelineCache                                   &cache
+)
+{
+  VkGraphicsPipelineCreateInfo info  = partInfo(part, complete, stages);
+  const ABox::Hash128          key   = partKey(part, info, shaderKey);
+  const size_t                 index = static_cast<size_t>(part);
+
+  VkDevice owner = VK_NULL_HANDLE;
+  {
+    std::lock_guard lock(mutex);
+    if (device == VK_NULL_HANDLE) {
+      throw std::runtime_error("Pipeline libraries are not enabled");
+    }
+    auto known = libraries.find(key);
+    if (known != libraries.end()) {
+      ++stats.reused[index];
+      return known->second;
+    }
+    owner = device;
+  }
+
+  // Compiled unlocked, the other parts and pipelines build meanwhile
+  auto library = std::make_shared<PipelineWrapper>(
+      owner,
+      VK_NULL_HANDLE,
+      HostAllocator::callbacks(HostAllocTag::Pipeline)
+  );
+  const VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+      .pNext = nullptr,
+      .flags = partFlag(part)
+  };
+  PipelineCreation creation;
+  info.pNext = cache.beginCreation(creation, &libraryInfo);
+  info.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+               VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT |
+               cache.creationFlags();
+
+  const VkResult result = vkCreateGraphicsPipelines(
+      owner,
+      cache.get(),
+      1,
+      &info,
+      library->getAllocator(),
+      library->ptr()
+  );
+  cache.endCreation(creation, library->get());
+
+  if (result != VK_SUCCESS) {
+    std::stringstream ss;
+    ss << "Failed to create the " << part
+       << " pipeline library, error value: " << result;
+    throw std::runtime_error(ss.str());
+  }
+
+  std::lock_guard lock(mutex);
+  auto [entry, inserted] = libraries.emplace(key, library);
+  if (inserted) {
+    ++stats.created[index];
+    LOG_DEBUG("Pipeline") << "Created " << part << " pipeline library";
+  }
+  else {
+    // Lost the race, ours is destroyed on return
+    ++stats.reused[index];
+  }
+  return entry->second;
+}
+
+PipelineWrapper PipelineLibraryCache::link(
+    std::span<const PipelineLibraryRef> parts,
+    VkPipelineLayout                    layout,
+    bool                                optimize,
+    PipelineCache                      &cache
+)
+{
+  VkDevice owner = VK_NULL_HANDLE;
+  {
+    std::lock_guard lock(mutex);
+    owner = device;
+  }
+  if (owner == VK_NULL_HANDLE || parts.size() != PIPELINE_LIBRARY_PART_COUNT) {
+    throw std::runtime_error(
+        "Linking needs pipeline libraries enabled and one library per part"
+    );
+  }
+
+  std::vector<VkPipeline> handles;
+  handles.reserve(parts.size());
+  for (const PipelineLibraryRef &part : parts) {
+    handles.push_back(part->get());
+  }
+  const VkPipelineLibraryCreateInfoKHR libraryInfo{
+      .sType        = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+      .pNext        = nullptr,
+      .libraryCount = static_cast<uint32_t>(handles.size()),
+      .pLibraries   = handles.data()
+  };
+
+  PipelineCreation             creation;
+  VkGraphicsPipelineCreateInfo info{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .pNext = cache.beginCreation(creation, &libraryInfo),
+      .flags               = cache.creationFlags(),
+      .stageCount          = 0u,
+      .pStages             = nullptr,
+      .pVertexInputState   = nullptr,
+      .pInputAssemblyState = nullptr,
+      .pTessellationState  = nullptr,
+      .pViewportState      = nullptr,
+      .pRasterizationState = nullptr,
+      .pMultisampleState   = nullptr,
+      .pDepthStencilState  = nullptr,
+      .pColorBlendState    = nullptr,
+      .pDynamicState       = nullptr,
+      .layout              = layout,
+      .renderPass          = VK_NULL_HANDLE,
+      .subpass             = 0u,
+      .basePipelineHandle  = VK_NULL_HANDLE,
+      .basePipelineIndex   = -1,
+  };
+  if (optimize) {
+    info.flags |= VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+  }
+
+  PipelineWrapper linked(
+      owner,
+      VK_NULL_HANDLE,
+      HostAllocator::callbacks(HostAllocTag::Pipeline)
+  );
+  const VkResult result = vkCreateGraphicsPipelines(
+      owner,
+      cache.get(),
+      1,
+      &info,
+      linked.getAllocator(),
+      linked.ptr()
+  );
+  cache.endCreation(creation, linked.get());
+
+  if (result != VK_SUCCESS) {
+    std::stringstream ss;
+    ss << "Failed to link the graphics pipeline libraries"
+       << (optimize ? " with optimization" : "")
+       << ", error value: " << result;
+    throw std::runtime_error(ss.str());
+  }
+
+  std::lock_guard lock(mutex);
+  ++(optimize ? stats.optimizedLinks : stats.fastLinks);
+  return linked;
+}
+
+size_t PipelineLibraryCache::trim(PipelineCache &cache)
+{
+  std::lock_guard lock(mutex);
+  return std::erase_if(libraries, [&cache](const auto &entry) {
+    if (entry.second.use_count() != 1) {
+      return false;
+    }
+    cache.forgetCreation(entry.second->get());
+    return true;
+  });
+}
+
+size_t PipelineLibraryCache::size() const
+{
+  std::lock_guard lock(mutex);
+  return libraries.size();
+}
+
+PipelineLibraryStats PipelineLibraryCache::getStats() const
+{
+  std::lock_guard lock(mutex);
+  return stats;
+}
@@ -0,0 +1,136 @@
+#ifndef PIPELINE_LIBRARY_CACHE_HPP
+#define PIPELINE_LIBRARY_CACHE_HPP
+
+#include "Hash.hpp"
+#include "PipelineBase.hpp"
+#include "PipelineCache.hpp"
+#include "PreProcUtils.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vulkan/vulkan_core.h>
+
+/** @brief Parts VK_EXT_graphics_pipeline_library splits a pipeline into */
+enum class PipelineLibraryPart : uint8_t {
+  VertexInput,      // vertex input and input assembly
+  PreRasterization, // vertex to geometry stages, viewport, rasterization
+  FragmentShader,   // fragment stage, multisampling, depth stencil
+  FragmentOutput,   // color blending, multisampling
+};
+
+inline constexpr size_t PIPELINE_LIBRARY_PART_COUNT = 4;
+
+OSTREAM_OP(PipelineLibraryPart part);
+
+/** @brief Shared library, kept by the cache and the pipelines linked from it */
+using PipelineLibraryRef = std::shared_ptr<const PipelineWrapper>;
+
+struct PipelineLibraryStats {
+  std::array<uint64_t, PIPELINE_LIBRARY_PART_COUNT> created{}; // per part
+  std::array<uint64_t, PIPELINE_LIBRARY_PART_COUNT> reused{};
+  uint64_t fastLinks      = 0;
+  uint64_t optimizedLinks = 0; // with link-time optimization
+};
+
+/**
+ * @class PipelineLibraryCache
+ * @brief Graphics pipeline libraries of one device, keyed by the state and
+ * shaders each part is built from
+ *
+ * With VK_EXT_graphics_pipeline_library enabled, GraphicsPipeline builds
+ * its four parts as libraries and fast-links them: a new combination of
+ * already built parts costs a link instead of a compile. The cache owns the
+ * libraries so they outlive the pipelines, and the manager relinks each
+ * pipeline with link-time optimization in the background. Thread safe.
+ */
+class PipelineLibraryCache {
+  mutable std::mutex                                    mutex;
+  std::unordered_map<ABox::Hash128, PipelineLibraryRef> libraries;
+  VkDevice             device               = VK_NULL_HANDLE; // null: disabled
+  bool                 optimizeInBackground = true;
+  PipelineLibraryStats stats;
+
+   public:
+  PipelineLibraryCache() = default;
+
+  DELETE_COPY(PipelineLibraryCache);
+  DELETE_MOVE(PipelineLibraryCache);
+
+  [[nodiscard]] static VkGraphicsPipelineLibraryFlagsEXT
+      partFlag(PipelineLibraryPart part);
+
+  /**
+   * @brief The subset of a complete create info a part is built from
+   * @param stages of the part, pre-rasterization and fragment shader only
+   */
+  [[nodiscard]] static VkGraphicsPipelineCreateInfo partInfo(
+      PipelineLibraryPart                              part,
+      const VkGraphicsPipelineCreateInfo              &complete,
+      std::span<const VkPipelineShaderStageCreateInfo> stages
+  );
+
+  /**
+   * @brief Key of a part: the state of its create info, plus shaderKey for
+   * what the state structs do not show (SPIR-V, specialization, layout)
+   */
+  [[nodiscard]] static ABox::Hash128 partKey(
+      PipelineLibraryPart                 part,
+      const VkGraphicsPipelineCreateInfo &info,
+      const ABox::Hash128                &shaderKey
+  );
+
+  /**
+   * @brief Build parts as libraries on this device from now on, only valid
+   * once the graphicsPipelineLibrary feature is enabled
+   */
+  void enable(VkDevice logicalDevice);
+
+  [[nodiscard]] bool isEnabled() const;
+
+  /** @brief Whether fast-linked pipelines get relinked with optimization */
+  void setBackgroundOptimization(bool enabled);
+
+  [[nodiscard]] bool optimizesInBackground() const;
+
+  /**
+   * @brief The library of this part of complete, created if missing. Two
+   * threads may build the same library, the first one stored is kept.
+   * @throws std::runtime_error if the cache is disabled or creation fails
+   */
+  [[nodiscard]] PipelineLibraryRef acquire(
+      PipelineLibraryPart                              part,
+      const VkGraphicsPipelineCreateInfo              &complete,
+      std::span<const VkPipelineShaderStageCreateInfo> stages,
+      const ABox::Hash128                             &shaderKey,
+      PipelineCache                                   &cache
+  );
+
+  /**
+   * @brief Link one library of each part into a pipeline
+   * @param layout identically defined to the one the libraries were built
+   * with
+   * @param optimize link-time optimization: slower, faster pipeline
+   * @throws std::runtime_error on failure
+   */
+  [[nodiscard]] PipelineWrapper link(
+      std::span<const PipelineLibraryRef> parts,
+      VkPipelineLayout                    layout,
+      bool                                optimize,
+      PipelineCache                      &cache
+  );
+
+  /**
+   * @brief Drop the libraries no pipeline links to anymore, and their
+   * creation records in cache
+   */
+  size_t trim(PipelineCache &cache);
+
+  [[nodiscard]] size_t size() const;
+
+  [[nodiscard]] PipelineLibraryStats getStats() const;
+};
+
+#endif // PIPELINE_LIBRARY_CACHE_HPP
@@ -1,35 +1,881 @@
 #include "PipelineManager.hpp"
 #include "Logger.hpp"
 #include "PreProcUtils.hpp"
+#include <future>
+#include <unordered_set>
 
 PipelineManager::PipelineManager()
 {
   LOG_DEBUG("Pipeline") << "PipelineManager created";
 }
 
+PipelineManager::~PipelineManager()
+{
+  // Workers use the caches and their build entry
+  for (auto &[id, build] : asyncBuilds) {
+    if (build->pipeline.valid()) {
+      build->pipeline.wait();
+    }
+  }
+  for (OptimizedLink &link : optimizedLinks) {
+    link.linked.wait();
+  }
+
+  const std::filesystem::path report = PipelineStatistics::requestedReport();
+  if (!report.empty() && !pipelineIndices.empty()) {
+    try {
+      const PipelineReport built = buildReport();
+      built.logSummary();
+      built.writeJson(report);
+    }
+    catch (const std::exception &e) {
+      LOG_WARN("Pipeline") << "Pipeline report failed: " << e.what();
+    }
+  }
+}
+
+std::string PipelineManager::validate(
+    const PipelineDescription &description,
+    PipelineBackend            built
+)
+{
+  const bool graphics =
+      description.bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS;
+  if (description.shaders.empty()) {
+    return "no shaders provided";
+  }
+  if (!graphics && description.bindPoint != VK_PIPELINE_BIND_POINT_COMPUTE) {
+    return "only graphics and compute pipelines are built from descriptions";
+  }
+  const auto unsupported = [](const ShaderDataRef &shader) {
+    return (shader->getStage() & ShaderObjectPipeline::unsupportedStages) != 0;
+  };
+  if (built == PipelineBackend::ShaderObjects &&
+      std::ranges::any_of(description.shaders, unsupported)) {
+    return "tessellation shaders are not built as shader objects";
+  }
+  if (graphics && !description.swapchain) {
+    return "graphics pipeline without a swapchain";
+  }
+  return {};
+}
+
+ABox::Hash128 PipelineManager::descriptionKey(
+    const PipelineDescription &description,
+    PipelineBackend            built
+) const
+{
+  if (built == PipelineBackend::ShaderObjects) {
+    return shaderObjectKey(pipelineKey(
+        dereferenced(description.shaders),
+        description.specialization,
+        VK_NULL_HANDLE,
+        description.bindPoint,
+        {}
+    ));
+  }
+  return pipelineKey(
+      dereferenced(description.shaders),
+      description.specialization,
+      description.bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS
+          ? description.renderPass
+          : VK_NULL_HANDLE,
+      description.bindPoint,
+      description.bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS
+          ? dynamicState.baked(description.raster)
+          : RasterState{}
+  );
+}
+
+bool PipelineManager::isUnchanged(
+    const std::string   &name,
+    const ABox::Hash128 &key
+) const
+{
+  auto known = pipelineKeys.find(name);
+  return known != pipelineKeys.end() && known->second == key;
+}
+
+PipelineBase *PipelineManager::findUnchanged(
+    const PipelineDescription &description,
+    const ABox::Hash128       &key,
+    PipelineBackend            built
+)
+{
+  if (built == PipelineBackend::ShaderObjects) {
+    return findUnchanged<ShaderObjectPipeline>(
+        description.name,
+        key,
+        description.raster
+    );
+  }
+  if (description.bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+    return findUnchanged<GraphicsPipeline>(
+        description.name,
+        key,
+        description.raster
+    );
+  }
+  return findUnchanged<ComputePipeline>(description.name, key, {});
+}
+
+void PipelineManager::setMain(const PipelineDescription &description)
+{
+  const size_t index = pipelineIndices.at(description.name);
+  if (std::holds_alternative<ShaderObjectPipeline>(*pipelines[index])) {
+    LOG_WARN("Pipeline") << "Pipeline '" << description.name
+                         << "' is built from shader objects, it cannot be "
+                            "the main pipeline";
+    return;
+  }
+  if (description.bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+    mainGraphicsPipelineIndex = index;
+    mainGraphicsName          = description.name;
+  }
+  else {
+    mainComputePipelineIndex = index;
+  }
+}
+
+void PipelineManager::scheduleOptimizedLink(size_t index)
+{
+  auto *graphics = std::get_if<GraphicsPipeline>(pipelines[index].get());
+  if (!graphics || !graphics->isFastLinked() ||
+      !pipelineLibraries.optimizesInBackground()) {
+    return;
+  }
+  // A pipeline is only released after dropOptimizedLink, the pointer stays
+  // valid until then
+  optimizedLinks.push_back(
+      {.pipeline = graphics,
+       .linked   = ABox::ThreadPool::shared().submit([this, graphics] {
+         return graphics->linkOptimized(pipelineLibraries, pipelineCache);
+       })}
+  );
+}
+
+void PipelineManager::dropOptimizedLink(const PipelineBase &pipeline)
+{
+  // The relink reads the layout the retire hands to the deletion queue
+  std::erase_if(optimizedLinks, [&pipeline](OptimizedLink &link) {
+    if (link.pipeline != &pipeline) {
+      return false;
+    }
+    link.linked.wait();
+    return true;
+  });
+}
+
+size_t PipelineManager::store(std::unique_ptr<AllPipelines> pipeline)
+{
+  if (freeIndices.empty()) {
+    pipelines.push_back(std::move(pipeline));
+    return pipelines.size() - 1;
+  }
+  const size_t index = freeIndices.back();
+  freeIndices.pop_back();
+  pipelines[index] = std::move(pipeline);
+  return index;
+}
+
+void PipelineManager::release(size_t index, DeferredDeletionQueue &queue)
+{
+  std::erase_if(keyIndices, [index](const auto &entry) {
+    return entry.second == index;
+  });
+  std::visit(
+      [this, &queue](auto &old) {
+        dropOptimizedLink(old);
+        pipelineCache.forgetCreation(old.getPipeline());
+        old.retire(queue);
+      },
+      *pipelines[index]
+  );
+  // Its handles are in the queue, the object holds nothing anymore
+  pipelines[index].reset();
+  freeIndices.push_back(index);
+}
+
+void PipelineManager::bindName(const std::string &name, size_t index)
+{
+  PipelineHandle  &handle  = pipelineHandles[name];
+  PipelineBinding *binding = bindings.get(handle.slot);
+  if (!binding) {
+    handle.slot = bindings.emplace();
+    binding     = bindings.get(handle.slot);
+    if (!binding) {
+      throw std::runtime_error(
+          "Failed to allocate the binding of pipeline '" + name + "'"
+      );
+    }
+  }
+  binding->index = index;
+  refreshBinding(*binding);
+}
+
+void PipelineManager::recordRaster(
+    const std::string &name,
+    const RasterState &raster
+)
+{
+  pipelineRasterStates[name] = raster;
+  if (PipelineBinding *binding = bindings.get(getHandle(name).slot)) {
+    binding->raster = raster;
+  }
+}
+
+void PipelineManager::refreshBinding(PipelineBinding &binding) const
+{
+  const PipelineBinding previous = binding;
+  binding.shaderObjects =
+      std::get_if<ShaderObjectPipeline>(pipelines[binding.index].get());
+  std::visit(
+      [&binding](const auto &pipeline) {
+        binding.pipeline  = pipeline.getPipeline();
+        binding.layout    = pipeline.getPipelineLayout();
+        binding.bindPoint = pipeline.getBindPoint();
+      },
+      *pipelines[binding.index]
+  );
+  if (binding.pipeline != previous.pipeline ||
+      binding.layout != previous.layout ||
+      binding.shaderObjects != previous.shaderObjects) {
+    ++binding.version;
+  }
+}
+
 // Pipeline creation functions are now templated in the header file
 
+std::unique_ptr<PipelineManager::AllPipelines> PipelineManager::buildPipeline(
+    VkDevice                   device,
+    const PipelineDescription &description,
+    PipelineBackend            built,
+    PipelineBuildResult       &result,
+    VkExtent2D                 fallbackExtent
+)
+{
+  const auto                    start   = std::chrono::steady_clock::now();
+  const auto                    shaders = dereferenced(description.shaders);
+  std::unique_ptr<AllPipelines> pipeline;
+  try {
+    if (built == PipelineBackend::ShaderObjects) {
+      pipeline = std::make_unique<AllPipelines>(
+          std::in_place_type<ShaderObjectPipeline>,
+          device,
+          shaders,
+          pipelineLayouts,
+          shaderObjectSupport,
+          description.specialization,
+          description.raster,
+          description.swapchain ? description.swapchain->getExtent()
+                                : fallbackExtent
+      );
+    }
+    else if (description.bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+      pipeline = std::make_unique<AllPipelines>(
+          std::in_place_type<GraphicsPipeline>,
+          device,
+          *description.swapchain,
+          shaders,
+          description.renderPass,
+          shaderModules,
+          pipelineLayouts,
+          pipelineCache,
+          pipelineLibraries,
+          dynamicState,
+          description.specialization,
+          description.raster
+      );
+    }
+    else if (description.bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) {
+      pipeline = std::make_unique<AllPipelines>(
+          std::in_place_type<ComputePipeline>,
+          device,
+          shaders,
+          shaderModules,
+          pipelineLayouts,
+          pipelineCache,
+          description.specialization
+      );
+    }
+    else {
+      // Only reloads describe ray tracing pipelines, see validate
+      pipeline = std::make_unique<AllPipelines>(
+          std::in_place_type<RayTracingPipeline>,
+          device,
+          shaders,
+          pipelineLayouts
+      );
+    }
+  }
+  catch (const std::exception &e) {
+    result.error = e.what();
+  }
+  result.duration = std::chrono::steady_clock::now() - start;
+  return pipeline;
+}
+
+std::vector<PipelineBatchStep> PipelineManager::planBatch(
+    std::span<const PipelineDescription> descriptions,
+    PipelineBackend                      built
+) const
+{
+  std::vector<PipelineBatchStep>  steps(descriptions.size());
+  std::unordered_set<std::string> names;
+  // First description of the batch building each key
+  std::unordered_map<ABox::Hash128, size_t> building;
+
+  for (size_t i = 0; i < descriptions.size(); ++i) {
+    const PipelineDescription &description = descriptions[i];
+    PipelineBatchStep         &step        = steps[i];
+
+    step.error = names.insert(description.name).second
+                     ? validate(description, built)
+                     : "name used twice in the batch";
+    if (!step.error.empty()) {
+      continue;
+    }
+
+    step.key = descriptionKey(description, built);
+    if (isUnchanged(description.name, step.key)) {
+      step.action = PipelineBatchAction::Keep;
+    }
+    else if (keyIndices.contains(step.key)) {
+      step.action = PipelineBatchAction::Share;
+    }
+    else if (auto [first, added] = building.emplace(step.key, i); !added) {
+      step.action  = PipelineBatchAction::ShareBuilt;
+      step.builder = first->second;
+    }
+    else {
+      step.action = PipelineBatchAction::Build;
+    }
+  }
+  return steps;
+}
+
+PipelineBatchReport PipelineManager::createPipelines(
+    VkDevice                             device,
+    std::span<const PipelineDescription> descriptions,
+    ABox::ThreadPool                    &pool
+)
+{
+  const auto          start = std::chrono::steady_clock::now();
+  PipelineBatchReport report;
+  // Sized once: workers write their own result
+  report.results.resize(descriptions.size());
+
+  const PipelineBackend                built = backend;
+  const std::vector<PipelineBatchStep> steps = planBatch(descriptions, built);
+  // Only the Build steps have one
+  std::vector<std::future<std::unique_ptr<AllPipelines>>> builds(
+      descriptions.size()
+  );
+  for (size_t i = 0; i < descriptions.size(); ++i) {
+    const PipelineDescription &description = descriptions[i];
+    PipelineBuildResult       &result      = report.results[i];
+    result.name                            = description.name;
+    if (steps[i].action != PipelineBatchAction::Build) {
+      continue;
+    }
+    // Both caches are internally synchronized, nothing else is shared
+    builds[i] = pool.submit([this, device, built, &description, &result] {
+      return buildPipeline(device, description, built, result);
+    });
+  }
+
+  // Committed in description order whatever order the workers finished in
+  for (size_t i = 0; i < descriptions.size(); ++i) {
+    const PipelineDescription &description = descriptions[i];
+    const PipelineBatchStep   &step        = steps[i];
+    PipelineBuildResult       &result      = report.results[i];
+    switch (step.action) {
+      case PipelineBatchAction::Reject:
+        result.error = step.error;
+        LOG_ERROR("Pipeline") << "Cannot create pipeline '" << description.name
+                              << "': " << result.error;
+        break;
+      case PipelineBatchAction::Keep:
+        findUnchanged(description, step.key, built);
+        result.status = PipelineBuildStatus::Unchanged;
+        break;
+      case PipelineBatchAction::Share:
+      case PipelineBatchAction::ShareBuilt:
+        // A ShareBuilt step's builder was committed before, if it built
+        if (share(
+                description.name,
+                dereferenced(description.shaders),
+                description.specialization,
+                description.raster,
+                description.renderPass,
+                step.key
+            )) {
+          ++avoidedCreations;
+          result.status = PipelineBuildStatus::Shared;
+        }
+        else {
+          result.error = "same state as '" +
+                         descriptions[step.builder].name + "', which failed";
+          LOG_ERROR("Pipeline") << "Failed to create pipeline '"
+                                << description.name << "': " << result.error;
+        }
+        break;
+      case PipelineBatchAction::Build:
+        if (std::unique_ptr<AllPipelines> pipeline = builds[i].get()) {
+          commit(
+              description.name,
+              std::move(pipeline),
+              dereferenced(description.shaders),
+              description.specialization,
+              description.raster,
+              description.renderPass,
+              step.key
+          );
+          result.status = PipelineBuildStatus::Created;
+        }
+        else {
+          LOG_ERROR("Pipeline") << "Failed to create pipeline '"
+                                << description.name << "': " << result.error;
+        }
+        break;
+    }
+  }
+
+  for (size_t i = 0; i < descriptions.size(); ++i) {
+    if (report.results[i].status == PipelineBuildStatus::Failed) {
+      continue;
+    }
+    report.results[i].handle = getHandle(descriptions[i].name);
+    if (descriptions[i].setAsMain) {
+      setMain(descriptions[i]);
+    }
+  }
+
+  report.wallTime = std::chrono::steady_clock::now() - start;
+  LOG_INFO("Pipeline") << "Pipeline batch: "
+                       << report.count(PipelineBuildStatus::Created)
+                       << " created, "
+                       << report.count(PipelineBuildStatus::Unchanged)
+                       << " unchanged, "
+                       << report.count(PipelineBuildStatus::Shared)
+                       << " shared, "
+                       << report.count(PipelineBuildStatus::Failed)
+                       << " failed in "
+                       << std::chrono::duration<double, std::milli>(
+                              report.wallTime
+                          )
+                              .count()
+                       << " ms on " << pool.size() << " threads";
+  return report;
+}
+
+AsyncPipelineHandle PipelineManager::createPipelineAsync(
+    VkDevice            device,
+    PipelineDescription description,
+    std::string         fallback,
+    ABox::ThreadPool   &pool
+)
+{
+  const AsyncPipelineHandle handle{.id = nextAsyncId++};
+  auto                      build = std::make_unique<AsyncBuild>();
+  build->result.name              = description.name;
+  build->result.error             = validate(description, backend);
+  build->description              = std::move(description);
+  build->fallback                 = std::move(fallback);
+  build->backend                  = backend;
+
+  AsyncBuild &entry = *build;
+  asyncBuilds.emplace(handle.id, std::move(build));
+  if (!entry.result.error.empty()) {
+    LOG_ERROR("Pipeline") << "Cannot create pipeline '" << entry.result.name
+                          << "': " << entry.result.error;
+    entry.state = AsyncPipelineState::Failed;
+    return handle;
+  }
+
+  entry.key = descriptionKey(entry.description, entry.backend);
+  if (findUnchanged(entry.description, entry.key, entry.backend)) {
+    entry.result.status = PipelineBuildStatus::Unchanged;
+  }
+  else if (share(
+               entry.description.name,
+               dereferenced(entry.description.shaders),
+               entry.description.specialization,
+               entry.description.raster,
+               entry.description.renderPass,
+               entry.key
+           )) {
+    ++avoidedCreations;
+    entry.result.status = PipelineBuildStatus::Shared;
+  }
+  if (entry.result.status != PipelineBuildStatus::Failed) {
+    entry.state         = AsyncPipelineState::Ready;
+    entry.result.handle = getHandle(entry.description.name);
+    if (entry.description.setAsMain) {
+      setMain(entry.description);
+    }
+    return handle;
+  }
+
+  // The entry is heap allocated: it stays put while the map changes
+  entry.pipeline = pool.submit([this, device, &entry] {
+    return buildPipeline(
+        device,
+        entry.description,
+        entry.backend,
+        entry.result
+    );
+  });
+  LOG_DEBUG("Pipeline") << "Building pipeline '" << entry.result.name
+                        << "' in the background";
+  return handle;
+}
+
+size_t PipelineManager::publishReadyPipelines()
+{
+  size_t published = 0;
+  for (auto &[id, build] : asyncBuilds) {
+    if (build->state != AsyncPipelineState::Pending ||
+        build->pipeline.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready) {
+      continue;
+    }
+    std::unique_ptr<AllPipelines> pipeline    = build->pipeline.get();
+    const PipelineDescription    &description = build->description;
+    if (!pipeline) {
+      LOG_ERROR("Pipeline") << "Failed to create pipeline '"
+                            << description.name
+                            << "': " << build->result.error;
+      build->state = AsyncPipelineState::Failed;
+      continue;
+    }
+    // Another request may have registered the same state meanwhile, the
+    // duplicate was never bound and goes right away
+    if (share(
+            description.name,
+            dereferenced(description.shaders),
+            description.specialization,
+            description.raster,
+            description.renderPass,
+            build->key
+        )) {
+      build->result.status = PipelineBuildStatus::Shared;
+      std::visit(
+          [this](const auto &duplicate) {
+            pipelineCache.forgetCreation(duplicate.getPipeline());
+          },
+          *pipeline
+      );
+    }
+    else {
+      commit(
+          description.name,
+          std::move(pipeline),
+          dereferenced(description.shaders),
+          description.specialization,
+          description.raster,
+          description.renderPass,
+          build->key
+      );
+      build->result.status = PipelineBuildStatus::Created;
+    }
+    if (description.setAsMain) {
+      setMain(description);
+    }
+    build->state         = AsyncPipelineState::Ready;
+    build->result.handle = getHandle(description.name);
+    ++published;
+    LOG_INFO("Pipeline") << "Published pipeline: " << description.name;
+  }
+  return published;
+}
+
+AsyncPipelineState PipelineManager::getState(AsyncPipelineHandle handle) const
+{
+  auto it = asyncBuilds.find(handle.id);
+  return it != asyncBuilds.end() ? it->second->state
+                                 : AsyncPipelineState::Failed;
+}
+
+PipelineBase *PipelineManager::resolve(AsyncPipelineHandle handle)
+{
+  auto it = asyncBuilds.find(handle.id);
+  if (it == asyncBuilds.end()) {
+    return nullptr;
+  }
+  const AsyncBuild  &build = *it->second;
+  const std::string &name  = build.state == AsyncPipelineState::Ready
+                                 ? build.description.name
+                                 : build.fallback;
+  auto index = pipelineIndices.find(name);
+  if (index == pipelineIndices.end()) {
+    return nullptr;
+  }
+  return std::visit(
+      [](auto &pipeline) -> PipelineBase * { return &pipeline; },
+      *pipelines[index->second]
+  );
+}
+
+const PipelineBuildResult *
+    PipelineManager::getAsyncResult(AsyncPipelineHandle handle) const
+{
+  auto it = asyncBuilds.find(handle.id);
+  return it != asyncBuilds.end() ? &it->second->result : nullptr;
+}
+
+size_t PipelineManager::getPendingAsyncCount() const
+{
+  return std::ranges::count_if(asyncBuilds, [](const auto &entry) {
+    return entry.second->state == AsyncPipelineState::Pending;
+  });
+}
+
+size_t PipelineManager::swapOptimizedPipelines(DeferredDeletionQueue &queue)
+{
+  size_t swapped = 0;
+  std::erase_if(optimizedLinks, [this, &queue, &swapped](OptimizedLink &link) {
+    if (link.linked.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      return false;
+    }
+    try {
+      const VkPipeline fastLinked = link.pipeline->getPipeline();
+      if (link.pipeline->adoptOptimized(link.linked.get(), queue)) {
+        pipelineCache.forgetCreation(fastLinked);
+        ++swapped;
+      }
+    }
+    catch (const std::exception &e) {
+      LOG_WARN("Pipeline") << "Optimized link failed, keeping the fast-linked "
+                              "pipeline: "
+                           << e.what();
+    }
+    return true;
+  });
+  if (swapped > 0) {
+    // The names of a swapped pipeline now bind its optimized handle
+    for (PipelineBinding &binding : bindings) {
+      refreshBinding(binding);
+    }
+    LOG_DEBUG("Pipeline") << "Swapped in " << swapped
+                          << " link-time optimized pipelines";
+  }
+  return swapped;
+}
+
+size_t PipelineManager::reload(
+    VkDevice                          device,
+    const std::vector<std::string>   &changedShaders,
+    const std::vector<ShaderDataRef> &shaders,
+    const Swapchain                  *swapchain,
+    DeferredDeletionQueue            &queue
+)
+{
+  size_t              rebuilt = 0;
+  std::vector<size_t> replaced;
+  for (auto &[name, shaderNames] : pipelineShaders) {
+    const bool affected = std::ranges::any_of(
+        shaderNames,
+        [&changedShaders](const std::string &shader) {
+          return std::ranges::find(changedShaders, shader) !=
+                 changedShaders.end();
+        }
+    );
+    if (!affected) {
+      continue;
+    }
+
+    const size_t oldIndex = pipelineIndices.at(name);
+    const auto  *objects =
+        std::get_if<ShaderObjectPipeline>(pipelines[oldIndex].get());
+    const PipelineBackend built = objects ? PipelineBackend::ShaderObjects
+                                          : PipelineBackend::Pipelines;
+    PipelineDescription description;
+    description.name      = name;
+    description.bindPoint = std::visit(
+        [](const auto &pipeline) { return pipeline.getBindPoint(); },
+        *pipelines[oldIndex]
+    );
+    description.specialization = pipelineSpecializations[name];
+    description.raster         = pipelineRasterStates[name];
+    description.swapchain      = swapchain;
+    description.renderPass     = pipelineRenderPasses[name];
+    for (const std::string &shaderName : shaderNames) {
+      for (const ShaderDataRef &shader : shaders) {
+        if (shader->getName() == shaderName) {
+          description.shaders.push_back(shader);
+          break;
+        }
+      }
+    }
+    const bool rayTracing =
+        description.bindPoint == VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR;
+    std::optional<ABox::Hash128> key;
+    if (!rayTracing) {
+      key = descriptionKey(description, built);
+    }
+
+    size_t newIndex = 0;
+    auto   shared   = key ? keyIndices.find(*key) : keyIndices.end();
+    if (shared != keyIndices.end()) {
+      // Possibly the current pipeline, when the code did not change
+      newIndex = shared->second;
+    }
+    else {
+      // Built next to the old one, which frames in flight still use
+      PipelineBuildResult           result;
+      std::unique_ptr<AllPipelines> pipeline;
+      if (built == PipelineBackend::Pipelines &&
+          description.bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS &&
+          !swapchain) {
+        result.error = "no swapchain";
+      }
+      else {
+        pipeline = buildPipeline(
+            device,
+            description,
+            built,
+            result,
+            objects ? objects->getScissor().extent : VkExtent2D{}
+        );
+      }
+      if (!pipeline) {
+        LOG_ERROR("Pipeline") << "Reload of pipeline '" << name
+                              << "' failed, keeping the previous one: "
+                              << result.error;
+        continue;
+      }
+      newIndex = store(std::move(pipeline));
+      if (key) {
+        keyIndices[*key] = newIndex;
+      }
+      scheduleOptimizedLink(newIndex);
+    }
+    if (key) {
+      pipelineKeys[name] = *key;
+    }
+    if (newIndex == oldIndex) {
+      continue;
+    }
+
+    pipelineIndices[name] = newIndex;
+    bindName(name, newIndex);
+    replaced.push_back(oldIndex);
+    if (mainGraphicsPipelineIndex == oldIndex) {
+      mainGraphicsPipelineIndex = newIndex;
+    }
+    if (mainComputePipelineIndex == oldIndex) {
+      mainComputePipelineIndex = newIndex;
+    }
+    ++rebuilt;
+    LOG_INFO("Pipeline") << "Reloaded pipeline: " << name;
+  }
+
+  // Other names may still share a replaced pipeline
+  std::ranges::sort(replaced);
+  const auto [last, end] = std::ranges::unique(replaced);
+  replaced.erase(last, end);
+  for (const size_t oldIndex : replaced) {
+    if (std::ranges::find(pipelineIndices | std::views::values, oldIndex) !=
+        std::ranges::end(pipelineIndices | std::views::values)) {
+      continue;
+    }
+    release(oldIndex, queue);
+  }
+  if (!replaced.empty()) {
+    pipelineLayouts.retireUnused(queue);
+    // Libraries are never bound: the released pipelines' parts can go now
+    pipelineLibraries.trim(pipelineCache);
+  }
+  return rebuilt;
+}
+
+bool PipelineManager::setBackend(PipelineBackend preferred)
+{
+  if (preferred == PipelineBackend::ShaderObjects &&
+      !shaderObjectSupport.isEnabled()) {
+    LOG_WARN("Pipeline") << "VK_EXT_shader_object not enabled on the device, "
+                            "building pipelines";
+    backend = PipelineBackend::Pipelines;
+    return false;
+  }
+  backend = preferred;
+  return true;
+}
+
 PipelineBase *PipelineManager::getPipeline(const std::string &name)
 {
+  // Setup code probes names with it, a miss is not worth a warning
   auto it = pipelineIndices.find(name);
   if (it == pipelineIndices.end()) {
-    LOG_WARN("Pipeline") << "Pipeline '" << name << "' not found";
     return nullptr;
   }
 
   return std::visit(
       [](auto &pipeline) -> PipelineBase * { return &pipeline; },
-      pipelines[it->second]
+      *pipelines[it->second]
   );
 }
 
+PipelineBase *PipelineManager::getPipeline(PipelineHandle handle)
+{
+  const PipelineBinding *binding = bindings.get(handle.slot);
+  if (!binding) {
+    return nullptr;
+  }
+
+  return std::visit(
+      [](auto &pipeline) -> PipelineBase * { return &pipeline; },
+      *pipelines[binding->index]
+  );
+}
+
+PipelineReport PipelineManager::buildReport() const
+{
+  PipelineReport report;
+  report.entries.reserve(pipelineIndices.size());
+  for (const auto &[name, index] : pipelineIndices) {
+    PipelineReportEntry &entry = report.entries.emplace_back();
+    entry.name                 = name;
+    const VkPipeline pipeline  = std::visit(
+        [&entry](const auto &named) {
+          entry.bindPoint = named.getBindPoint();
+          return named.getPipeline();
+        },
+        *pipelines[index]
+    );
+    if (pipeline == VK_NULL_HANDLE) {
+      continue;
+    }
+    entry.creation    = pipelineCache.getCreationRecord(pipeline);
+    entry.executables = pipelineStatistics.collect(pipeline);
+  }
+  std::ranges::sort(report.entries, {}, &PipelineReportEntry::name);
+  return report;
+}
+
+PipelineHandle PipelineManager::getHandle(const std::string &name) const
+{
+  auto it = pipelineHandles.find(name);
+  return it != pipelineHandles.end() ? it->second : PipelineHandle{};
+}
+
 GraphicsPipeline *PipelineManager::getMainGraphicsPipeline()
 {
   if (mainGraphicsPipelineIndex == static_cast<size_t>(-1)) {
     return nullptr;
   }
 
-  return std::get_if<GraphicsPipeline>(&pipelines[mainGraphicsPipelineIndex]);
+  return std::get_if<GraphicsPipeline>(
+      pipelines[mainGraphicsPipelineIndex].get()
+  );
+}
+
+const RasterState *PipelineManager::getMainGraphicsRasterState() const
+{
+  const PipelineBinding *binding = getBinding(getHandle(mainGraphicsName));
+  return binding ? &binding->raster : nullptr;
 }
 
 ComputePipeline *PipelineManager::getMainComputePipeline()
@@ -38,7 +884,9 @@ ComputePipeline *PipelineManager::getMainComputePipeline()
     return nullptr;
   }
 
-  return std::get_if<ComputePipeline>(&pipelines[mainComputePipelineIndex]);
+  return std::get_if<ComputePipeline>(
+      pipelines[mainComputePipelineIndex].get()
+  );
 }
 
 void PipelineManager::bindPipeline(
@@ -46,14 +894,11 @@ void PipelineManager::bindPipeline(
     VkCommandBuffer    commandBuffer
 )
 {
-  auto it = pipelineIndices.find(name);
-  if (it == pipelineIndices.end()) {
+  const PipelineHandle handle = getHandle(name);
+  if (!handle.valid()) {
     LOG_WARN("Pipeline") << "Cannot bind: Pipeline '" << name << "' not found";
     return;
   }
 
-  std::visit(
-      [commandBuffer](auto &pipeline) { pipeline.bind(commandBuffer); },
-      pipelines[it->second]
-  );
+  bindPipeline(handle, commandBuffer);
 }
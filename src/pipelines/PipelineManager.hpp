@@ -2,19 +2,150 @@
 #define PIPELINE_MANAGER_HPP
 
 #include "ComputePipeline.hpp"
+#include "DynamicState.hpp"
+#include "FetchList.hpp"
 #include "GraphicsPipeline.hpp"
+#include "Hash.hpp"
 #include "Logger.hpp"
 #include "PipelineBase.hpp"
+#include "PipelineCache.hpp"
+#include "PipelineLayoutCache.hpp"
+#include "PipelineLibraryCache.hpp"
+#include "PipelineStatistics.hpp"
 #include "RayTracingPipeline.hpp"
+#include "RenderPassCompatibility.hpp"
+#include "ShaderObjectPipeline.hpp"
+#include "ShaderModuleCache.hpp"
+#include "SpecializationConstants.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
 #include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 #include <vulkan/vulkan_core.h>
 
+/**
+ * @brief One pipeline of a PipelineManager::createPipelines batch, the
+ * swapchain and render pass must outlive the call. The shaders are held, see
+ * ShaderHandler::shareShader
+ */
+struct PipelineDescription {
+  std::string name;
+  // VK_PIPELINE_BIND_POINT_GRAPHICS or VK_PIPELINE_BIND_POINT_COMPUTE
+  VkPipelineBindPoint        bindPoint;
+  std::vector<ShaderDataRef> shaders;
+  SpecializationConstants    specialization;
+  RasterState                raster; // graphics only
+  const Swapchain           *swapchain  = nullptr; // graphics only
+  VkRenderPass               renderPass = VK_NULL_HANDLE;
+  bool                       setAsMain  = false;
+};
+
+enum class PipelineBuildStatus : uint8_t {
+  Created,
+  Unchanged, // built from the same key as the registered one, kept
+  Shared,    // same key as a pipeline of another name, now named by both
+  Failed,
+};
+
+/**
+ * @brief What binding a named pipeline takes, kept current by the
+ * PipelineManager across reloads and optimized relinks
+ */
+struct PipelineBinding {
+  VkPipeline          pipeline  = VK_NULL_HANDLE;
+  VkPipelineLayout    layout    = VK_NULL_HANDLE;
+  VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  size_t              index     = 0; // in the manager's pipeline storage
+  RasterState         raster; // asked by the name, dynamic fields included
+  // Bound through its shaders instead of pipeline, null for a pipeline
+  const ShaderObjectPipeline *shaderObjects = nullptr;
+  // Bumped when the name gets another pipeline, so copies can tell stale
+  uint32_t version = 0;
+};
+
+/**
+ * @brief Name registered in a PipelineManager, resolved once at setup so
+ * recording binds without a name lookup. Stays valid across reloads: it
+ * follows the name, not the pipeline.
+ */
+struct PipelineHandle {
+  FetchList<PipelineBinding>::Handle slot;
+
+  [[nodiscard]] bool valid() const { return slot.isValid(); }
+
+  bool operator==(const PipelineHandle &) const = default;
+};
+
+struct PipelineBuildResult {
+  std::string              name;
+  PipelineBuildStatus      status = PipelineBuildStatus::Failed;
+  PipelineHandle           handle; // of the name, unless the build failed
+  std::string              error;
+  std::chrono::nanoseconds duration{0}; // construction on the worker
+};
+
+/** @brief What PipelineManager::createPipelines does with one description */
+enum class PipelineBatchAction : uint8_t {
+  Reject,     // invalid, or its name is used twice: see the step's error
+  Keep,       // registered under its name with the same key
+  Share,      // a registered pipeline has the same key
+  Build,      // built on the pool
+  ShareBuilt, // same key as an earlier Build of the batch, shares it
+};
+
+/** @brief Plan of one description, see PipelineManager::planBatch */
+struct PipelineBatchStep {
+  PipelineBatchAction action = PipelineBatchAction::Reject;
+  ABox::Hash128       key;         // unless rejected
+  size_t              builder = 0; // ShareBuilt: description building it
+  std::string         error;       // Reject only
+};
+
+struct PipelineBatchReport {
+  std::vector<PipelineBuildResult> results; // in description order
+  std::chrono::nanoseconds         wallTime{0};
+
+  [[nodiscard]] size_t count(PipelineBuildStatus status) const
+  {
+    return std::ranges::count(results, status, &PipelineBuildResult::status);
+  }
+};
+
+/** @brief Pipeline requested through PipelineManager::createPipelineAsync */
+struct AsyncPipelineHandle {
+  uint64_t id = 0; // 0: no request
+
+  [[nodiscard]] bool valid() const { return id != 0; }
+
+  bool operator==(const AsyncPipelineHandle &) const = default;
+};
+
+enum class AsyncPipelineState : uint8_t {
+  Pending, // building, or built and waiting for the next frame boundary
+  Ready,
+  Failed,
+};
+
+/** @brief What PipelineDescriptions are built as */
+enum class PipelineBackend : uint8_t {
+  Pipelines,     // GraphicsPipeline and ComputePipeline
+  ShaderObjects, // ShaderObjectPipeline, VK_EXT_shader_object
+};
+
 /**
  * @brief Manages all pipeline types in a single heterogeneous container
- * Uses std::variant for type-safe storage without heap allocation
+ * Uses std::variant for type-safe storage; each pipeline is allocated on
+ * its own so batches can build them on worker threads
  */
 class PipelineManager {
   // Constrained variant - only accepts PipelineBase derivatives
@@ -23,18 +154,338 @@ class PipelineManager {
   using PipelineVariant = std::variant<Ts...>;
 
   using AllPipelines =
-      PipelineVariant<GraphicsPipeline, ComputePipeline, RayTracingPipeline>;
+      PipelineVariant<
+          GraphicsPipeline,
+          ComputePipeline,
+          RayTracingPipeline,
+          ShaderObjectPipeline>;
 
-  std::deque<AllPipelines>                pipelines;
+  std::deque<std::unique_ptr<AllPipelines>> pipelines;
+  // Slots of retired pipelines, null in the deque, reused by the next ones
+  std::vector<size_t>                     freeIndices;
   std::unordered_map<std::string, size_t> pipelineIndices;
+  // Cached bind state of each name, what recording reads through handles
+  FetchList<PipelineBinding>                      bindings;
+  std::unordered_map<std::string, PipelineHandle> pipelineHandles;
+  // Names of the shaders each pipeline was built from, for reloads
+  std::unordered_map<std::string, std::vector<std::string>> pipelineShaders;
+  // Specialization values each pipeline was built with, for reloads
+  std::unordered_map<std::string, SpecializationConstants>
+      pipelineSpecializations;
+  // Fixed-function state each graphics name asked for, for reloads and binds
+  std::unordered_map<std::string, RasterState> pipelineRasterStates;
+  // Render pass each graphics name was built for, for reloads
+  std::unordered_map<std::string, VkRenderPass> pipelineRenderPasses;
+  // Shader code, specialization and render pass each pipeline was built from
+  std::unordered_map<std::string, ABox::Hash128> pipelineKeys;
+  // Live pipeline of each key, shared by all the names asking for that state
+  std::unordered_map<ABox::Hash128, size_t> keyIndices;
+  // Requests answered with a registered pipeline instead of a compile
+  uint64_t avoidedCreations = 0;
+  // Modules shared by the pipelines of this device
+  ShaderModuleCache shaderModules;
+  // Set and pipeline layouts shared by the pipelines of this device
+  PipelineLayoutCache pipelineLayouts;
+  // States graphics pipelines leave dynamic, enabled by DeviceHandler
+  ExtendedDynamicState dynamicState;
+  // Driver cache of this device's pipelines, saved when the manager goes
+  PipelineCache pipelineCache;
+  // Graphics pipeline parts, when the device links pipelines from libraries
+  PipelineLibraryCache pipelineLibraries;
+  // Shader object entry points, enabled by DeviceHandler when supported
+  ShaderObjectSupport shaderObjectSupport;
+  // Executable statistics, enabled by DeviceHandler on request
+  PipelineStatistics pipelineStatistics;
+  // What descriptions are built as, see setBackend
+  PipelineBackend backend = PipelineBackend::Pipelines;
 
   // Optional: "main" pipeline references for quick access
   size_t mainGraphicsPipelineIndex = static_cast<size_t>(-1);
   size_t mainComputePipelineIndex  = static_cast<size_t>(-1);
+  // Its raster state is recorded with the main graphics pipeline
+  std::string mainGraphicsName;
+
+  // Background build of createPipelineAsync, published between frames
+  struct AsyncBuild {
+    PipelineDescription description;
+    std::string         fallback;
+    PipelineBackend     backend = PipelineBackend::Pipelines;
+    ABox::Hash128       key;
+    AsyncPipelineState  state = AsyncPipelineState::Pending;
+    PipelineBuildResult result; // written by the worker until it is done
+    std::future<std::unique_ptr<AllPipelines>> pipeline;
+  };
+  // Ordered by id: of two builds of one name, the later request wins
+  std::map<uint64_t, std::unique_ptr<AsyncBuild>> asyncBuilds;
+  uint64_t                                        nextAsyncId = 1;
+
+  // Link-time optimized relink of a fast-linked pipeline, swapped in
+  // between frames
+  struct OptimizedLink {
+    GraphicsPipeline            *pipeline;
+    std::future<PipelineWrapper> linked;
+  };
+  std::vector<OptimizedLink> optimizedLinks;
+
+  /** @brief Relink the pipeline at index on the pool if it was fast-linked */
+  void scheduleOptimizedLink(size_t index);
+
+  /** @brief Wait for the relink of pipeline and drop it, before a retire */
+  void dropOptimizedLink(const PipelineBase &pipeline);
+
+  /**
+   * @brief Keep pipeline in a free slot, or a new one
+   * @return Its index
+   */
+  size_t store(std::unique_ptr<AllPipelines> pipeline);
+
+  /**
+   * @brief Retire the pipeline at index, which no name uses anymore, and
+   * free its slot
+   */
+  void release(size_t index, DeferredDeletionQueue &queue);
+
+  /** @brief Point the binding of name at the pipeline at index */
+  void bindName(const std::string &name, size_t index);
+
+  /**
+   * @brief Read the handle, layout and bind point of binding's pipeline,
+   * bumping its version if they changed
+   */
+  void refreshBinding(PipelineBinding &binding) const;
+
+  /** @brief Keep the state name asks for, applied when it is bound */
+  void recordRaster(const std::string &name, const RasterState &raster);
+
+  template <std::ranges::range R>
+  void recordShaders(const std::string &name, const R &shaders)
+  {
+    std::vector<std::string> &names = pipelineShaders[name];
+    names.clear();
+    for (const ShaderDataFile &shader : shaders) {
+      names.push_back(shader.getName());
+    }
+  }
+
+  /**
+   * @return Why the description cannot be built with the built backend,
+   * empty if it can
+   */
+  static std::string
+      validate(const PipelineDescription &description, PipelineBackend built);
+
+  ABox::Hash128 descriptionKey(
+      const PipelineDescription &description,
+      PipelineBackend            built
+  ) const;
+
+  /** @brief Whether name is registered with key, see findUnchanged */
+  bool isUnchanged(const std::string &name, const ABox::Hash128 &key) const;
+
+  /** @brief The registered pipeline the description would rebuild as is */
+  PipelineBase *findUnchanged(
+      const PipelineDescription &description,
+      const ABox::Hash128       &key,
+      PipelineBackend            built
+  );
+
+  void setMain(const PipelineDescription &description);
+
+  static auto dereferenced(const std::vector<ShaderDataRef> &shaders)
+  {
+    return std::views::transform(shaders, ShaderDataDeref{});
+  }
+
+  /**
+   * @brief Construct one pipeline of a batch, on a worker thread
+   * @param fallbackExtent Of shader objects built without a swapchain
+   * @return null on failure, the error is in result
+   */
+  std::unique_ptr<AllPipelines> buildPipeline(
+      VkDevice                   device,
+      const PipelineDescription &description,
+      PipelineBackend            built,
+      PipelineBuildResult       &result,
+      VkExtent2D                 fallbackExtent = {}
+  );
+
+  /**
+   * @brief reloadPipelines once the shader set is taken by reference
+   * @param shaders Only used during the call
+   */
+  size_t reload(
+      VkDevice                          device,
+      const std::vector<std::string>   &changedShaders,
+      const std::vector<ShaderDataRef> &shaders,
+      const Swapchain                  *swapchain,
+      DeferredDeletionQueue            &queue
+  );
+
+  /** @brief Point name at the pipeline at index, replacing any previous one */
+  template <std::ranges::range R>
+  void registerName(
+      const std::string             &name,
+      size_t                         index,
+      const R                       &shaders,
+      const SpecializationConstants &specialization,
+      const RasterState             &raster,
+      VkRenderPass                   renderPass,
+      const ABox::Hash128           &key
+  )
+  {
+    if (pipelineIndices.contains(name)) {
+      LOG_WARN("Pipeline") << "Pipeline '" << name
+                           << "' already exists, overwriting";
+    }
+    pipelineIndices[name] = index;
+    bindName(name, index);
+    recordRaster(name, raster);
+    recordShaders(name, shaders);
+    pipelineSpecializations[name] = specialization;
+    pipelineRenderPasses[name]    = renderPass;
+    pipelineKeys[name]            = key;
+  }
+
+  /**
+   * @brief Register a built pipeline under name, replacing any previous one
+   * @return Its index
+   */
+  template <std::ranges::range R>
+  size_t commit(
+      const std::string             &name,
+      std::unique_ptr<AllPipelines>  pipeline,
+      const R                       &shaders,
+      const SpecializationConstants &specialization,
+      const RasterState             &raster,
+      VkRenderPass                   renderPass,
+      const ABox::Hash128           &key
+  )
+  {
+    const size_t index = store(std::move(pipeline));
+    registerName(
+        name,
+        index,
+        shaders,
+        specialization,
+        raster,
+        renderPass,
+        key
+    );
+    keyIndices[key] = index;
+    scheduleOptimizedLink(index);
+    return index;
+  }
+
+  /**
+   * @brief Register name for the live pipeline built from key, if any
+   * @return Its index
+   */
+  template <std::ranges::range R>
+  std::optional<size_t> share(
+      const std::string             &name,
+      const R                       &shaders,
+      const SpecializationConstants &specialization,
+      const RasterState             &raster,
+      VkRenderPass                   renderPass,
+      const ABox::Hash128           &key
+  )
+  {
+    auto known = keyIndices.find(key);
+    if (known == keyIndices.end()) {
+      return std::nullopt;
+    }
+    const size_t index = known->second;
+    registerName(
+        name,
+        index,
+        shaders,
+        specialization,
+        raster,
+        renderPass,
+        key
+    );
+    LOG_INFO("Pipeline") << "Pipeline '" << name
+                         << "' has the state of an existing one, sharing it";
+    return index;
+  }
+
+  /**
+   * @brief Canonical key of a pipeline of this manager: the SPIR-V of each
+   * stage, the specialization data, what the pipeline needs of the render
+   * pass (see RenderPassCompatibility) and the baked raster state. The
+   * vertex input and the rest of the fixed-function state are the same for
+   * every pipeline of a bind point, the bind point stands for them.
+   * @param baked ExtendedDynamicState::baked, default for compute
+   */
+  template <std::ranges::range R>
+  static ABox::Hash128 pipelineKey(
+      const R                       &shaders,
+      const SpecializationConstants &specialization,
+      VkRenderPass                   renderPass,
+      VkPipelineBindPoint            bindPoint,
+      const RasterState             &baked
+  )
+  {
+    ABox::Hasher hasher;
+    hasher.update(bindPoint);
+    for (const ShaderDataFile &shader : shaders) {
+      const std::span<const uint32_t> code = shader.getCode();
+      hasher.update(static_cast<uint32_t>(shader.getStage()));
+      hasher.update(code.data(), code.size_bytes());
+    }
+    hasher.update(specialization.getHash());
+    // Graphics pipelines are built for subpass 0
+    hasher.update(RenderPassCompatibility::key(renderPass, 0u));
+    baked.hash(hasher);
+    return hasher.digest();
+  }
+
+  /**
+   * @brief Key of shader objects built from the state of pipelineKey, with
+   * the render pass and raster state left out: none of it is baked. Never
+   * equal to a pipeline's, the two cannot stand for each other.
+   */
+  static ABox::Hash128 shaderObjectKey(const ABox::Hash128 &pipelineKey)
+  {
+    ABox::Hasher hasher;
+    hasher.update(std::string_view("VK_EXT_shader_object"));
+    hasher.update(pipelineKey);
+    return hasher.digest();
+  }
+
+  /**
+   * @brief The pipeline already registered under name if it was built from
+   * the same key, so asking for it again does not recompile it
+   */
+  template <std::derived_from<PipelineBase> T>
+  T *findUnchanged(
+      const std::string   &name,
+      const ABox::Hash128 &key,
+      const RasterState   &raster
+  )
+  {
+    auto known = pipelineKeys.find(name);
+    if (known == pipelineKeys.end() || !(known->second == key)) {
+      return nullptr;
+    }
+    T *existing = getPipelineAs<T>(name);
+    if (existing) {
+      // The key leaves out the dynamic fields, which may have changed
+      recordRaster(name, raster);
+      ++avoidedCreations;
+      LOG_DEBUG("Pipeline") << "Pipeline '" << name
+                            << "' unchanged, reusing it";
+    }
+    return existing;
+  }
 
    public:
   PipelineManager();
-  ~PipelineManager() = default;
+  /**
+   * @brief Waits for the background builds still running, then writes the
+   * report to PipelineStatistics::requestedReport() if set
+   */
+  ~PipelineManager();
 
   DELETE_COPY(PipelineManager)
   DELETE_MOVE(PipelineManager)
@@ -46,18 +497,25 @@ class PipelineManager {
    * @param shaders Range of shader data files (accepts any container: list,
    * vector, etc.)
    * @param setAsMain If true, sets this as the main graphics pipeline
-   * @return Reference to the created pipeline
+   * @param specialization Values of the shaders' specialization constants,
+   * part of the pipeline key
+   * @param raster Fixed-function state of the draws, part of the pipeline
+   * key except the fields the device sets dynamically
+   * @return Reference to the created pipeline, or to the registered one
+   * built from the same shaders, values and render pass, whatever its name
    */
   template <std::ranges::range R>
     requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
              std::same_as<std::ranges::range_value_t<R>, const ShaderDataFile>
   GraphicsPipeline &createGraphicsPipeline(
-      VkDevice           device,
-      const std::string &name,
-      const Swapchain   &swapchain,
-      VkRenderPass       renderPass,
-      const R           &shaders,
-      bool               setAsMain = false
+      VkDevice                       device,
+      const std::string             &name,
+      const Swapchain               &swapchain,
+      VkRenderPass                   renderPass,
+      const R                       &shaders,
+      bool                           setAsMain      = false,
+      const SpecializationConstants &specialization = {},
+      const RasterState             &raster         = {}
   )
   {
     if (std::ranges::empty(shaders)) {
@@ -68,30 +526,63 @@ class PipelineManager {
       );
     }
 
-    if (pipelineIndices.contains(name)) {
-      LOG_WARN("Pipeline") << "Pipeline '" << name
-                           << "' already exists, overwriting";
+    const ABox::Hash128 key = pipelineKey(
+        shaders,
+        specialization,
+        renderPass,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        dynamicState.baked(raster)
+    );
+    if (GraphicsPipeline *existing =
+            findUnchanged<GraphicsPipeline>(name, key, raster)) {
+      if (setAsMain) {
+        mainGraphicsPipelineIndex = pipelineIndices.at(name);
+        mainGraphicsName          = name;
+      }
+      return *existing;
+    }
+    if (std::optional<size_t> shared =
+            share(name, shaders, specialization, raster, renderPass, key)) {
+      ++avoidedCreations;
+      if (setAsMain) {
+        mainGraphicsPipelineIndex = *shared;
+        mainGraphicsName          = name;
+      }
+      return std::get<GraphicsPipeline>(*pipelines[*shared]);
     }
-
-    size_t index          = pipelines.size();
-    pipelineIndices[name] = index;
 
     // GraphicsPipeline constructor handles shader module creation internally
-    auto &variant = pipelines.emplace_back(
-        std::in_place_type<GraphicsPipeline>,
-        device,
-        swapchain,
+    const size_t index = commit(
+        name,
+        std::make_unique<AllPipelines>(
+            std::in_place_type<GraphicsPipeline>,
+            device,
+            swapchain,
+            shaders,
+            renderPass,
+            shaderModules,
+            pipelineLayouts,
+            pipelineCache,
+            pipelineLibraries,
+            dynamicState,
+            specialization,
+            raster
+        ),
         shaders,
-        renderPass
+        specialization,
+        raster,
+        renderPass,
+        key
     );
 
     if (setAsMain) {
       mainGraphicsPipelineIndex = index;
+      mainGraphicsName          = name;
       LOG_DEBUG("Pipeline") << "Set '" << name << "' as main graphics pipeline";
     }
 
     LOG_INFO("Pipeline") << "Created graphics pipeline: " << name;
-    return std::get<GraphicsPipeline>(variant);
+    return std::get<GraphicsPipeline>(*pipelines[index]);
   }
 
   /**
@@ -99,16 +590,21 @@ class PipelineManager {
    * @param name Unique identifier for the pipeline
    * @param shaders Range of shader data files (accepts any container)
    * @param setAsMain If true, sets this as the main compute pipeline
-   * @return Reference to the created pipeline
+   * @param specialization Values of the shader's specialization constants
+   * (a workgroup size picked from the device limits...), part of the
+   * pipeline key
+   * @return Reference to the created pipeline, or to the registered one
+   * built from the same shader and values, whatever its name
    */
   template <std::ranges::range R>
     requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
              std::same_as<std::ranges::range_value_t<R>, const ShaderDataFile>
   ComputePipeline &createComputePipeline(
-      VkDevice           device,
-      const std::string &name,
-      const R           &shaders,
-      bool               setAsMain = false
+      VkDevice                       device,
+      const std::string             &name,
+      const R                       &shaders,
+      bool                           setAsMain      = false,
+      const SpecializationConstants &specialization = {}
   )
   {
     if (std::ranges::empty(shaders)) {
@@ -119,17 +615,45 @@ class PipelineManager {
       );
     }
 
-    if (pipelineIndices.contains(name)) {
-      LOG_WARN("Pipeline") << "Pipeline '" << name
-                           << "' already exists, overwriting";
+    const ABox::Hash128 key = pipelineKey(
+        shaders,
+        specialization,
+        VK_NULL_HANDLE,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        {}
+    );
+    if (ComputePipeline *existing =
+            findUnchanged<ComputePipeline>(name, key, {})) {
+      if (setAsMain) {
+        mainComputePipelineIndex = pipelineIndices.at(name);
+      }
+      return *existing;
+    }
+    if (std::optional<size_t> shared =
+            share(name, shaders, specialization, {}, VK_NULL_HANDLE, key)) {
+      ++avoidedCreations;
+      if (setAsMain) {
+        mainComputePipelineIndex = *shared;
+      }
+      return std::get<ComputePipeline>(*pipelines[*shared]);
     }
 
-    size_t index          = pipelines.size();
-    pipelineIndices[name] = index;
-    auto &variant         = pipelines.emplace_back(
-        std::in_place_type<ComputePipeline>,
-        device,
-        shaders
+    const size_t index = commit(
+        name,
+        std::make_unique<AllPipelines>(
+            std::in_place_type<ComputePipeline>,
+            device,
+            shaders,
+            shaderModules,
+            pipelineLayouts,
+            pipelineCache,
+            specialization
+        ),
+        shaders,
+        specialization,
+        {},
+        VK_NULL_HANDLE,
+        key
     );
 
     if (setAsMain) {
@@ -138,7 +662,7 @@ class PipelineManager {
     }
 
     LOG_INFO("Pipeline") << "Created compute pipeline: " << name;
-    return std::get<ComputePipeline>(variant);
+    return std::get<ComputePipeline>(*pipelines[index]);
   }
 
   /**
@@ -169,18 +693,143 @@ class PipelineManager {
                            << "' already exists, overwriting";
     }
 
-    size_t index          = pipelines.size();
-    pipelineIndices[name] = index;
-    auto &variant         = pipelines.emplace_back(
+    auto pipeline = std::make_unique<AllPipelines>(
         std::in_place_type<RayTracingPipeline>,
         device,
-        shaders
+        shaders,
+        pipelineLayouts
     );
+    auto        &variant  = *pipeline;
+    const size_t index    = store(std::move(pipeline));
+    pipelineIndices[name] = index;
+    bindName(name, index);
+    recordRaster(name, {});
+
+    recordShaders(name, shaders);
+    pipelineSpecializations.erase(name);
+    pipelineRenderPasses.erase(name);
+    pipelineKeys.erase(name);
 
     LOG_INFO("Pipeline") << "Created ray tracing pipeline: " << name;
     return std::get<RayTracingPipeline>(variant);
   }
 
+  /**
+   * @brief What createPipelines would do with each description, decided
+   * before any build and without a device call: invalid ones are rejected,
+   * the unchanged and already registered states reused, and each new state
+   * built once by its first description
+   * @param built Backend the descriptions would be built with
+   * @return One step per description, in description order
+   */
+  [[nodiscard]] std::vector<PipelineBatchStep> planBatch(
+      std::span<const PipelineDescription> descriptions,
+      PipelineBackend                      built
+  ) const;
+
+  /**
+   * @brief Build many graphics and compute pipelines at once, concurrently
+   * on the pool, through the shared shader module and pipeline caches. The
+   * pipelines are registered together once all are built, in description
+   * order; a failed one leaves any previous pipeline of that name in place.
+   * Blocks until the batch is done: do not call from a task of the pool.
+   * @return Per-pipeline status, error and build time, and the wall time
+   * @see planBatch
+   */
+  PipelineBatchReport createPipelines(
+      VkDevice                             device,
+      std::span<const PipelineDescription> descriptions,
+      ABox::ThreadPool                    &pool = ABox::ThreadPool::shared()
+  );
+
+  /**
+   * @brief Start building a graphics or compute pipeline in the background
+   * and return straight away. The pipeline is registered under its name by
+   * the first publishReadyPipelines() after the build finished, so recording
+   * never waits on a compile; until then resolve() returns the fallback.
+   * The swapchain and render pass must outlive the build, the description
+   * holds the shaders through any reload meanwhile.
+   * @param fallback Name of a registered pipeline to use meanwhile
+   */
+  AsyncPipelineHandle createPipelineAsync(
+      VkDevice            device,
+      PipelineDescription description,
+      std::string         fallback = {},
+      ABox::ThreadPool   &pool     = ABox::ThreadPool::shared()
+  );
+
+  /**
+   * @brief Register the background builds that finished, call at a frame
+   * boundary (DeviceBoundElements::collectRetired does)
+   * @return Number of pipelines published
+   */
+  size_t publishReadyPipelines();
+
+  [[nodiscard]] AsyncPipelineState getState(AsyncPipelineHandle handle) const;
+
+  /** @brief Published: resolve() returns the requested pipeline */
+  [[nodiscard]] bool isReady(AsyncPipelineHandle handle) const
+  {
+    return getState(handle) == AsyncPipelineState::Ready;
+  }
+
+  /**
+   * @brief The requested pipeline once published, else the fallback
+   * @return nullptr if neither is registered (unknown handle, failed build
+   * without fallback...)
+   */
+  PipelineBase *resolve(AsyncPipelineHandle handle);
+
+  /**
+   * @brief Status, error and build time of a request, null for an unknown
+   * handle. Only complete once the request left the Pending state
+   */
+  [[nodiscard]] const PipelineBuildResult *
+      getAsyncResult(AsyncPipelineHandle handle) const;
+
+  /** @brief Requests still building or waiting to be published */
+  [[nodiscard]] size_t getPendingAsyncCount() const;
+
+  /**
+   * @brief Swap in the link-time optimized versions of fast-linked pipelines
+   * that finished linking, call at a frame boundary
+   * (DeviceBoundElements::collectRetired does)
+   * @return Number of pipelines swapped
+   */
+  size_t swapOptimizedPipelines(DeferredDeletionQueue &queue);
+
+  /**
+   * @brief Rebuild every pipeline made from one of the changed shaders and
+   * swap it in, graphics ones for the render pass they were created with. A
+   * name whose new state matches a registered pipeline shares it instead.
+   * The replaced handles are retired through the deletion queue once no name
+   * uses them, so no device idle is needed: call between frames. Their slots
+   * are reused, the storage does not grow across reloads. A pipeline whose
+   * rebuild fails keeps its previous version.
+   * @param changedShaders Names of the shaders that changed
+   * @param shaders Current shader set, looked up by name
+   * @param swapchain Needed by graphics pipelines, may be null otherwise
+   * @return Number of names now using another pipeline
+   */
+  template <std::ranges::range R>
+    requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
+             std::same_as<std::ranges::range_value_t<R>, const ShaderDataFile>
+  size_t reloadPipelines(
+      VkDevice                        device,
+      const std::vector<std::string> &changedShaders,
+      const R                        &shaders,
+      const Swapchain                *swapchain,
+      DeferredDeletionQueue          &queue
+  )
+  {
+    // Built synchronously, the shader set outlives these non-owning refs
+    std::vector<ShaderDataRef> current;
+    for (const ShaderDataFile &shader : shaders) {
+      current.emplace_back(ShaderDataRef{}, &shader);
+    }
+    return reload(device, changedShaders, current, swapchain, queue);
+  }
+
   /**
    * @brief Get a pipeline by name (returns base type pointer)
    * @param name Pipeline identifier
@@ -188,6 +837,23 @@ class PipelineManager {
    */
   PipelineBase *getPipeline(const std::string &name);
 
+  /** @brief The pipeline a handle names now, nullptr for an unknown handle */
+  PipelineBase *getPipeline(PipelineHandle handle);
+
+  /**
+   * @brief Handle of a registered name, for setup code: recording binds
+   * through it without hashing the name
+   * @return An invalid handle if no pipeline has that name
+   */
+  [[nodiscard]] PipelineHandle getHandle(const std::string &name) const;
+
+  /** @brief Cached bind state of a handle, null for an unknown handle */
+  [[nodiscard]] const PipelineBinding *getBinding(PipelineHandle handle
+  ) const noexcept
+  {
+    return bindings.get(handle.slot);
+  }
+
   /**
    * @brief Get a typed pipeline by name
    * @tparam T Pipeline type (GraphicsPipeline, ComputePipeline, etc.)
@@ -202,15 +868,105 @@ class PipelineManager {
       return nullptr;
     }
 
-    return std::get_if<T>(&pipelines[it->second]);
+    return std::get_if<T>(pipelines[it->second].get());
   }
 
+  /**
+   * @brief Shader modules of this device's pipelines, see
+   * ShaderModuleCache::setInlineModules for maintenance5
+   */
+  [[nodiscard]] ShaderModuleCache &getShaderModuleCache() noexcept
+  {
+    return shaderModules;
+  }
+
+  /**
+   * @brief Descriptor set and pipeline layouts of this device's pipelines,
+   * identical bindings get the same, bind compatible, layout
+   */
+  [[nodiscard]] PipelineLayoutCache &getPipelineLayoutCache() noexcept
+  {
+    return pipelineLayouts;
+  }
+
+  /**
+   * @brief Extended dynamic state of this device, enabled by DeviceHandler
+   * before any pipeline is created
+   */
+  [[nodiscard]] ExtendedDynamicState &getExtendedDynamicState() noexcept
+  {
+    return dynamicState;
+  }
+
+  /**
+   * @brief Pipeline cache of this device, opened by DeviceHandler when the
+   * device is created
+   */
+  [[nodiscard]] PipelineCache &getPipelineCache() noexcept
+  {
+    return pipelineCache;
+  }
+
+  /**
+   * @brief Graphics pipeline libraries of this device, enabled by
+   * DeviceHandler with VK_EXT_graphics_pipeline_library
+   */
+  [[nodiscard]] PipelineLibraryCache &getPipelineLibraryCache() noexcept
+  {
+    return pipelineLibraries;
+  }
+
+  /**
+   * @brief Shader object entry points of this device, enabled by
+   * DeviceHandler with VK_EXT_shader_object
+   */
+  [[nodiscard]] ShaderObjectSupport &getShaderObjectSupport() noexcept
+  {
+    return shaderObjectSupport;
+  }
+
+  /**
+   * @brief Executable statistics of this device, enabled by DeviceHandler
+   * with VK_KHR_pipeline_executable_properties when requested
+   */
+  [[nodiscard]] PipelineStatistics &getPipelineStatistics() noexcept
+  {
+    return pipelineStatistics;
+  }
+
+  /**
+   * @brief Creation time, cache outcome and, when captured, executable
+   * statistics of every named pipeline, by name. Queries the driver: call
+   * outside the frame loop.
+   */
+  [[nodiscard]] PipelineReport buildReport() const;
+
+  /**
+   * @brief Build the next PipelineDescriptions (createPipelines,
+   * createPipelineAsync) as pipelines or as shader objects. Shader objects
+   * need no compile per state but draw inside dynamic rendering only, and
+   * cannot be the main pipelines. Registered pipelines are kept, a name
+   * changes backend when it is built again.
+   * @return false if the device lacks VK_EXT_shader_object, descriptions
+   * are then built as pipelines
+   */
+  bool setBackend(PipelineBackend preferred);
+
+  [[nodiscard]] PipelineBackend getBackend() const noexcept { return backend; }
+
   /**
    * @brief Get the main graphics pipeline
    * @return Pointer to main graphics pipeline, or nullptr if not set
    */
   GraphicsPipeline *getMainGraphicsPipeline();
 
+  /**
+   * @brief State the main graphics pipeline's name asked for, dynamic fields
+   * included: record it with that pipeline, not its baked state
+   * @return null if no main graphics pipeline is set
+   */
+  [[nodiscard]] const RasterState *getMainGraphicsRasterState() const;
+
   /**
    * @brief Get the main compute pipeline
    * @return Pointer to main compute pipeline, or nullptr if not set
@@ -225,11 +981,56 @@ class PipelineManager {
   void bindPipeline(const std::string &name, VkCommandBuffer commandBuffer);
 
   /**
-   * @brief Get total number of pipelines
+   * @brief Bind the pipeline a handle names, from its cached state: no name
+   * lookup and no variant visit. An unknown handle binds nothing.
+   */
+  void bindPipeline(PipelineHandle handle, VkCommandBuffer commandBuffer)
+      const noexcept
+  {
+    const PipelineBinding *binding = bindings.get(handle.slot);
+    if (!binding) {
+      return;
+    }
+    if (binding->shaderObjects) {
+      binding->shaderObjects->bind(commandBuffer, binding->raster);
+      return;
+    }
+    vkCmdBindPipeline(commandBuffer, binding->bindPoint, binding->pipeline);
+  }
+
+  /**
+   * @brief Bind the pipeline a handle names, then set the dynamic fields of
+   * the state that name asked for, those already set are skipped
+   * @param recorder of commandBuffer, built on getExtendedDynamicState()
+   */
+  void bindPipeline(
+      PipelineHandle        handle,
+      VkCommandBuffer       commandBuffer,
+      DynamicStateRecorder &recorder
+  ) const
+  {
+    const PipelineBinding *binding = bindings.get(handle.slot);
+    if (!binding) {
+      return;
+    }
+    if (binding->shaderObjects) {
+      // Sets all the state, not through the recorder
+      binding->shaderObjects->bind(commandBuffer, binding->raster);
+      recorder.reset();
+      return;
+    }
+    vkCmdBindPipeline(commandBuffer, binding->bindPoint, binding->pipeline);
+    if (binding->bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+      recorder.apply(commandBuffer, binding->raster);
+    }
+  }
+
+  /**
+   * @brief Get the number of live pipelines, retired ones excluded
    */
   [[nodiscard]] size_t getPipelineCount() const noexcept
   {
-    return pipelines.size();
+    return pipelines.size() - freeIndices.size();
   }
 
   /**
@@ -239,6 +1040,15 @@ class PipelineManager {
   {
     return pipelineIndices.contains(name);
   }
+
+  /**
+   * @brief Creation requests answered with a registered pipeline built from
+   * the same state, under that name or another one
+   */
+  [[nodiscard]] uint64_t getAvoidedCreations() const noexcept
+  {
+    return avoidedCreations;
+  }
 };
 
 #endif // PIPELINE_MANAGER_HPP
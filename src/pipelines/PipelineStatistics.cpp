@@ -0,0 +1,330 @@
+#include "PipelineStatistics.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+double milliseconds(std::chrono::nanoseconds duration)
+{
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+const char *bindPointName(VkPipelineBindPoint bindPoint)
+{
+  switch (bindPoint) {
+    case VK_PIPELINE_BIND_POINT_GRAPHICS: return "graphics";
+    case VK_PIPELINE_BIND_POINT_COMPUTE: return "compute";
+    case VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR: return "ray tracing";
+    default: return "unknown";
+  }
+}
+
+double statisticValue(const VkPipelineExecutableStatisticKHR &statistic)
+{
+  switch (statistic.format) {
+    case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_BOOL32_KHR:
+      return statistic.value.b32 ? 1.0 : 0.0;
+    case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_INT64_KHR:
+      return static_cast<double>(statistic.value.i64);
+    case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR:
+      return static_cast<double>(statistic.value.u64);
+    case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_FLOAT64_KHR:
+      return statistic.value.f64;
+    default: return 0.0;
+  }
+}
+
+/** @brief text as a JSON string, quotes included */
+void writeString(std::ostream &os, std::string_view text)
+{
+  os << '"';
+  for (const char c : text) {
+    switch (c) {
+      case '"': os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\r': os << "\\r"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+             << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }
+        else {
+          os << c;
+        }
+    }
+  }
+  os << '"';
+}
+
+} // namespace
+
+double PipelineReportEntry::statistic(std::string_view statisticName) const
+{
+  double total = 0.0;
+  for (const PipelineExecutable &executable : executables) {
+    for (const PipelineStatistic &entry : executable.statistics) {
+      if (entry.name == statisticName) {
+        total += entry.value;
+      }
+    }
+  }
+  return total;
+}
+
+void PipelineReport::sortByCreationTime()
+{
+  std::ranges::stable_sort(
+      entries,
+      [](const PipelineReportEntry &a, const PipelineReportEntry &b) {
+        if (!a.creation || !b.creation) {
+          return a.creation.has_value() > b.creation.has_value();
+        }
+        return a.creation->duration > b.creation->duration;
+      }
+  );
+}
+
+void PipelineReport::sortByStatistic(std::string_view statisticName)
+{
+  std::ranges::stable_sort(
+      entries,
+      std::ranges::greater{},
+      [statisticName](const PipelineReportEntry &entry) {
+        return entry.statistic(statisticName);
+      }
+  );
+}
+
+std::vector<std::string> PipelineReport::statisticNames() const
+{
+  std::set<std::string> names;
+  for (const PipelineReportEntry &entry : entries) {
+    for (const PipelineExecutable &executable : entry.executables) {
+      for (const PipelineStatistic &statistic : executable.statistics) {
+        names.insert(statistic.name);
+      }
+    }
+  }
+  return {names.begin(), names.end()};
+}
+
+std::string PipelineReport::toJson() const
+{
+  std::ostringstream os;
+  // Counts stay integers, times keep sub-microsecond digits
+  os.precision(12);
+  os << "{\n  \"pipelines\": [";
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const PipelineReportEntry &entry = entries[i];
+    os << (i ? ",\n" : "\n") << "    {\n      \"name\": ";
+    writeString(os, entry.name);
+    os << ",\n      \"bindPoint\": ";
+    writeString(os, bindPointName(entry.bindPoint));
+    os << ",\n      \"creation\": ";
+    if (entry.creation) {
+      std::ostringstream outcome;
+      outcome << entry.creation->outcome;
+      os << "{\"milliseconds\": " << milliseconds(entry.creation->duration)
+         << ", \"cache\": ";
+      writeString(os, outcome.str());
+      os << '}';
+    }
+    else {
+      os << "null";
+    }
+    os << ",\n      \"executables\": [";
+    for (size_t j = 0; j < entry.executables.size(); ++j) {
+      const PipelineExecutable &executable = entry.executables[j];
+      os << (j ? ",\n" : "\n") << "        {\"name\": ";
+      writeString(os, executable.name);
+      os << ", \"description\": ";
+      writeString(os, executable.description);
+      os << ", \"stages\": " << executable.stages
+         << ", \"subgroupSize\": " << executable.subgroupSize
+         << ", \"statistics\": [";
+      for (size_t k = 0; k < executable.statistics.size(); ++k) {
+        const PipelineStatistic &statistic = executable.statistics[k];
+        os << (k ? ", " : "") << "{\"name\": ";
+        writeString(os, statistic.name);
+        os << ", \"description\": ";
+        writeString(os, statistic.description);
+        os << ", \"value\": " << statistic.value << '}';
+      }
+      os << "]}";
+    }
+    os << (entry.executables.empty() ? "]" : "\n      ]") << "\n    }";
+  }
+  os << (entries.empty() ? "]" : "\n  ]") << "\n}\n";
+  return os.str();
+}
+
+bool PipelineReport::writeJson(const fs::path &path) const
+{
+  std::error_code ec;
+  if (path.has_parent_path()) {
+    fs::create_directories(path.parent_path(), ec);
+  }
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << toJson();
+  if (!file) {
+    LOG_WARN("Pipeline") << "Failed to write the pipeline report to "
+                         << path.string();
+    return false;
+  }
+  LOG_INFO("Pipeline") << "Pipeline report of " << entries.size()
+                       << " pipelines written to " << path.string();
+  return true;
+}
+
+void PipelineReport::logSummary(size_t worst) const
+{
+  std::chrono::nanoseconds total{0};
+  size_t                   hits       = 0;
+  size_t                   misses     = 0;
+  size_t                   unreported = 0;
+  for (const PipelineReportEntry &entry : entries) {
+    if (!entry.creation) {
+      continue;
+    }
+    total += entry.creation->duration;
+    switch (entry.creation->outcome) {
+      case PipelineCacheOutcome::Hit: ++hits; break;
+      case PipelineCacheOutcome::Miss: ++misses; break;
+      case PipelineCacheOutcome::Unreported: ++unreported; break;
+    }
+  }
+  LOG_INFO("Pipeline") << "Pipeline report: " << entries.size()
+                       << " pipelines, " << milliseconds(total)
+                       << " ms of creation, " << hits << " cache hits, "
+                       << misses << " misses, " << unreported
+                       << " unreported";
+
+  PipelineReport sorted = *this;
+  sorted.sortByCreationTime();
+  for (size_t i = 0; i < std::min(worst, sorted.entries.size()); ++i) {
+    const PipelineReportEntry &entry = sorted.entries[i];
+    if (!entry.creation) {
+      break;
+    }
+    LOG_INFO("Pipeline") << "  " << milliseconds(entry.creation->duration)
+                         << " ms (" << entry.creation->outcome << "): '"
+                         << entry.name << "'";
+  }
+
+  for (const std::string &statisticName : statisticNames()) {
+    sorted.sortByStatistic(statisticName);
+    std::ostringstream line;
+    for (size_t i = 0; i < std::min(worst, sorted.entries.size()); ++i) {
+      line << (i ? ", '" : "'") << sorted.entries[i].name
+           << "' " << sorted.entries[i].statistic(statisticName);
+    }
+    LOG_INFO("Pipeline") << "  " << statisticName << ": " << line.str();
+  }
+}
+
+fs::path PipelineStatistics::requestedReport()
+{
+  if (const char *env = std::getenv("ABOX_PIPELINE_STATISTICS")) {
+    return env;
+  }
+  return {};
+}
+
+bool PipelineStatistics::enable(VkDevice logicalDevice)
+{
+  getProperties = reinterpret_cast<PFN_vkGetPipelineExecutablePropertiesKHR>(
+      vkGetDeviceProcAddr(logicalDevice, "vkGetPipelineExecutablePropertiesKHR")
+  );
+  getStatistics = reinterpret_cast<PFN_vkGetPipelineExecutableStatisticsKHR>(
+      vkGetDeviceProcAddr(logicalDevice, "vkGetPipelineExecutableStatisticsKHR")
+  );
+  if (!getProperties || !getStatistics) {
+    LOG_WARN("Vulkan") << "Missing VK_KHR_pipeline_executable_properties "
+                          "entry points, no pipeline statistics";
+    return false;
+  }
+  device = logicalDevice;
+  LOG_INFO("Pipeline") << "Capturing pipeline executable statistics";
+  return true;
+}
+
+std::vector<PipelineExecutable> PipelineStatistics::collect(VkPipeline pipeline
+) const
+{
+  std::vector<PipelineExecutable> executables;
+  if (!isEnabled() || pipeline == VK_NULL_HANDLE) {
+    return executables;
+  }
+
+  const VkPipelineInfoKHR pipelineInfo{
+      .sType    = VK_STRUCTURE_TYPE_PIPELINE_INFO_KHR,
+      .pNext    = nullptr,
+      .pipeline = pipeline
+  };
+  uint32_t count = 0;
+  if (getProperties(device, &pipelineInfo, &count, nullptr) != VK_SUCCESS) {
+    return executables;
+  }
+  VkPipelineExecutablePropertiesKHR blankProperties{};
+  blankProperties.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_PROPERTIES_KHR;
+  std::vector<VkPipelineExecutablePropertiesKHR> properties(
+      count,
+      blankProperties
+  );
+  if (getProperties(device, &pipelineInfo, &count, properties.data()) !=
+      VK_SUCCESS) {
+    return executables;
+  }
+
+  executables.reserve(count);
+  for (uint32_t index = 0; index < count; ++index) {
+    PipelineExecutable &executable = executables.emplace_back();
+    executable.name                = properties[index].name;
+    executable.description         = properties[index].description;
+    executable.stages              = properties[index].stages;
+    executable.subgroupSize        = properties[index].subgroupSize;
+
+    const VkPipelineExecutableInfoKHR executableInfo{
+        .sType           = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INFO_KHR,
+        .pNext           = nullptr,
+        .pipeline        = pipeline,
+        .executableIndex = index
+    };
+    uint32_t statisticCount = 0;
+    if (getStatistics(device, &executableInfo, &statisticCount, nullptr) !=
+        VK_SUCCESS) {
+      continue;
+    }
+    VkPipelineExecutableStatisticKHR blankStatistic{};
+    blankStatistic.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR;
+    std::vector<VkPipelineExecutableStatisticKHR> statistics(
+        statisticCount,
+        blankStatistic
+    );
+    if (getStatistics(
+            device,
+            &executableInfo,
+            &statisticCount,
+            statistics.data()
+        ) != VK_SUCCESS) {
+      continue;
+    }
+    for (const VkPipelineExecutableStatisticKHR &statistic : statistics) {
+      executable.statistics.push_back(
+          {.name        = statistic.name,
+           .description = statistic.description,
+           .value       = statisticValue(statistic)}
+      );
+    }
+  }
+  return executables;
+}
@@ -0,0 +1,128 @@
+#ifndef PIPELINE_STATISTICS_HPP
+#define PIPELINE_STATISTICS_HPP
+
+#include "PipelineCache.hpp"
+#include "PreProcUtils.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+/** @brief One statistic of a pipeline executable, named by the driver */
+struct PipelineStatistic {
+  std::string name; // "Instruction Count", "VGPRs"...
+  std::string description;
+  double      value = 0.0; // booleans as 0 or 1
+};
+
+/**
+ * @brief Part of a pipeline the driver compiled on its own, usually one
+ * stage
+ */
+struct PipelineExecutable {
+  std::string                    name;
+  std::string                    description;
+  VkShaderStageFlags             stages       = 0;
+  uint32_t                       subgroupSize = 0;
+  std::vector<PipelineStatistic> statistics;
+};
+
+/** @brief What a PipelineReport knows of one named pipeline */
+struct PipelineReportEntry {
+  std::string         name;
+  VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  // Empty for shader objects and pipelines built outside the cache
+  std::optional<PipelineCreationRecord> creation;
+  // Empty unless the device captures statistics
+  std::vector<PipelineExecutable> executables;
+
+  /** @brief Sum over the executables, 0 where the driver has no such name */
+  [[nodiscard]] double statistic(std::string_view statisticName) const;
+};
+
+/**
+ * @brief Creation time, cache outcome and executable statistics of the
+ * named pipelines of a device, see PipelineManager::buildReport. Sort it to
+ * find the pipelines worth simplifying.
+ */
+struct PipelineReport {
+  std::vector<PipelineReportEntry> entries;
+
+  /** @brief Slowest creation first, unrecorded ones last */
+  void sortByCreationTime();
+
+  /** @brief Highest value of the statistic first, see statistic() */
+  void sortByStatistic(std::string_view statisticName);
+
+  /** @brief Statistic names the driver reported, sorted */
+  [[nodiscard]] std::vector<std::string> statisticNames() const;
+
+  /** @brief The entries in their current order, as a JSON document */
+  [[nodiscard]] std::string toJson() const;
+
+  /**
+   * @brief Write toJson() to path
+   * @return false if the file cannot be written
+   */
+  bool writeJson(const std::filesystem::path &path) const;
+
+  /**
+   * @brief Log the totals and the slowest creations, and the worst pipelines
+   * of each statistic
+   * @param worst pipelines listed per ranking
+   */
+  void logSummary(size_t worst = 5) const;
+};
+
+/**
+ * @class PipelineStatistics
+ * @brief VK_KHR_pipeline_executable_properties of one device: what the
+ * driver compiled each pipeline into (register and instruction counts...)
+ *
+ * Opt-in: DeviceHandler enables the extension when $ABOX_PIPELINE_STATISTICS
+ * names a report file and the device supports it, pipelines are then
+ * created with VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR.
+ */
+class PipelineStatistics {
+  VkDevice device = VK_NULL_HANDLE;
+
+  PFN_vkGetPipelineExecutablePropertiesKHR getProperties = nullptr;
+  PFN_vkGetPipelineExecutableStatisticsKHR getStatistics = nullptr;
+
+   public:
+  PipelineStatistics() = default;
+
+  DELETE_COPY(PipelineStatistics);
+  DELETE_MOVE(PipelineStatistics);
+
+  /**
+   * @brief $ABOX_PIPELINE_STATISTICS: where the report of a device is
+   * written when its pipelines go (the last device's with several), empty
+   * if unset
+   */
+  static std::filesystem::path requestedReport();
+
+  /**
+   * @brief Load the entry points, the device was created with the extension
+   * and its pipelineExecutableInfo feature
+   * @return false if one is missing
+   */
+  bool enable(VkDevice logicalDevice);
+
+  [[nodiscard]] bool isEnabled() const noexcept
+  {
+    return device != VK_NULL_HANDLE;
+  }
+
+  /**
+   * @brief Executables of pipeline and their statistics, empty if not
+   * enabled or the pipeline was not created capturing them
+   */
+  [[nodiscard]] std::vector<PipelineExecutable> collect(VkPipeline pipeline
+  ) const;
+};
+
+#endif // PIPELINE_STATISTICS_HPP
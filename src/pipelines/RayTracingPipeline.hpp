@@ -63,9 +63,7 @@ class RayTracingPipeline : public PipelineBase {
     bool hasRayGen = false;
 
     for (const auto &shader : shaders) {
-      const auto           &reflectModule = shader.getReflectModule();
-      VkShaderStageFlagBits stage =
-          static_cast<VkShaderStageFlagBits>(reflectModule.shader_stage);
+      const VkShaderStageFlagBits stage = shader.getStage();
       if (stage == VK_SHADER_STAGE_RAYGEN_BIT_KHR) {
         hasRayGen = true;
         break;
@@ -90,9 +88,7 @@ class RayTracingPipeline : public PipelineBase {
     // Hit groups -> combine closest hit + any hit + intersection
 
     for (const auto &shader : shaders) {
-      const auto           &reflectModule = shader.getReflectModule();
-      VkShaderStageFlagBits stage =
-          static_cast<VkShaderStageFlagBits>(reflectModule.shader_stage);
+      const VkShaderStageFlagBits stage = shader.getStage();
 
       VkRayTracingShaderGroupCreateInfoKHR group{};
       group.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
@@ -132,6 +128,7 @@ class RayTracingPipeline : public PipelineBase {
    * @brief Construct a ray tracing pipeline
    * @param device Logical device handle
    * @param shaders Range of ray tracing shaders (.rgen, .rchit, .rmiss, etc.)
+   * @param layouts Device's layouts, the pipeline keeps the ones it uses
    *
    * NOTE: Currently a stub implementation. Requires:
    * - Extension support checking
@@ -141,8 +138,12 @@ class RayTracingPipeline : public PipelineBase {
   template <std::ranges::range R>
     requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
              std::same_as<std::ranges::range_value_t<R>, const ShaderDataFile>
-  RayTracingPipeline(VkDevice device, const R &shaders)
-      : PipelineBase(device, shaders)
+  RayTracingPipeline(
+      VkDevice             device,
+      const R             &shaders,
+      PipelineLayoutCache &layouts
+  )
+      : PipelineBase(device, shaders, layouts)
   {
     LOG_DEBUG("Pipeline") << "RayTracingPipeline construction started with "
                           << std::ranges::size(shaders) << " shaders";
@@ -163,7 +164,7 @@ class RayTracingPipeline : public PipelineBase {
     //     .groupCount = shaderGroups.size(),
     //     .pGroups = shaderGroups.data(),
     //     .maxPipelineRayRecursionDepth = 1,
-    //     .layout = pipelineLayout
+    //     .layout = getPipelineLayout()
     // };
     //
     // vkCreateRayTracingPipelinesKHR(device, VK_NULL_HANDLE, VK_NULL_HANDLE, 1,
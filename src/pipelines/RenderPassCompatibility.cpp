@@ -0,0 +1,112 @@
+#include "RenderPassCompatibility.hpp"
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Registry {
+  std::mutex mutex;
+  // Key of each subpass of a registered render pass
+  std::unordered_map<VkRenderPass, std::vector<ABox::Hash128>> subpassKeys;
+};
+
+Registry &registry()
+{
+  static Registry instance;
+  return instance;
+}
+
+void hashReferences(
+    ABox::Hasher                 &hasher,
+    const VkRenderPassCreateInfo &info,
+    const VkAttachmentReference  *references,
+    uint32_t                      count
+)
+{
+  hasher.update(references ? count : 0u);
+  for (uint32_t i = 0; references && i < count; ++i) {
+    const uint32_t attachment = references[i].attachment;
+    // Unused references are only compatible with each other
+    if (attachment == VK_ATTACHMENT_UNUSED ||
+        attachment >= info.attachmentCount) {
+      hasher.update(VK_ATTACHMENT_UNUSED);
+      continue;
+    }
+    hasher.update(info.pAttachments[attachment].format);
+    hasher.update(info.pAttachments[attachment].samples);
+  }
+}
+
+} // namespace
+
+ABox::Hash128 RenderPassCompatibility::compute(
+    const VkRenderPassCreateInfo &info,
+    uint32_t                      subpass
+)
+{
+  ABox::Hasher hasher;
+  hasher.update(subpass);
+  hasher.update(info.subpassCount);
+  for (uint32_t i = 0; i < info.subpassCount; ++i) {
+    const VkSubpassDescription &description = info.pSubpasses[i];
+    hashReferences(
+        hasher,
+        info,
+        description.pInputAttachments,
+        description.inputAttachmentCount
+    );
+    hashReferences(
+        hasher,
+        info,
+        description.pColorAttachments,
+        description.colorAttachmentCount
+    );
+    hashReferences(
+        hasher,
+        info,
+        description.pResolveAttachments,
+        description.colorAttachmentCount
+    );
+    hashReferences(hasher, info, description.pDepthStencilAttachment, 1u);
+  }
+  return hasher.digest();
+}
+
+void RenderPassCompatibility::add(
+    VkRenderPass                  renderPass,
+    const VkRenderPassCreateInfo &info
+)
+{
+  std::vector<ABox::Hash128> keys;
+  keys.reserve(info.subpassCount);
+  for (uint32_t subpass = 0; subpass < info.subpassCount; ++subpass) {
+    keys.push_back(compute(info, subpass));
+  }
+  Registry        &known = registry();
+  std::scoped_lock lock(known.mutex);
+  known.subpassKeys.insert_or_assign(renderPass, std::move(keys));
+}
+
+ABox::Hash128 RenderPassCompatibility::key(
+    VkRenderPass renderPass,
+    uint32_t     subpass
+)
+{
+  ABox::Hasher hasher;
+  hasher.update(subpass);
+  if (renderPass == VK_NULL_HANDLE) {
+    return hasher.digest();
+  }
+  {
+    Registry        &known = registry();
+    std::scoped_lock lock(known.mutex);
+    auto             entry = known.subpassKeys.find(renderPass);
+    if (entry != known.subpassKeys.end() && subpass < entry->second.size()) {
+      return entry->second[subpass];
+    }
+  }
+  hasher.update(reinterpret_cast<uintptr_t>(renderPass));
+  return hasher.digest();
+}
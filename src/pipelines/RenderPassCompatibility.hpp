@@ -0,0 +1,35 @@
+#ifndef RENDER_PASS_COMPATIBILITY_HPP
+#define RENDER_PASS_COMPATIBILITY_HPP
+
+#include "Hash.hpp"
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+
+/**
+ * @class RenderPassCompatibility
+ * @brief What a pipeline key takes from a render pass: the formats and
+ * sample counts of the attachments each subpass references, and the
+ * subpass used. Compatible render passes (load and store ops, layouts
+ * aside) give equal keys, so pipeline keys do not depend on the handle.
+ *
+ * Render passes are registered by RenderPassManager when created, a handle
+ * value reused by a later render pass takes its data. Thread safe.
+ */
+class RenderPassCompatibility {
+   public:
+  /** @brief Key of subpass of the render pass info describes */
+  [[nodiscard]] static ABox::Hash128
+      compute(const VkRenderPassCreateInfo &info, uint32_t subpass);
+
+  /** @brief Remember what renderPass was created from */
+  static void add(VkRenderPass renderPass, const VkRenderPassCreateInfo &info);
+
+  /**
+   * @brief Key of subpass of renderPass. A null render pass (compute, shader
+   * objects) has a fixed key, an unregistered one is keyed by its handle.
+   */
+  [[nodiscard]] static ABox::Hash128
+      key(VkRenderPass renderPass, uint32_t subpass);
+};
+
+#endif // RENDER_PASS_COMPATIBILITY_HPP
@@ -0,0 +1,99 @@
+#include "ShaderModuleCache.hpp"
+#include "HostAllocator.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+ABox::Hash128 ShaderModuleCache::moduleKey(std::span<const uint32_t> code)
+{
+  return ABox::Hasher().update(code.data(), code.size_bytes()).digest();
+}
+
+void ShaderModuleCache::setInlineModules(bool enabled)
+{
+  std::lock_guard lock(mutex);
+  inlineModules = enabled;
+  LOG_INFO("Pipeline") << "Shader modules "
+                       << (enabled ? "passed inline (maintenance5)"
+                                   : "created and shared per SPIR-V");
+}
+
+bool ShaderModuleCache::usesInlineModules() const
+{
+  std::lock_guard lock(mutex);
+  return inlineModules;
+}
+
+ShaderModuleRef
+    ShaderModuleCache::acquire(VkDevice device, const ShaderDataFile &shader)
+{
+  const ABox::Hash128 key = moduleKey(shader.getCode());
+
+  {
+    std::lock_guard lock(mutex);
+    auto            known = modules.find(key);
+    if (known != modules.end()) {
+      if (ShaderModuleRef module = known->second.lock()) {
+        ++reuses;
+        LOG_DEBUG("Pipeline") << "Reusing shader module of "
+                              << shader.getName();
+        return module;
+      }
+    }
+  }
+
+  // Created unlocked, the other workers of a batch create theirs meanwhile
+  auto module = std::make_shared<ShaderModuleWrapper>(
+      device,
+      VK_NULL_HANDLE,
+      HostAllocator::callbacks(HostAllocTag::ShaderModule)
+  );
+  const VkShaderModuleCreateInfo moduleInfo = shader;
+  if (vkCreateShaderModule(
+          device,
+          &moduleInfo,
+          module->getAllocator(),
+          module->ptr()
+      ) != VK_SUCCESS) {
+    throw std::runtime_error(
+        "Failed to create shader module for " + shader.getName()
+    );
+  }
+
+  std::lock_guard lock(mutex);
+  auto            known = modules.find(key);
+  if (known != modules.end()) {
+    if (ShaderModuleRef existing = known->second.lock()) {
+      // Lost the race, ours is destroyed on return
+      ++reuses;
+      return existing;
+    }
+  }
+  ++creations;
+  // Expired entries are only dropped here, when the map is written anyway
+  std::erase_if(modules, [](const auto &entry) {
+    return entry.second.expired();
+  });
+  modules[key] = module;
+  return module;
+}
+
+size_t ShaderModuleCache::size() const
+{
+  std::lock_guard lock(mutex);
+  return std::ranges::count_if(modules, [](const auto &entry) {
+    return !entry.second.expired();
+  });
+}
+
+uint64_t ShaderModuleCache::getCreations() const
+{
+  std::lock_guard lock(mutex);
+  return creations;
+}
+
+uint64_t ShaderModuleCache::getReuses() const
+{
+  std::lock_guard lock(mutex);
+  return reuses;
+}
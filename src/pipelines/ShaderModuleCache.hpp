@@ -0,0 +1,123 @@
+#ifndef SHADER_MODULE_CACHE_HPP
+#define SHADER_MODULE_CACHE_HPP
+
+#include "Hash.hpp"
+#include "ShaderHandler.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+/** @brief Shared module, destroyed with the last pipeline using it */
+using ShaderModuleRef = std::shared_ptr<const ShaderModuleWrapper>;
+
+/**
+ * @brief Stage create infos of one pipeline and everything they point to,
+ * keep it alive until the vkCreate*Pipelines call returns
+ */
+struct ShaderStageSet {
+  std::vector<ShaderModuleRef>                 modules;
+  std::vector<VkShaderModuleCreateInfo>        inlineModules; // maintenance5
+  std::vector<VkPipelineShaderStageCreateInfo> stages;
+};
+
+/**
+ * @class ShaderModuleCache
+ * @brief VkShaderModules of one device, keyed by a hash of their SPIR-V
+ *
+ * Pipelines built from the same code share one module: the cache only keeps
+ * weak references, the pipelines own the modules, so a module lives as long
+ * as a pipeline built from it. With VK_KHR_maintenance5 enabled no module is
+ * created at all, the VkShaderModuleCreateInfo is chained to the stage.
+ * Thread safe.
+ */
+class ShaderModuleCache {
+  mutable std::mutex mutex;
+  std::unordered_map<ABox::Hash128, std::weak_ptr<const ShaderModuleWrapper>>
+           modules;
+  bool     inlineModules = false;
+  uint64_t creations     = 0;
+  uint64_t reuses        = 0;
+
+   public:
+  ShaderModuleCache() = default;
+
+  DELETE_COPY(ShaderModuleCache);
+  DELETE_MOVE(ShaderModuleCache);
+
+  [[nodiscard]] static ABox::Hash128 moduleKey(std::span<const uint32_t> code);
+
+  /**
+   * @brief Pass the create infos through the stages instead of creating
+   * modules, only valid once the maintenance5 feature is enabled on the
+   * device
+   */
+  void setInlineModules(bool enabled);
+
+  [[nodiscard]] bool usesInlineModules() const;
+
+  /**
+   * @brief The live module for this code, created if there is none.
+   * Created without holding the cache lock: callers racing on the same code
+   * may both create one, the first registered is returned to all
+   * @throws std::runtime_error if vkCreateShaderModule fails
+   */
+  [[nodiscard]] ShaderModuleRef
+      acquire(VkDevice device, const ShaderDataFile &shader);
+
+  /**
+   * @brief One stage per shader, in order, with modules from the cache or
+   * inline create infos
+   * @param specialization set on every stage, may be null
+   */
+  template <std::ranges::range R>
+    requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
+             std::same_as<std::ranges::range_value_t<R>, const ShaderDataFile>
+  [[nodiscard]] ShaderStageSet stagesFor(
+      VkDevice                    device,
+      const R                    &shaders,
+      const VkSpecializationInfo *specialization
+  )
+  {
+    ShaderStageSet set;
+    const size_t   count = std::ranges::size(shaders);
+    set.stages.reserve(count);
+
+    if (usesInlineModules()) {
+      // Reserved up front: the stages point into it
+      set.inlineModules.reserve(count);
+      for (const ShaderDataFile &shader : shaders) {
+        set.inlineModules.push_back(shader);
+        VkPipelineShaderStageCreateInfo stage =
+            shader.getPSSCI(VK_NULL_HANDLE, specialization);
+        stage.pNext = &set.inlineModules.back();
+        set.stages.push_back(stage);
+      }
+      return set;
+    }
+
+    set.modules.reserve(count);
+    for (const ShaderDataFile &shader : shaders) {
+      set.modules.push_back(acquire(device, shader));
+      set.stages.push_back(
+          shader.getPSSCI(set.modules.back()->get(), specialization)
+      );
+    }
+    return set;
+  }
+
+  /** @brief Modules still owned by at least one pipeline */
+  [[nodiscard]] size_t size() const;
+
+  /** @brief vkCreateShaderModule calls made */
+  [[nodiscard]] uint64_t getCreations() const;
+
+  /** @brief Requests served by a live module */
+  [[nodiscard]] uint64_t getReuses() const;
+};
+
+#endif // SHADER_MODULE_CACHE_HPP
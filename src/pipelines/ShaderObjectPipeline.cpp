@@ -0,0 +1,207 @@
+#include "ShaderObjectPipeline.hpp"
+#include "DeferredDeletionQueue.hpp"
+
+namespace {
+
+template <typename PFN>
+bool load(VkDevice device, PFN &function, const char *name)
+{
+  function = reinterpret_cast<PFN>(vkGetDeviceProcAddr(device, name));
+  return function != nullptr;
+}
+
+} // namespace
+
+bool ShaderObjectSupport::enable(VkDevice device)
+{
+  enabled =
+      load(device, createShaders, "vkCreateShadersEXT") &&
+      load(device, destroyShader, "vkDestroyShaderEXT") &&
+      load(device, bindShaders, "vkCmdBindShadersEXT") &&
+      load(device, setViewportWithCount, "vkCmdSetViewportWithCount") &&
+      load(device, setScissorWithCount, "vkCmdSetScissorWithCount") &&
+      load(device, setPrimitiveTopology, "vkCmdSetPrimitiveTopology") &&
+      load(device, setCullMode, "vkCmdSetCullMode") &&
+      load(device, setFrontFace, "vkCmdSetFrontFace") &&
+      load(device, setDepthTestEnable, "vkCmdSetDepthTestEnable") &&
+      load(device, setDepthWriteEnable, "vkCmdSetDepthWriteEnable") &&
+      load(device, setDepthCompareOp, "vkCmdSetDepthCompareOp") &&
+      load(
+          device,
+          setDepthBoundsTestEnable,
+          "vkCmdSetDepthBoundsTestEnable"
+      ) &&
+      load(device, setStencilTestEnable, "vkCmdSetStencilTestEnable") &&
+      load(device, setDepthBiasEnable, "vkCmdSetDepthBiasEnable") &&
+      load(
+          device,
+          setPrimitiveRestartEnable,
+          "vkCmdSetPrimitiveRestartEnable"
+      ) &&
+      load(
+          device,
+          setRasterizerDiscardEnable,
+          "vkCmdSetRasterizerDiscardEnable"
+      ) &&
+      load(device, setPolygonMode, "vkCmdSetPolygonModeEXT") &&
+      load(
+          device,
+          setRasterizationSamples,
+          "vkCmdSetRasterizationSamplesEXT"
+      ) &&
+      load(device, setSampleMask, "vkCmdSetSampleMaskEXT") &&
+      load(
+          device,
+          setAlphaToCoverageEnable,
+          "vkCmdSetAlphaToCoverageEnableEXT"
+      ) &&
+      load(device, setColorBlendEnable, "vkCmdSetColorBlendEnableEXT") &&
+      load(device, setColorBlendEquation, "vkCmdSetColorBlendEquationEXT") &&
+      load(device, setColorWriteMask, "vkCmdSetColorWriteMaskEXT") &&
+      load(device, setVertexInput, "vkCmdSetVertexInputEXT");
+  if (!enabled) {
+    LOG_WARN("Vulkan") << "Missing VK_EXT_shader_object entry points, "
+                          "shader objects disabled";
+    return false;
+  }
+  LOG_INFO("Pipeline") << "Shader objects available as pipeline backend";
+  return true;
+}
+
+void ShaderObjectSupport::setDrawState(
+    VkCommandBuffer    commandBuffer,
+    const RasterState &state,
+    const VkViewport  &viewport,
+    const VkRect2D    &scissor
+) const noexcept
+{
+  const VkSampleMask          sampleMask = ~0u;
+  const VkBool32              blend = state.blend ? VK_TRUE : VK_FALSE;
+  const VkColorComponentFlags writeMask =
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+  // The equation GraphicsPipeline blends with
+  const VkColorBlendEquationEXT equation{
+      .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+      .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+      .colorBlendOp        = VK_BLEND_OP_ADD,
+      .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+      .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+      .alphaBlendOp        = VK_BLEND_OP_ADD
+  };
+
+  setViewportWithCount(commandBuffer, 1u, &viewport);
+  setScissorWithCount(commandBuffer, 1u, &scissor);
+  setRasterizerDiscardEnable(commandBuffer, state.rasterizerDiscard);
+  setPrimitiveTopology(commandBuffer, state.topology);
+  setPrimitiveRestartEnable(commandBuffer, state.primitiveRestart);
+  setVertexInput(commandBuffer, 0u, nullptr, 0u, nullptr);
+  setPolygonMode(commandBuffer, state.polygonMode);
+  setCullMode(commandBuffer, state.cullMode);
+  setFrontFace(commandBuffer, state.frontFace);
+  setDepthBiasEnable(commandBuffer, state.depthBias);
+  if (state.depthBias) {
+    vkCmdSetDepthBias(commandBuffer, 0.0f, 0.0f, 0.0f);
+  }
+  vkCmdSetLineWidth(commandBuffer, 1.0f);
+  setRasterizationSamples(commandBuffer, VK_SAMPLE_COUNT_1_BIT);
+  setSampleMask(commandBuffer, VK_SAMPLE_COUNT_1_BIT, &sampleMask);
+  setAlphaToCoverageEnable(commandBuffer, VK_FALSE);
+  setDepthTestEnable(commandBuffer, state.depthTest);
+  setDepthWriteEnable(commandBuffer, state.depthWrite);
+  setDepthCompareOp(commandBuffer, state.depthCompareOp);
+  setDepthBoundsTestEnable(commandBuffer, VK_FALSE);
+  setStencilTestEnable(commandBuffer, VK_FALSE);
+  setColorBlendEnable(commandBuffer, 0u, 1u, &blend);
+  setColorBlendEquation(commandBuffer, 0u, 1u, &equation);
+  setColorWriteMask(commandBuffer, 0u, 1u, &writeMask);
+}
+
+void ShaderObjectPipeline::createShaders(
+    VkDevice                                  device,
+    const std::vector<VkShaderCreateInfoEXT> &infos
+)
+{
+  const VkAllocationCallbacks *allocator =
+      HostAllocator::callbacks(HostAllocTag::Pipeline);
+  std::vector<VkShaderEXT> created(infos.size(), VK_NULL_HANDLE);
+  const VkResult           result = support.createShaders(
+      device,
+      static_cast<uint32_t>(infos.size()),
+      infos.data(),
+      allocator,
+      created.data()
+  );
+  // Wrapped first: a failed linked creation may still return some shaders
+  shaderObjects.reserve(created.size());
+  for (VkShaderEXT shader : created) {
+    shaderObjects.emplace_back(
+        shader,
+        device,
+        support.destroyShader,
+        allocator
+    );
+  }
+  if (result != VK_SUCCESS) {
+    throw std::runtime_error(
+        "Failed to create shader objects: " + std::to_string(result)
+    );
+  }
+
+  if (bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) {
+    boundStages  = {VK_SHADER_STAGE_COMPUTE_BIT};
+    boundShaders = {created.front()};
+    return;
+  }
+  for (const VkShaderStageFlagBits stage : GRAPHICS_STAGES) {
+    const auto info =
+        std::ranges::find(infos, stage, &VkShaderCreateInfoEXT::stage);
+    boundStages.push_back(stage);
+    boundShaders.push_back(
+        info != infos.end() ? created[info - infos.begin()] : VK_NULL_HANDLE
+    );
+  }
+}
+
+void ShaderObjectPipeline::updateExtent(VkExtent2D extent) noexcept
+{
+  scissor = {
+      .offset = {0, 0},
+      .extent = extent
+  };
+  viewport = {
+      .x        = 0.0f,
+      .y        = 0.0f,
+      .width    = static_cast<float>(extent.width),
+      .height   = static_cast<float>(extent.height),
+      .minDepth = 0.0f,
+      .maxDepth = 1.0f
+  };
+}
+
+void ShaderObjectPipeline::bind(
+    VkCommandBuffer    commandBuffer,
+    const RasterState &raster
+) const noexcept
+{
+  support.bindShaders(
+      commandBuffer,
+      static_cast<uint32_t>(boundStages.size()),
+      boundStages.data(),
+      boundShaders.data()
+  );
+  if (bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+    support.setDrawState(commandBuffer, raster, viewport, scissor);
+  }
+}
+
+void ShaderObjectPipeline::retire(DeferredDeletionQueue &queue)
+{
+  for (ShaderObjectWrapper &shader : shaderObjects) {
+    shader.retire(queue);
+  }
+  shaderObjects.clear();
+  boundShaders.clear();
+  boundStages.clear();
+  PipelineBase::retire(queue);
+}
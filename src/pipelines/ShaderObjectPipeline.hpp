@@ -0,0 +1,305 @@
+#ifndef SHADER_OBJECT_PIPELINE_HPP
+#define SHADER_OBJECT_PIPELINE_HPP
+
+#include "DynamicState.hpp"
+#include "HostAllocator.hpp"
+#include "Logger.hpp"
+#include "MemoryWrapper.hpp"
+#include "PipelineBase.hpp"
+#include "PreProcUtils.hpp"
+#include "ShaderHandler.hpp"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+// Destroyed through the entry point loaded with the extension
+using ShaderObjectWrapper =
+    MemoryWrapper<VkShaderEXT, PFN_vkDestroyShaderEXT, VkDevice>;
+
+/**
+ * @class ShaderObjectSupport
+ * @brief VK_EXT_shader_object entry points of one device: shader creation
+ * and binding, and every state command a draw with shader objects needs.
+ * Enabled by DeviceHandler when the device supports the extension; until
+ * then no ShaderObjectPipeline can be built.
+ */
+class ShaderObjectSupport {
+  bool enabled = false;
+
+  PFN_vkCreateShadersEXT  createShaders = nullptr;
+  PFN_vkDestroyShaderEXT  destroyShader = nullptr;
+  PFN_vkCmdBindShadersEXT bindShaders   = nullptr;
+
+  // Vulkan 1.3 core
+  PFN_vkCmdSetViewportWithCountEXT      setViewportWithCount      = nullptr;
+  PFN_vkCmdSetScissorWithCountEXT       setScissorWithCount       = nullptr;
+  PFN_vkCmdSetPrimitiveTopologyEXT      setPrimitiveTopology      = nullptr;
+  PFN_vkCmdSetCullModeEXT               setCullMode               = nullptr;
+  PFN_vkCmdSetFrontFaceEXT              setFrontFace              = nullptr;
+  PFN_vkCmdSetDepthTestEnableEXT        setDepthTestEnable        = nullptr;
+  PFN_vkCmdSetDepthWriteEnableEXT       setDepthWriteEnable       = nullptr;
+  PFN_vkCmdSetDepthCompareOpEXT         setDepthCompareOp         = nullptr;
+  PFN_vkCmdSetDepthBoundsTestEnableEXT  setDepthBoundsTestEnable  = nullptr;
+  PFN_vkCmdSetStencilTestEnableEXT      setStencilTestEnable      = nullptr;
+  PFN_vkCmdSetDepthBiasEnableEXT        setDepthBiasEnable        = nullptr;
+  PFN_vkCmdSetPrimitiveRestartEnableEXT setPrimitiveRestartEnable = nullptr;
+  PFN_vkCmdSetRasterizerDiscardEnableEXT setRasterizerDiscardEnable =
+      nullptr;
+  // VK_EXT_shader_object
+  PFN_vkCmdSetPolygonModeEXT           setPolygonMode           = nullptr;
+  PFN_vkCmdSetRasterizationSamplesEXT  setRasterizationSamples  = nullptr;
+  PFN_vkCmdSetSampleMaskEXT            setSampleMask            = nullptr;
+  PFN_vkCmdSetAlphaToCoverageEnableEXT setAlphaToCoverageEnable = nullptr;
+  PFN_vkCmdSetColorBlendEnableEXT      setColorBlendEnable      = nullptr;
+  PFN_vkCmdSetColorBlendEquationEXT    setColorBlendEquation    = nullptr;
+  PFN_vkCmdSetColorWriteMaskEXT        setColorWriteMask        = nullptr;
+  PFN_vkCmdSetVertexInputEXT           setVertexInput           = nullptr;
+
+  friend class ShaderObjectPipeline;
+
+   public:
+  ShaderObjectSupport() = default;
+
+  DELETE_COPY(ShaderObjectSupport);
+  DELETE_MOVE(ShaderObjectSupport);
+
+  /**
+   * @brief Load the entry points, the device was created with
+   * VK_EXT_shader_object and its feature on Vulkan 1.3
+   * @return false if one is missing, shader objects stay disabled
+   */
+  bool enable(VkDevice device);
+
+  [[nodiscard]] bool isEnabled() const noexcept { return enabled; }
+
+  /**
+   * @brief Set every state a draw reads when shader objects are bound:
+   * those of state, viewport and scissor, and fixed values for the rest
+   * (no vertex input, single sample, all components of color attachment 0
+   * written)
+   */
+  void setDrawState(
+      VkCommandBuffer    commandBuffer,
+      const RasterState &state,
+      const VkViewport  &viewport,
+      const VkRect2D    &scissor
+  ) const noexcept;
+};
+
+/**
+ * @brief Graphics or compute shaders as VK_EXT_shader_object shaders, an
+ * alternative to GraphicsPipeline and ComputePipeline without a pipeline
+ * object: nothing is compiled per state, all of it is set when binding.
+ * Graphics stages are created linked, and draw inside dynamic rendering
+ * (vkCmdBeginRendering), not a render pass.
+ */
+class ShaderObjectPipeline : public PipelineBase {
+  const ShaderObjectSupport       &support;
+  std::vector<ShaderObjectWrapper> shaderObjects;
+  // Bound together, unused graphics stages with a null shader
+  std::vector<VkShaderStageFlagBits> boundStages;
+  std::vector<VkShaderEXT>           boundShaders;
+  VkPipelineBindPoint                bindPoint;
+  RasterState                        rasterState;
+  VkViewport                         viewport{};
+  VkRect2D                           scissor{};
+
+  // Graphics stages bound with shader objects, in pipeline order
+  static constexpr std::array<VkShaderStageFlagBits, 5> GRAPHICS_STAGES = {
+      VK_SHADER_STAGE_VERTEX_BIT,
+      VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+      VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+      VK_SHADER_STAGE_GEOMETRY_BIT,
+      VK_SHADER_STAGE_FRAGMENT_BIT
+  };
+
+  /**
+   * @brief Create the shaders of infos in one call, linked if flagged so,
+   * and fill the bound stages
+   */
+  void createShaders(
+      VkDevice                                  device,
+      const std::vector<VkShaderCreateInfoEXT> &infos
+  );
+
+   public:
+  /**
+   * @brief Stages not built as shader objects: their patch control points
+   * are never set when binding
+   */
+  static constexpr VkShaderStageFlags unsupportedStages =
+      VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT |
+      VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+
+  /**
+   * @brief Create the shader objects of a graphics or compute pipeline
+   * @param device Logical device handle
+   * @param shaders Vertex and fragment (geometry optional) shaders, or a
+   * single compute shader, tessellation stages are rejected
+   * @param layouts Device's layouts, the shaders are created with the ones
+   * reflected, so descriptor sets bind as with a pipeline
+   * @param support Device's shader object entry points, enabled
+   * @param specialization values of the shaders' specialization constants
+   * @param raster State set when binding, graphics only
+   * @param extent Viewport and scissor set when binding, graphics only
+   */
+  template <std::ranges::range R>
+    requires std::same_as<std::ranges::range_value_t<R>, ShaderDataFile> ||
+             std::same_as<std::ranges::range_value_t<R>, const ShaderDataFile>
+  ShaderObjectPipeline(
+      VkDevice                       device,
+      const R                       &shaders,
+      PipelineLayoutCache           &layouts,
+      const ShaderObjectSupport     &support,
+      const SpecializationConstants &specialization = {},
+      const RasterState             &raster         = {},
+      VkExtent2D                     extent         = {}
+  )
+      : PipelineBase(device, shaders, layouts)
+      , support(support)
+      , rasterState(raster)
+  {
+    if (!support.isEnabled()) {
+      throw std::runtime_error(
+          "ShaderObjectPipeline requires VK_EXT_shader_object"
+      );
+    }
+    if (std::ranges::empty(shaders)) {
+      throw std::runtime_error(
+          "ShaderObjectPipeline requires at least one shader"
+      );
+    }
+    const bool compute = std::ranges::any_of(
+        shaders,
+        [](const ShaderDataFile &shader) {
+          return shader.getStage() == VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+    );
+    const bool vertex = std::ranges::any_of(
+        shaders,
+        [](const ShaderDataFile &shader) {
+          return shader.getStage() == VK_SHADER_STAGE_VERTEX_BIT;
+        }
+    );
+    if (compute && std::ranges::distance(shaders) != 1) {
+      throw std::runtime_error(
+          "ShaderObjectPipeline takes a compute shader alone"
+      );
+    }
+    if (!compute && !vertex) {
+      throw std::runtime_error(
+          "ShaderObjectPipeline requires a vertex or a compute shader"
+      );
+    }
+    if (std::ranges::any_of(shaders, [](const ShaderDataFile &shader) {
+          return (shader.getStage() & unsupportedStages) != 0;
+        })) {
+      throw std::runtime_error(
+          "ShaderObjectPipeline does not support tessellation shaders"
+      );
+    }
+    bindPoint = compute ? VK_PIPELINE_BIND_POINT_COMPUTE
+                        : VK_PIPELINE_BIND_POINT_GRAPHICS;
+    updateExtent(extent);
+
+    validateSpecialization(shaders, specialization);
+    const VkSpecializationInfo specializationInfo = specialization.getInfo();
+
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    setLayouts.reserve(descriptorSetLayouts.size());
+    for (const DescriptorSetLayoutRef &setLayout : descriptorSetLayouts) {
+      setLayouts.push_back(setLayout->get());
+    }
+
+    // In stage order: each graphics stage names the next one it links to
+    std::vector<const ShaderDataFile *> ordered;
+    for (const ShaderDataFile &shader : shaders) {
+      ordered.push_back(&shader);
+    }
+    std::ranges::sort(ordered, {}, [](const ShaderDataFile *shader) {
+      return static_cast<uint32_t>(shader->getStage());
+    });
+
+    std::vector<VkShaderCreateInfoEXT> infos;
+    infos.reserve(ordered.size());
+    for (size_t i = 0; i < ordered.size(); ++i) {
+      const std::span<const uint32_t> code = ordered[i]->getCode();
+      infos.push_back(
+          {.sType     = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
+           .pNext     = nullptr,
+           .flags     = compute ? 0u
+                                : static_cast<VkShaderCreateFlagsEXT>(
+                                      VK_SHADER_CREATE_LINK_STAGE_BIT_EXT
+                                  ),
+           .stage     = ordered[i]->getStage(),
+           .nextStage = i + 1 < ordered.size()
+                            ? static_cast<VkShaderStageFlags>(
+                                  ordered[i + 1]->getStage()
+                              )
+                            : 0u,
+           .codeType  = VK_SHADER_CODE_TYPE_SPIRV_EXT,
+           .codeSize  = code.size_bytes(),
+           .pCode     = code.data(),
+           .pName     = MAIN_ENTRY_POINT,
+           .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+           .pSetLayouts    = setLayouts.data(),
+           .pushConstantRangeCount =
+               static_cast<uint32_t>(pushConstantRanges.size()),
+           .pPushConstantRanges = pushConstantRanges.data(),
+           .pSpecializationInfo =
+               specialization.empty() ? nullptr : &specializationInfo}
+      );
+    }
+    createShaders(device, infos);
+
+    LOG_INFO("Pipeline") << "ShaderObjectPipeline created with "
+                         << shaderObjects.size() << " shader objects";
+    printReflectionInfo();
+  }
+
+  ~ShaderObjectPipeline() = default;
+
+  DELETE_COPY(ShaderObjectPipeline)
+  DELETE_MOVE(ShaderObjectPipeline)
+
+  [[nodiscard]] VkPipelineBindPoint getBindPoint() const noexcept override
+  {
+    return bindPoint;
+  }
+
+  [[nodiscard]] const RasterState &getRasterState() const noexcept
+  {
+    return rasterState;
+  }
+
+  [[nodiscard]] const VkRect2D &getScissor() const noexcept
+  {
+    return scissor;
+  }
+
+  /** @brief Viewport and scissor covering extent, e.g. after a resize */
+  void updateExtent(VkExtent2D extent) noexcept;
+
+  /**
+   * @brief Bind the shaders, then set all the draw state with raster's
+   * fields: shader objects have no baked state
+   */
+  void bind(VkCommandBuffer commandBuffer, const RasterState &raster)
+      const noexcept;
+
+  /** @brief Bind with the state the shaders were created with */
+  void bind(VkCommandBuffer commandBuffer) const noexcept
+  {
+    bind(commandBuffer, rasterState);
+  }
+
+  /**
+   * @brief Hand the shader objects and the layouts over to the deletion
+   * queue, frames in flight may still use them
+   */
+  void retire(DeferredDeletionQueue &queue);
+};
+
+#endif // SHADER_OBJECT_PIPELINE_HPP
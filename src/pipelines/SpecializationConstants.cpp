@@ -0,0 +1,66 @@
+#include "SpecializationConstants.hpp"
+#include <algorithm>
+
+SpecializationConstants &SpecializationConstants::setBytes(
+    uint32_t    constantId,
+    const void *value,
+    uint32_t    size
+)
+{
+  Value v{.constantId = constantId, .size = size, .bytes = {}};
+  std::memcpy(v.bytes.data(), value, size);
+  auto it = std::lower_bound(
+      values.begin(),
+      values.end(),
+      constantId,
+      [](const Value &a, uint32_t id) { return a.constantId < id; }
+  );
+  if (it != values.end() && it->constantId == constantId) {
+    *it = v;
+  }
+  else {
+    values.insert(it, v);
+  }
+
+  // Repack: entries and data follow the id order, each value aligned to
+  // its size
+  entries.clear();
+  data.clear();
+  ABox::Hasher hasher;
+  for (const Value &value : values) {
+    const size_t offset =
+        (data.size() + value.size - 1) / value.size * value.size;
+    data.resize(offset + value.size);
+    std::memcpy(data.data() + offset, value.bytes.data(), value.size);
+    entries.push_back(
+        {.constantID = value.constantId,
+         .offset     = static_cast<uint32_t>(offset),
+         .size       = value.size}
+    );
+    hasher.update(value.constantId);
+    hasher.update(value.size);
+    hasher.update(value.bytes.data(), value.size);
+  }
+  hash = hasher.digest();
+  return *this;
+}
+
+uint32_t SpecializationConstants::sizeOf(uint32_t constantId) const
+{
+  auto it = std::find_if(
+      values.begin(),
+      values.end(),
+      [constantId](const Value &v) { return v.constantId == constantId; }
+  );
+  return it != values.end() ? it->size : 0;
+}
+
+VkSpecializationInfo SpecializationConstants::getInfo() const
+{
+  return {
+      .mapEntryCount = static_cast<uint32_t>(entries.size()),
+      .pMapEntries   = entries.data(),
+      .dataSize      = data.size(),
+      .pData         = data.data()
+  };
+}
@@ -0,0 +1,91 @@
+#ifndef SPECIALIZATION_CONSTANTS_HPP
+#define SPECIALIZATION_CONSTANTS_HPP
+
+#include "Hash.hpp"
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+/** @brief Host types a specialization constant can be given as */
+template <typename T>
+concept SpecializationScalar =
+    std::same_as<T, bool> || std::same_as<T, int32_t> ||
+    std::same_as<T, uint32_t> || std::same_as<T, float> ||
+    std::same_as<T, int64_t> || std::same_as<T, uint64_t> ||
+    std::same_as<T, double>;
+
+/**
+ * @class SpecializationConstants
+ * @brief Typed values for `layout(constant_id = N)` constants, applied to
+ * every stage of a pipeline (stages ignore ids they do not declare)
+ *
+ * Values are packed in constant id order, so the same set gives the same
+ * map entries, data and hash whatever order it was filled in. The hash is
+ * part of the pipeline key in PipelineManager.
+ */
+class SpecializationConstants {
+  struct Value {
+    uint32_t                 constantId;
+    uint32_t                 size;
+    std::array<std::byte, 8> bytes;
+  };
+  std::vector<Value>                    values; // sorted by constantId
+  std::vector<VkSpecializationMapEntry> entries;
+  std::vector<std::byte>                data;
+  ABox::Hash128                         hash; // zero when empty
+
+  SpecializationConstants &
+      setBytes(uint32_t constantId, const void *value, uint32_t size);
+
+   public:
+  SpecializationConstants() = default;
+
+  /**
+   * @brief Set or replace a constant, bool is stored as a VkBool32 as
+   * Vulkan expects
+   */
+  template <SpecializationScalar T>
+  SpecializationConstants &set(uint32_t constantId, T value)
+  {
+    if constexpr (std::same_as<T, bool>) {
+      const VkBool32 b = value ? VK_TRUE : VK_FALSE;
+      return setBytes(constantId, &b, sizeof(b));
+    }
+    else {
+      return setBytes(constantId, &value, sizeof(T));
+    }
+  }
+
+  [[nodiscard]] bool   empty() const { return values.empty(); }
+  [[nodiscard]] size_t size() const { return values.size(); }
+
+  /** @return 0 if constantId is not set */
+  [[nodiscard]] uint32_t sizeOf(uint32_t constantId) const;
+
+  [[nodiscard]] std::span<const VkSpecializationMapEntry> getEntries() const
+  {
+    return entries;
+  }
+
+  [[nodiscard]] std::span<const std::byte> getData() const { return data; }
+
+  [[nodiscard]] const ABox::Hash128 &getHash() const { return hash; }
+
+  /**
+   * @brief Points into this object: keep it alive and unchanged while the
+   * info is used
+   */
+  [[nodiscard]] VkSpecializationInfo getInfo() const;
+
+  bool operator==(const SpecializationConstants &other) const
+  {
+    return hash == other.hash && data == other.data;
+  }
+};
+
+#endif // SPECIALIZATION_CONSTANTS_HPP
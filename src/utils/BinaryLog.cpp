@@ -0,0 +1,500 @@
+#include "BinaryLog.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+
+namespace ABox {
+
+using namespace BinaryLogLayout;
+
+namespace {
+
+  struct FormatInfo {
+    LogLevel    level;
+    const char *category;
+    const char *format;
+  };
+
+  struct BinarySink {
+    abox::platform::MappedFile file{};
+    FileHeader                *header      = nullptr;
+    uint8_t                   *formatTable = nullptr;
+    uint8_t                   *ring        = nullptr;
+    uint64_t                   ringSize    = 0;
+    uint64_t                   maxRecord   = 0;
+    std::chrono::steady_clock::time_point openTime;
+  };
+
+  constexpr size_t FORMAT_TABLE_SIZE = 256u << 10;
+
+  std::mutex                g_formatMutex; // guards g_formats, table appends
+  std::vector<FormatInfo>   g_formats;
+  std::atomic<BinarySink *> g_sink{nullptr};
+  std::atomic<LogLevel>     g_binaryMinLevel{LogLevel::DEBUG};
+
+  /**
+   * @brief Append a format entry to the open file, caller holds the mutex
+   */
+  void writeFormatEntry(BinarySink &sink, uint32_t id, const FormatInfo &info)
+  {
+    const size_t catLen = std::strlen(info.category);
+    const size_t fmtLen = std::strlen(info.format);
+    const size_t entrySize =
+        alignRecord(sizeof(FormatEntry) + catLen + fmtLen);
+
+    std::atomic_ref<uint64_t> used(sink.header->formatTableUsed);
+    const uint64_t            offset = used.load(std::memory_order_relaxed);
+    if (offset + entrySize > sink.header->formatTableSize) {
+      LOG_WARN("Logger") << "Binary log format table full, format " << id
+                         << " will decode as unknown";
+      return;
+    }
+
+    uint8_t    *dst = sink.formatTable + offset;
+    FormatEntry entry{
+        .id             = id,
+        .level          = static_cast<uint8_t>(info.level),
+        .reserved       = 0,
+        .categoryLength = static_cast<uint16_t>(catLen),
+        .formatLength   = static_cast<uint32_t>(fmtLen),
+        .entrySize      = static_cast<uint32_t>(entrySize),
+    };
+    std::memcpy(dst, &entry, sizeof(entry));
+    std::memcpy(dst + sizeof(entry), info.category, catLen);
+    std::memcpy(dst + sizeof(entry) + catLen, info.format, fmtLen);
+    used.store(offset + entrySize, std::memory_order_release);
+  }
+
+  /**
+   * @brief Fill `size` bytes at absolute position `pos` with a skip record
+   */
+  void writePadding(BinarySink &sink, uint64_t pos, uint64_t size)
+  {
+    auto *hdr = reinterpret_cast<RecordHeader *>(
+        sink.ring + (pos % sink.ringSize)
+    );
+    hdr->size = static_cast<uint32_t>(size) | PADDING_FLAG;
+    std::atomic_ref<uint32_t>(hdr->tag).store(
+        tagForPosition(pos), std::memory_order_release
+    );
+  }
+
+} // namespace
+
+std::atomic<bool> g_binaryLogOpen{false};
+
+BinaryLogSite registerBinaryFormat(
+    LogLevel    level,
+    const char *category,
+    const char *format
+)
+{
+  std::lock_guard lock(g_formatMutex);
+  const uint32_t  id = static_cast<uint32_t>(g_formats.size());
+  g_formats.push_back({level, category, format});
+  if (BinarySink *sink = g_sink.load(std::memory_order_relaxed)) {
+    writeFormatEntry(*sink, id, g_formats.back());
+  }
+  return {id, level, category, format};
+}
+
+bool openBinaryLog(const std::string &path, size_t ringBytes)
+{
+  std::lock_guard lock(g_formatMutex);
+  if (g_sink.load(std::memory_order_relaxed)) {
+    LOG_WARN("Logger") << "Binary log already open";
+    return false;
+  }
+
+  ringBytes = alignRecord(std::max<size_t>(ringBytes, 4096));
+  const size_t headerSize = alignRecord(sizeof(FileHeader));
+  const size_t total      = headerSize + FORMAT_TABLE_SIZE + ringBytes;
+
+  auto *sink = new BinarySink{};
+  if (abox::platform::map_file_write(path.c_str(), total, sink->file) != 0) {
+    LOG_ERROR("Logger") << "Failed to create binary log " << path;
+    delete sink;
+    return false;
+  }
+
+  auto *base   = static_cast<uint8_t *>(sink->file.data);
+  sink->header = reinterpret_cast<FileHeader *>(base);
+  sink->formatTable = base + headerSize;
+  sink->ring        = base + headerSize + FORMAT_TABLE_SIZE;
+  sink->ringSize    = ringBytes;
+  sink->maxRecord   = std::min<uint64_t>(ringBytes / 4, 64u << 10);
+  sink->openTime    = std::chrono::steady_clock::now();
+
+  FileHeader *h = sink->header;
+  std::memcpy(h->magic, MAGIC, sizeof(MAGIC));
+  h->version           = VERSION;
+  h->headerSize        = static_cast<uint32_t>(headerSize);
+  h->formatTableOffset = headerSize;
+  h->formatTableSize   = FORMAT_TABLE_SIZE;
+  h->ringOffset        = headerSize + FORMAT_TABLE_SIZE;
+  h->ringSize          = ringBytes;
+  h->wallClockNs       = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch()
+      )
+          .count()
+  );
+  h->head            = 0;
+  h->formatTableUsed = 0;
+  h->dropped         = 0;
+
+  // Sites registered before the file existed
+  for (uint32_t id = 0; id < g_formats.size(); ++id) {
+    writeFormatEntry(*sink, id, g_formats[id]);
+  }
+
+  g_sink.store(sink, std::memory_order_release);
+  g_binaryLogOpen.store(true, std::memory_order_release);
+  LOG_INFO("Logger") << "Binary log opened: " << path << " (" << ringBytes
+                     << " byte ring)";
+  return true;
+}
+
+void closeBinaryLog()
+{
+  std::lock_guard lock(g_formatMutex);
+  BinarySink *sink = g_sink.exchange(nullptr, std::memory_order_acq_rel);
+  if (!sink) {
+    return;
+  }
+  g_binaryLogOpen.store(false, std::memory_order_release);
+  abox::platform::unmap_file(sink->file);
+  delete sink;
+}
+
+bool isBinaryLogOpen()
+{
+  return g_binaryLogOpen.load(std::memory_order_acquire);
+}
+
+void setBinaryLogLevel(LogLevel minLevel)
+{
+  g_binaryMinLevel.store(minLevel, std::memory_order_relaxed);
+}
+
+LogLevel getBinaryLogLevel()
+{
+  return g_binaryMinLevel.load(std::memory_order_relaxed);
+}
+
+bool binaryLogAccepts(LogLevel level)
+{
+  return level >= g_binaryMinLevel.load(std::memory_order_relaxed);
+}
+
+BinaryRecordSlot reserveBinaryRecord(uint32_t formatId, size_t payloadSize)
+{
+  BinarySink *sink = g_sink.load(std::memory_order_acquire);
+  if (!sink) {
+    return {};
+  }
+
+  const uint64_t size = alignRecord(sizeof(RecordHeader) + payloadSize);
+  if (size > sink->maxRecord) {
+    std::atomic_ref<uint64_t>(sink->header->dropped)
+        .fetch_add(1, std::memory_order_relaxed);
+    return {};
+  }
+
+  std::atomic_ref<uint64_t> head(sink->header->head);
+  for (;;) {
+    const uint64_t pos    = head.fetch_add(size, std::memory_order_relaxed);
+    const uint64_t offset = pos % sink->ringSize;
+    if (offset + size <= sink->ringSize) {
+      auto *hdr        = reinterpret_cast<RecordHeader *>(sink->ring + offset);
+      hdr->size        = static_cast<uint32_t>(size);
+      hdr->formatId    = formatId;
+      hdr->reserved    = 0;
+      hdr->timestampNs = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - sink->openTime
+          )
+              .count()
+      );
+      return {
+          hdr,
+          reinterpret_cast<uint8_t *>(hdr + 1),
+          tagForPosition(pos)
+      };
+    }
+    // The reservation straddles the end of the ring: turn both fragments
+    // into skip records and take a fresh slot
+    const uint64_t tail = sink->ringSize - offset;
+    writePadding(*sink, pos, tail);
+    writePadding(*sink, pos + tail, size - tail);
+  }
+}
+
+void logBinaryAsText(
+    const BinaryLogSite &site,
+    const uint8_t       *payload,
+    size_t               size
+)
+{
+  createLogStream(site.level, site.category)
+      << renderBinaryRecord(site.format, {payload, size});
+}
+
+std::string renderBinaryRecord(
+    std::string_view         format,
+    std::span<const uint8_t> payload
+)
+{
+  std::string out;
+  out.reserve(format.size() + payload.size());
+  size_t cursor    = 0;
+  bool   truncated = false;
+
+  auto appendArg = [&](bool hex) {
+    if (cursor >= payload.size()) {
+      out += "{}";
+      return;
+    }
+    const auto tag  = static_cast<ArgTag>(payload[cursor++]);
+    auto       need = [&](size_t n) {
+      if (cursor + n > payload.size()) {
+        truncated = true;
+        cursor    = payload.size();
+        return false;
+      }
+      return true;
+    };
+    char buf[64];
+    switch (tag) {
+      case ArgTag::Bool:
+        if (need(1)) {
+          out += payload[cursor++] ? "true" : "false";
+        }
+        return;
+      case ArgTag::Char:
+        if (need(1)) {
+          out += static_cast<char>(payload[cursor++]);
+        }
+        return;
+      case ArgTag::Str: {
+        uint32_t len;
+        if (!need(sizeof(len))) {
+          return;
+        }
+        std::memcpy(&len, payload.data() + cursor, sizeof(len));
+        cursor += sizeof(len);
+        if (need(len)) {
+          out.append(
+              reinterpret_cast<const char *>(payload.data() + cursor), len
+          );
+          cursor += len;
+        }
+        return;
+      }
+      case ArgTag::I64:
+      case ArgTag::U64:
+      case ArgTag::F64:
+      case ArgTag::Ptr: {
+        uint64_t bits;
+        if (!need(sizeof(bits))) {
+          return;
+        }
+        std::memcpy(&bits, payload.data() + cursor, sizeof(bits));
+        cursor += sizeof(bits);
+        if (tag == ArgTag::F64) {
+          double d;
+          std::memcpy(&d, &bits, sizeof(d));
+          std::snprintf(buf, sizeof(buf), "%g", d);
+        }
+        else if (tag == ArgTag::Ptr || hex) {
+          std::snprintf(buf, sizeof(buf), "0x%" PRIx64, bits);
+        }
+        else if (tag == ArgTag::I64) {
+          std::snprintf(
+              buf, sizeof(buf), "%" PRId64, static_cast<int64_t>(bits)
+          );
+        }
+        else {
+          std::snprintf(buf, sizeof(buf), "%" PRIu64, bits);
+        }
+        out += buf;
+        return;
+      }
+    }
+    // Unknown tag, the rest of the payload can't be trusted
+    truncated = true;
+    cursor    = payload.size();
+  };
+
+  for (size_t i = 0; i < format.size(); ++i) {
+    const char c = format[i];
+    if (c == '{' && i + 1 < format.size() && format[i + 1] == '{') {
+      out += '{';
+      ++i;
+    }
+    else if (c == '}' && i + 1 < format.size() && format[i + 1] == '}') {
+      out += '}';
+      ++i;
+    }
+    else if (c == '{') {
+      const size_t close = format.find('}', i);
+      if (close == std::string_view::npos) {
+        out.append(format.substr(i));
+        break;
+      }
+      const std::string_view spec = format.substr(i + 1, close - i - 1);
+      appendArg(spec.find('x') != std::string_view::npos);
+      i = close;
+    }
+    else {
+      out += c;
+    }
+  }
+  if (truncated) {
+    out += " <truncated>";
+  }
+  return out;
+}
+
+// BinaryLogReader
+
+BinaryLogReader::~BinaryLogReader() { close(); }
+
+bool BinaryLogReader::open(const std::string &path)
+{
+  close();
+  if (abox::platform::map_file_read(path.c_str(), file) != 0) {
+    return false;
+  }
+
+  const auto *base = static_cast<const uint8_t *>(file.data);
+  header           = reinterpret_cast<const FileHeader *>(base);
+  if (file.size < sizeof(FileHeader) ||
+      std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header->version != VERSION ||
+      header->ringOffset + header->ringSize > file.size ||
+      header->formatTableOffset + header->formatTableSize >
+          header->ringOffset ||
+      header->ringSize % RECORD_ALIGN != 0 || header->ringSize == 0) {
+    close();
+    return false;
+  }
+
+  const uint8_t *table = base + header->formatTableOffset;
+  const uint64_t used =
+      std::min(header->formatTableUsed, header->formatTableSize);
+  for (uint64_t offset = 0; offset + sizeof(FormatEntry) <= used;) {
+    FormatEntry entry;
+    std::memcpy(&entry, table + offset, sizeof(entry));
+    if (entry.entrySize < sizeof(FormatEntry) ||
+        offset + entry.entrySize > used ||
+        sizeof(FormatEntry) + entry.categoryLength + entry.formatLength >
+            entry.entrySize ||
+        // Each id has its own entry, so no valid id can reach this
+        entry.id >= used / sizeof(FormatEntry)) {
+      break;
+    }
+    const char *chars =
+        reinterpret_cast<const char *>(table + offset + sizeof(FormatEntry));
+    if (entry.id >= formats.size()) {
+      formats.resize(entry.id + 1, {LogLevel::DEBUG, {}, {}});
+    }
+    formats[entry.id] = {
+        static_cast<LogLevel>(entry.level),
+        {chars, entry.categoryLength},
+        {chars + entry.categoryLength, entry.formatLength}
+    };
+    offset += entry.entrySize;
+  }
+  return true;
+}
+
+void BinaryLogReader::close()
+{
+  if (file.data) {
+    abox::platform::unmap_file(file);
+  }
+  header = nullptr;
+  formats.clear();
+}
+
+uint64_t BinaryLogReader::wallClockAtOpenNs() const
+{
+  return header ? header->wallClockNs : 0;
+}
+
+uint64_t BinaryLogReader::droppedRecords() const
+{
+  return header ? header->dropped : 0;
+}
+
+size_t BinaryLogReader::forEach(
+    const std::function<void(const BinaryLogRecord &)> &visit
+) const
+{
+  if (!header) {
+    return 0;
+  }
+
+  const uint8_t *ring =
+      static_cast<const uint8_t *>(file.data) + header->ringOffset;
+  const uint64_t ringSize = header->ringSize;
+  const uint64_t head     = header->head;
+  uint64_t       pos      = head > ringSize ? head - ringSize : 0;
+  size_t         count    = 0;
+
+  // Records are found by their tag: after a wrap the oldest surviving bytes
+  // may be the tail of an overwritten record, and uncommitted reservations
+  // keep a stale tag, so anything that does not match is skipped 8 bytes at
+  // a time.
+  while (pos + RECORD_ALIGN <= head) {
+    const uint8_t *at = ring + (pos % ringSize);
+    uint32_t       tag, size;
+    std::memcpy(&tag, at, sizeof(tag));
+    std::memcpy(&size, at + sizeof(tag), sizeof(size));
+
+    if (tag != tagForPosition(pos)) {
+      pos += RECORD_ALIGN;
+      continue;
+    }
+
+    if (size & PADDING_FLAG) {
+      const uint64_t skip = size & ~PADDING_FLAG;
+      pos += (skip >= RECORD_ALIGN && skip % RECORD_ALIGN == 0) ? skip
+                                                                : RECORD_ALIGN;
+      continue;
+    }
+
+    if (size < sizeof(RecordHeader) || size % RECORD_ALIGN != 0 ||
+        pos + size > head || (pos % ringSize) + size > ringSize) {
+      pos += RECORD_ALIGN;
+      continue;
+    }
+
+    RecordHeader hdr;
+    std::memcpy(&hdr, at, sizeof(hdr));
+    BinaryLogRecord record{
+        .timestampNs = hdr.timestampNs,
+        .formatId    = hdr.formatId,
+        .level       = LogLevel::DEBUG,
+        .category    = "?",
+        .format      = "<unknown format>",
+        .payload = {at + sizeof(RecordHeader), size - sizeof(RecordHeader)},
+    };
+    if (hdr.formatId < formats.size() && !formats[hdr.formatId].format.empty()
+    ) {
+      const Format &f = formats[hdr.formatId];
+      record.level    = f.level;
+      record.category = f.category;
+      record.format   = f.format;
+    }
+    visit(record);
+    ++count;
+    pos += size;
+  }
+  return count;
+}
+
+} // namespace ABox
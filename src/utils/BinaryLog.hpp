@@ -0,0 +1,369 @@
+#ifndef ABOX_BINARY_LOG_HPP
+#define ABOX_BINARY_LOG_HPP
+
+#include "Logger.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <platform/mapped_file.hpp>
+
+namespace ABox {
+
+/**
+ * @brief On-disk layout of a binary log file
+ *
+ * [FileHeader][format table][ring]
+ *
+ * The format table holds one FormatEntry per registered call site, appended
+ * as sites register. The ring holds 8-byte aligned records; a record is
+ * committed once its tag is written, and the tag encodes the record's
+ * absolute stream position so a reader can resynchronise after the ring
+ * wrapped over older data.
+ */
+namespace BinaryLogLayout {
+  constexpr char     MAGIC[8]       = {'A', 'B', 'O', 'X', 'B', 'L', 'O', 'G'};
+  constexpr uint32_t VERSION        = 1;
+  constexpr uint32_t PADDING_FLAG   = 0x80000000u;
+  constexpr size_t   RECORD_ALIGN   = 8;
+  constexpr size_t   MAX_STRING_ARG = 1024;
+
+  /** @brief Argument type tags, one byte in front of each argument */
+  enum class ArgTag : uint8_t { I64 = 1, U64, F64, Bool, Char, Str, Ptr };
+
+  struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t formatTableOffset;
+    uint64_t formatTableSize;
+    uint64_t ringOffset;
+    uint64_t ringSize;
+    uint64_t wallClockNs;     // system_clock at open, ns since epoch
+    uint64_t head;            // bytes ever reserved in the ring (atomic)
+    uint64_t formatTableUsed; // bytes of committed format entries (atomic)
+    uint64_t dropped;         // records rejected as oversized (atomic)
+  };
+
+  /** @brief Followed by category then format characters, padded to 8 */
+  struct FormatEntry {
+    uint32_t id;
+    uint8_t  level;
+    uint8_t  reserved;
+    uint16_t categoryLength;
+    uint32_t formatLength;
+    uint32_t entrySize;
+  };
+
+  /** @brief Followed by the encoded arguments, padded to 8 */
+  struct RecordHeader {
+    uint32_t tag;         // written last: commit marker
+    uint32_t size;        // whole record, PADDING_FLAG for filler records
+    uint32_t formatId;
+    uint32_t reserved;
+    uint64_t timestampNs; // steady clock, relative to the file open
+  };
+
+  /** @brief Commit tag of a record starting at absolute position `pos` */
+  constexpr uint32_t tagForPosition(uint64_t pos)
+  {
+    return static_cast<uint32_t>(pos / RECORD_ALIGN) + 1u;
+  }
+
+  constexpr size_t alignRecord(size_t size)
+  {
+    return (size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+  }
+} // namespace BinaryLogLayout
+
+/**
+ * @brief Static description of one structured log call site
+ */
+struct BinaryLogSite {
+  uint32_t    id;
+  LogLevel    level;
+  const char *category;
+  const char *format;
+};
+
+/**
+ * @brief Register a call site format, returns its descriptor
+ *
+ * Called once per site through the function-local static in ABOX_SLOG.
+ * The format uses `{}` placeholders (`{:x}` for hex, `{{`/`}}` to escape).
+ */
+BinaryLogSite registerBinaryFormat(
+    LogLevel    level,
+    const char *category,
+    const char *format
+);
+
+/**
+ * @brief Open a binary log file and route ABOX_SLOG records into it
+ * @param path Output file, created or truncated
+ * @param ringBytes Capacity of the record ring, older records get overwritten
+ * @return false if the file could not be created or a log is already open
+ */
+bool openBinaryLog(const std::string &path, size_t ringBytes = 16u << 20);
+
+/**
+ * @brief Flush and close the binary log, ABOX_SLOG falls back to text
+ *
+ * Must not race with threads still logging.
+ */
+void closeBinaryLog();
+
+/**
+ * @brief Whether ABOX_SLOG records currently go to a binary log file
+ */
+bool isBinaryLogOpen();
+
+/**
+ * @brief Minimum level written to the binary log (text filters don't apply)
+ */
+void     setBinaryLogLevel(LogLevel minLevel);
+LogLevel getBinaryLogLevel();
+
+/**
+ * @brief Render a format with its encoded arguments to text
+ *
+ * Shared by the text fallback and the offline decoder so both produce the
+ * exact same output.
+ */
+std::string renderBinaryRecord(
+    std::string_view         format,
+    std::span<const uint8_t> payload
+);
+
+/**
+ * @brief A decoded record handed out by BinaryLogReader
+ */
+struct BinaryLogRecord {
+  uint64_t                 timestampNs;
+  uint32_t                 formatId;
+  LogLevel                 level;
+  std::string_view         category;
+  std::string_view         format;
+  std::span<const uint8_t> payload;
+
+  std::string text() const { return renderBinaryRecord(format, payload); }
+};
+
+/**
+ * @brief Read-only view over a binary log file, used by abox-logdump
+ */
+class BinaryLogReader {
+  struct Format {
+    LogLevel         level;
+    std::string_view category;
+    std::string_view format;
+  };
+
+  abox::platform::MappedFile         file{};
+  const BinaryLogLayout::FileHeader *header = nullptr;
+  std::vector<Format>                formats;
+
+   public:
+  BinaryLogReader() = default;
+  ~BinaryLogReader();
+  BinaryLogReader(const BinaryLogReader &)            = delete;
+  BinaryLogReader &operator=(const BinaryLogReader &) = delete;
+
+  /**
+   * @brief Map and validate a log file
+   * @return false if the file is missing or not a binary log
+   */
+  bool open(const std::string &path);
+  void close();
+
+  uint64_t wallClockAtOpenNs() const;
+  uint64_t droppedRecords() const;
+  size_t   formatCount() const { return formats.size(); }
+
+  /**
+   * @brief Visit every committed record, oldest first
+   * @return Number of records visited
+   */
+  size_t forEach(const std::function<void(const BinaryLogRecord &)> &visit
+  ) const;
+};
+
+// Hot path internals used by the ABOX_SLOG macros
+
+/**
+ * @brief A reserved, not yet committed record in the ring
+ */
+struct BinaryRecordSlot {
+  BinaryLogLayout::RecordHeader *header  = nullptr;
+  uint8_t                       *payload = nullptr;
+  uint32_t                       tag     = 0;
+};
+
+extern std::atomic<bool> g_binaryLogOpen;
+
+BinaryRecordSlot reserveBinaryRecord(uint32_t formatId, size_t payloadSize);
+bool             binaryLogAccepts(LogLevel level);
+void             logBinaryAsText(
+    const BinaryLogSite &site,
+    const uint8_t       *payload,
+    size_t               size
+);
+
+namespace BinaryLogDetail {
+  using BinaryLogLayout::ArgTag;
+
+  template <typename T> constexpr ArgTag tagOf()
+  {
+    using U = std::remove_cvref_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+      return ArgTag::Bool;
+    }
+    else if constexpr (std::is_same_v<U, char>) {
+      return ArgTag::Char;
+    }
+    else if constexpr (std::is_enum_v<U>) {
+      return std::is_signed_v<std::underlying_type_t<U>> ? ArgTag::I64
+                                                         : ArgTag::U64;
+    }
+    else if constexpr (std::is_integral_v<U>) {
+      return std::is_signed_v<U> ? ArgTag::I64 : ArgTag::U64;
+    }
+    else if constexpr (std::is_floating_point_v<U>) {
+      return ArgTag::F64;
+    }
+    else if constexpr (std::is_same_v<std::decay_t<U>, const char *> ||
+                       std::is_same_v<std::decay_t<U>, char *> ||
+                       std::is_same_v<U, std::string> ||
+                       std::is_same_v<U, std::string_view>) {
+      return ArgTag::Str;
+    }
+    else if constexpr (std::is_pointer_v<std::decay_t<U>>) {
+      return ArgTag::Ptr;
+    }
+    else {
+      static_assert(
+          sizeof(U) == 0, "Unsupported ABOX_SLOG argument type"
+      );
+    }
+  }
+
+  inline std::string_view asString(std::string_view s)
+  {
+    return s.substr(0, BinaryLogLayout::MAX_STRING_ARG);
+  }
+  inline std::string_view asString(const char *s)
+  {
+    return asString(std::string_view(s ? s : "(null)"));
+  }
+
+  template <typename T> size_t encodedSize(const T &value)
+  {
+    constexpr ArgTag tag = tagOf<T>();
+    if constexpr (tag == ArgTag::Bool || tag == ArgTag::Char) {
+      return 2;
+    }
+    else if constexpr (tag == ArgTag::Str) {
+      return 1 + sizeof(uint32_t) + asString(value).size();
+    }
+    else {
+      return 1 + sizeof(uint64_t);
+    }
+  }
+
+  template <typename T> uint8_t *encode(uint8_t *out, const T &value)
+  {
+    constexpr ArgTag tag = tagOf<T>();
+    *out++               = static_cast<uint8_t>(tag);
+    if constexpr (tag == ArgTag::Bool || tag == ArgTag::Char) {
+      *out++ = static_cast<uint8_t>(value);
+    }
+    else if constexpr (tag == ArgTag::Str) {
+      const std::string_view s   = asString(value);
+      const uint32_t         len = static_cast<uint32_t>(s.size());
+      std::memcpy(out, &len, sizeof(len));
+      std::memcpy(out + sizeof(len), s.data(), s.size());
+      out += sizeof(len) + s.size();
+    }
+    else {
+      uint64_t bits;
+      if constexpr (tag == ArgTag::F64) {
+        const double d = static_cast<double>(value);
+        std::memcpy(&bits, &d, sizeof(bits));
+      }
+      else if constexpr (tag == ArgTag::Ptr) {
+        bits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+      }
+      else if constexpr (tag == ArgTag::I64) {
+        bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+      }
+      else {
+        bits = static_cast<uint64_t>(value);
+      }
+      std::memcpy(out, &bits, sizeof(bits));
+      out += sizeof(bits);
+    }
+    return out;
+  }
+} // namespace BinaryLogDetail
+
+/**
+ * @brief Write one structured record, or render it as text if no binary log
+ * is open and the text filters let it through
+ */
+template <typename... Args>
+void binaryLog(const BinaryLogSite &site, const Args &...args)
+{
+  const size_t payloadSize =
+      (size_t{0} + ... + BinaryLogDetail::encodedSize(args));
+
+  if (g_binaryLogOpen.load(std::memory_order_acquire)) {
+    if (!binaryLogAccepts(site.level)) {
+      return;
+    }
+    BinaryRecordSlot slot = reserveBinaryRecord(site.id, payloadSize);
+    if (!slot.header) {
+      return;
+    }
+    uint8_t *out = slot.payload;
+    ((out = BinaryLogDetail::encode(out, args)), ...);
+    (void)out;
+    std::atomic_ref<uint32_t>(slot.header->tag)
+        .store(slot.tag, std::memory_order_release);
+    return;
+  }
+
+  if (site.level < getLogLevel() || !isCategoryEnabled(site.category)) {
+    return;
+  }
+  std::vector<uint8_t> payload(payloadSize);
+  uint8_t             *out = payload.data();
+  ((out = BinaryLogDetail::encode(out, args)), ...);
+  (void)out;
+  logBinaryAsText(site, payload.data(), payload.size());
+}
+
+} // namespace ABox
+
+/**
+ * Structured logging: the format is registered once per call site and the
+ * arguments are stored raw, rendering happens offline in abox-logdump.
+ *   ABOX_SLOG("Vulkan", ABox::LogLevel::DEBUG, "image {} of {}", i, n);
+ */
+#define ABOX_SLOG(category, level, fmt, ...)                                   \
+  do {                                                                         \
+    static const ABox::BinaryLogSite aboxSlogSite_ =                           \
+        ABox::registerBinaryFormat(level, category, fmt);                      \
+    ABox::binaryLog(aboxSlogSite_ __VA_OPT__(, ) __VA_ARGS__);                 \
+  } while (0)
+
+#define ABOX_SLOG_PER_FRAME(fmt, ...)                                          \
+  ABOX_SLOG("PER_FRAME", ABox::LogLevel::DEBUG, fmt __VA_OPT__(, ) __VA_ARGS__)
+
+#endif // ABOX_BINARY_LOG_HPP
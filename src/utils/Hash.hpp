@@ -0,0 +1,170 @@
+#ifndef ABOX_HASH_HPP
+#define ABOX_HASH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ABox {
+
+/**
+ * @brief 128 bit digest, used as a content address (shader cache keys...)
+ */
+struct Hash128 {
+  uint64_t lo = 0;
+  uint64_t hi = 0;
+
+  bool operator==(const Hash128 &) const = default;
+
+  /** @brief 32 lowercase hex digits, hi first */
+  std::string toHex() const
+  {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string           out(32, '0');
+    for (int i = 0; i < 16; ++i) {
+      out[15 - i] = digits[(hi >> (4 * i)) & 0xF];
+      out[31 - i] = digits[(lo >> (4 * i)) & 0xF];
+    }
+    return out;
+  }
+};
+
+/**
+ * @class Hasher
+ * @brief Streaming non-cryptographic 128 bit hash (two murmur3 style lanes
+ * over 8 byte words)
+ *
+ * Not meant to resist crafted collisions, only to address content that the
+ * engine produced or loaded itself. The digest depends on the byte stream
+ * only, not on how it was split across update() calls.
+ */
+class Hasher {
+  static constexpr uint64_t C1     = 0x87c37b91114253d5ull;
+  static constexpr uint64_t C2     = 0x4cf5ad432745937full;
+  static constexpr uint64_t SEED_1 = 0x9E3779B97F4A7C15ull;
+  static constexpr uint64_t SEED_2 = 0xC2B2AE3D27D4EB4Full;
+
+  uint64_t h1     = SEED_1;
+  uint64_t h2     = SEED_2;
+  uint64_t length = 0;
+  uint8_t  tail[8]{};
+  size_t   tailSize = 0;
+
+  static constexpr uint64_t rotl(uint64_t x, int r)
+  {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  static constexpr uint64_t fmix(uint64_t k)
+  {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+  }
+
+  void block(uint64_t k)
+  {
+    uint64_t k1 = rotl(k * C1, 31) * C2;
+    uint64_t k2 = rotl(k * C2, 33) * C1;
+    h1          = (rotl(h1 ^ k1, 27) + h2) * 5 + 0x52dce729;
+    h2          = (rotl(h2 ^ k2, 31) + h1) * 5 + 0x38495ab5;
+  }
+
+   public:
+  Hasher() = default;
+
+  explicit Hasher(uint64_t seed)
+      : h1(SEED_1 ^ seed)
+      , h2(SEED_2 + seed)
+  {
+  }
+
+  Hasher &update(const void *data, size_t size)
+  {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    length += size;
+    if (tailSize > 0) {
+      const size_t take = std::min(size, sizeof(tail) - tailSize);
+      std::memcpy(tail + tailSize, bytes, take);
+      tailSize += take;
+      bytes += take;
+      size -= take;
+      if (tailSize < sizeof(tail)) {
+        return *this;
+      }
+      uint64_t k;
+      std::memcpy(&k, tail, sizeof(k));
+      block(k);
+      tailSize = 0;
+    }
+    for (; size >= 8; size -= 8, bytes += 8) {
+      uint64_t k;
+      std::memcpy(&k, bytes, sizeof(k));
+      block(k);
+    }
+    std::memcpy(tail, bytes, size);
+    tailSize = size;
+    return *this;
+  }
+
+  /**
+   * @brief Hash a string prefixed by its length, so consecutive strings
+   * cannot shift into each other
+   */
+  Hasher &update(std::string_view text)
+  {
+    const uint64_t size = text.size();
+    update(&size, sizeof(size));
+    return update(text.data(), text.size());
+  }
+
+  /**
+   * @brief Hash the object representation of a trivially copyable value.
+   * Padding bytes must be deterministic (zero or static storage).
+   */
+  template <typename T>
+    requires std::is_trivially_copyable_v<T> &&
+             (!std::is_pointer_v<T>) &&
+             (!std::is_convertible_v<const T &, std::string_view>)
+  Hasher &update(const T &value)
+  {
+    return update(&value, sizeof(T));
+  }
+
+  [[nodiscard]] Hash128 digest() const
+  {
+    uint64_t a = h1;
+    uint64_t b = h2;
+    uint64_t k = 0;
+    std::memcpy(&k, tail, tailSize);
+    a ^= rotl(k * C1, 31) * C2;
+    b ^= length;
+    a += b;
+    b += a;
+    a = fmix(a);
+    b = fmix(b);
+    a += b;
+    b += a;
+    return {.lo = a, .hi = b};
+  }
+};
+
+} // namespace ABox
+
+/** @brief Digests are already mixed, half of one is a good bucket hash */
+template <> struct std::hash<ABox::Hash128> {
+  size_t operator()(const ABox::Hash128 &h) const noexcept
+  {
+    return static_cast<size_t>(h.lo);
+  }
+};
+
+#endif // ABOX_HASH_HPP
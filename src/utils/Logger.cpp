@@ -5,12 +5,24 @@
 
 namespace ABox {
 
+/**
+ * @brief Transparent hash so category lookups from a `const char *` don't
+ * build a std::string on every log call
+ */
+struct CategoryHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view s) const
+  {
+    return std::hash<std::string_view>{}(s);
+  }
+};
+
 // Global state
-static LogCallback                     g_logCallback = nullptr;
-static LogLevel                        g_minLogLevel = LogLevel::DEBUG;
-static std::unordered_set<std::string> g_enabledCategories{"PER_FRAME"
-}; // PER_FRAME disabled by default
-static bool                            g_whitelistMode =
+static LogCallback g_logCallback = nullptr;
+static LogLevel    g_minLogLevel = LogLevel::DEBUG;
+static std::unordered_set<std::string, CategoryHash, std::equal_to<>>
+    g_enabledCategories{"PER_FRAME"}; // PER_FRAME disabled by default
+static bool g_whitelistMode =
     false; // false = all enabled by default (blacklist mode)
 
 // ANSI color codes for terminal output
@@ -83,18 +95,18 @@ void enableCategory(const char *category)
 
 void disableCategory(const char *category)
 {
-  g_enabledCategories.erase(category);
+  g_enabledCategories.erase(std::string(category));
 }
 
 bool isCategoryEnabled(const char *category)
 {
   if (g_whitelistMode) {
     // Whitelist mode: only enabled if explicitly added
-    return g_enabledCategories.count(category) > 0;
+    return g_enabledCategories.contains(std::string_view(category));
   }
   else {
     // Blacklist mode: enabled unless explicitly disabled
-    return g_enabledCategories.count(category) == 0;
+    return !g_enabledCategories.contains(std::string_view(category));
   }
 }
 
@@ -117,11 +129,19 @@ void setFilterMode(bool whitelist)
 
 // LogStream implementation
 
-LogStream::LogStream(LogLevel level, const char *category, bool enabled)
+LogStream::LogStream(
+    LogLevel    level,
+    const char *category,
+    bool        enabled,
+    uint64_t    suppressed
+)
     : level(level)
     , category(category)
     , enabled(enabled)
 {
+  if (enabled && suppressed > 0) {
+    buffer << "[" << suppressed << " suppressed] ";
+  }
 }
 
 LogStream::~LogStream() { flush(); }
@@ -1,10 +1,16 @@
 #ifndef ABOX_LOGGER_HPP
 #define ABOX_LOGGER_HPP
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <functional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace ABox {
 
@@ -86,7 +92,16 @@ class LogStream {
   bool               enabled;
 
    public:
-  LogStream(LogLevel level, const char *category, bool enabled);
+  /**
+   * @param suppressed Messages a gate skipped since the last one, reported as
+   * a prefix when non zero
+   */
+  LogStream(
+      LogLevel    level,
+      const char *category,
+      bool        enabled,
+      uint64_t    suppressed = 0
+  );
   ~LogStream();
 
   // Stream operator support
@@ -110,6 +125,159 @@ class LogStream {
  */
 LogStream createLogStream(LogLevel level, const char *category);
 
+// Per call site gates. Instances live in function-local statics created by
+// the macros below: constant-initialised, lock-free, relaxed atomics only.
+
+/**
+ * @brief Outcome of a gate: emit or not, and how many were skipped before
+ */
+struct LogGateDecision {
+  bool     emit       = false;
+  uint64_t suppressed = 0;
+};
+
+/**
+ * @brief Lets 1 message in N through (the first one included)
+ */
+class LogEveryN {
+  std::atomic<uint64_t> counter{0};
+
+   public:
+  constexpr LogEveryN() = default;
+
+  LogGateDecision check(uint64_t n)
+  {
+    const uint64_t count = counter.fetch_add(1, std::memory_order_relaxed);
+    return {n <= 1 || count % n == 0, 0};
+  }
+};
+
+/**
+ * @brief Lets at most N messages per second through, reports the skipped
+ * count on the next message that passes
+ */
+class LogRateLimiter {
+  // Window start in ms (high 32 bits, wraps every 49 days) and messages let
+  // through in it (low 32 bits), so one CAS both opens and counts
+  std::atomic<uint64_t> window{0};
+  std::atomic<uint64_t> suppressed{0};
+
+   public:
+  constexpr LogRateLimiter() = default;
+
+  LogGateDecision check(uint32_t perSecond)
+  {
+    const auto now = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count()
+    );
+
+    uint64_t current = window.load(std::memory_order_relaxed);
+    for (;;) {
+      const auto start = static_cast<uint32_t>(current >> 32);
+      const auto count = static_cast<uint32_t>(current);
+      // Unsigned, so the difference holds across the wrap
+      const bool expired = now - start >= 1000;
+      if (perSecond == 0 || (!expired && count >= perSecond)) {
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return {false, 0};
+      }
+      const uint64_t next =
+          expired ? (static_cast<uint64_t>(now) << 32) | 1 : current + 1;
+      if (window.compare_exchange_weak(
+              current, next, std::memory_order_relaxed
+          )) {
+        return {true, suppressed.exchange(0, std::memory_order_relaxed)};
+      }
+    }
+  }
+};
+
+/**
+ * @brief Lets the first message through, then nothing
+ */
+class LogOnce {
+  std::atomic<bool> done{false};
+
+   public:
+  constexpr LogOnce() = default;
+
+  LogGateDecision check()
+  {
+    // Plain load first so the steady state is a shared read, not an RMW
+    if (done.load(std::memory_order_relaxed)) {
+      return {false, 0};
+    }
+    return {!done.exchange(true, std::memory_order_relaxed), 0};
+  }
+};
+
+/**
+ * @brief Reduce a watched value to the 64-bit key compared by LogOnChange
+ */
+template <typename T> uint64_t logChangeKey(const T &value)
+{
+  using U = std::remove_cvref_t<T>;
+  if constexpr (std::is_integral_v<U> || std::is_enum_v<U>) {
+    return static_cast<uint64_t>(value);
+  }
+  else if constexpr (std::is_pointer_v<U>) {
+    return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+  }
+  else if constexpr (std::is_floating_point_v<U>) {
+    const double d = static_cast<double>(value);
+    uint64_t     bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return bits;
+  }
+  else if constexpr (std::is_convertible_v<const U &, std::string_view>) {
+    return std::hash<std::string_view>{}(std::string_view(value));
+  }
+  else {
+    return std::hash<U>{}(value);
+  }
+}
+
+/**
+ * @brief Lets a message through the first time and whenever the watched
+ * value differs from the previous call
+ */
+class LogOnChange {
+  std::atomic<uint64_t> last{0};
+  std::atomic<bool>     seeded{false};
+
+   public:
+  constexpr LogOnChange() = default;
+
+  template <typename T> LogGateDecision check(const T &value)
+  {
+    const uint64_t key = logChangeKey(value);
+    if (!seeded.load(std::memory_order_relaxed)) {
+      last.store(key, std::memory_order_relaxed);
+      return {!seeded.exchange(true, std::memory_order_relaxed), 0};
+    }
+    return {last.exchange(key, std::memory_order_relaxed) != key, 0};
+  }
+};
+
+/**
+ * @brief Creates a LogStream behind a per call site gate
+ *
+ * Level and category filters are checked first so a filtered-out site
+ * never touches its gate state.
+ */
+template <typename Gate>
+LogStream createLogStream(LogLevel level, const char *category, Gate &&gate)
+{
+  if (level < getLogLevel() || !isCategoryEnabled(category)) {
+    return LogStream(level, category, false);
+  }
+  const LogGateDecision decision = gate();
+  return LogStream(level, category, decision.emit, decision.suppressed);
+}
+
 } // namespace ABox
 
 // Main logging macro - stream-based
@@ -127,6 +295,37 @@ LogStream createLogStream(LogLevel level, const char *category);
 #define ABOX_LOG_PER_FRAME ABOX_LOG("PER_FRAME", ABox::LogLevel::DEBUG)
 #define ABOX_LOG_VERBOSE ABOX_LOG("VERBOSE", ABox::LogLevel::DEBUG)
 
+// Sampled / rate-limited variants, state is per call site
+#define ABOX_LOG_EVERY_N(category, level, n)                                   \
+  ABox::createLogStream(level, category, [&] {                                 \
+    static ABox::LogEveryN aboxLogGate_;                                       \
+    return aboxLogGate_.check(n);                                              \
+  })
+#define ABOX_LOG_RATE_LIMITED(category, level, perSecond)                      \
+  ABox::createLogStream(level, category, [&] {                                 \
+    static ABox::LogRateLimiter aboxLogGate_;                                  \
+    return aboxLogGate_.check(perSecond);                                      \
+  })
+#define ABOX_LOG_ONCE(category, level)                                         \
+  ABox::createLogStream(level, category, [] {                                  \
+    static ABox::LogOnce aboxLogGate_;                                         \
+    return aboxLogGate_.check();                                               \
+  })
+#define ABOX_LOG_ON_CHANGE(category, level, value)                             \
+  ABox::createLogStream(level, category, [&] {                                 \
+    static ABox::LogOnChange aboxLogGate_;                                     \
+    return aboxLogGate_.check(value);                                          \
+  })
+
+#define ABOX_LOG_PER_FRAME_EVERY_N(n)                                          \
+  ABOX_LOG_EVERY_N("PER_FRAME", ABox::LogLevel::DEBUG, n)
+#define ABOX_LOG_PER_FRAME_RATE_LIMITED(perSecond)                             \
+  ABOX_LOG_RATE_LIMITED("PER_FRAME", ABox::LogLevel::DEBUG, perSecond)
+#define ABOX_LOG_PER_FRAME_ONCE                                                \
+  ABOX_LOG_ONCE("PER_FRAME", ABox::LogLevel::DEBUG)
+#define ABOX_LOG_PER_FRAME_ON_CHANGE(value)                                    \
+  ABOX_LOG_ON_CHANGE("PER_FRAME", ABox::LogLevel::DEBUG, value)
+
 // Convenience macros with level (always compiled, filtered at runtime)
 #define LOG_DEBUG(category) ABOX_LOG(category, ABox::LogLevel::DEBUG)
 #define LOG_INFO(category) ABOX_LOG(category, ABox::LogLevel::INFO)
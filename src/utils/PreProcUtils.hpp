@@ -12,6 +12,8 @@
   #define VK_ABOX_VALIDATION_LAYERS
   #define VK_ABOX_PROFILING
   #define ABOX_RESSOURCES_DEBUG
+  #define ABOX_OBJECT_TRACKING // live handle counts, see ObjectRegistry
+  #define ABOX_SHADER_HOT_RELOAD // recompile edited shaders, see ShaderWatcher
 #endif
 
 #define AxREAL double // Might map to float on other target
@@ -82,6 +84,9 @@
 
 #define INFLIGHT_NUMBER_OF_ELEMENTS 2
 
+// Driver host allocations go through HostAllocator pools
+#define ABOX_HOST_ALLOCATOR
+
 // x86-64 standard cache line size (also works on most ARM architectures)
 inline constexpr size_t ABOX_CACHE_LINE_SIZE = 64;
 
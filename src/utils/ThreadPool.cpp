@@ -0,0 +1,53 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace ABox {
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+  if (threadCount == 0) {
+    const size_t hw = std::thread::hardware_concurrency();
+    threadCount     = std::max<size_t>(hw > 1 ? hw - 1 : 1, 1);
+  }
+  workers.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+ThreadPool &ThreadPool::shared()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock(mutex);
+      wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+      if (tasks.empty()) {
+        return; // stopping and drained
+      }
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
+
+} // namespace ABox
@@ -0,0 +1,75 @@
+#ifndef ABOX_THREAD_POOL_HPP
+#define ABOX_THREAD_POOL_HPP
+
+#include "PreProcUtils.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ABox {
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads draining a FIFO of tasks
+ *
+ * Meant for coarse CPU work (shader compilation, pipeline builds), not for
+ * per-frame jobs. Tasks still queued on destruction are run before the
+ * workers join, so every returned future becomes ready.
+ */
+class ThreadPool {
+  std::vector<std::thread>          workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex                        mutex;
+  std::condition_variable           wake;
+  bool                              stopping = false;
+
+  void workerLoop();
+
+   public:
+  /**
+   * @param threadCount 0 picks hardware_concurrency() - 1, at least 1
+   */
+  explicit ThreadPool(size_t threadCount = 0);
+  ~ThreadPool();
+
+  DELETE_COPY(ThreadPool);
+  DELETE_MOVE(ThreadPool);
+
+  /**
+   * @brief Process wide pool, created on first use
+   */
+  static ThreadPool &shared();
+
+  [[nodiscard]] size_t size() const { return workers.size(); }
+
+  /**
+   * @brief Queue a callable, its result (or exception) is delivered through
+   * the returned future
+   */
+  template <typename F>
+  auto submit(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+  {
+    using R = std::invoke_result_t<std::decay_t<F>>;
+    // std::function needs a copyable target
+    auto packaged =
+        std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+    std::future<R> result = packaged->get_future();
+    {
+      std::lock_guard lock(mutex);
+      tasks.emplace_back([packaged] { (*packaged)(); });
+    }
+    wake.notify_one();
+    return result;
+  }
+};
+
+} // namespace ABox
+
+#endif // ABOX_THREAD_POOL_HPP
@@ -72,12 +72,14 @@ CommandBoundElement::CommandBoundElement(
 }
 
 VkResult CommandBoundElement::recordCommandBuffer(
-    GraphicsPipeline  &gp,
-    Swapchain         &sm,
-    FrameBufferBroker &fbb,
-    VkRenderPass       rp,
-    uint32_t           imageIndex,
-    uint32_t           commandBufferIndex
+    GraphicsPipeline           &gp,
+    const ExtendedDynamicState &dynamicState,
+    const RasterState          &raster,
+    Swapchain                  &sm,
+    FrameBufferBroker          &fbb,
+    VkRenderPass                rp,
+    uint32_t                    imageIndex,
+    uint32_t                    commandBufferIndex
 )
 {
   VkCommandBufferBeginInfo beginInfo{
@@ -111,7 +113,8 @@ VkResult CommandBoundElement::recordCommandBuffer(
       .clearValueCount = 1u,
       .pClearValues    = &clearColor
   };
-  ABOX_LOG_PER_FRAME << "Framebuffer size: " << fv->size();
+  ABOX_LOG_PER_FRAME_ON_CHANGE(fv->size())
+      << "Framebuffer size: " << fv->size();
 
   vkCmdBeginRenderPass(
       commandBuffers.at(commandBufferIndex),
@@ -126,6 +129,10 @@ VkResult CommandBoundElement::recordCommandBuffer(
       gp.getPipeline()
   );
 
+  ABOX_LOG_PER_FRAME << "Setting dynamic state";
+  DynamicStateRecorder dynamicStates(dynamicState);
+  dynamicStates.apply(commandBuffers.at(commandBufferIndex), raster);
+
   ABOX_LOG_PER_FRAME << "Setting viewport";
   vkCmdSetViewport(
       commandBuffers.at(commandBufferIndex),
@@ -59,12 +59,14 @@ class CommandBoundElement {
   );
 
   VkResult recordCommandBuffer(
-      GraphicsPipeline  &gp,
-      Swapchain         &sm,
-      FrameBufferBroker &fbb,
-      VkRenderPass       rp,
-      uint32_t           imageIndex,
-      uint32_t           commandBufferIndex
+      GraphicsPipeline           &gp,
+      const ExtendedDynamicState &dynamicState,
+      const RasterState          &raster,
+      Swapchain                  &sm,
+      FrameBufferBroker          &fbb,
+      VkRenderPass                rp,
+      uint32_t                    imageIndex,
+      uint32_t                    commandBufferIndex
   );
 
   VkCommandBuffer getCommandBuffer(uint32_t index)
@@ -76,31 +76,38 @@ uint32_t queueFamilyQueueCount(VkQueueFamilyProperties qfp)
 }
 
 struct ExtensionSupport {
+  std::vector<VkExtensionProperties> available;
   std::vector<const char *> enabled; // list to pass to vkCreateDevice
   bool allRequired = true;           // false if any required ext is missing
-};
 
-ExtensionSupport filterDeviceExtensions(VkPhysicalDevice phys)
-{
-  uint32_t count = 0;
-  vkEnumerateDeviceExtensionProperties(phys, nullptr, &count, nullptr);
-  std::vector<VkExtensionProperties> avail(count);
-  vkEnumerateDeviceExtensionProperties(phys, nullptr, &count, avail.data());
-
-  auto hasExt = [&](const char *name) {
-    for (auto &e : avail) {
+  bool isAvailable(const char *name) const
+  {
+    for (auto &e : available) {
       if (strcmp(e.extensionName, name) == 0) {
         return true;
       }
     }
     return false;
-  };
+  }
+};
 
+ExtensionSupport filterDeviceExtensions(VkPhysicalDevice phys)
+{
   ExtensionSupport result;
 
+  uint32_t count = 0;
+  vkEnumerateDeviceExtensionProperties(phys, nullptr, &count, nullptr);
+  result.available.resize(count);
+  vkEnumerateDeviceExtensionProperties(
+      phys,
+      nullptr,
+      &count,
+      result.available.data()
+  );
+
   // Required
   for (auto *name : requiredDeviceExtensions) {
-    if (hasExt(name)) {
+    if (result.isAvailable(name)) {
       result.enabled.push_back(name);
     }
     else {
@@ -111,7 +118,7 @@ ExtensionSupport filterDeviceExtensions(VkPhysicalDevice phys)
 
   // Optional
   for (auto *name : optionalDeviceExtentions) {
-    if (hasExt(name)) {
+    if (result.isAvailable(name)) {
       result.enabled.push_back(name);
       LOG_INFO("Vulkan") << "Enabling optional extension: " << name;
     }
@@ -122,6 +129,245 @@ ExtensionSupport filterDeviceExtensions(VkPhysicalDevice phys)
   return result;
 }
 
+/**
+ * @brief Enable VK_KHR_maintenance5 when the device supports it: pipelines
+ * then take SPIR-V without shader modules. It depends on dynamic rendering,
+ * core from Vulkan 1.3 only.
+ * @param features filled and to be chained to VkDeviceCreateInfo
+ * @return true if the feature is enabled
+ */
+bool enableMaintenance5(
+    VkPhysicalDevice                         phys,
+    ExtensionSupport                        &extensions,
+    VkPhysicalDeviceMaintenance5FeaturesKHR &features
+)
+{
+  features = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR,
+      .pNext = nullptr,
+      .maintenance5 = VK_FALSE
+  };
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(phys, &properties);
+  if (properties.apiVersion < VK_API_VERSION_1_3 ||
+      !extensions.isAvailable(VK_KHR_MAINTENANCE_5_EXTENSION_NAME)) {
+    LOG_INFO("Vulkan") << "VK_KHR_maintenance5 unavailable, shader modules "
+                          "are created per SPIR-V";
+    return false;
+  }
+
+  VkPhysicalDeviceFeatures2 supported{
+      .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext    = &features,
+      .features = {}
+  };
+  vkGetPhysicalDeviceFeatures2(phys, &supported);
+  if (!features.maintenance5) {
+    return false;
+  }
+  extensions.enabled.push_back(VK_KHR_MAINTENANCE_5_EXTENSION_NAME);
+  LOG_INFO("Vulkan") << "Enabling optional extension: "
+                     << VK_KHR_MAINTENANCE_5_EXTENSION_NAME;
+  return true;
+}
+
+/**
+ * @brief Enable VK_EXT_graphics_pipeline_library when the device supports
+ * it: graphics pipelines are then fast-linked from cached parts.
+ * @param features filled and to be chained to VkDeviceCreateInfo
+ * @return true if the feature is enabled
+ */
+bool enableGraphicsPipelineLibrary(
+    VkPhysicalDevice                                    phys,
+    ExtensionSupport                                   &extensions,
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT &features
+)
+{
+  features = {
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+      .pNext                   = nullptr,
+      .graphicsPipelineLibrary = VK_FALSE
+  };
+  if (!extensions.isAvailable(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) ||
+      !extensions.isAvailable(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)
+  ) {
+    LOG_INFO("Vulkan") << "VK_EXT_graphics_pipeline_library unavailable, "
+                          "graphics pipelines are built whole";
+    return false;
+  }
+
+  VkPhysicalDeviceFeatures2 supported{
+      .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext    = &features,
+      .features = {}
+  };
+  vkGetPhysicalDeviceFeatures2(phys, &supported);
+  if (!features.graphicsPipelineLibrary) {
+    return false;
+  }
+  for (const char *name : {VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+                           VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME}) {
+    extensions.enabled.push_back(name);
+    LOG_INFO("Vulkan") << "Enabling optional extension: " << name;
+  }
+  return true;
+}
+
+/**
+ * @brief Find the extended dynamic state the device supports: graphics
+ * pipelines then leave those states to the command buffer. The first two
+ * are core from Vulkan 1.3; the polygon mode and blend enable of
+ * VK_EXT_extended_dynamic_state3 are enabled when supported.
+ * @param features3 filled and to be chained to VkDeviceCreateInfo if any
+ * of its states is supported
+ */
+DynamicStateFeatures enableExtendedDynamicState(
+    VkPhysicalDevice                                  phys,
+    ExtensionSupport                                 &extensions,
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT &features3
+)
+{
+  // One member per state: value-initialized, not listed
+  features3       = {};
+  features3.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+  DynamicStateFeatures       supported;
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(phys, &properties);
+  if (properties.apiVersion < VK_API_VERSION_1_3) {
+    LOG_INFO("Vulkan") << "Extended dynamic state needs Vulkan 1.3, "
+                          "pipeline state is baked";
+    return supported;
+  }
+  supported.extendedDynamicState  = true;
+  supported.extendedDynamicState2 = true;
+  if (!extensions.isAvailable(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+    return supported;
+  }
+
+  VkPhysicalDeviceFeatures2 query{
+      .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext    = &features3,
+      .features = {}
+  };
+  vkGetPhysicalDeviceFeatures2(phys, &query);
+  supported.polygonMode      = features3.extendedDynamicState3PolygonMode;
+  supported.colorBlendEnable = features3.extendedDynamicState3ColorBlendEnable;
+  // Only what the pipelines use is enabled
+  features3       = {};
+  features3.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+  features3.extendedDynamicState3PolygonMode      = supported.polygonMode;
+  features3.extendedDynamicState3ColorBlendEnable = supported.colorBlendEnable;
+  if (supported.polygonMode || supported.colorBlendEnable) {
+    extensions.enabled.push_back(
+        VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME
+    );
+    LOG_INFO("Vulkan") << "Enabling optional extension: "
+                       << VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME;
+  }
+  return supported;
+}
+
+/**
+ * @brief Enable VK_EXT_shader_object when the device supports it: shaders
+ * can then be bound without pipelines, see PipelineManager::setBackend.
+ * Shader objects draw inside dynamic rendering, enabled along; both need
+ * Vulkan 1.3 here, the state commands they rely on are core there.
+ * @param features filled and to be chained to VkDeviceCreateInfo
+ * @param rendering filled and to be chained to VkDeviceCreateInfo
+ * @return true if the features are enabled
+ */
+bool enableShaderObject(
+    VkPhysicalDevice                          phys,
+    ExtensionSupport                         &extensions,
+    VkPhysicalDeviceShaderObjectFeaturesEXT  &features,
+    VkPhysicalDeviceDynamicRenderingFeatures &rendering
+)
+{
+  features = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT,
+      .pNext = nullptr,
+      .shaderObject = VK_FALSE
+  };
+  rendering = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES,
+      .pNext = &features,
+      .dynamicRendering = VK_FALSE
+  };
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(phys, &properties);
+  if (properties.apiVersion < VK_API_VERSION_1_3 ||
+      !extensions.isAvailable(VK_EXT_SHADER_OBJECT_EXTENSION_NAME)) {
+    LOG_INFO("Vulkan") << "VK_EXT_shader_object unavailable, shaders are "
+                          "bound through pipelines";
+    return false;
+  }
+
+  VkPhysicalDeviceFeatures2 supported{
+      .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext    = &rendering,
+      .features = {}
+  };
+  vkGetPhysicalDeviceFeatures2(phys, &supported);
+  if (!features.shaderObject || !rendering.dynamicRendering) {
+    return false;
+  }
+  extensions.enabled.push_back(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
+  LOG_INFO("Vulkan") << "Enabling optional extension: "
+                     << VK_EXT_SHADER_OBJECT_EXTENSION_NAME;
+  return true;
+}
+
+/**
+ * @brief Enable VK_KHR_pipeline_executable_properties when a pipeline report
+ * is requested, see PipelineStatistics::requestedReport, and the device
+ * supports it: pipelines then capture their executable statistics.
+ * @param features filled and to be chained to VkDeviceCreateInfo
+ * @return true if the feature is enabled
+ */
+bool enablePipelineExecutableProperties(
+    VkPhysicalDevice                                         phys,
+    ExtensionSupport                                        &extensions,
+    VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR &features
+)
+{
+  features = {
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_EXECUTABLE_PROPERTIES_FEATURES_KHR,
+      .pNext                  = nullptr,
+      .pipelineExecutableInfo = VK_FALSE
+  };
+  if (PipelineStatistics::requestedReport().empty()) {
+    return false;
+  }
+  if (!extensions.isAvailable(
+          VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME
+      )) {
+    LOG_INFO("Vulkan") << "VK_KHR_pipeline_executable_properties "
+                          "unavailable, the pipeline report has no "
+                          "statistics";
+    return false;
+  }
+
+  VkPhysicalDeviceFeatures2 supported{
+      .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext    = &features,
+      .features = {}
+  };
+  vkGetPhysicalDeviceFeatures2(phys, &supported);
+  if (!features.pipelineExecutableInfo) {
+    return false;
+  }
+  extensions.enabled.push_back(
+      VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME
+  );
+  LOG_INFO("Vulkan") << "Enabling optional extension: "
+                     << VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME;
+  return true;
+}
+
 uint32_t DeviceHandler::listQueueFamilies()
 {
   uint32_t queueCount;
@@ -202,6 +448,8 @@ void DeviceHandler::waitIdle()
 {
   for (auto &dev : devices) {
     vkDeviceWaitIdle(dev.getDevice().get());
+    // Nothing is in flight anymore
+    dev.getDeletionQueue().flush();
   }
 }
 
@@ -285,11 +533,57 @@ VkResult DeviceHandler::addLogicalDevice(
     );
   }
   LOG_DEBUG("Device") << "Preparing logical device creation";
-  std::vector<const char *> devExtVect = filterDeviceExtensions(phydev).enabled;
+  ExtensionSupport extensions = filterDeviceExtensions(phydev);
+  VkPhysicalDeviceMaintenance5FeaturesKHR maintenance5;
+  const bool inlineShaderModules =
+      enableMaintenance5(phydev, extensions, maintenance5);
+  VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibrary;
+  const bool                                         pipelineLibraries =
+      enableGraphicsPipelineLibrary(phydev, extensions, pipelineLibrary);
+  VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3;
+  const DynamicStateFeatures                       dynamicState =
+      enableExtendedDynamicState(phydev, extensions, dynamicState3);
+  VkPhysicalDeviceShaderObjectFeaturesEXT  shaderObject;
+  VkPhysicalDeviceDynamicRenderingFeatures dynamicRendering;
+  const bool                               shaderObjects = enableShaderObject(
+      phydev,
+      extensions,
+      shaderObject,
+      dynamicRendering
+  );
+  VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR executableProperties;
+  const bool statistics = enablePipelineExecutableProperties(
+      phydev,
+      extensions,
+      executableProperties
+  );
+  // Chain of the enabled feature structs
+  void *enabledFeatures = nullptr;
+  if (statistics) {
+    executableProperties.pNext = enabledFeatures;
+    enabledFeatures            = &executableProperties;
+  }
+  if (shaderObjects) {
+    shaderObject.pNext = enabledFeatures;
+    enabledFeatures    = &dynamicRendering; // chained to shaderObject
+  }
+  if (dynamicState.polygonMode || dynamicState.colorBlendEnable) {
+    dynamicState3.pNext = enabledFeatures;
+    enabledFeatures     = &dynamicState3;
+  }
+  if (pipelineLibraries) {
+    pipelineLibrary.pNext = enabledFeatures;
+    enabledFeatures       = &pipelineLibrary;
+  }
+  if (inlineShaderModules) {
+    maintenance5.pNext = enabledFeatures;
+    enabledFeatures    = &maintenance5;
+  }
+  const std::vector<const char *> &devExtVect = extensions.enabled;
   listQueueFamilies();
   VkDeviceCreateInfo devInfo{
       .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-      .pNext                   = nullptr,
+      .pNext                   = enabledFeatures,
       .flags                   = 0u,
       .queueCreateInfoCount    = static_cast<uint32_t>(qCI.size()),
       .pQueueCreateInfos       = qCI.data(),
@@ -301,7 +595,13 @@ VkResult DeviceHandler::addLogicalDevice(
   };
 
   VkDevice dev;
-  VkResult res = vkCreateDevice(phydev, &devInfo, nullptr, &dev);
+  // DeviceBoundElements destroys it with the same callbacks
+  VkResult res = vkCreateDevice(
+      phydev,
+      &devInfo,
+      HostAllocator::callbacks(HostAllocTag::Device),
+      &dev
+  );
 
   DeviceHandle handle{};  // Declare outside the if block
 
@@ -339,6 +639,26 @@ VkResult DeviceHandler::addLogicalDevice(
           0u,
           &newDevice->presentQueue
       );
+      newDevice->pipelineManager.getShaderModuleCache().setInlineModules(
+          inlineShaderModules
+      );
+      newDevice->pipelineManager.getPipelineCache().open(dev, phydev);
+      newDevice->pipelineManager.getExtendedDynamicState().enable(
+          dev,
+          dynamicState
+      );
+      if (pipelineLibraries) {
+        newDevice->pipelineManager.getPipelineLibraryCache().enable(dev);
+      }
+      if (shaderObjects) {
+        newDevice->pipelineManager.getShaderObjectSupport().enable(dev);
+      }
+      if (statistics &&
+          newDevice->pipelineManager.getPipelineStatistics().enable(dev)) {
+        newDevice->pipelineManager.getPipelineCache().setCaptureStatistics(
+            true
+        );
+      }
     }
   }
   else {
@@ -478,8 +798,8 @@ VkResult DeviceHandler::addSwapchain(
 }
 
 VkResult DeviceHandler::addGraphicsPipeline(
-    uint32_t                         deviceIndex,
-    const std::list<ShaderDataFile> &shaderFiles
+    uint32_t       deviceIndex,
+    ShaderDataView shaderFiles
 )
 {
   DeviceBoundElements *dbe = getDBE(deviceIndex);
@@ -504,6 +824,25 @@ VkResult DeviceHandler::addGraphicsPipeline(
   return VK_ERROR_INITIALIZATION_FAILED;
 };
 
+size_t DeviceHandler::reloadPipelines(
+    uint32_t                        deviceIndex,
+    ShaderDataView                  shaderFiles,
+    const std::vector<std::string> &changedShaders
+)
+{
+  DeviceBoundElements *dbe = getDBE(deviceIndex);
+  if (!dbe || changedShaders.empty()) {
+    return 0;
+  }
+  return dbe->pipelineManager.reloadPipelines(
+      getDevice(deviceIndex),
+      changedShaders,
+      shaderFiles,
+      dbe->swapchains.empty() ? nullptr : &dbe->swapchains.front(),
+      dbe->getDeletionQueue()
+  );
+}
+
 //------DISPLAY FUNCTIONS --- Maybe Need to opacity----//
 OSTREAM_OP(const VkPhysicalDeviceType &phyT)
 {
@@ -2,8 +2,10 @@
 #define DEVICE_HANDLER_HPP
 
 #include "CommandsHandler.hpp"
+#include "DeferredDeletionQueue.hpp"
 #include "FetchList.hpp"
 #include "FrameBufferBroker.hpp"
+#include "HostAllocator.hpp"
 #include "Logger.hpp"
 #include "PipelineManager.hpp"
 #include "PreProcUtils.hpp"
@@ -31,6 +33,7 @@ DEFINE_VK_MEMORY_WRAPPER_SOLO(VkDevice, Device, vkDestroyDevice)
  */
 class DeviceBoundElements {
   DeviceWrapper            device;
+  DeferredDeletionQueue    deletionQueue; // after device: destroyed before it
   VkPhysicalDevice         physical;
   const QueueFamilyIndices fIndices;
   FrameSyncArray           syncM;
@@ -50,7 +53,7 @@ class DeviceBoundElements {
       VkPhysicalDevice   phyDev,
       QueueFamilyIndices queueRoleIndices
   )
-      : device(logDevice)
+      : device(logDevice, HostAllocator::callbacks(HostAllocTag::Device))
       , physical(phyDev)
       , fIndices(queueRoleIndices)
       , syncM(logDevice)
@@ -74,13 +77,39 @@ class DeviceBoundElements {
 
   CommandsHandler *getCommandHandler() { return &commands; }
 
-  VkResult recordCommandBuffer(uint32_t imageIndex, uint32_t commandBufferIndex)
+  DeferredDeletionQueue &getDeletionQueue() { return deletionQueue; }
+
+  /**
+   * @brief Destroy the retired handles whose frame has completed, call once
+   * the current frame slot's fence has been waited on. Also refreshes the
+   * ObjectRegistry high-water marks and rates, publishes the pipelines
+   * built in the background, swaps in their link-time optimized versions
+   * and saves the pipeline cache when new pipelines are due to be persisted.
+   */
+  size_t collectRetired()
   {
-    ABOX_LOG_PER_FRAME << "Recording commands Img " << imageIndex
-                       << " commandBufferIndex: " << commandBufferIndex;
+#ifdef ABOX_OBJECT_TRACKING
+    ObjectRegistry::sample();
+#endif
+    pipelineManager.publishReadyPipelines();
+    pipelineManager.swapOptimizedPipelines(deletionQueue);
+    pipelineManager.getPipelineCache().saveIfDue();
+    return deletionQueue.advance(
+        syncM.getCurrentSerial(),
+        syncM.getCompletedSerial()
+    );
+  }
 
-    GraphicsPipeline *mainPipeline = pipelineManager.getMainGraphicsPipeline();
-    if (!mainPipeline) {
+  VkResult recordCommandBuffer(uint32_t imageIndex, uint32_t commandBufferIndex)
+  {
+    ABOX_LOG_PER_FRAME_RATE_LIMITED(10)
+        << "Recording commands Img " << imageIndex
+        << " commandBufferIndex: " << commandBufferIndex;
+
+    GraphicsPipeline  *mainPipeline = pipelineManager.getMainGraphicsPipeline();
+    const RasterState *mainRaster =
+        pipelineManager.getMainGraphicsRasterState();
+    if (!mainPipeline || !mainRaster) {
       LOG_ERROR("Pipeline") << "No main graphics pipeline set";
       throw std::runtime_error(
           "Wrong graphics pipeline target during recordcommandbuffer"
@@ -95,6 +124,8 @@ class DeviceBoundElements {
     }
     return commands.top().recordCommandBuffer(
         *mainPipeline,
+        pipelineManager.getExtendedDynamicState(),
+        *mainRaster,
         swapchains.front(),
         fbb,
         rpm.front().get(),
@@ -185,8 +216,19 @@ class DeviceHandler {
    * swapchain
    */
   VkResult addGraphicsPipeline(
-      uint32_t                         deviceIndex,
-      const std::list<ShaderDataFile> &shaderFiles
+      uint32_t       deviceIndex,
+      ShaderDataView shaderFiles
+  );
+
+  /**
+   * @brief Rebuild the device's pipelines using the changed shaders, the
+   * old ones are retired through its deletion queue
+   * @return Number of pipelines rebuilt
+   */
+  size_t reloadPipelines(
+      uint32_t                        deviceIndex,
+      ShaderDataView                  shaderFiles,
+      const std::vector<std::string> &changedShaders
   );
 
   VkResult createFramebuffers(uint32_t deviceIndex = 0u)
@@ -232,12 +274,15 @@ class DeviceHandler {
         LOG_DEBUG("Pipeline") << "GP has value " << (mainPipeline != nullptr);
         mainPipeline->updateExtent(window);
       }
+      // Old swapchain, views and framebuffers may still be used by frames
+      // in flight: they go through the deletion queue, no device idle needed
       dbe->swapchains.front().resizeSwapChain(
           dbe->getPhysicalDevice(),
           dbe->getDevice().get(),
           window,
           dbe->rpm.front(),
-          dbe->fbb
+          dbe->fbb,
+          dbe->getDeletionQueue()
       );
 
       return VK_SUCCESS;
@@ -65,9 +65,19 @@ class FrameSyncObject {
   }
 };
 
+/**
+ * @brief Ring of per-frame sync objects
+ *
+ * Every submitted frame gets a serial. Once a slot's fence has been waited
+ * on, the serial it was submitted with is complete; that is what the
+ * deferred deletion queue keys on.
+ */
 class FrameSyncArray {
   std::vector<FrameSyncObject> framesSync;
-  int16_t                      frameIndex = 0u;
+  std::vector<uint64_t>        submittedSerials; // per slot, 0 = never used
+  int16_t                      frameIndex      = 0u;
+  uint64_t                     currentSerial   = 1u;
+  uint64_t                     completedSerial = 0u;
 
    public:
   FrameSyncArray(
@@ -88,6 +98,7 @@ class FrameSyncArray {
     for (int32_t a = 0; a < arraySize; a++) {
       framesSync.emplace_back(device);
     }
+    submittedSerials.assign(framesSync.size(), 0u);
   }
 
   FrameSyncObject *getFrameSyncObject(uint32_t index)
@@ -111,17 +122,51 @@ class FrameSyncArray {
 
   void resetFrameIndex() { frameIndex = 0; }
 
-  void waitAndReset(VkDevice device, uint64_t time = UINT64_MAX)
+  /**
+   * @brief Wait for the current slot's previous submission, without resetting
+   * its fence. Reset only once the frame is sure to be submitted (after a
+   * successful acquire), otherwise the next wait would never return.
+   */
+  VkResult wait(VkDevice device, uint64_t time = UINT64_MAX)
   {
-    vkWaitForFences(
+    VkResult result = vkWaitForFences(
         device,
         1,
         framesSync.at(frameIndex).inFlight.ptr(),
         VK_TRUE,
         time
     );
+    if (result == VK_SUCCESS) {
+      // Single queue: fences signal in submission order
+      completedSerial =
+          std::max(completedSerial, submittedSerials.at(frameIndex));
+    }
+    return result;
+  }
+
+  void reset(VkDevice device)
+  {
     vkResetFences(device, 1, framesSync.at(frameIndex).inFlight.ptr());
   }
+
+  void waitAndReset(VkDevice device, uint64_t time = UINT64_MAX)
+  {
+    wait(device, time);
+    reset(device);
+  }
+
+  /**
+   * @brief Record that the current slot was submitted with the current
+   * serial, the next frame gets a new one
+   */
+  void markSubmitted() { submittedSerials.at(frameIndex) = currentSerial++; }
+
+  /** @brief Serial of the frame being recorded */
+  uint64_t getCurrentSerial() const { return currentSerial; }
+
+  /** @brief Highest serial known to have completed on the GPU */
+  uint64_t getCompletedSerial() const { return completedSerial; }
+
   void waitAll(VkDevice device)
   {
     for (auto &f : framesSync) {
@@ -129,6 +174,7 @@ class FrameSyncArray {
       // vkWaitSemaphores(device,f.renderEnd,nullptr,UINT64_MAX);
       vkWaitForFences(device, 1u, f.inFlight.ptr(), VK_TRUE, UINT64_MAX);
     }
+    completedSerial = currentSerial - 1;
   }
 };
 
@@ -0,0 +1,46 @@
+#ifndef TEST_TEMP_DIR_HPP
+#define TEST_TEMP_DIR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// Fresh directory per test, removed on scope exit
+struct TempDir {
+    std::filesystem::path path;
+
+    TempDir() {
+        // The counter tells apart directories made within one clock tick
+        static std::atomic<uint64_t> made{0};
+        path = std::filesystem::temp_directory_path() /
+               ("abox-test-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "-" +
+                std::to_string(made.fetch_add(1)));
+        std::filesystem::create_directories(path);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    // Writes name under the directory, creating its parents
+    void write(const std::filesystem::path& name, const std::string& content) const {
+        std::filesystem::create_directories((path / name).parent_path());
+        std::ofstream(path / name) << content;
+    }
+};
+
+// words of SPIR-V that only has a valid magic number, the rest set to seed
+inline std::vector<uint32_t> fakeSpirv(uint32_t words, uint32_t seed) {
+    std::vector<uint32_t> code(words, seed);
+    code[0] = 0x07230203;
+    return code;
+}
+
+#endif // TEST_TEMP_DIR_HPP
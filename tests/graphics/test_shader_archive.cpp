@@ -0,0 +1,109 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ShaderArchive.hpp>
+#include <TestTempDir.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("ShaderArchive: Round trip", "[graphics][shader_archive]") {
+    TempDir dir;
+    const fs::path path = dir.path / "shaders.absa";
+    const std::vector<uint32_t> vert = fakeSpirv(7, 1);
+    const std::vector<uint32_t> frag = fakeSpirv(12, 2);
+    const std::vector<std::byte> blob{std::byte{1}, std::byte{2}, std::byte{3}};
+
+    ShaderArchiveWriter writer;
+    REQUIRE(writer.add("shader.vert", 0x1, vert));
+    REQUIRE(writer.add("a.frag", 0x10, frag, blob));
+    REQUIRE_FALSE(writer.add("shader.vert", 0x1, vert));
+    REQUIRE_FALSE(writer.add("", 0x1, vert));
+    REQUIRE(writer.size() == 2);
+    REQUIRE(writer.write(path));
+
+    ShaderArchive archive(path);
+    REQUIRE(archive.isValid());
+
+    SECTION("Index is sorted by name") {
+        REQUIRE(archive.entries().size() == 2);
+        REQUIRE(archive.name(archive.entries()[0]) == "a.frag");
+        REQUIRE(archive.name(archive.entries()[1]) == "shader.vert");
+    }
+
+    SECTION("Lookup returns the code in place, aligned") {
+        const ShaderArchiveEntry *entry = archive.find("shader.vert");
+        REQUIRE(entry != nullptr);
+        REQUIRE(entry->stage == 0x1);
+        REQUIRE(std::ranges::equal(archive.code(*entry), vert));
+        REQUIRE(reinterpret_cast<uintptr_t>(archive.code(*entry).data()) % 4 == 0);
+        REQUIRE(archive.reflection(*entry).empty());
+        REQUIRE(entry->hash == ABox::Hasher().update(vert.data(), vert.size() * sizeof(uint32_t)).digest());
+
+        const ShaderArchiveEntry *other = archive.find("a.frag");
+        REQUIRE(other != nullptr);
+        REQUIRE(std::ranges::equal(archive.code(*other), frag));
+        REQUIRE(std::ranges::equal(archive.reflection(*other), blob));
+        REQUIRE(archive.find("missing.comp") == nullptr);
+    }
+}
+
+TEST_CASE("ShaderArchive: Rejects bad files", "[graphics][shader_archive]") {
+    TempDir dir;
+    const fs::path path = dir.path / "shaders.absa";
+    ShaderArchiveWriter writer;
+    REQUIRE(writer.add("shader.vert", 0x1, fakeSpirv(8, 3)));
+    REQUIRE(writer.write(path));
+
+    SECTION("Missing file") {
+        ShaderArchive archive(dir.path / "absent.absa");
+        REQUIRE_FALSE(archive.isValid());
+        REQUIRE(archive.entries().empty());
+    }
+
+    SECTION("Truncated") {
+        fs::resize_file(path, fs::file_size(path) - 4);
+        ShaderArchive archive(path);
+        REQUIRE_FALSE(archive.isValid());
+    }
+
+    SECTION("Wrong magic") {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.write("XXXX", 4);
+        file.close();
+        ShaderArchive archive(path);
+        REQUIRE_FALSE(archive.isValid());
+    }
+
+    SECTION("Corrupted code") {
+        uint64_t codeOffset = 0;
+        {
+            ShaderArchive archive(path);
+            REQUIRE(archive.isValid());
+            codeOffset = archive.entries()[0].codeOffset;
+        }
+        // In bounds, only the hash tells
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(codeOffset + 4));
+        const uint32_t flipped = 0xdeadbeef;
+        file.write(reinterpret_cast<const char*>(&flipped), sizeof(flipped));
+        file.close();
+        // Opening reads no code, the first code() call checks the hash
+        ShaderArchive archive(path);
+        REQUIRE(archive.isValid());
+        const ShaderArchiveEntry *entry = archive.find("shader.vert");
+        REQUIRE(entry != nullptr);
+        REQUIRE(archive.code(*entry).empty());
+        REQUIRE(archive.code(*entry).empty());
+    }
+
+    SECTION("Empty archive is valid") {
+        ShaderArchiveWriter empty;
+        REQUIRE(empty.write(path));
+        ShaderArchive archive(path);
+        REQUIRE(archive.isValid());
+        REQUIRE(archive.entries().empty());
+        REQUIRE(archive.find("shader.vert") == nullptr);
+    }
+}
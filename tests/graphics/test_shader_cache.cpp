@@ -0,0 +1,132 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ShaderCache.hpp>
+#include <TestTempDir.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static ABox::Hash128 keyOf(uint64_t value) {
+    return ABox::Hasher().update(value).digest();
+}
+
+TEST_CASE("ShaderCache: Store and load", "[graphics][shader_cache]") {
+    TempDir dir;
+    ShaderCache cache(dir.path);
+    REQUIRE(cache.isValid());
+
+    SECTION("Miss then hit") {
+        REQUIRE_FALSE(cache.load(keyOf(1)).has_value());
+        REQUIRE(cache.getMisses() == 1);
+
+        std::vector<uint32_t> code = fakeSpirv(64, 7);
+        REQUIRE(cache.store(keyOf(1), code));
+
+        std::optional<MappedSpirv> hit = cache.load(keyOf(1));
+        REQUIRE(hit.has_value());
+        REQUIRE(std::vector<uint32_t>(hit->code().begin(), hit->code().end()) == code);
+        REQUIRE(cache.getHits() == 1);
+    }
+
+    SECTION("Entries survive the cache object") {
+        cache.store(keyOf(2), fakeSpirv(16, 2));
+        ShaderCache reopened(dir.path);
+        REQUIRE(reopened.load(keyOf(2)).has_value());
+    }
+
+    SECTION("Overwriting a key is harmless") {
+        REQUIRE(cache.store(keyOf(3), fakeSpirv(16, 3)));
+        REQUIRE(cache.store(keyOf(3), fakeSpirv(16, 3)));
+        REQUIRE(cache.load(keyOf(3)).has_value());
+    }
+
+    SECTION("Corrupted entries are removed") {
+        std::ofstream(dir.path / (keyOf(4).toHex() + ".spv"), std::ios::binary) << "not spirv at all";
+        REQUIRE_FALSE(cache.load(keyOf(4)).has_value());
+        REQUIRE_FALSE(fs::exists(dir.path / (keyOf(4).toHex() + ".spv")));
+    }
+
+    SECTION("No temporary file is left behind") {
+        cache.store(keyOf(5), fakeSpirv(16, 5));
+        size_t files = 0;
+        for (const auto& entry : fs::directory_iterator(dir.path)) {
+            REQUIRE(entry.path().extension() == ".spv");
+            files++;
+        }
+        REQUIRE(files == 1);
+    }
+}
+
+TEST_CASE("ShaderCache: Size bounded eviction", "[graphics][shader_cache]") {
+    TempDir dir;
+    // Room for 4 entries of 1 KiB
+    ShaderCache cache(dir.path, 4 * 1024);
+
+    for (uint64_t i = 0; i < 4; ++i) {
+        REQUIRE(cache.store(keyOf(100 + i), fakeSpirv(256, static_cast<uint32_t>(i))));
+    }
+    // Make entry 100 the oldest and entry 101 recently used
+    fs::last_write_time(dir.path / (keyOf(100).toHex() + ".spv"), fs::file_time_type::clock::now() - std::chrono::hours(2));
+    fs::last_write_time(dir.path / (keyOf(101).toHex() + ".spv"), fs::file_time_type::clock::now() - std::chrono::hours(1));
+    REQUIRE(cache.load(keyOf(101)).has_value());
+
+    // Over budget: trimmed to 3/4 of it, least recently used first
+    REQUIRE(cache.store(keyOf(104), fakeSpirv(256, 4)));
+
+    REQUIRE_FALSE(cache.load(keyOf(100)).has_value());
+    REQUIRE(cache.load(keyOf(101)).has_value());
+    REQUIRE(cache.load(keyOf(104)).has_value());
+
+    uint64_t total = 0;
+    for (const auto& entry : fs::directory_iterator(dir.path)) {
+        total += entry.file_size();
+    }
+    REQUIRE(total <= 3 * 1024);
+}
+
+TEST_CASE("ShaderCache: Entries on disk count toward the budget", "[graphics][shader_cache]") {
+    TempDir dir;
+    {
+        ShaderCache previous(dir.path);
+        for (uint64_t i = 0; i < 4; ++i) {
+            REQUIRE(previous.store(keyOf(200 + i), fakeSpirv(256, static_cast<uint32_t>(i))));
+        }
+    }
+    fs::last_write_time(dir.path / (keyOf(200).toHex() + ".spv"), fs::file_time_type::clock::now() - std::chrono::hours(1));
+
+    // Opened full: the scan on open seeds the running total
+    ShaderCache cache(dir.path, 4 * 1024);
+    REQUIRE(cache.load(keyOf(200 + 1)).has_value());
+    REQUIRE(cache.store(keyOf(204), fakeSpirv(256, 4)));
+    REQUIRE_FALSE(cache.load(keyOf(200)).has_value());
+    REQUIRE(cache.load(keyOf(204)).has_value());
+
+    // Back under budget: stores do not rescan until it is exceeded again
+    REQUIRE(cache.evict() == 0);
+}
+
+TEST_CASE("ShaderCache: Concurrent writers", "[graphics][shader_cache]") {
+    TempDir dir;
+    ShaderCache cache(dir.path);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache] {
+            for (uint64_t i = 0; i < 20; ++i) {
+                cache.store(keyOf(i), fakeSpirv(32, static_cast<uint32_t>(i)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (uint64_t i = 0; i < 20; ++i) {
+        std::optional<MappedSpirv> hit = cache.load(keyOf(i));
+        REQUIRE(hit.has_value());
+        REQUIRE(hit->code()[1] == i);
+    }
+}
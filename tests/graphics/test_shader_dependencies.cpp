@@ -0,0 +1,87 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ShaderIncludes.hpp>
+#include <TestTempDir.hpp>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("ShaderDependencies: Includes are collected transitively", "[graphics][shader_includes]") {
+    TempDir dir;
+    dir.write("common/light.glsl", "#include \"math.glsl\"\n");
+    dir.write("common/math.glsl", "float sq(float x) { return x * x; }\n");
+    dir.write("lit.frag", "#version 450\n#include \"common/light.glsl\"\n");
+
+    std::vector<ShaderInclude> includes = collectShaderIncludes("#include \"common/light.glsl\"\n", dir.path);
+
+    REQUIRE(includes.size() == 2);
+    REQUIRE(includes[0].path == (dir.path / "common/light.glsl").lexically_normal());
+    REQUIRE(includes[1].path == (dir.path / "common/math.glsl").lexically_normal());
+}
+
+TEST_CASE("ShaderDependencies: Includes resolve like the compiler", "[graphics][shader_includes]") {
+    TempDir dir;
+    dir.write("math.glsl", "float sq(float x) { return x * x; }\n");
+    dir.write("common/math.glsl", "float cube(float x) { return x * x * x; }\n");
+    dir.write("common/light.glsl", "#include \"math.glsl\"\n#include <math.glsl>\n");
+
+    SECTION("Quotes look next to the including file, brackets next to the shader") {
+        REQUIRE(resolveShaderInclude("math.glsl", true, dir.path / "common", dir.path, {}) == (dir.path / "common/math.glsl").lexically_normal());
+        REQUIRE(resolveShaderInclude("math.glsl", false, dir.path / "common", dir.path, {}) == (dir.path / "math.glsl").lexically_normal());
+        REQUIRE(resolveShaderInclude("light.glsl", false, dir.path, dir.path, {dir.path / "common"}) == (dir.path / "common/light.glsl").lexically_normal());
+        REQUIRE(resolveShaderInclude("missing.glsl", true, dir.path, dir.path, {}).empty());
+    }
+
+    SECTION("Nested bracket includes are found in the shader's directory") {
+        std::vector<ShaderInclude> includes = collectShaderIncludes("#include \"common/light.glsl\"\n", dir.path);
+
+        REQUIRE(includes.size() == 3);
+        REQUIRE(includes[0].path == (dir.path / "common/light.glsl").lexically_normal());
+        REQUIRE(includes[1].path == (dir.path / "common/math.glsl").lexically_normal());
+        REQUIRE(includes[2].path == (dir.path / "math.glsl").lexically_normal());
+    }
+}
+
+TEST_CASE("ShaderDependencies: Affected shaders", "[graphics][shader_includes]") {
+    TempDir dir;
+    dir.write("common/light.glsl", "#include \"math.glsl\"\n");
+    dir.write("common/math.glsl", "float sq(float x) { return x * x; }\n");
+    dir.write("common/noise.glsl", "float noise() { return 0.0; }\n");
+
+    const fs::path lit   = dir.path / "lit.frag";
+    const fs::path flat  = dir.path / "flat.frag";
+    const fs::path water = dir.path / "water.vert";
+
+    ShaderDependencyGraph graph;
+    graph.setIncludes(lit, collectShaderIncludes("#include \"common/light.glsl\"\n", dir.path));
+    graph.setIncludes(flat, {});
+    graph.setIncludes(water, collectShaderIncludes("#include \"common/noise.glsl\"\n#include \"common/math.glsl\"\n", dir.path));
+
+    SECTION("A shader change only rebuilds that shader") {
+        REQUIRE(graph.affected({flat}) == std::set<fs::path>{flat});
+    }
+
+    SECTION("An include change rebuilds its direct and indirect users") {
+        REQUIRE(graph.affected({dir.path / "common/math.glsl"}) == std::set<fs::path>{lit, water});
+        REQUIRE(graph.affected({dir.path / "common/noise.glsl"}) == std::set<fs::path>{water});
+    }
+
+    SECTION("Paths are compared normalized") {
+        REQUIRE(graph.affected({dir.path / "common/../common/light.glsl"}) == std::set<fs::path>{lit});
+    }
+
+    SECTION("Unrelated files rebuild nothing") {
+        REQUIRE(graph.affected({dir.path / "README.md"}).empty());
+    }
+
+    SECTION("Replacing the includes drops stale edges") {
+        graph.setIncludes(water, {});
+        REQUIRE(graph.affected({dir.path / "common/noise.glsl"}).empty());
+        REQUIRE(graph.affected({dir.path / "common/math.glsl"}) == std::set<fs::path>{lit});
+    }
+
+    SECTION("Watched directories") {
+        std::set<fs::path> dirs = graph.directories();
+        REQUIRE(dirs.contains(dir.path));
+        REQUIRE(dirs.contains(dir.path / "common"));
+    }
+}
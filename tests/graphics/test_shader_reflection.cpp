@@ -0,0 +1,195 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ShaderCache.hpp>
+#include <ShaderReflection.hpp>
+#include <TestTempDir.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static ShaderReflectionData sampleReflection() {
+    ShaderReflectionData data;
+    data.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    data.descriptorBindings = {
+        {.set = 0, .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .count = 1},
+        {.set = 2, .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .count = 4},
+    };
+    data.pushConstants = {{.offset = 0, .size = 64}};
+    data.names = "fragColorinUVuseFog";
+    data.outputVariables = {
+        {.location = 0, .format = SPV_REFLECT_FORMAT_R32G32B32A32_SFLOAT,
+         .builtIn = static_cast<SpvBuiltIn>(-1), .nameOffset = 0, .nameSize = 9},
+    };
+    data.inputVariables = {
+        {.location = 1, .format = SPV_REFLECT_FORMAT_R32G32_SFLOAT,
+         .builtIn = static_cast<SpvBuiltIn>(-1), .nameOffset = 9, .nameSize = 4},
+        {.location = REFLECTION_NO_LOCATION, .format = SPV_REFLECT_FORMAT_R32G32B32A32_SFLOAT,
+         .builtIn = SpvBuiltInPosition, .nameOffset = 13, .nameSize = 0},
+    };
+    data.specializationConstants = {
+        {.defaultValue = 1, .constantId = 0, .kind = SpecializationKind::Bool, .size = 4,
+         .nameOffset = 13, .nameSize = 6, .reserved = 0},
+        {.defaultValue = 0x3FF0000000000000ull, .constantId = 3, .kind = SpecializationKind::Float, .size = 8,
+         .nameOffset = 19, .nameSize = 0, .reserved = 0},
+    };
+    return data;
+}
+
+static void requireSame(const ShaderReflectionData &a, const ShaderReflectionData &b) {
+    REQUIRE(a.stage == b.stage);
+    REQUIRE(a.names == b.names);
+    REQUIRE(a.descriptorBindings.size() == b.descriptorBindings.size());
+    for (size_t i = 0; i < a.descriptorBindings.size(); ++i) {
+        REQUIRE(a.descriptorBindings[i].set == b.descriptorBindings[i].set);
+        REQUIRE(a.descriptorBindings[i].binding == b.descriptorBindings[i].binding);
+        REQUIRE(a.descriptorBindings[i].descriptorType == b.descriptorBindings[i].descriptorType);
+        REQUIRE(a.descriptorBindings[i].count == b.descriptorBindings[i].count);
+    }
+    REQUIRE(a.pushConstants.size() == b.pushConstants.size());
+    REQUIRE(a.inputVariables.size() == b.inputVariables.size());
+    for (size_t i = 0; i < a.inputVariables.size(); ++i) {
+        REQUIRE(a.inputVariables[i].location == b.inputVariables[i].location);
+        REQUIRE(a.inputVariables[i].format == b.inputVariables[i].format);
+        REQUIRE(a.inputVariables[i].builtIn == b.inputVariables[i].builtIn);
+        REQUIRE(a.nameOf(a.inputVariables[i]) == b.nameOf(b.inputVariables[i]));
+    }
+    REQUIRE(a.outputVariables.size() == b.outputVariables.size());
+    REQUIRE(a.specializationConstants.size() == b.specializationConstants.size());
+    for (size_t i = 0; i < a.specializationConstants.size(); ++i) {
+        REQUIRE(a.specializationConstants[i].constantId == b.specializationConstants[i].constantId);
+        REQUIRE(a.specializationConstants[i].kind == b.specializationConstants[i].kind);
+        REQUIRE(a.specializationConstants[i].size == b.specializationConstants[i].size);
+        REQUIRE(a.specializationConstants[i].defaultValue == b.specializationConstants[i].defaultValue);
+        REQUIRE(a.nameOf(a.specializationConstants[i]) == b.nameOf(b.specializationConstants[i]));
+    }
+}
+
+TEST_CASE("ShaderReflection: Accessors", "[graphics][shader_reflection]") {
+    const ShaderReflectionData data = sampleReflection();
+
+    REQUIRE(data.descriptorSetCount() == 3);
+    REQUIRE(ShaderReflectionData{}.descriptorSetCount() == 0);
+    REQUIRE(data.nameOf(data.outputVariables[0]) == "fragColor");
+    REQUIRE(data.nameOf(data.inputVariables[0]) == "inUV");
+    REQUIRE(data.nameOf(data.inputVariables[1]).empty());
+    REQUIRE(data.nameOf(data.specializationConstants[0]) == "useFog");
+    REQUIRE(data.findSpecializationConstant(3) == &data.specializationConstants[1]);
+    REQUIRE(data.findSpecializationConstant(1) == nullptr);
+}
+
+TEST_CASE("ShaderReflection: Serialization", "[graphics][shader_reflection]") {
+    const ShaderReflectionData data = sampleReflection();
+    std::vector<std::byte> blob = serializeReflection(data);
+
+    SECTION("Round trip") {
+        const auto restored = deserializeReflection(blob);
+        REQUIRE(restored.has_value());
+        requireSame(data, *restored);
+    }
+
+    SECTION("Empty reflection round trips") {
+        const auto restored = deserializeReflection(serializeReflection(ShaderReflectionData{}));
+        REQUIRE(restored.has_value());
+        REQUIRE(restored->descriptorBindings.empty());
+        REQUIRE(restored->names.empty());
+    }
+
+    SECTION("Truncated blobs are rejected") {
+        for (size_t size : {size_t(0), size_t(4), blob.size() / 2, blob.size() - 1}) {
+            REQUIRE_FALSE(deserializeReflection(std::span(blob).first(size)).has_value());
+        }
+    }
+
+    SECTION("Trailing bytes are rejected") {
+        blob.push_back(std::byte{0});
+        REQUIRE_FALSE(deserializeReflection(blob).has_value());
+    }
+
+    SECTION("Other versions are rejected") {
+        blob[4] = std::byte{0xFF};
+        REQUIRE_FALSE(deserializeReflection(blob).has_value());
+    }
+
+    SECTION("Names outside the pool are rejected") {
+        ShaderReflectionData broken = data;
+        broken.inputVariables[0].nameOffset = 100;
+        REQUIRE_FALSE(deserializeReflection(serializeReflection(broken)).has_value());
+        broken = data;
+        broken.specializationConstants[0].nameSize = 100;
+        REQUIRE_FALSE(deserializeReflection(serializeReflection(broken)).has_value());
+    }
+}
+
+TEST_CASE("ShaderReflection: Specialization constants from SPIR-V", "[graphics][shader_reflection]") {
+    // layout(constant_id = 7) const uint wg = 64;
+    // layout(constant_id = 2) const bool <unnamed> = true;
+    // plus a double spec constant without SpecId, which is not specializable
+    const std::vector<uint32_t> code{
+        SPIRV_MAGIC_NUMBER, 0x00010000, 0, 8, 0,
+        (3u << 16) | 5, 3, 'w' | ('g' << 8),    // OpName %3 "wg"
+        (4u << 16) | 71, 3, 1, 7,               // OpDecorate %3 SpecId 7
+        (4u << 16) | 71, 5, 1, 2,               // OpDecorate %5 SpecId 2
+        (4u << 16) | 21, 1, 32, 0,              // %1 = OpTypeInt 32 0
+        (2u << 16) | 20, 2,                     // %2 = OpTypeBool
+        (3u << 16) | 22, 4, 64,                 // %4 = OpTypeFloat 64
+        (4u << 16) | 50, 1, 3, 64,              // %3 = OpSpecConstant %1 64
+        (3u << 16) | 48, 2, 5,                  // %5 = OpSpecConstantTrue %2
+        (5u << 16) | 50, 4, 6, 0, 0x3FF80000,   // %6 = OpSpecConstant %4 1.5
+    };
+
+    std::string names;
+    const auto constants = reflectSpecializationConstants(code, names);
+    REQUIRE(constants.size() == 2);
+    REQUIRE(constants[0].constantId == 2);
+    REQUIRE(constants[0].kind == SpecializationKind::Bool);
+    REQUIRE(constants[0].size == 4);
+    REQUIRE(constants[0].defaultValue == 1);
+    REQUIRE(constants[0].nameSize == 0);
+    REQUIRE(constants[1].constantId == 7);
+    REQUIRE(constants[1].kind == SpecializationKind::UInt);
+    REQUIRE(constants[1].size == 4);
+    REQUIRE(constants[1].defaultValue == 64);
+    REQUIRE(names.substr(constants[1].nameOffset, constants[1].nameSize) == "wg");
+
+    REQUIRE(specializationTypeName(SpecializationKind::Bool, 4) == "bool");
+    REQUIRE(specializationTypeName(SpecializationKind::Float, 8) == "float64");
+
+    SECTION("Malformed modules give nothing") {
+        std::vector<uint32_t> truncated = code;
+        truncated.pop_back();
+        REQUIRE(reflectSpecializationConstants(truncated, names).empty());
+        REQUIRE(reflectSpecializationConstants(std::span(code).first(3), names).empty());
+    }
+}
+
+TEST_CASE("ShaderReflection: Cache key", "[graphics][shader_reflection]") {
+    const std::vector<uint32_t> a{SPIRV_MAGIC_NUMBER, 1, 2, 3};
+    const std::vector<uint32_t> b{SPIRV_MAGIC_NUMBER, 1, 2, 4};
+
+    REQUIRE(reflectionCacheKey(a) == reflectionCacheKey(a));
+    REQUIRE_FALSE(reflectionCacheKey(a) == reflectionCacheKey(b));
+}
+
+TEST_CASE("ShaderReflection: Stored in the shader cache", "[graphics][shader_reflection]") {
+    TempDir dir;
+    ShaderCache cache(dir.path);
+    REQUIRE(cache.isValid());
+
+    const std::vector<uint32_t> code{SPIRV_MAGIC_NUMBER, 7, 7, 7};
+    const ABox::Hash128 key = reflectionCacheKey(code);
+    const std::vector<std::byte> blob = serializeReflection(sampleReflection());
+
+    REQUIRE_FALSE(cache.loadReflection(key).has_value());
+    REQUIRE(cache.storeReflection(key, blob));
+
+    const auto loaded = cache.loadReflection(key);
+    REQUIRE(loaded.has_value());
+    REQUIRE(*loaded == blob);
+    REQUIRE(fs::exists(dir.path / (key.toHex() + ".refl")));
+
+    // Reflection lookups stay out of the SPIR-V statistics
+    REQUIRE(cache.getHits() == 0);
+    REQUIRE(cache.getMisses() == 0);
+    REQUIRE(cache.getStores() == 0);
+}
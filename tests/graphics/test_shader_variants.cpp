@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ShaderHandler.hpp>
+#include <ShaderVariant.hpp>
+#include <TestTempDir.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const std::string FILL_SHADER = R"(#version 450
+layout(local_size_x = 1) in;
+layout(set = 0, binding = 0) buffer Out { uint value; };
+void main() {
+#ifdef FILL_VALUE
+    value = FILL_VALUE;
+#else
+    value = 0u;
+#endif
+}
+)";
+
+TEST_CASE("ShaderVariant: Keys are canonical", "[graphics][shader_variant]") {
+    const ShaderVariantKey a{{"SKINNING", "1"}, {"SHADOWS", "2"}};
+    ShaderVariantKey b;
+    b.define("SHADOWS", "2").define("SKINNING");
+
+    REQUIRE(a == b);
+    REQUIRE(a.getHash() == b.getHash());
+    REQUIRE(a.toString() == "SHADOWS=2,SKINNING=1");
+    REQUIRE(a.preamble() == "#define SHADOWS 2\n#define SKINNING 1\n");
+
+    SECTION("Redefining replaces the value") {
+        b.define("SHADOWS", "3");
+        REQUIRE(b.getDefines().size() == 2);
+        REQUIRE_FALSE(a == b);
+        REQUIRE_FALSE(a.getHash() == b.getHash());
+    }
+
+    SECTION("Empty key is the base shader") {
+        REQUIRE(ShaderVariantKey{}.empty());
+        REQUIRE(ShaderVariantKey{}.toString().empty());
+        REQUIRE(ShaderVariantKey{}.getHash() == ABox::Hash128{});
+    }
+
+    SECTION("Invalid defines are rejected") {
+        REQUIRE_THROWS_AS(ShaderVariantKey().define("2X"), std::invalid_argument);
+        REQUIRE_THROWS_AS(ShaderVariantKey().define(""), std::invalid_argument);
+        REQUIRE_THROWS_AS(ShaderVariantKey().define("A B"), std::invalid_argument);
+        REQUIRE_THROWS_AS(ShaderVariantKey().define("A", "1\n#define B"), std::invalid_argument);
+    }
+}
+
+TEST_CASE("ShaderVariant: Permutations", "[graphics][shader_variant]") {
+    const std::vector<ShaderVariantAxis> axes{
+        {"SKINNING", {"", "1"}},
+        {"SHADOW_QUALITY", {"0", "1", "2"}},
+        {"MSAA", {}},
+    };
+    const std::vector<ShaderVariantKey> keys = shaderVariantPermutations(axes);
+
+    REQUIRE(keys.size() == 6);
+    REQUIRE(keys[0].toString() == "SHADOW_QUALITY=0");
+    REQUIRE(keys[5].toString() == "SHADOW_QUALITY=2,SKINNING=1");
+    for (size_t i = 0; i < keys.size(); ++i) {
+        for (size_t j = i + 1; j < keys.size(); ++j) {
+            REQUIRE_FALSE(keys[i].getHash() == keys[j].getHash());
+        }
+    }
+    REQUIRE(shaderVariantPermutations({}).size() == 1);
+}
+
+TEST_CASE("ShaderVariant: Compiled through the handler", "[graphics][shader_variant]") {
+    TempDir dir;
+    dir.write("shaders/fill.comp", FILL_SHADER);
+    ShaderHandler shaders;
+    shaders.setCache(std::make_unique<ShaderCache>(dir.path / "cache"));
+    REQUIRE(shaders.loadShaderDataFromFolder(dir.path / "shaders") == 1);
+    const ShaderDataFile *base = shaders.getShader("fill.comp");
+    REQUIRE(base != nullptr);
+
+    SECTION("Lazy compilation, then lookups") {
+        const ShaderVariantKey two{{"FILL_VALUE", "2u"}};
+        const ShaderDataFile *variant = shaders.getShaderVariant("fill.comp", two);
+        REQUIRE(variant != nullptr);
+        REQUIRE(variant->getName() == "fill.comp[FILL_VALUE=2u]");
+        REQUIRE(variant->getStage() == VK_SHADER_STAGE_COMPUTE_BIT);
+        REQUIRE_FALSE(std::ranges::equal(variant->getCode(), base->getCode()));
+        REQUIRE(shaders.getShaderVariant("fill.comp", two) == variant);
+        REQUIRE(shaders.getShaderVariant("fill.comp", {}) == base);
+    }
+
+    SECTION("Identical SPIR-V is shared") {
+        const ShaderDataFile *a = shaders.getShaderVariant("fill.comp", {{"UNUSED_A"}});
+        const ShaderDataFile *b = shaders.getShaderVariant("fill.comp", {{"UNUSED_B"}});
+        REQUIRE(a != nullptr);
+        REQUIRE(a == b);
+        REQUIRE(shaders.getVariantModuleCount() == 1);
+    }
+
+    SECTION("Ahead of time compilation") {
+        const std::vector<ShaderVariantKey> keys =
+            shaderVariantPermutations(std::vector<ShaderVariantAxis>{{"FILL_VALUE", {"1u", "2u", "3u"}}});
+        REQUIRE(shaders.prepareShaderVariants("fill.comp", keys) == 3);
+        REQUIRE(shaders.prepareShaderVariants("fill.comp", keys) == 0);
+        REQUIRE(shaders.waitForShaders().failures.empty());
+        REQUIRE(shaders.getVariantModuleCount() == 3);
+        REQUIRE(shaders.getShaderVariant("fill.comp", keys[2]) != nullptr);
+    }
+
+    SECTION("Variants go through the SPIR-V cache") {
+        const ShaderVariantKey one{{"FILL_VALUE", "1u"}};
+        REQUIRE(shaders.getShaderVariant("fill.comp", one) != nullptr);
+        const uint64_t stores = shaders.getCache()->getStores();
+        REQUIRE(stores >= 2);
+
+        ShaderHandler warm;
+        warm.setCache(std::make_unique<ShaderCache>(dir.path / "cache"));
+        REQUIRE(warm.loadShaderDataFromFolder(dir.path / "shaders") == 1);
+        REQUIRE(warm.getShaderVariant("fill.comp", one) != nullptr);
+        REQUIRE(warm.getCache()->getHits() == 2);
+        REQUIRE(warm.getCache()->getStores() == 0);
+    }
+
+    SECTION("Failures are not cached") {
+        const ShaderVariantKey broken{{"FILL_VALUE", "not_a_value"}};
+        REQUIRE(shaders.getShaderVariant("fill.comp", broken) == nullptr);
+        REQUIRE(shaders.getShaderVariant("fill.comp", broken) == nullptr);
+        REQUIRE(shaders.prepareShaderVariants("fill.comp", std::span(&broken, 1)) == 1);
+        REQUIRE(shaders.getShaderVariant("fill.comp", broken) == nullptr);
+        REQUIRE(shaders.getShaderVariant("missing.comp", {{"FILL_VALUE", "1u"}}) == nullptr);
+    }
+}
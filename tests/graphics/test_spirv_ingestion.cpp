@@ -0,0 +1,79 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ShaderHandler.hpp>
+#include <TestTempDir.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <spirv-tools/libspirv.hpp>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const std::string COMPUTE_SHADER = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint GLCompute %main "main"
+               OpExecutionMode %main LocalSize 1 1 1
+       %void = OpTypeVoid
+         %fn = OpTypeFunction %void
+       %main = OpFunction %void None %fn
+      %entry = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+static std::vector<uint32_t> assemble(const std::string &text) {
+    std::vector<uint32_t> binary;
+    spvtools::SpirvTools tools(SPV_ENV_VULKAN_1_3);
+    REQUIRE(tools.Assemble(text, &binary));
+    return binary;
+}
+
+static void writeFile(const fs::path &path, const void *data, size_t size) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+}
+
+TEST_CASE("SpirvIngestion: Precompiled binaries", "[graphics][spirv_ingestion]") {
+    TempDir dir;
+    const std::vector<uint32_t> spirv = assemble(COMPUTE_SHADER);
+    const fs::path path = dir.path / "blur.spv";
+    writeFile(path, spirv.data(), spirv.size() * sizeof(uint32_t));
+
+    SECTION("Recognized as a shader file") {
+        REQUIRE(ShaderHandler::isShaderFile(path));
+        REQUIRE(ShaderHandler::isShaderFile("shader.vert"));
+        REQUIRE_FALSE(ShaderHandler::isShaderFile("notes.txt"));
+    }
+
+    SECTION("Stage comes from the entry point, code is mapped") {
+        ShaderCompileResult result = ShaderHandler::compileShaderFile(path, nullptr, SpirvOptimizerConfig{});
+        REQUIRE(result.status == VK_FILE_SUCCESS);
+        REQUIRE(result.stage != nullptr);
+        REQUIRE(std::get<VkShaderStageFlagBits>(*result.stage) == VK_SHADER_STAGE_COMPUTE_BIT);
+        REQUIRE(result.code.empty());
+        REQUIRE(result.backing);
+        REQUIRE(std::ranges::equal(result.mappedCode, spirv));
+    }
+
+    SECTION("ShaderDataFile references the mapping in place") {
+        ShaderCompileResult result = ShaderHandler::compileShaderFile(path, nullptr, SpirvOptimizerConfig{});
+        REQUIRE(result.backing);
+        const uint32_t *words = result.mappedCode.data();
+        ShaderDataFile shader("blur.spv", result.mappedCode, result.backing, result.stage, result.platform);
+        result.backing.reset(); // the ShaderDataFile keeps it alive
+        REQUIRE(shader.getCode().data() == words);
+        REQUIRE(shader.getStage() == VK_SHADER_STAGE_COMPUTE_BIT);
+        REQUIRE(static_cast<VkShaderModuleCreateInfo>(shader).codeSize == spirv.size() * sizeof(uint32_t));
+    }
+
+    SECTION("Not SPIR-V is rejected") {
+        const fs::path bogus = dir.path / "bogus.spv";
+        const std::string text = "definitely not a spir-v module";
+        writeFile(bogus, text.data(), text.size());
+        ShaderCompileResult result = ShaderHandler::compileShaderFile(bogus, nullptr, SpirvOptimizerConfig{});
+        REQUIRE(result.status == VK_FILE_NOT_A_SHADER);
+        REQUIRE_FALSE(result.backing);
+    }
+}
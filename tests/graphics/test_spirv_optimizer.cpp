@@ -0,0 +1,105 @@
+#include <catch2/catch_test_macros.hpp>
+#include <SpirvOptimizer.hpp>
+#include <algorithm>
+#include <spirv-tools/libspirv.hpp>
+#include <string>
+#include <vector>
+
+// Compute shader with a debug name and a dead store
+static const std::string DEAD_STORE_SHADER = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint GLCompute %main "main"
+               OpExecutionMode %main LocalSize 1 1 1
+               OpName %main "main"
+               OpName %unused "unused"
+       %void = OpTypeVoid
+         %fn = OpTypeFunction %void
+      %float = OpTypeFloat 32
+        %ptr = OpTypePointer Function %float
+    %float_1 = OpConstant %float 1
+       %main = OpFunction %void None %fn
+      %entry = OpLabel
+     %unused = OpVariable %ptr Function
+               OpStore %unused %float_1
+               OpReturn
+               OpFunctionEnd
+)";
+
+static std::vector<uint32_t> assemble(const std::string &text) {
+    std::vector<uint32_t> binary;
+    spvtools::SpirvTools tools(SPV_ENV_VULKAN_1_3);
+    REQUIRE(tools.Assemble(text, &binary));
+    return binary;
+}
+
+// OpName is opcode 5, instructions start after the 5 word header
+static bool hasOpName(const std::vector<uint32_t> &spirv) {
+    for (size_t i = 5; i < spirv.size(); i += spirv[i] >> 16) {
+        if ((spirv[i] & 0xFFFF) == 5) {
+            return true;
+        }
+        if ((spirv[i] >> 16) == 0) {
+            break;
+        }
+    }
+    return false;
+}
+
+TEST_CASE("SpirvOptimizer: Passes", "[graphics][spirv_optimizer]") {
+    const std::vector<uint32_t> original = assemble(DEAD_STORE_SHADER);
+    REQUIRE(hasOpName(original));
+
+    SECTION("Size passes remove dead code, stripping removes names") {
+        std::vector<uint32_t> spirv = original;
+        SpirvOptimizeStats stats;
+        SpirvOptimizerConfig config{.level = SpirvOptLevel::Size, .stripDebugInfo = true, .validate = true};
+        REQUIRE(optimizeSpirv(spirv, config, &stats));
+        REQUIRE(stats.wordsBefore == original.size());
+        REQUIRE(stats.wordsAfter == spirv.size());
+        REQUIRE(spirv.size() < original.size());
+        REQUIRE_FALSE(hasOpName(spirv));
+    }
+
+    SECTION("Debug info is kept unless stripping is requested") {
+        std::vector<uint32_t> spirv = original;
+        SpirvOptimizerConfig config{.level = SpirvOptLevel::Performance, .stripDebugInfo = false, .validate = false};
+        REQUIRE(optimizeSpirv(spirv, config));
+        REQUIRE(hasOpName(spirv));
+    }
+
+    SECTION("Validation only leaves the module untouched") {
+        std::vector<uint32_t> spirv = original;
+        SpirvOptimizerConfig config{.level = SpirvOptLevel::None, .stripDebugInfo = false, .validate = true};
+        REQUIRE(optimizeSpirv(spirv, config));
+        REQUIRE(spirv == original);
+    }
+}
+
+TEST_CASE("SpirvOptimizer: Invalid modules are rejected", "[graphics][spirv_optimizer]") {
+    std::vector<uint32_t> spirv = assemble(DEAD_STORE_SHADER);
+    spirv.resize(spirv.size() - 3); // truncated function
+    const std::vector<uint32_t> broken = spirv;
+
+    std::string errors;
+    SpirvOptimizerConfig config{.level = SpirvOptLevel::None, .stripDebugInfo = false, .validate = true};
+    REQUIRE_FALSE(optimizeSpirv(spirv, config, nullptr, &errors));
+    REQUIRE_FALSE(errors.empty());
+    REQUIRE(spirv == broken);
+}
+
+TEST_CASE("SpirvOptimizer: Configuration is part of the cache key", "[graphics][spirv_optimizer]") {
+    auto keyOf = [](const SpirvOptimizerConfig &config) {
+        ABox::Hasher hasher;
+        config.hash(hasher);
+        return hasher.digest();
+    };
+    SpirvOptimizerConfig a{.level = SpirvOptLevel::Performance, .stripDebugInfo = false, .validate = false};
+    SpirvOptimizerConfig b = a;
+    REQUIRE(keyOf(a) == keyOf(b));
+    b.stripDebugInfo = true;
+    REQUIRE_FALSE(keyOf(a) == keyOf(b));
+    b = a;
+    b.level = SpirvOptLevel::Size;
+    REQUIRE_FALSE(keyOf(a) == keyOf(b));
+}
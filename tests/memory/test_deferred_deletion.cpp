@@ -0,0 +1,175 @@
+#include <catch2/catch_test_macros.hpp>
+#include <DeferredDeletionQueue.hpp>
+#include <MemoryWrapper.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Mock types for testing (not real Vulkan handles)
+using MockHandle = void*;
+using MockDevice = void*;
+
+static std::vector<MockHandle> destroyed_handles;
+static std::atomic<int> deferred_solo_calls{0};
+
+void MockDeferredDestroy(MockDevice device, MockHandle handle, const VkAllocationCallbacks* /*allocator*/) {
+    if (device != VK_NULL_HANDLE && handle != VK_NULL_HANDLE) {
+        destroyed_handles.push_back(handle);
+    }
+}
+
+void MockDeferredDestroySolo(MockHandle handle, const VkAllocationCallbacks* /*allocator*/) {
+    if (handle != VK_NULL_HANDLE) {
+        deferred_solo_calls++;
+    }
+}
+
+using MockWrapper = MemoryWrapper<MockHandle, decltype(&MockDeferredDestroy), MockDevice>;
+
+static MockHandle mockHandle(uintptr_t value) {
+    return reinterpret_cast<MockHandle>(value);
+}
+
+static const MockDevice mock_device = reinterpret_cast<MockDevice>(0x5678);
+
+TEST_CASE("DeferredDeletionQueue: Destruction waits for the frame", "[memory][deferred]") {
+    destroyed_handles.clear();
+
+    SECTION("Retired handle survives until its serial completes") {
+        DeferredDeletionQueue queue;
+        queue.advance(5, 4);
+
+        MockWrapper wrapper(mockHandle(0x10), mock_device, MockDeferredDestroy);
+        wrapper.retire(queue);
+
+        REQUIRE(wrapper.get() == VK_NULL_HANDLE);
+        REQUIRE(queue.size() == 1);
+        REQUIRE(destroyed_handles.empty());
+
+        // Frame 5 still in flight
+        REQUIRE(queue.advance(6, 4) == 0);
+        REQUIRE(destroyed_handles.empty());
+
+        // Frame 5 done
+        REQUIRE(queue.advance(7, 5) == 1);
+        REQUIRE(destroyed_handles == std::vector<MockHandle>{mockHandle(0x10)});
+        REQUIRE(queue.size() == 0);
+    }
+
+    SECTION("Handles from successive frames are released in order") {
+        DeferredDeletionQueue queue;
+        MockWrapper a(mockHandle(0x1), mock_device, MockDeferredDestroy);
+        MockWrapper b(mockHandle(0x2), mock_device, MockDeferredDestroy);
+        MockWrapper c(mockHandle(0x3), mock_device, MockDeferredDestroy);
+
+        queue.advance(1, 0);
+        a.retire(queue);
+        queue.advance(2, 0);
+        b.retire(queue);
+        queue.advance(3, 0);
+        c.retire(queue);
+
+        REQUIRE(queue.collect(2) == 2);
+        REQUIRE(destroyed_handles == std::vector<MockHandle>{mockHandle(0x1), mockHandle(0x2)});
+        REQUIRE(queue.collect(3) == 1);
+        REQUIRE(destroyed_handles.size() == 3);
+    }
+
+    SECTION("Completed serial never moves backwards") {
+        DeferredDeletionQueue queue;
+        queue.advance(10, 9);
+        queue.collect(3);
+
+        REQUIRE(queue.getCompletedSerial() == 9);
+        REQUIRE(queue.getRecordingSerial() == 10);
+    }
+}
+
+TEST_CASE("DeferredDeletionQueue: swap and flush", "[memory][deferred]") {
+    destroyed_handles.clear();
+
+    SECTION("swap with a queue defers the previous handle") {
+        DeferredDeletionQueue queue;
+        queue.advance(1, 0);
+        {
+            MockWrapper wrapper(mockHandle(0x20), mock_device, MockDeferredDestroy);
+            wrapper.swap(mockHandle(0x21), queue);
+
+            REQUIRE(wrapper.get() == mockHandle(0x21));
+            REQUIRE(destroyed_handles.empty());
+        }
+        // Wrapper destructor destroys the new handle immediately
+        REQUIRE(destroyed_handles == std::vector<MockHandle>{mockHandle(0x21)});
+
+        queue.collect(1);
+        REQUIRE(destroyed_handles.back() == mockHandle(0x20));
+    }
+
+    SECTION("Retiring an empty wrapper queues nothing") {
+        DeferredDeletionQueue queue;
+        MockWrapper wrapper(VK_NULL_HANDLE, mock_device, MockDeferredDestroy);
+        wrapper.retire(queue);
+
+        REQUIRE(queue.size() == 0);
+    }
+
+    SECTION("Retiring with a null parent queues nothing") {
+        DeferredDeletionQueue queue;
+        MockWrapper wrapper(mockHandle(0x30), VK_NULL_HANDLE, MockDeferredDestroy);
+        wrapper.retire(queue);
+
+        REQUIRE(queue.size() == 0);
+        REQUIRE(wrapper.get() == VK_NULL_HANDLE);
+    }
+
+    SECTION("Solo wrappers go through the queue too") {
+        deferred_solo_calls = 0;
+        DeferredDeletionQueue queue;
+        MemoryWrapper<MockHandle, decltype(&MockDeferredDestroySolo)> wrapper(
+            mockHandle(0x40),
+            nullptr,
+            MockDeferredDestroySolo
+        );
+        wrapper.retire(queue);
+        REQUIRE(deferred_solo_calls == 0);
+
+        REQUIRE(queue.flush() == 1);
+        REQUIRE(deferred_solo_calls == 1);
+    }
+
+    SECTION("Destruction of the queue flushes pending handles") {
+        {
+            DeferredDeletionQueue queue;
+            MockWrapper wrapper(mockHandle(0x50), mock_device, MockDeferredDestroy);
+            wrapper.retire(queue);
+        }
+        REQUIRE(destroyed_handles == std::vector<MockHandle>{mockHandle(0x50)});
+    }
+}
+
+TEST_CASE("DeferredDeletionQueue: Concurrent retire", "[memory][deferred]") {
+    deferred_solo_calls = 0;
+    DeferredDeletionQueue queue;
+    queue.advance(1, 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&queue, t] {
+            for (int i = 1; i <= 100; ++i) {
+                MemoryWrapper<MockHandle, decltype(&MockDeferredDestroySolo)> wrapper(
+                    mockHandle(static_cast<uintptr_t>(t * 1000 + i)),
+                    nullptr,
+                    MockDeferredDestroySolo
+                );
+                wrapper.retire(queue);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(queue.size() == 400);
+    REQUIRE(queue.collect(1) == 400);
+    REQUIRE(deferred_solo_calls == 400);
+}
@@ -0,0 +1,126 @@
+#include <catch2/catch_test_macros.hpp>
+#include <HostAllocator.hpp>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static bool isAligned(const void* ptr, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+TEST_CASE("HostSizeClasses: Derived classes", "[memory][host_allocator]") {
+    SECTION("Linear then four classes per power of two") {
+        std::vector<size_t> classes = deriveSizeClasses(16, 512);
+        REQUIRE(classes == std::vector<size_t>{16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512});
+    }
+
+    SECTION("Granularity is at least the allocator alignment") {
+        std::vector<size_t> classes = deriveSizeClasses(8, 64);
+        REQUIRE(classes.front() == 16);
+        for (size_t size : classes) {
+            REQUIRE(size % 16 == 0);
+        }
+    }
+}
+
+#ifdef ABOX_HOST_ALLOCATOR
+
+TEST_CASE("HostAllocator: Allocation callbacks", "[memory][host_allocator]") {
+    const VkAllocationCallbacks* cb = HostAllocator::callbacks(HostAllocTag::ShaderModule);
+    REQUIRE(cb != nullptr);
+    REQUIRE(cb->pUserData != HostAllocator::callbacks(HostAllocTag::Pipeline)->pUserData);
+
+    SECTION("Small requests come from the pools and are accounted per scope") {
+        const HostScopeStats before = HostAllocator::scopeStats(HostAllocTag::ShaderModule, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+        const uint64_t systemBefore = HostAllocator::systemAllocations();
+
+        void* p = cb->pfnAllocation(cb->pUserData, 40, 8, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+        REQUIRE(p != nullptr);
+        REQUIRE(isAligned(p, 16));
+        std::memset(p, 0xAB, 40);
+
+        HostScopeStats during = HostAllocator::scopeStats(HostAllocTag::ShaderModule, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+        REQUIRE(during.allocations == before.allocations + 1);
+        REQUIRE(during.liveBytes == before.liveBytes + 40);
+        REQUIRE(HostAllocator::systemAllocations() == systemBefore);
+
+        cb->pfnFree(cb->pUserData, p);
+        HostScopeStats after = HostAllocator::scopeStats(HostAllocTag::ShaderModule, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+        REQUIRE(after.liveBytes == before.liveBytes);
+        REQUIRE(after.frees == before.frees + 1);
+        REQUIRE(after.peakBytes >= 40);
+
+        // Other scopes are untouched
+        REQUIRE(HostAllocator::scopeStats(HostAllocTag::ShaderModule, VK_SYSTEM_ALLOCATION_SCOPE_CACHE).allocations == 0);
+    }
+
+    SECTION("Large and over-aligned requests go to the system") {
+        const uint64_t systemBefore = HostAllocator::systemAllocations();
+
+        void* big = cb->pfnAllocation(cb->pUserData, 64 * 1024, 16, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+        void* aligned = cb->pfnAllocation(cb->pUserData, 32, 256, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+        REQUIRE(big != nullptr);
+        REQUIRE(aligned != nullptr);
+        REQUIRE(isAligned(aligned, 256));
+        REQUIRE(HostAllocator::systemAllocations() == systemBefore + 2);
+
+        cb->pfnFree(cb->pUserData, big);
+        cb->pfnFree(cb->pUserData, aligned);
+    }
+
+    SECTION("Reallocation keeps the content") {
+        auto* p = static_cast<unsigned char*>(cb->pfnAllocation(cb->pUserData, 24, 8, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
+        for (int i = 0; i < 24; ++i) {
+            p[i] = static_cast<unsigned char>(i);
+        }
+
+        // Same class, same block
+        REQUIRE(cb->pfnReallocation(cb->pUserData, p, 30, 8, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) == p);
+
+        auto* grown = static_cast<unsigned char*>(cb->pfnReallocation(cb->pUserData, p, 4096, 8, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
+        REQUIRE(grown != nullptr);
+        for (int i = 0; i < 24; ++i) {
+            REQUIRE(grown[i] == i);
+        }
+        REQUIRE(cb->pfnReallocation(cb->pUserData, grown, 0, 8, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) == nullptr);
+        REQUIRE(HostAllocator::scopeStats(HostAllocTag::ShaderModule, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND).liveBytes == 0);
+    }
+
+    SECTION("Internal allocations are recorded") {
+        cb->pfnInternalAllocation(cb->pUserData, 128, VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
+        REQUIRE(HostAllocator::scopeStats(HostAllocTag::ShaderModule, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE).internalBytes == 128);
+        cb->pfnInternalFree(cb->pUserData, 128, VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
+        REQUIRE(HostAllocator::scopeStats(HostAllocTag::ShaderModule, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE).internalBytes == 0);
+    }
+}
+
+TEST_CASE("HostAllocator: Concurrent allocations", "[memory][host_allocator]") {
+    const VkAllocationCallbacks* cb = HostAllocator::callbacks(HostAllocTag::Other);
+    const HostScopeStats before = HostAllocator::scopeStats(HostAllocTag::Other, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([cb, t] {
+            std::vector<void*> blocks;
+            for (size_t i = 1; i <= 2000; ++i) {
+                void* p = cb->pfnAllocation(cb->pUserData, (i * 7 + t) % 1024 + 1, 16, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+                std::memset(p, t, 1);
+                blocks.push_back(p);
+            }
+            for (void* p : blocks) {
+                cb->pfnFree(cb->pUserData, p);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    HostScopeStats after = HostAllocator::scopeStats(HostAllocTag::Other, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    REQUIRE(after.allocations == before.allocations + 8000);
+    REQUIRE(after.liveCount == before.liveCount);
+    REQUIRE(after.liveBytes == before.liveBytes);
+}
+
+#endif // ABOX_HOST_ALLOCATOR
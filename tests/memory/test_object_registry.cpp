@@ -0,0 +1,207 @@
+#include <catch2/catch_test_macros.hpp>
+#include <DeferredDeletionQueue.hpp>
+#include <MemoryWrapper.hpp>
+#include <ObjectRegistry.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Dedicated mock handle types so the registry slots are not shared with other tests
+struct RegistryMockHandle_T;
+struct RegistryMockSolo_T;
+using RegistryHandle = RegistryMockHandle_T*;
+using RegistrySolo = RegistryMockSolo_T*;
+using MockDevice = void*;
+
+void MockRegistryDestroy(MockDevice /*device*/, RegistryHandle /*handle*/, const VkAllocationCallbacks* /*allocator*/) {}
+
+void MockRegistryDestroySolo(RegistrySolo /*handle*/, const VkAllocationCallbacks* /*allocator*/) {}
+
+using RegistryWrapper = MemoryWrapper<RegistryHandle, decltype(&MockRegistryDestroy), MockDevice>;
+using RegistrySoloWrapper = MemoryWrapper<RegistrySolo, decltype(&MockRegistryDestroySolo)>;
+
+static RegistryHandle registryHandle(uintptr_t value) {
+    return reinterpret_cast<RegistryHandle>(value);
+}
+
+static const MockDevice device_a = reinterpret_cast<MockDevice>(0xA000);
+static const MockDevice device_b = reinterpret_cast<MockDevice>(0xB000);
+
+static ObjectTypeStats statsOf(const std::string& type) {
+    for (const ObjectTypeStats& t : ObjectRegistry::snapshot().types) {
+        if (t.name.find(type) != std::string::npos) {
+            return t;
+        }
+    }
+    return {};
+}
+
+static int64_t liveUnder(MockDevice parent, const std::string& type) {
+    for (const ObjectParentStats& p : ObjectRegistry::snapshot().parents) {
+        if (p.parent == reinterpret_cast<uintptr_t>(parent) && p.type.find(type) != std::string::npos) {
+            return p.live;
+        }
+    }
+    return 0;
+}
+
+#ifdef ABOX_OBJECT_TRACKING
+
+TEST_CASE("ObjectRegistry: Counts wrapped handles", "[memory][registry]") {
+    ObjectRegistry::reset();
+
+    SECTION("Construction and destruction") {
+        {
+            RegistryWrapper a(registryHandle(0x1), device_a, MockRegistryDestroy);
+            RegistryWrapper b(registryHandle(0x2), device_a, MockRegistryDestroy);
+            RegistryWrapper c(registryHandle(0x3), device_b, MockRegistryDestroy);
+
+            ObjectTypeStats stats = statsOf("RegistryMockHandle");
+            REQUIRE(stats.created == 3);
+            REQUIRE(stats.live == 3);
+            REQUIRE(liveUnder(device_a, "RegistryMockHandle") == 2);
+            REQUIRE(liveUnder(device_b, "RegistryMockHandle") == 1);
+        }
+        ObjectTypeStats stats = statsOf("RegistryMockHandle");
+        REQUIRE(stats.destroyed == 3);
+        REQUIRE(stats.live == 0);
+        REQUIRE(stats.leaked == 0);
+        REQUIRE(ObjectRegistry::reportLeaks() == 0);
+    }
+
+    SECTION("Handles written through ptr() are counted on next access") {
+        RegistryWrapper wrapper(VK_NULL_HANDLE, device_a, MockRegistryDestroy);
+        REQUIRE(statsOf("RegistryMockHandle").created == 0);
+
+        // What vkCreate* does
+        *wrapper.ptr() = registryHandle(0x10);
+        REQUIRE(wrapper.get() == registryHandle(0x10));
+        REQUIRE(statsOf("RegistryMockHandle").live == 1);
+
+        // Further accesses do not count it again
+        (void)wrapper.get();
+        (void)wrapper.ptr();
+        REQUIRE(statsOf("RegistryMockHandle").created == 1);
+    }
+
+    SECTION("Moving keeps a single count") {
+        RegistryWrapper a(registryHandle(0x20), device_a, MockRegistryDestroy);
+        RegistryWrapper b(std::move(a));
+        RegistryWrapper c(VK_NULL_HANDLE, device_a, MockRegistryDestroy);
+        c = std::move(b);
+
+        ObjectTypeStats stats = statsOf("RegistryMockHandle");
+        REQUIRE(stats.created == 1);
+        REQUIRE(stats.live == 1);
+    }
+}
+
+TEST_CASE("ObjectRegistry: Leaks and deferred deletion", "[memory][registry]") {
+    ObjectRegistry::reset();
+
+    SECTION("Null parent drops the handle and reports it") {
+        {
+            RegistryWrapper wrapper(registryHandle(0x30), VK_NULL_HANDLE, MockRegistryDestroy);
+        }
+        ObjectTypeStats stats = statsOf("RegistryMockHandle");
+        REQUIRE(stats.leaked == 1);
+        REQUIRE(stats.live == 0);
+        REQUIRE(ObjectRegistry::reportLeaks() == 1);
+    }
+
+    SECTION("Retired handles stay live until the queue destroys them") {
+        DeferredDeletionQueue queue;
+        queue.advance(1, 0);
+        RegistryWrapper wrapper(registryHandle(0x40), device_a, MockRegistryDestroy);
+        wrapper.retire(queue);
+
+        REQUIRE(statsOf("RegistryMockHandle").live == 1);
+        REQUIRE(liveUnder(device_a, "RegistryMockHandle") == 1);
+
+        queue.collect(1);
+        ObjectTypeStats stats = statsOf("RegistryMockHandle");
+        REQUIRE(stats.live == 0);
+        REQUIRE(stats.destroyed == 1);
+        REQUIRE(liveUnder(device_a, "RegistryMockHandle") == 0);
+    }
+
+    SECTION("Parentless handles are counted under parent 0") {
+        {
+            RegistrySoloWrapper wrapper(reinterpret_cast<RegistrySolo>(0x50), nullptr, MockRegistryDestroySolo);
+            REQUIRE(liveUnder(nullptr, "RegistryMockSolo") == 1);
+        }
+        REQUIRE(statsOf("RegistryMockSolo").destroyed == 1);
+    }
+}
+
+TEST_CASE("ObjectRegistry: High-water marks", "[memory][registry]") {
+    ObjectRegistry::reset();
+
+    {
+        std::vector<RegistryWrapper> wrappers;
+        wrappers.reserve(5);
+        for (uintptr_t i = 1; i <= 5; ++i) {
+            wrappers.emplace_back(registryHandle(i), device_a, MockRegistryDestroy);
+        }
+        ObjectRegistry::sample(0);
+    }
+    ObjectRegistry::sample(0);
+
+    ObjectTypeStats stats = statsOf("RegistryMockHandle");
+    REQUIRE(stats.live == 0);
+    REQUIRE(stats.highWater == 5);
+
+    for (const ObjectParentStats& p : ObjectRegistry::snapshot().parents) {
+        if (p.parent == reinterpret_cast<uintptr_t>(device_a) && p.type.find("RegistryMockHandle") != std::string::npos) {
+            REQUIRE(p.highWater == 5);
+        }
+    }
+}
+
+TEST_CASE("ObjectRegistry: Concurrent creation", "[memory][registry]") {
+    ObjectRegistry::reset();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([t] {
+            for (uintptr_t i = 1; i <= 500; ++i) {
+                RegistryWrapper wrapper(registryHandle(static_cast<uintptr_t>(t) * 1000 + i), device_b, MockRegistryDestroy);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ObjectTypeStats stats = statsOf("RegistryMockHandle");
+    REQUIRE(stats.created == 4000);
+    REQUIRE(stats.destroyed == 4000);
+    REQUIRE(stats.live == 0);
+    REQUIRE(liveUnder(device_b, "RegistryMockHandle") == 0);
+}
+
+TEST_CASE("ObjectRegistry: Concurrent first access", "[memory][registry]") {
+    ObjectRegistry::reset();
+
+    RegistryWrapper wrapper(VK_NULL_HANDLE, device_a, MockRegistryDestroy);
+    *wrapper.ptr() = registryHandle(0x60);
+
+    // Every thread may be the first to see the handle, only one counts it
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&wrapper] {
+            for (int i = 0; i < 100; ++i) {
+                (void)wrapper.get();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ObjectTypeStats stats = statsOf("RegistryMockHandle");
+    REQUIRE(stats.created == 1);
+    REQUIRE(stats.live == 1);
+}
+
+#endif // ABOX_OBJECT_TRACKING
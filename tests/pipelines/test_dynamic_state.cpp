@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+#include <DynamicState.hpp>
+#include <algorithm>
+
+// State lists, baking and the disabled recorder: no device is needed
+
+namespace {
+
+ABox::Hash128 key(const RasterState &state) {
+    ABox::Hasher hasher;
+    state.hash(hasher);
+    return hasher.digest();
+}
+
+RasterState material() {
+    RasterState state;
+    state.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    state.cullMode = VK_CULL_MODE_BACK_BIT;
+    state.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    state.depthTest = true;
+    state.depthWrite = true;
+    state.depthBias = true;
+    state.polygonMode = VK_POLYGON_MODE_LINE;
+    state.blend = true;
+    return state;
+}
+
+} // namespace
+
+TEST_CASE("ExtendedDynamicState: State lists follow the features", "[pipelines][dynamic_state]") {
+    const std::vector<VkDynamicState> baseline = ExtendedDynamicState::stateList({});
+    REQUIRE(baseline == std::vector<VkDynamicState>{VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR});
+
+    const std::vector<VkDynamicState> all = ExtendedDynamicState::stateList({true, true, true, true});
+    REQUIRE(all.size() == 13);
+    REQUIRE(std::ranges::find(all, VK_DYNAMIC_STATE_CULL_MODE) != all.end());
+    REQUIRE(std::ranges::find(all, VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT) != all.end());
+
+    const ExtendedDynamicState disabled;
+    REQUIRE(std::ranges::equal(disabled.getStates(), baseline));
+}
+
+TEST_CASE("ExtendedDynamicState: Baking leaves dynamic fields out", "[pipelines][dynamic_state]") {
+    const RasterState state = material();
+
+    SECTION("Without features every field is baked") {
+        REQUIRE(ExtendedDynamicState::baked(state, {}) == state);
+    }
+
+    SECTION("Dynamic fields fall back to their default") {
+        const DynamicStateFeatures features{.extendedDynamicState = true, .extendedDynamicState2 = true};
+        const RasterState baked = ExtendedDynamicState::baked(state, features);
+        REQUIRE(baked.cullMode == VK_CULL_MODE_NONE);
+        REQUIRE(baked.frontFace == VK_FRONT_FACE_COUNTER_CLOCKWISE);
+        REQUIRE_FALSE(baked.depthTest);
+        REQUIRE_FALSE(baked.depthBias);
+        // Extended dynamic state 3 fields stay baked
+        REQUIRE(baked.polygonMode == VK_POLYGON_MODE_LINE);
+        REQUIRE(baked.blend);
+        // Materials differing in dynamic fields only share a key
+        REQUIRE(key(baked) == key(ExtendedDynamicState::baked(RasterState{.polygonMode = VK_POLYGON_MODE_LINE, .blend = true}, features)));
+    }
+
+    SECTION("A dynamic topology keeps its class") {
+        const DynamicStateFeatures features{.extendedDynamicState = true};
+        REQUIRE(ExtendedDynamicState::baked(state, features).topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+        RasterState lines;
+        lines.topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+        REQUIRE(ExtendedDynamicState::baked(lines, features).topology == VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
+        REQUIRE_FALSE(key(ExtendedDynamicState::baked(lines, features)) == key(ExtendedDynamicState::baked(state, features)));
+    }
+}
+
+TEST_CASE("DynamicStateRecorder: Nothing is recorded without dynamic state", "[pipelines][dynamic_state]") {
+    const ExtendedDynamicState disabled;
+    DynamicStateRecorder recorder(disabled);
+    // The command buffer is never read
+    REQUIRE(recorder.apply(VK_NULL_HANDLE, material()) == 0);
+    REQUIRE(recorder.apply(VK_NULL_HANDLE, RasterState{}) == 0);
+    REQUIRE(recorder.getRecorded() == 0);
+    REQUIRE(recorder.getSkipped() == 0);
+}
@@ -0,0 +1,119 @@
+#include <catch2/catch_test_macros.hpp>
+#include <PipelineCache.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+VkPhysicalDeviceProperties deviceProperties() {
+    VkPhysicalDeviceProperties properties{};
+    properties.vendorID = 0x10de;
+    properties.deviceID = 0x2684;
+    for (uint32_t i = 0; i < VK_UUID_SIZE; ++i) {
+        properties.pipelineCacheUUID[i] = static_cast<uint8_t>(i * 7);
+    }
+    return properties;
+}
+
+// Header as the driver writes it, followed by some opaque payload
+std::vector<std::byte> cacheData(const VkPhysicalDeviceProperties &properties) {
+    VkPipelineCacheHeaderVersionOne header{};
+    header.headerSize = sizeof(header);
+    header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::vector<std::byte> data(sizeof(header) + 64, std::byte{0x5a});
+    std::memcpy(data.data(), &header, sizeof(header));
+    return data;
+}
+
+} // namespace
+
+TEST_CASE("PipelineCache: Data from the same device and driver is accepted", "[pipelines][pipeline_cache]") {
+    const VkPhysicalDeviceProperties properties = deviceProperties();
+    REQUIRE(PipelineCache::checkData(cacheData(properties), properties) == PipelineCacheDataCheck::Valid);
+}
+
+TEST_CASE("PipelineCache: Header mismatches are rejected", "[pipelines][pipeline_cache]") {
+    const VkPhysicalDeviceProperties properties = deviceProperties();
+    const std::vector<std::byte> valid = cacheData(properties);
+
+    SECTION("Empty or truncated") {
+        REQUIRE(PipelineCache::checkData({}, properties) == PipelineCacheDataCheck::TooSmall);
+        const std::vector<std::byte> truncated(valid.begin(), valid.begin() + 16);
+        REQUIRE(PipelineCache::checkData(truncated, properties) == PipelineCacheDataCheck::TooSmall);
+    }
+
+    SECTION("Header size or version") {
+        std::vector<std::byte> data = valid;
+        const uint32_t tooLarge = static_cast<uint32_t>(data.size() + 1);
+        std::memcpy(data.data(), &tooLarge, sizeof(tooLarge));
+        REQUIRE(PipelineCache::checkData(data, properties) == PipelineCacheDataCheck::BadHeader);
+
+        data = valid;
+        const uint32_t version = 2;
+        std::memcpy(data.data() + 4, &version, sizeof(version));
+        REQUIRE(PipelineCache::checkData(data, properties) == PipelineCacheDataCheck::BadHeader);
+    }
+
+    SECTION("Other GPU") {
+        VkPhysicalDeviceProperties other = properties;
+        other.vendorID = 0x1002;
+        REQUIRE(PipelineCache::checkData(valid, other) == PipelineCacheDataCheck::OtherVendor);
+        other = properties;
+        other.deviceID = 0x2685;
+        REQUIRE(PipelineCache::checkData(valid, other) == PipelineCacheDataCheck::OtherDevice);
+    }
+
+    SECTION("Driver update") {
+        VkPhysicalDeviceProperties updated = properties;
+        updated.pipelineCacheUUID[VK_UUID_SIZE - 1] ^= 1;
+        REQUIRE(PipelineCache::checkData(valid, updated) == PipelineCacheDataCheck::OtherDriver);
+    }
+}
+
+TEST_CASE("PipelineCache: One file per GPU model", "[pipelines][pipeline_cache]") {
+    VkPhysicalDeviceProperties properties = deviceProperties();
+    REQUIRE(PipelineCache::fileName(properties) == "10de-2684.bin");
+    properties.deviceID = 0x1;
+    REQUIRE(PipelineCache::fileName(properties) == "10de-1.bin");
+}
+
+TEST_CASE("PipelineCache: Unopened cache is inert", "[pipelines][pipeline_cache]") {
+    PipelineCache cache;
+    REQUIRE(cache.get() == VK_NULL_HANDLE);
+    REQUIRE_FALSE(cache.save());
+    REQUIRE_FALSE(cache.saveIfDue(std::chrono::seconds(0)));
+
+    // Without creation feedback the create info chain is left untouched
+    PipelineCreation creation;
+    int next = 0;
+    REQUIRE(cache.beginCreation(creation, &next) == &next);
+    cache.endCreation(creation);
+    const PipelineCacheStats stats = cache.getStats();
+    REQUIRE(stats.unreported == 1);
+    REQUIRE(stats.hits == 0);
+    REQUIRE(stats.misses == 0);
+    REQUIRE(stats.averageHitMilliseconds() == 0.0);
+}
+
+TEST_CASE("PipelineCache: Creation records last until forgotten", "[pipelines][pipeline_cache]") {
+    PipelineCache cache;
+    // Never dereferenced: records are keyed by the handle value
+    const VkPipeline pipeline = reinterpret_cast<VkPipeline>(uintptr_t{0x1000});
+    PipelineCreation creation;
+    (void)cache.beginCreation(creation);
+    cache.endCreation(creation, pipeline);
+    REQUIRE(cache.getCreationRecord(pipeline).has_value());
+    REQUIRE(cache.getCreationRecord(pipeline)->outcome == PipelineCacheOutcome::Unreported);
+
+    // Retired: a later pipeline given the same handle value starts clean
+    cache.forgetCreation(pipeline);
+    REQUIRE_FALSE(cache.getCreationRecord(pipeline).has_value());
+    cache.forgetCreation(pipeline);
+    REQUIRE(cache.getStats().unreported == 1);
+}
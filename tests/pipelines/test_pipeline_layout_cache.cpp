@@ -0,0 +1,79 @@
+#include <catch2/catch_test_macros.hpp>
+#include <PipelineLayoutCache.hpp>
+#include <vector>
+
+// Normalization and keys only: no device is needed
+
+namespace {
+
+VkDescriptorSetLayoutBinding binding(uint32_t index, VkDescriptorType type, VkShaderStageFlags stages) {
+    return {index, type, 1, stages, nullptr};
+}
+
+} // namespace
+
+TEST_CASE("PipelineLayoutCache: Bindings are keyed in binding order", "[pipelines][pipeline_layout_cache]") {
+    std::vector<VkDescriptorSetLayoutBinding> reflected{
+        binding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT),
+        binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT),
+    };
+    std::vector<VkDescriptorSetLayoutBinding> sorted{reflected[1], reflected[0]};
+
+    PipelineLayoutCache::normalize(reflected);
+    REQUIRE(reflected[0].binding == 0);
+    REQUIRE(reflected[1].binding == 2);
+    REQUIRE(PipelineLayoutCache::setLayoutKey(reflected) == PipelineLayoutCache::setLayoutKey(sorted));
+
+    SECTION("Stages are part of the key") {
+        sorted[0].stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+        REQUIRE_FALSE(PipelineLayoutCache::setLayoutKey(reflected) == PipelineLayoutCache::setLayoutKey(sorted));
+    }
+
+    SECTION("Immutable sampler pointers are not") {
+        static const VkSampler sampler = VK_NULL_HANDLE;
+        sorted[1].pImmutableSamplers = &sampler;
+        REQUIRE(PipelineLayoutCache::setLayoutKey(reflected) == PipelineLayoutCache::setLayoutKey(sorted));
+    }
+}
+
+TEST_CASE("PipelineLayoutCache: Pipeline layout keys", "[pipelines][pipeline_layout_cache]") {
+    const std::vector<VkDescriptorSetLayoutBinding> uniforms{
+        binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)};
+    const ABox::Hash128 empty = PipelineLayoutCache::setLayoutKey({});
+    const ABox::Hash128 set = PipelineLayoutCache::setLayoutKey(uniforms);
+
+    std::vector<VkPushConstantRange> ranges{
+        {VK_SHADER_STAGE_FRAGMENT_BIT, 16, 16},
+        {VK_SHADER_STAGE_VERTEX_BIT, 0, 16},
+    };
+    std::vector<VkPushConstantRange> sortedRanges{ranges[1], ranges[0]};
+    PipelineLayoutCache::normalize(ranges);
+    REQUIRE(ranges[0].offset == 0);
+    REQUIRE(ranges[1].offset == 16);
+
+    const std::vector<ABox::Hash128> sets{set};
+    REQUIRE(PipelineLayoutCache::pipelineLayoutKey(sets, ranges) ==
+            PipelineLayoutCache::pipelineLayoutKey(sets, sortedRanges));
+
+    SECTION("Set indices matter") {
+        const std::vector<ABox::Hash128> shifted{empty, set};
+        REQUIRE_FALSE(PipelineLayoutCache::pipelineLayoutKey(sets, ranges) ==
+                      PipelineLayoutCache::pipelineLayoutKey(shifted, ranges));
+    }
+
+    SECTION("Push constant ranges matter") {
+        REQUIRE_FALSE(PipelineLayoutCache::pipelineLayoutKey(sets, ranges) ==
+                      PipelineLayoutCache::pipelineLayoutKey(sets, {}));
+    }
+}
+
+TEST_CASE("PipelineLayoutCache: Empty cache", "[pipelines][pipeline_layout_cache]") {
+    PipelineLayoutCache cache;
+    DeferredDeletionQueue queue;
+
+    REQUIRE(cache.setLayoutCount() == 0);
+    REQUIRE(cache.pipelineLayoutCount() == 0);
+    REQUIRE(cache.retireUnused(queue) == 0);
+    REQUIRE(cache.getCreations() == 0);
+    REQUIRE(cache.getReuses() == 0);
+}
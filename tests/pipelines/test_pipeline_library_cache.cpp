@@ -0,0 +1,128 @@
+#include <catch2/catch_test_macros.hpp>
+#include <PipelineLibraryCache.hpp>
+#include <array>
+#include <stdexcept>
+
+// Splitting and keys only: no device is needed
+
+namespace {
+
+struct TestState {
+    std::array<VkDynamicState, 2> dynamicStates{VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkViewport viewport{0.0f, 0.0f, 800.0f, 600.0f, 0.0f, 1.0f};
+    VkRect2D scissor{{0, 0}, {800u, 600u}};
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    VkPipelineViewportStateCreateInfo viewportState{};
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    VkPipelineColorBlendAttachmentState blendAttachment{};
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    VkGraphicsPipelineCreateInfo info{};
+
+    TestState() {
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        viewportState.viewportCount = 1;
+        viewportState.pViewports = &viewport;
+        viewportState.scissorCount = 1;
+        viewportState.pScissors = &scissor;
+        rasterizer.lineWidth = 1.0f;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        blendAttachment.colorWriteMask = 0xF;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &blendAttachment;
+        dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+        dynamicState.pDynamicStates = dynamicStates.data();
+
+        info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        info.pVertexInputState = &vertexInput;
+        info.pInputAssemblyState = &inputAssembly;
+        info.pViewportState = &viewportState;
+        info.pRasterizationState = &rasterizer;
+        info.pMultisampleState = &multisampling;
+        info.pColorBlendState = &colorBlending;
+        info.pDynamicState = &dynamicState;
+    }
+
+    ABox::Hash128 key(PipelineLibraryPart part) const {
+        return PipelineLibraryCache::partKey(part, PipelineLibraryCache::partInfo(part, info, {}), {});
+    }
+};
+
+} // namespace
+
+TEST_CASE("PipelineLibraryCache: Parts take their own state", "[pipelines][pipeline_library_cache]") {
+    const TestState state;
+    const VkPipelineShaderStageCreateInfo stage{};
+
+    const VkGraphicsPipelineCreateInfo vertexInput =
+        PipelineLibraryCache::partInfo(PipelineLibraryPart::VertexInput, state.info, {&stage, 1});
+    REQUIRE(vertexInput.stageCount == 0);
+    REQUIRE(vertexInput.pVertexInputState == &state.vertexInput);
+    REQUIRE(vertexInput.pRasterizationState == nullptr);
+    REQUIRE(vertexInput.pColorBlendState == nullptr);
+
+    const VkGraphicsPipelineCreateInfo preRasterization =
+        PipelineLibraryCache::partInfo(PipelineLibraryPart::PreRasterization, state.info, {&stage, 1});
+    REQUIRE(preRasterization.stageCount == 1);
+    REQUIRE(preRasterization.pRasterizationState == &state.rasterizer);
+    REQUIRE(preRasterization.pVertexInputState == nullptr);
+    REQUIRE(preRasterization.pMultisampleState == nullptr);
+
+    const VkGraphicsPipelineCreateInfo fragmentOutput =
+        PipelineLibraryCache::partInfo(PipelineLibraryPart::FragmentOutput, state.info, {});
+    REQUIRE(fragmentOutput.stageCount == 0);
+    REQUIRE(fragmentOutput.pColorBlendState == &state.colorBlending);
+    REQUIRE(fragmentOutput.pMultisampleState == &state.multisampling);
+}
+
+TEST_CASE("PipelineLibraryCache: A state change only rekeys its part", "[pipelines][pipeline_library_cache]") {
+    TestState state;
+    const ABox::Hash128 vertexInput = state.key(PipelineLibraryPart::VertexInput);
+    const ABox::Hash128 preRasterization = state.key(PipelineLibraryPart::PreRasterization);
+    const ABox::Hash128 fragmentOutput = state.key(PipelineLibraryPart::FragmentOutput);
+    REQUIRE_FALSE(vertexInput == fragmentOutput);
+
+    state.blendAttachment.blendEnable = VK_TRUE;
+    REQUIRE_FALSE(state.key(PipelineLibraryPart::FragmentOutput) == fragmentOutput);
+    REQUIRE(state.key(PipelineLibraryPart::PreRasterization) == preRasterization);
+    REQUIRE(state.key(PipelineLibraryPart::VertexInput) == vertexInput);
+
+    state.rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+    REQUIRE_FALSE(state.key(PipelineLibraryPart::PreRasterization) == preRasterization);
+
+    const ABox::Hash128 otherShaders{.lo = 1, .hi = 2};
+    const VkGraphicsPipelineCreateInfo part =
+        PipelineLibraryCache::partInfo(PipelineLibraryPart::PreRasterization, state.info, {});
+    REQUIRE_FALSE(PipelineLibraryCache::partKey(PipelineLibraryPart::PreRasterization, part, otherShaders) ==
+                  PipelineLibraryCache::partKey(PipelineLibraryPart::PreRasterization, part, {}));
+}
+
+TEST_CASE("PipelineLibraryCache: Dynamic viewports do not split libraries", "[pipelines][pipeline_library_cache]") {
+    TestState state;
+    const ABox::Hash128 before = state.key(PipelineLibraryPart::PreRasterization);
+    state.viewport.width = 1920.0f;
+    state.scissor.extent = {1920u, 1080u};
+    REQUIRE(state.key(PipelineLibraryPart::PreRasterization) == before);
+
+    state.dynamicState.dynamicStateCount = 0;
+    const ABox::Hash128 staticViewport = state.key(PipelineLibraryPart::PreRasterization);
+    state.viewport.width = 800.0f;
+    REQUIRE_FALSE(state.key(PipelineLibraryPart::PreRasterization) == staticViewport);
+}
+
+TEST_CASE("PipelineLibraryCache: Disabled cache builds nothing", "[pipelines][pipeline_library_cache]") {
+    PipelineLibraryCache libraries;
+    PipelineCache cache;
+    const TestState state;
+    REQUIRE_FALSE(libraries.isEnabled());
+    REQUIRE(libraries.optimizesInBackground());
+    REQUIRE_THROWS_AS(
+        libraries.acquire(PipelineLibraryPart::VertexInput, state.info, {}, {}, cache),
+        std::runtime_error);
+    REQUIRE_THROWS_AS(libraries.link({}, VK_NULL_HANDLE, false, cache), std::runtime_error);
+    REQUIRE(libraries.size() == 0);
+    REQUIRE(libraries.trim(cache) == 0);
+    REQUIRE(libraries.getStats().fastLinks == 0);
+}
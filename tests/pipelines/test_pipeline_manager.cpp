@@ -0,0 +1,353 @@
+#include <catch2/catch_test_macros.hpp>
+#include <DeferredDeletionQueue.hpp>
+#include <ObjectRegistry.hpp>
+#include <PipelineManager.hpp>
+#include <ShaderHandler.hpp>
+#include <TestTempDir.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Headless device of the first Vulkan implementation found (lavapipe on CI),
+// the tests building pipelines are skipped without one
+struct TestDevice {
+    VkInstance instance = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+
+    TestDevice() {
+        VkApplicationInfo app{};
+        app.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        app.pApplicationName = "test_pipelines";
+        app.apiVersion = VK_API_VERSION_1_3;
+        VkInstanceCreateInfo instanceInfo{};
+        instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        instanceInfo.pApplicationInfo = &app;
+        if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS) {
+            instance = VK_NULL_HANDLE;
+            return;
+        }
+        uint32_t count = 1;
+        VkPhysicalDevice physical = VK_NULL_HANDLE;
+        if (vkEnumeratePhysicalDevices(instance, &count, &physical) < 0 || count == 0) {
+            return;
+        }
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physical, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physical, &familyCount, families.data());
+        const auto compute = std::ranges::find_if(families, [](const VkQueueFamilyProperties& family) {
+            return (family.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+        });
+        if (compute == families.end()) {
+            return;
+        }
+        const float priority = 1.0f;
+        VkDeviceQueueCreateInfo queueInfo{};
+        queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueInfo.queueFamilyIndex = static_cast<uint32_t>(compute - families.begin());
+        queueInfo.queueCount = 1;
+        queueInfo.pQueuePriorities = &priority;
+        VkDeviceCreateInfo deviceInfo{};
+        deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        deviceInfo.queueCreateInfoCount = 1;
+        deviceInfo.pQueueCreateInfos = &queueInfo;
+        if (vkCreateDevice(physical, &deviceInfo, nullptr, &device) != VK_SUCCESS) {
+            device = VK_NULL_HANDLE;
+        }
+    }
+    ~TestDevice() {
+        if (device != VK_NULL_HANDLE) {
+            vkDestroyDevice(device, nullptr);
+        }
+        if (instance != VK_NULL_HANDLE) {
+            vkDestroyInstance(instance, nullptr);
+        }
+    }
+};
+
+static std::string computeSource(uint32_t localSize) {
+    return "#version 450\nlayout(local_size_x = " + std::to_string(localSize) + ") in;\nvoid main() {}\n";
+}
+
+// Only descriptions rejected before any device call: no device is needed
+
+// Shader of placeholder SPIR-V, planning only hashes the code
+static ShaderDataRef placeholderShader(const std::string& name, const std::string& extension, uint32_t word) {
+    return std::make_shared<const ShaderDataFile>(
+        name, std::vector<uint32_t>{SPIRV_MAGIC_NUMBER, 0x00010500u, 0u, 1u, word},
+        &*StageExtentionHandler::at(extension), SourcePlatform::GLSL, ShaderReflectionData{});
+}
+
+static ShaderDataRef computeShader(const std::string& name, uint32_t word) {
+    return placeholderShader(name, ".comp", word);
+}
+
+static PipelineDescription computeDescription(const std::string& name, ShaderDataRef shader) {
+    PipelineDescription description;
+    description.name = name;
+    description.bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+    description.shaders = {std::move(shader)};
+    return description;
+}
+
+TEST_CASE("PipelineManager: Invalid batch descriptions fail on their own", "[pipelines][pipeline_manager]") {
+    PipelineManager manager;
+    ABox::ThreadPool pool(2);
+
+    std::vector<PipelineDescription> descriptions(4);
+    descriptions[0].name = "empty";
+    descriptions[0].bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+    descriptions[1].name = "empty";
+    descriptions[1].bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+    descriptions[2].name = "rays";
+    descriptions[2].bindPoint = VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR;
+    descriptions[3].name = "noSwapchain";
+    descriptions[3].bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+    // Shaders of rejected entries are never read
+    descriptions[2].shaders = {nullptr};
+    descriptions[3].shaders = {nullptr};
+
+    const PipelineBatchReport report = manager.createPipelines(VK_NULL_HANDLE, descriptions, pool);
+    REQUIRE(report.results.size() == 4);
+    REQUIRE(report.count(PipelineBuildStatus::Failed) == 4);
+    REQUIRE(report.count(PipelineBuildStatus::Created) == 0);
+    REQUIRE(report.count(PipelineBuildStatus::Shared) == 0);
+    REQUIRE(report.results[0].error == "no shaders provided");
+    REQUIRE(report.results[1].error == "name used twice in the batch");
+    REQUIRE(report.results[2].name == "rays");
+    REQUIRE_FALSE(report.results[2].error.empty());
+    REQUIRE_FALSE(report.results[3].error.empty());
+    REQUIRE(manager.getPipelineCount() == 0);
+    REQUIRE_FALSE(manager.hasPipeline("empty"));
+    REQUIRE_FALSE(report.results[0].handle.valid());
+    REQUIRE_FALSE(manager.getHandle("empty").valid());
+    // Rejected entries are not creations avoided
+    REQUIRE(manager.getAvoidedCreations() == 0);
+}
+
+TEST_CASE("PipelineManager: Batch plan builds each new state once", "[pipelines][pipeline_manager]") {
+    PipelineManager manager;
+    const ShaderDataRef fill = computeShader("fill.comp", 1);
+    const ShaderDataRef copy = computeShader("copy.comp", 2);
+
+    std::vector<PipelineDescription> descriptions{
+        computeDescription("fillA", fill),
+        computeDescription("copy", copy),
+        computeDescription("fillB", fill),
+        computeDescription("fillA", copy),
+        // Same code in another file: same state
+        computeDescription("fillC", computeShader("fill_again.comp", 1)),
+        computeDescription("fillTwo", fill),
+    };
+    descriptions[5].specialization.set(0, 2u);
+
+    const std::vector<PipelineBatchStep> steps = manager.planBatch(descriptions, PipelineBackend::Pipelines);
+    REQUIRE(steps.size() == descriptions.size());
+    REQUIRE(steps[0].action == PipelineBatchAction::Build);
+    REQUIRE(steps[1].action == PipelineBatchAction::Build);
+    REQUIRE(steps[2].action == PipelineBatchAction::ShareBuilt);
+    REQUIRE(steps[2].builder == 0);
+    REQUIRE(steps[2].key == steps[0].key);
+    REQUIRE(steps[3].action == PipelineBatchAction::Reject);
+    REQUIRE(steps[3].error == "name used twice in the batch");
+    REQUIRE(steps[4].action == PipelineBatchAction::ShareBuilt);
+    REQUIRE(steps[4].builder == 0);
+    REQUIRE(steps[5].action == PipelineBatchAction::Build);
+    REQUIRE_FALSE(steps[5].key == steps[0].key);
+    REQUIRE(std::ranges::count(steps, PipelineBatchAction::Build, &PipelineBatchStep::action) == 3);
+
+    // Steps commit in description order: a duplicate's builder is committed before it
+    for (size_t i = 0; i < steps.size(); ++i) {
+        if (steps[i].action == PipelineBatchAction::ShareBuilt) {
+            REQUIRE(steps[i].builder < i);
+            REQUIRE(steps[steps[i].builder].action == PipelineBatchAction::Build);
+        }
+    }
+
+    // Planning registers nothing
+    REQUIRE(manager.getPipelineCount() == 0);
+    REQUIRE(manager.getAvoidedCreations() == 0);
+    REQUIRE_FALSE(manager.getHandle("fillA").valid());
+}
+
+TEST_CASE("PipelineManager: Batch plan follows the backend", "[pipelines][pipeline_manager]") {
+    PipelineManager manager;
+    const std::vector<PipelineDescription> compute{computeDescription("fill", computeShader("fill.comp", 1))};
+
+    // Shader objects and pipelines of the same state are not interchangeable
+    const std::vector<PipelineBatchStep> pipelines = manager.planBatch(compute, PipelineBackend::Pipelines);
+    const std::vector<PipelineBatchStep> objects = manager.planBatch(compute, PipelineBackend::ShaderObjects);
+    REQUIRE(pipelines[0].action == PipelineBatchAction::Build);
+    REQUIRE(objects[0].action == PipelineBatchAction::Build);
+    REQUIRE_FALSE(objects[0].key == pipelines[0].key);
+
+    // Shader objects never set patch control points: tessellation stays on pipelines
+    PipelineDescription tessellated;
+    tessellated.name = "patches";
+    tessellated.bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    tessellated.shaders = {placeholderShader("patches.vert", ".vert", 1), placeholderShader("patches.tesc", ".tesc", 2),
+                           placeholderShader("patches.tese", ".tese", 3), placeholderShader("patches.frag", ".frag", 4)};
+    const std::vector<PipelineBatchStep> rejected = manager.planBatch(std::span(&tessellated, 1), PipelineBackend::ShaderObjects);
+    REQUIRE(rejected[0].action == PipelineBatchAction::Reject);
+    REQUIRE(rejected[0].error == "tessellation shaders are not built as shader objects");
+    // Without a swapchain the pipelines backend rejects it for another reason
+    const std::vector<PipelineBatchStep> asPipeline = manager.planBatch(std::span(&tessellated, 1), PipelineBackend::Pipelines);
+    REQUIRE(asPipeline[0].error == "graphics pipeline without a swapchain");
+}
+
+TEST_CASE("PipelineManager: Empty batch", "[pipelines][pipeline_manager]") {
+    PipelineManager manager;
+    const PipelineBatchReport report = manager.createPipelines(VK_NULL_HANDLE, {});
+    REQUIRE(report.results.empty());
+    REQUIRE(manager.getPipelineCount() == 0);
+}
+
+TEST_CASE("PipelineManager: Rejected async request fails without fallback", "[pipelines][pipeline_manager]") {
+    PipelineManager manager;
+    PipelineDescription description;
+    description.name = "empty";
+    description.bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+
+    const AsyncPipelineHandle handle = manager.createPipelineAsync(VK_NULL_HANDLE, description, "missing");
+    REQUIRE(handle.valid());
+    REQUIRE(manager.getState(handle) == AsyncPipelineState::Failed);
+    REQUIRE_FALSE(manager.isReady(handle));
+    REQUIRE(manager.resolve(handle) == nullptr);
+    REQUIRE(manager.getAsyncResult(handle)->error == "no shaders provided");
+    REQUIRE(manager.getPendingAsyncCount() == 0);
+    REQUIRE(manager.publishReadyPipelines() == 0);
+}
+
+TEST_CASE("PipelineManager: Unknown async handle", "[pipelines][pipeline_manager]") {
+    PipelineManager manager;
+    const AsyncPipelineHandle none;
+    REQUIRE_FALSE(none.valid());
+    REQUIRE(manager.getState(none) == AsyncPipelineState::Failed);
+    REQUIRE(manager.resolve(none) == nullptr);
+    REQUIRE(manager.getAsyncResult(none) == nullptr);
+}
+
+TEST_CASE("PipelineManager: Unknown pipeline handle", "[pipelines][pipeline_manager]") {
+    PipelineManager manager;
+    const PipelineHandle none;
+    REQUIRE_FALSE(none.valid());
+    REQUIRE(none == manager.getHandle("missing"));
+    REQUIRE(manager.getBinding(none) == nullptr);
+    REQUIRE(manager.getPipeline(none) == nullptr);
+    REQUIRE(manager.getPipeline("missing") == nullptr);
+    // Binds nothing, the command buffer is never read
+    manager.bindPipeline(none, VK_NULL_HANDLE);
+}
+
+TEST_CASE("PipelineManager: Shader object backend needs device support", "[pipelines][pipeline_manager]") {
+    PipelineManager manager;
+    REQUIRE(manager.getBackend() == PipelineBackend::Pipelines);
+    REQUIRE_FALSE(manager.getShaderObjectSupport().isEnabled());
+
+    // Not enabled by a device: descriptions keep being built as pipelines
+    REQUIRE_FALSE(manager.setBackend(PipelineBackend::ShaderObjects));
+    REQUIRE(manager.getBackend() == PipelineBackend::Pipelines);
+    REQUIRE(manager.setBackend(PipelineBackend::Pipelines));
+    REQUIRE(manager.getBackend() == PipelineBackend::Pipelines);
+}
+
+TEST_CASE("PipelineManager: Async builds publish once finished", "[pipelines][pipeline_manager][device]") {
+    TestDevice gpu;
+    if (gpu.device == VK_NULL_HANDLE) {
+        SKIP("No Vulkan device");
+    }
+    TempDir dir;
+    dir.write("fill.comp", computeSource(1));
+    ShaderHandler shaders;
+    REQUIRE(shaders.loadShaderDataFromFolder(dir.path) == 1);
+
+    PipelineManager manager;
+    ABox::ThreadPool pool(1);
+    // Holds the only worker: nothing finishes before it is released
+    std::promise<void> release;
+    std::future<void> held = pool.submit([gate = release.get_future().share()] { gate.wait(); });
+
+    PipelineDescription description = computeDescription("first", shaders.shareShader("fill.comp"));
+    const AsyncPipelineHandle first = manager.createPipelineAsync(gpu.device, description, {}, pool);
+    // Same state, requested before the first is registered: built too
+    description.name = "second";
+    const AsyncPipelineHandle second = manager.createPipelineAsync(gpu.device, description, {}, pool);
+
+    REQUIRE(manager.publishReadyPipelines() == 0);
+    REQUIRE(manager.getState(first) == AsyncPipelineState::Pending);
+    REQUIRE(manager.getState(second) == AsyncPipelineState::Pending);
+    REQUIRE(manager.getPendingAsyncCount() == 2);
+    REQUIRE(manager.resolve(first) == nullptr);
+    REQUIRE(manager.getPipelineCount() == 0);
+
+    release.set_value();
+    held.get();
+    // The single worker runs in order: both builds are done once this is
+    pool.submit([] {}).get();
+
+    REQUIRE(manager.publishReadyPipelines() == 2);
+    REQUIRE(manager.getPendingAsyncCount() == 0);
+    REQUIRE(manager.getState(first) == AsyncPipelineState::Ready);
+    REQUIRE(manager.getState(second) == AsyncPipelineState::Ready);
+    REQUIRE(manager.getAsyncResult(first)->status == PipelineBuildStatus::Created);
+    REQUIRE(manager.getAsyncResult(second)->status == PipelineBuildStatus::Shared);
+    REQUIRE(manager.resolve(first) == manager.resolve(second));
+
+    // The duplicate build was destroyed, not registered
+    REQUIRE(manager.getPipelineCount() == 1);
+    REQUIRE(manager.getBinding(manager.getHandle("first"))->pipeline ==
+            manager.getBinding(manager.getHandle("second"))->pipeline);
+#ifdef ABOX_OBJECT_TRACKING
+    int64_t livePipelines = 0;
+    for (const ObjectParentStats& parent : ObjectRegistry::snapshot().parents) {
+        if (parent.parent == reinterpret_cast<uintptr_t>(gpu.device) && parent.type.find("VkPipeline_T") != std::string::npos) {
+            livePipelines += parent.live;
+        }
+    }
+    REQUIRE(livePipelines == 1);
+#endif
+    REQUIRE(manager.publishReadyPipelines() == 0);
+}
+
+TEST_CASE("PipelineManager: Handles follow their name across reloads", "[pipelines][pipeline_manager][device]") {
+    TestDevice gpu;
+    if (gpu.device == VK_NULL_HANDLE) {
+        SKIP("No Vulkan device");
+    }
+    TempDir before;
+    before.write("fill.comp", computeSource(1));
+    TempDir after;
+    after.write("fill.comp", computeSource(2));
+    ShaderHandler original;
+    REQUIRE(original.loadShaderDataFromFolder(before.path) == 1);
+    ShaderHandler edited;
+    REQUIRE(edited.loadShaderDataFromFolder(after.path) == 1);
+
+    // Flushed before the device goes, after the manager released its pipelines
+    DeferredDeletionQueue queue;
+    PipelineManager manager;
+    manager.createComputePipeline(gpu.device, "fill", original.getShaderHandlers());
+    const PipelineHandle handle = manager.getHandle("fill");
+    REQUIRE(handle.valid());
+    // What recording code caches
+    const PipelineBinding cached = *manager.getBinding(handle);
+
+    REQUIRE(manager.reloadPipelines(gpu.device, {"fill.comp"}, edited.getShaderHandlers(), nullptr, queue) == 1);
+
+    REQUIRE(manager.getHandle("fill") == handle);
+    const PipelineBinding* reloaded = manager.getBinding(handle);
+    REQUIRE(reloaded != nullptr);
+    REQUIRE(reloaded->pipeline != VK_NULL_HANDLE);
+    REQUIRE(reloaded->pipeline != cached.pipeline);
+    REQUIRE(reloaded->version != cached.version);
+    // The replaced pipeline was retired, not kept next to the new one
+    REQUIRE(manager.getPipelineCount() == 1);
+    REQUIRE(queue.size() > 0);
+}
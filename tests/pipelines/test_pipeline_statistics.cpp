@@ -0,0 +1,89 @@
+#include <catch2/catch_test_macros.hpp>
+#include <PipelineStatistics.hpp>
+
+// Report sorting and serialization: no device is needed
+
+namespace {
+
+PipelineReportEntry entry(const std::string &name, std::optional<std::chrono::milliseconds> duration, double instructions) {
+    PipelineReportEntry result;
+    result.name = name;
+    if (duration) {
+        result.creation = PipelineCreationRecord{.duration = *duration, .outcome = PipelineCacheOutcome::Miss};
+    }
+    PipelineExecutable vertex;
+    vertex.name = "Vertex";
+    vertex.stages = VK_SHADER_STAGE_VERTEX_BIT;
+    vertex.statistics = {{"Instruction Count", "", instructions / 2}, {"VGPRs", "", 8}};
+    PipelineExecutable fragment;
+    fragment.name = "Fragment";
+    fragment.stages = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragment.statistics = {{"Instruction Count", "", instructions / 2}};
+    result.executables = {vertex, fragment};
+    return result;
+}
+
+std::vector<std::string> names(const PipelineReport &report) {
+    std::vector<std::string> result;
+    for (const PipelineReportEntry &e : report.entries) {
+        result.push_back(e.name);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("PipelineReport: Statistics sum over executables", "[pipelines][statistics]") {
+    const PipelineReportEntry e = entry("main", std::chrono::milliseconds(3), 100);
+    REQUIRE(e.statistic("Instruction Count") == 100.0);
+    REQUIRE(e.statistic("VGPRs") == 8.0);
+    REQUIRE(e.statistic("Unknown") == 0.0);
+
+    PipelineReport report;
+    report.entries = {e};
+    REQUIRE(report.statisticNames() == std::vector<std::string>{"Instruction Count", "VGPRs"});
+}
+
+TEST_CASE("PipelineReport: Sorting puts the worst pipelines first", "[pipelines][statistics]") {
+    PipelineReport report;
+    report.entries = {
+        entry("fast", std::chrono::milliseconds(1), 300),
+        entry("unrecorded", std::nullopt, 50),
+        entry("slow", std::chrono::milliseconds(20), 100),
+        entry("medium", std::chrono::milliseconds(5), 200),
+    };
+
+    report.sortByCreationTime();
+    REQUIRE(names(report) == std::vector<std::string>{"slow", "medium", "fast", "unrecorded"});
+
+    report.sortByStatistic("Instruction Count");
+    REQUIRE(names(report) == std::vector<std::string>{"fast", "medium", "slow", "unrecorded"});
+
+    // Ties keep the previous order
+    report.sortByStatistic("VGPRs");
+    REQUIRE(names(report) == std::vector<std::string>{"fast", "medium", "slow", "unrecorded"});
+}
+
+TEST_CASE("PipelineReport: JSON lists the entries in order", "[pipelines][statistics]") {
+    PipelineReport empty;
+    REQUIRE(empty.toJson() == "{\n  \"pipelines\": []\n}\n");
+
+    PipelineReport report;
+    report.entries = {entry("say \"hi\"\\\n", std::chrono::milliseconds(2), 10), entry("compute", std::nullopt, 4)};
+    report.entries[0].creation->outcome = PipelineCacheOutcome::Hit;
+    report.entries[1].bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+    const std::string json = report.toJson();
+
+    REQUIRE(json.find("\"name\": \"say \\\"hi\\\"\\\\\\n\"") != std::string::npos);
+    REQUIRE(json.find("\"creation\": {\"milliseconds\": 2, \"cache\": \"hit\"}") != std::string::npos);
+    REQUIRE(json.find("\"creation\": null") != std::string::npos);
+    REQUIRE(json.find("\"bindPoint\": \"compute\"") != std::string::npos);
+    REQUIRE(json.find("{\"name\": \"Instruction Count\", \"description\": \"\", \"value\": 5}") != std::string::npos);
+    REQUIRE(json.find("say") < json.find("compute"));
+}
+
+TEST_CASE("PipelineStatistics: Disabled collects nothing", "[pipelines][statistics]") {
+    const PipelineStatistics statistics;
+    REQUIRE_FALSE(statistics.isEnabled());
+    REQUIRE(statistics.collect(VK_NULL_HANDLE).empty());
+}
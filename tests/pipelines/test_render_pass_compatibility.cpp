@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+#include <RenderPassCompatibility.hpp>
+#include <cstdint>
+
+// Keys come from the create info alone and fake handles are never dereferenced: no device is needed
+
+namespace {
+
+// One color attachment in one subpass, as RenderPassManager creates it
+struct ColorPass {
+    VkAttachmentDescription attachment{
+        .flags = 0u,
+        .format = VK_FORMAT_B8G8R8A8_SRGB,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+    VkAttachmentReference reference{.attachment = 0, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription subpass{
+        .flags = 0u,
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .inputAttachmentCount = 0u,
+        .pInputAttachments = nullptr,
+        .colorAttachmentCount = 1u,
+        .pColorAttachments = &reference,
+        .pResolveAttachments = nullptr,
+        .pDepthStencilAttachment = nullptr,
+        .preserveAttachmentCount = 0u,
+        .pPreserveAttachments = nullptr};
+
+    VkRenderPassCreateInfo info() const {
+        return {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0u,
+                .attachmentCount = 1u,
+                .pAttachments = &attachment,
+                .subpassCount = 1u,
+                .pSubpasses = &subpass,
+                .dependencyCount = 0u,
+                .pDependencies = nullptr};
+    }
+
+    ABox::Hash128 key(uint32_t subpassIndex = 0) const {
+        return RenderPassCompatibility::compute(info(), subpassIndex);
+    }
+};
+
+VkRenderPass fakeRenderPass(uintptr_t value) {
+    return reinterpret_cast<VkRenderPass>(value);
+}
+
+} // namespace
+
+TEST_CASE("RenderPassCompatibility: Keys follow the attachments", "[pipelines][render_pass_compatibility]") {
+    const ColorPass base;
+
+    SECTION("Ops and layouts do not count") {
+        ColorPass other;
+        other.attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        other.attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        other.attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        other.attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        other.reference.layout = VK_IMAGE_LAYOUT_GENERAL;
+        REQUIRE(other.key() == base.key());
+    }
+
+    SECTION("Format, samples and subpass do") {
+        ColorPass format;
+        format.attachment.format = VK_FORMAT_R8G8B8A8_UNORM;
+        REQUIRE_FALSE(format.key() == base.key());
+
+        ColorPass samples;
+        samples.attachment.samples = VK_SAMPLE_COUNT_4_BIT;
+        REQUIRE_FALSE(samples.key() == base.key());
+
+        REQUIRE_FALSE(base.key(1) == base.key());
+    }
+
+    SECTION("An unused reference differs from a used one") {
+        ColorPass unused;
+        unused.reference.attachment = VK_ATTACHMENT_UNUSED;
+        REQUIRE_FALSE(unused.key() == base.key());
+    }
+}
+
+TEST_CASE("RenderPassCompatibility: Registered render passes", "[pipelines][render_pass_compatibility]") {
+    const ColorPass pass;
+    const VkRenderPassCreateInfo info = pass.info();
+    const VkRenderPass first = fakeRenderPass(0x1000);
+    const VkRenderPass second = fakeRenderPass(0x2000);
+
+    // Unknown handles are told apart by their value
+    REQUIRE_FALSE(RenderPassCompatibility::key(first, 0) == RenderPassCompatibility::key(second, 0));
+
+    // Two compatible render passes share their key
+    RenderPassCompatibility::add(first, info);
+    RenderPassCompatibility::add(second, info);
+    REQUIRE(RenderPassCompatibility::key(first, 0) == pass.key());
+    REQUIRE(RenderPassCompatibility::key(second, 0) == RenderPassCompatibility::key(first, 0));
+
+    // A reused handle takes the data of the new render pass
+    ColorPass other;
+    other.attachment.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+    RenderPassCompatibility::add(second, other.info());
+    REQUIRE(RenderPassCompatibility::key(second, 0) == other.key());
+
+    // No render pass: one key for all
+    REQUIRE(RenderPassCompatibility::key(VK_NULL_HANDLE, 0) == RenderPassCompatibility::key(VK_NULL_HANDLE, 0));
+    REQUIRE_FALSE(RenderPassCompatibility::key(VK_NULL_HANDLE, 0) == RenderPassCompatibility::key(first, 0));
+}
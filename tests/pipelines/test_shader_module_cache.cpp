@@ -0,0 +1,52 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ShaderHandler.hpp>
+#include <ShaderModuleCache.hpp>
+#include <TestTempDir.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("ShaderModuleCache: Keys follow the SPIR-V", "[pipelines][shader_module_cache]") {
+    const std::vector<uint32_t> a{SPIRV_MAGIC_NUMBER, 1, 2, 3};
+    const std::vector<uint32_t> b{SPIRV_MAGIC_NUMBER, 1, 2, 4};
+
+    REQUIRE(ShaderModuleCache::moduleKey(a) == ShaderModuleCache::moduleKey(std::vector<uint32_t>(a)));
+    REQUIRE_FALSE(ShaderModuleCache::moduleKey(a) == ShaderModuleCache::moduleKey(b));
+}
+
+TEST_CASE("ShaderModuleCache: Inline create infos with maintenance5", "[pipelines][shader_module_cache]") {
+    TempDir dir;
+    {
+        std::ofstream out(dir.path / "fill.comp");
+        out << "#version 450\nlayout(local_size_x = 1) in;\nvoid main() {}\n";
+    }
+    ShaderHandler shaders;
+    REQUIRE(shaders.loadShaderDataFromFolder(dir.path) == 1);
+    const ShaderDataFile *shader = shaders.getShader("fill.comp");
+    REQUIRE(shader != nullptr);
+
+    ShaderModuleCache modules;
+    REQUIRE_FALSE(modules.usesInlineModules());
+    modules.setInlineModules(true);
+
+    // No device call is made, a null device is never used
+    ShaderStageSet set = modules.stagesFor(VK_NULL_HANDLE, shaders.getShaderHandlers(), nullptr);
+    REQUIRE(set.stages.size() == 1);
+    REQUIRE(set.modules.empty());
+    REQUIRE(set.stages[0].module == VK_NULL_HANDLE);
+    REQUIRE(set.stages[0].stage == VK_SHADER_STAGE_COMPUTE_BIT);
+    REQUIRE(set.stages[0].pNext == &set.inlineModules[0]);
+    REQUIRE(set.inlineModules[0].pCode == shader->getCode().data());
+    REQUIRE(set.inlineModules[0].codeSize == shader->getCode().size_bytes());
+    REQUIRE(modules.size() == 0);
+    REQUIRE(modules.getCreations() == 0);
+
+    SECTION("Moving the set keeps the chain valid") {
+        const ShaderStageSet moved = std::move(set);
+        REQUIRE(moved.stages[0].pNext == &moved.inlineModules[0]);
+    }
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+#include <SpecializationConstants.hpp>
+#include <cstring>
+
+TEST_CASE("SpecializationConstants: Packing", "[pipelines][specialization]") {
+    SpecializationConstants constants;
+    constants.set(3, 1.5).set(0, true).set(1, 64u);
+
+    REQUIRE(constants.size() == 3);
+    const auto entries = constants.getEntries();
+    REQUIRE(entries.size() == 3);
+
+    // Sorted by id, each value aligned to its size
+    REQUIRE(entries[0].constantID == 0);
+    REQUIRE(entries[0].offset == 0);
+    REQUIRE(entries[0].size == sizeof(VkBool32));
+    REQUIRE(entries[1].constantID == 1);
+    REQUIRE(entries[1].offset == 4);
+    REQUIRE(entries[1].size == 4);
+    REQUIRE(entries[2].constantID == 3);
+    REQUIRE(entries[2].offset == 8);
+    REQUIRE(entries[2].size == 8);
+    REQUIRE(constants.getData().size() == 16);
+
+    VkBool32 b = VK_FALSE;
+    double   d = 0.0;
+    std::memcpy(&b, constants.getData().data(), sizeof(b));
+    std::memcpy(&d, constants.getData().data() + 8, sizeof(d));
+    REQUIRE(b == VK_TRUE);
+    REQUIRE(d == 1.5);
+
+    REQUIRE(constants.sizeOf(3) == 8);
+    REQUIRE(constants.sizeOf(2) == 0);
+
+    SECTION("Info points at the packed values") {
+        const VkSpecializationInfo info = constants.getInfo();
+        REQUIRE(info.mapEntryCount == 3);
+        REQUIRE(info.pMapEntries == entries.data());
+        REQUIRE(info.dataSize == 16);
+        REQUIRE(info.pData == constants.getData().data());
+    }
+
+    SECTION("Setting an id again replaces its value") {
+        constants.set(1, 128u);
+        REQUIRE(constants.size() == 3);
+        uint32_t value = 0;
+        std::memcpy(&value, constants.getData().data() + 4, sizeof(value));
+        REQUIRE(value == 128u);
+    }
+}
+
+TEST_CASE("SpecializationConstants: Hash", "[pipelines][specialization]") {
+    SpecializationConstants a;
+    a.set(0, 16u).set(1, 2.0f);
+    SpecializationConstants b;
+    b.set(1, 2.0f).set(0, 16u);
+
+    REQUIRE(a == b);
+    REQUIRE(a.getHash() == b.getHash());
+    REQUIRE(SpecializationConstants{}.empty());
+    REQUIRE(SpecializationConstants{}.getHash() == ABox::Hash128{});
+
+    SECTION("Values are part of the hash") {
+        b.set(0, 32u);
+        REQUIRE_FALSE(a == b);
+        REQUIRE_FALSE(a.getHash() == b.getHash());
+    }
+
+    SECTION("Types are part of the hash") {
+        SpecializationConstants c;
+        c.set(0, 16).set(1, 2.0f);
+        SpecializationConstants d;
+        d.set(0, uint64_t{16}).set(1, 2.0f);
+        REQUIRE_FALSE(a.getHash() == d.getHash());
+        REQUIRE(a.getData().size() == c.getData().size());
+    }
+}
@@ -0,0 +1,197 @@
+#include <catch2/catch_test_macros.hpp>
+#include <BinaryLog.hpp>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string tempLogPath(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::vector<std::string> readAll(const std::string &path) {
+    ABox::BinaryLogReader reader;
+    std::vector<std::string> lines;
+    REQUIRE(reader.open(path));
+    reader.forEach([&](const ABox::BinaryLogRecord &r) {
+        lines.push_back(r.text());
+    });
+    return lines;
+}
+
+template <typename... Args>
+std::string render(const char *format, const Args &...args) {
+    std::vector<uint8_t> payload((size_t{0} + ... + ABox::BinaryLogDetail::encodedSize(args)));
+    uint8_t *out = payload.data();
+    ((out = ABox::BinaryLogDetail::encode(out, args)), ...);
+    (void)out;
+    return ABox::renderBinaryRecord(format, payload);
+}
+
+} // namespace
+
+TEST_CASE("BinaryLog: Argument rendering", "[utils][binary_log]") {
+    SECTION("Integers, floats, bools and strings") {
+        REQUIRE(render("a={} b={} c={}", -5, 7u, 1.5) == "a=-5 b=7 c=1.5");
+        REQUIRE(render("{} {}", true, 'x') == "true x");
+        REQUIRE(render("{}/{}", "lit", std::string("str")) == "lit/str");
+    }
+
+    SECTION("Hex and escapes") {
+        REQUIRE(render("{:x}", 255) == "0xff");
+        REQUIRE(render("{{}} {}", 1) == "{} 1");
+    }
+
+    SECTION("Missing arguments keep the placeholder") {
+        REQUIRE(render("{} {}", 3) == "3 {}");
+    }
+
+    SECTION("Null C string") {
+        const char *nothing = nullptr;
+        REQUIRE(render("{}", nothing) == "(null)");
+    }
+
+    SECTION("Truncated payload is reported") {
+        std::vector<uint8_t> payload{
+            static_cast<uint8_t>(ABox::BinaryLogLayout::ArgTag::U64), 1, 2
+        };
+        REQUIRE(ABox::renderBinaryRecord("{}", payload) == " <truncated>");
+    }
+}
+
+TEST_CASE("BinaryLog: File round trip", "[utils][binary_log]") {
+    const std::string path = tempLogPath("abox_test_round_trip.ablog");
+    REQUIRE(ABox::openBinaryLog(path, 1u << 16));
+    REQUIRE(ABox::isBinaryLogOpen());
+
+    SECTION("Records decode in order with their format") {
+        for (int i = 0; i < 10; ++i) {
+            ABOX_SLOG("Test", ABox::LogLevel::INFO, "frame {} image {}", i, i * 2);
+        }
+        ABox::closeBinaryLog();
+
+        const auto lines = readAll(path);
+        REQUIRE(lines.size() == 10);
+        REQUIRE(lines.front() == "frame 0 image 0");
+        REQUIRE(lines.back() == "frame 9 image 18");
+    }
+
+    SECTION("Binary level filter drops lower levels") {
+        ABox::setBinaryLogLevel(ABox::LogLevel::WARN);
+        ABOX_SLOG("Test", ABox::LogLevel::DEBUG, "dropped");
+        ABOX_SLOG("Test", ABox::LogLevel::ERROR, "kept");
+        ABox::setBinaryLogLevel(ABox::LogLevel::DEBUG);
+        ABox::closeBinaryLog();
+
+        const auto lines = readAll(path);
+        REQUIRE(lines.size() == 1);
+        REQUIRE(lines.front() == "kept");
+    }
+
+    ABox::closeBinaryLog();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("BinaryLog: Ring wrap keeps the newest records", "[utils][binary_log]") {
+    const std::string path = tempLogPath("abox_test_wrap.ablog");
+    REQUIRE(ABox::openBinaryLog(path, 4096));
+
+    constexpr int count = 2000;
+    for (int i = 0; i < count; ++i) {
+        ABOX_SLOG("Test", ABox::LogLevel::DEBUG, "value {}", i);
+    }
+    ABox::closeBinaryLog();
+
+    const auto lines = readAll(path);
+    REQUIRE_FALSE(lines.empty());
+    REQUIRE(lines.size() < static_cast<size_t>(count));
+    REQUIRE(lines.back() == "value 1999");
+
+    // Surviving records are contiguous
+    const int first = std::stoi(lines.front().substr(6));
+    for (size_t i = 0; i < lines.size(); ++i) {
+        REQUIRE(lines[i] == "value " + std::to_string(first + i));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("BinaryLog: Concurrent writers", "[utils][binary_log]") {
+    const std::string path = tempLogPath("abox_test_threads.ablog");
+    REQUIRE(ABox::openBinaryLog(path, 1u << 20));
+
+    constexpr int threads = 4;
+    constexpr int perThread = 1000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < perThread; ++i) {
+                ABOX_SLOG("Test", ABox::LogLevel::DEBUG, "t{} i{}", t, i);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    ABox::closeBinaryLog();
+
+    REQUIRE(readAll(path).size() == threads * perThread);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("BinaryLog: Reader rejects foreign files", "[utils][binary_log]") {
+    const std::string path = tempLogPath("abox_test_foreign.ablog");
+    FILE *f = std::fopen(path.c_str(), "wb");
+    REQUIRE(f);
+    std::fputs("definitely not a binary log, just some text", f);
+    std::fclose(f);
+
+    ABox::BinaryLogReader reader;
+    REQUIRE_FALSE(reader.open(path));
+    REQUIRE_FALSE(reader.open(tempLogPath("abox_test_missing.ablog")));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("BinaryLog: Reader stops at a corrupted format id", "[utils][binary_log]") {
+    const std::string path = tempLogPath("abox_test_bad_id.ablog");
+    REQUIRE(ABox::openBinaryLog(path, 1u << 16));
+    ABOX_SLOG("Test", ABox::LogLevel::INFO, "frame {}", 1);
+    ABox::closeBinaryLog();
+
+    // No table can hold that many entries, it must not size the lookup
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    ABox::BinaryLogLayout::FileHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    file.seekp(static_cast<std::streamoff>(header.formatTableOffset));
+    const uint32_t id = 0xfffffff0;
+    file.write(reinterpret_cast<const char *>(&id), sizeof(id));
+    file.close();
+
+    ABox::BinaryLogReader reader;
+    REQUIRE(reader.open(path));
+    std::vector<std::string> formats;
+    reader.forEach([&](const ABox::BinaryLogRecord &r) {
+        formats.emplace_back(r.format);
+    });
+    REQUIRE(formats.size() == 1);
+    REQUIRE(formats.front() == "<unknown format>");
+    reader.close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("BinaryLog: Text fallback when closed", "[utils][binary_log]") {
+    REQUIRE_FALSE(ABox::isBinaryLogOpen());
+
+    std::string captured;
+    ABox::setLogCallback([&](ABox::LogLevel, const char *, const char *msg) {
+        captured = msg;
+    });
+    ABOX_SLOG("Test", ABox::LogLevel::WARN, "fallback {} {}", 42, "ok");
+    ABox::setLogCallback(nullptr);
+
+    REQUIRE(captured == "fallback 42 ok");
+}
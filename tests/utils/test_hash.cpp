@@ -0,0 +1,55 @@
+#include <catch2/catch_test_macros.hpp>
+#include <Hash.hpp>
+#include <string>
+#include <vector>
+
+using ABox::Hash128;
+using ABox::Hasher;
+
+TEST_CASE("Hasher: Digest properties", "[utils][hash]") {
+    SECTION("Same input, same digest") {
+        REQUIRE(Hasher().update(std::string_view("shader")).digest() == Hasher().update(std::string_view("shader")).digest());
+    }
+
+    SECTION("Digest does not depend on how the input is split") {
+        std::vector<uint8_t> data(1000);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<uint8_t>(i * 31 + 7);
+        }
+        Hash128 whole = Hasher().update(data.data(), data.size()).digest();
+
+        for (size_t split : {1u, 3u, 7u, 8u, 9u, 500u, 999u}) {
+            Hasher pieces;
+            pieces.update(data.data(), split);
+            pieces.update(data.data() + split, data.size() - split);
+            REQUIRE(pieces.digest() == whole);
+        }
+    }
+
+    SECTION("Any change alters the digest") {
+        std::string text(64, 'a');
+        Hash128 reference = Hasher().update(std::string_view(text)).digest();
+        for (size_t i = 0; i < text.size(); ++i) {
+            std::string changed = text;
+            changed[i] = 'b';
+            REQUIRE_FALSE(Hasher().update(std::string_view(changed)).digest() == reference);
+        }
+        REQUIRE_FALSE(Hasher().update(std::string_view(text + "a")).digest() == reference);
+    }
+
+    SECTION("Strings are length prefixed") {
+        Hash128 ab_c = Hasher().update(std::string_view("ab")).update(std::string_view("c")).digest();
+        Hash128 a_bc = Hasher().update(std::string_view("a")).update(std::string_view("bc")).digest();
+        REQUIRE_FALSE(ab_c == a_bc);
+    }
+
+    SECTION("Seed changes the digest") {
+        REQUIRE_FALSE(Hasher(1).update(42).digest() == Hasher(2).update(42).digest());
+    }
+}
+
+TEST_CASE("Hash128: Hex form", "[utils][hash]") {
+    Hash128 h{.lo = 0x0123456789abcdefull, .hi = 0xfedcba9876543210ull};
+    REQUIRE(h.toHex() == "fedcba98765432100123456789abcdef");
+    REQUIRE(Hash128{}.toHex() == std::string(32, '0'));
+}
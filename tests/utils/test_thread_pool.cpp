@@ -0,0 +1,49 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ThreadPool.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using ABox::ThreadPool;
+
+TEST_CASE("ThreadPool: Runs submitted tasks", "[utils][thread_pool]") {
+    ThreadPool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    SECTION("Futures deliver results in submission order") {
+        std::vector<std::future<int>> results;
+        for (int i = 0; i < 100; ++i) {
+            results.push_back(pool.submit([i] { return i * i; }));
+        }
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(results[i].get() == i * i);
+        }
+    }
+
+    SECTION("Exceptions are forwarded through the future") {
+        std::future<int> result = pool.submit([]() -> int { throw std::runtime_error("fail"); });
+        REQUIRE_THROWS_AS(result.get(), std::runtime_error);
+    }
+
+    SECTION("Move-only callables are accepted") {
+        auto value = std::make_unique<int>(42);
+        std::future<int> result = pool.submit([v = std::move(value)] { return *v; });
+        REQUIRE(result.get() == 42);
+    }
+}
+
+TEST_CASE("ThreadPool: Destruction drains the queue", "[utils][thread_pool]") {
+    std::atomic<int> done{0};
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 64; ++i) {
+            pool.submit([&done] { done.fetch_add(1); });
+        }
+    }
+    REQUIRE(done.load() == 64);
+}
+
+TEST_CASE("ThreadPool: Default size", "[utils][thread_pool]") {
+    REQUIRE(ThreadPool::shared().size() >= 1);
+    REQUIRE(ThreadPool::shared().submit([] { return 7; }).get() == 7);
+}